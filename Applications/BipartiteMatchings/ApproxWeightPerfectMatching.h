@@ -408,36 +408,175 @@ int ThreadBuffLenForBinning(int itemsize, int nbins)
 }
 
 
-
-template <class IT, class NT>
-std::vector< std::tuple<IT,IT,NT> > Phase1(const AWPM_param<IT>& param, Dcsc<IT, NT>* dcsc, const std::vector<IT>& colptr, const std::vector<IT>& RepMateR2C, const std::vector<IT>& RepMateC2R, const std::vector<NT>& RepMateWR2C, const std::vector<NT>& RepMateWC2R )
+/**
+ * Buffers of one all-to-all exchange of TwoThirdApprox, allocated once and reused (they only grow) in every iteration
+ * Items are counted per destination first; the second pass bins them in cache sized per-thread bins that are flushed
+ * into a single flattened send buffer at positions reserved with an atomic add, so no locks and no per-destination vectors
+ */
+template <class T>
+class AWPMArena
 {
+public:
+    AWPMArena(int nprocs, MPI_Comm World): nprocs(nprocs), World(World), nthreads(1),
+        sendcnt(nprocs), recvcnt(nprocs), sdispls(nprocs), rdispls(nprocs), transferCount(nprocs)
+    {
+#ifdef THREADED
+#pragma omp parallel
+        {
+            nthreads = omp_get_num_threads();
+        }
+#endif
+        THREAD_BUF_LEN = ThreadBuffLenForBinning(sizeof(T), nprocs);
+        threadcnt.resize(nthreads, std::vector<int>(nprocs));
+        threadbins.resize(nthreads, std::vector<T>(static_cast<size_t>(nprocs) * THREAD_BUF_LEN));
+        MPI_Type_contiguous(sizeof(T), MPI_CHAR, &MPI_tuple);
+        MPI_Type_commit(&MPI_tuple);
+    }
+    ~AWPMArena() { MPI_Type_free(&MPI_tuple); }
+    AWPMArena(const AWPMArena &) = delete;
+    AWPMArena & operator=(const AWPMArena &) = delete;
     
+    static int ThreadId()
+    {
+#ifdef THREADED
+        return omp_get_thread_num();
+#else
+        return 0;
+#endif
+    }
     
+    // Start of a new exchange: all counts are zeroed
+    void Reset()
+    {
+        std::fill(sendcnt.begin(), sendcnt.end(), 0);
+        for(int t=0; t<nthreads; ++t)
+            std::fill(threadcnt[t].begin(), threadcnt[t].end(), 0);
+    }
     
-    double tstart = MPI_Wtime();
+    // First pass, called by every thread: Count() its items, then AddCounts() once
+    void Count(int tid, int owner) { threadcnt[tid][owner]++; }
+    void AddCounts(int tid)
+    {
+        for(int i=0; i<nprocs; i++)
+        {
+            __sync_fetch_and_add(sendcnt.data()+i, threadcnt[tid][i]);
+            threadcnt[tid][i] = 0;  // reused as the bin fill counts in the second pass
+        }
+    }
     
+    // Between the passes, by a single thread
+    void Allocate()
+    {
+        sdispls[0] = 0;
+        std::partial_sum(sendcnt.data(), sendcnt.data()+nprocs-1, sdispls.data()+1);
+        sendbuf.resize(static_cast<size_t>(sdispls[nprocs-1]) + sendcnt[nprocs-1]);
+        std::fill(transferCount.begin(), transferCount.end(), 0);
+    }
     
-    MPI_Comm World = param.commGrid->GetWorld();
+    // Second pass, called by every thread: Push() its items (in the same amounts as counted), then Flush() once
+    void Push(int tid, int owner, const T & item)
+    {
+        int * tsendcnt = threadcnt[tid].data();
+        T * tsendTuples = threadbins[tid].data();
+        if (tsendcnt[owner] < THREAD_BUF_LEN)
+        {
+            tsendTuples[THREAD_BUF_LEN * owner + tsendcnt[owner]] = item;
+            tsendcnt[owner]++;
+        }
+        else
+        {
+            int tt = __sync_fetch_and_add(transferCount.data()+owner, THREAD_BUF_LEN);
+            std::copy( tsendTuples+THREAD_BUF_LEN * owner, tsendTuples+THREAD_BUF_LEN * (owner+1) , sendbuf.data() + sdispls[owner]+ tt);
+            
+            tsendTuples[THREAD_BUF_LEN * owner] = item;
+            tsendcnt[owner] = 1;
+        }
+    }
+    void Flush(int tid)
+    {
+        int * tsendcnt = threadcnt[tid].data();
+        T * tsendTuples = threadbins[tid].data();
+        for(int owner=0; owner < nprocs; owner++)
+        {
+            if (tsendcnt[owner] >0)
+            {
+                int tt = __sync_fetch_and_add(transferCount.data()+owner, tsendcnt[owner]);
+                std::copy( tsendTuples+THREAD_BUF_LEN * owner, tsendTuples+THREAD_BUF_LEN * owner + tsendcnt[owner], sendbuf.data() + sdispls[owner]+ tt);
+                tsendcnt[owner] = 0;
+            }
+        }
+    }
     
-   
+    // The received items stay valid until the next Exchange()
+    std::vector<T> & Exchange()
+    {
+        MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);
+        rdispls[0] = 0;
+        std::partial_sum(recvcnt.data(), recvcnt.data()+nprocs-1, rdispls.data()+1);
+        recvbuf.resize(static_cast<size_t>(rdispls[nprocs-1]) + recvcnt[nprocs-1]);
+        MPI_Alltoallv(sendbuf.data(), sendcnt.data(), sdispls.data(), MPI_tuple, recvbuf.data(), recvcnt.data(), rdispls.data(), MPI_tuple, World);
+        return recvbuf;
+    }
     
-    //Step 1: Count the amount of data to be sent to different processors
-     std::vector<int> sendcnt(param.nprocs,0); // number items to be sent to each processor
+private:
+    int nprocs;
+    MPI_Comm World;
+    int nthreads;
+    int THREAD_BUF_LEN;
+    MPI_Datatype MPI_tuple;
+    std::vector<int> sendcnt, recvcnt, sdispls, rdispls, transferCount;
+    std::vector<std::vector<int>> threadcnt;
+    std::vector<std::vector<T>> threadbins;
+    std::vector<T> sendbuf, recvbuf;
+};
 
+
+// Owner of the (grow, gcol) entry, same as OwnerProcs without the collectives
+template <class IT>
+inline int AWPMOwner(const AWPM_param<IT>& param, IT grow, IT gcol)
+{
+    int rrank = param.m_perproc != 0 ? std::min(static_cast<int>(grow / param.m_perproc), param.pr-1) : (param.pr-1);
+    int crank = param.n_perproc != 0 ? std::min(static_cast<int>(gcol / param.n_perproc), param.pc-1) : (param.pc-1);
+    return param.commGrid->GetRank(rrank , crank);
+}
+
+
+/**
+ * Lock-free best offer: slot keeps the index of the best item seen so far (-1 if none)
+ * better(k, cur) must be a strict total order on the items, so the winner does not depend on the thread schedule
+ */
+template <class IT, typename BETTER>
+inline void AWPMOffer(IT * slot, IT k, BETTER better)
+{
+    IT cur = __atomic_load_n(slot, __ATOMIC_RELAXED);
+    while(cur == -1 || better(k, cur))
+    {
+        if(__sync_bool_compare_and_swap(slot, cur, k)) break;
+        cur = __atomic_load_n(slot, __ATOMIC_RELAXED);
+    }
+}
+
+
+
+template <class IT, class NT>
+std::vector< std::tuple<IT,IT,NT> > & Phase1(const AWPM_param<IT>& param, Dcsc<IT, NT>* dcsc, const std::vector<IT>& colptr, const std::vector<IT>& RepMateR2C, const std::vector<IT>& RepMateC2R, const std::vector<NT>& RepMateWR2C, const std::vector<NT>& RepMateWC2R, AWPMArena<std::tuple<IT,IT,NT>> & arena )
+{
+    
+    double tstart = MPI_Wtime();
+    arena.Reset();
     
+    //Step 1: Count the amount of data to be sent to different processors
 #ifdef THREADED
 #pragma omp parallel
 #endif
     {
-        std::vector<int> tsendcnt(param.nprocs,0);
+        int tid = arena.ThreadId();
 #ifdef THREADED
 #pragma omp for
 #endif
         for(int k=0; k<param.lncol; ++k)
         {
             IT mj = RepMateC2R[k]; // lj = k
-            IT j = k + param.localColStart;
             
             for(IT cp = colptr[k]; cp < colptr[k+1]; ++cp)
             {
@@ -446,39 +585,20 @@ std::vector< std::tuple<IT,IT,NT> > Phase1(const AWPM_param<IT>& param, Dcsc<IT,
                 IT mi = RepMateR2C[li];
                 if( i > mj) // TODO : stop when first come to this, may be use <
                 {
-                    
-                    int rrank = param.m_perproc != 0 ? std::min(static_cast<int>(mj / param.m_perproc), param.pr-1) : (param.pr-1);
-                    int crank = param.n_perproc != 0 ? std::min(static_cast<int>(mi / param.n_perproc), param.pc-1) : (param.pc-1);
-                    int owner = param.commGrid->GetRank(rrank , crank);
-                    tsendcnt[owner]++;
+                    arena.Count(tid, AWPMOwner(param, mj, mi));
                 }
             }
         }
-        for(int i=0; i<param.nprocs; i++)
-        {
-            __sync_fetch_and_add(sendcnt.data()+i, tsendcnt[i]);
-        }
+        arena.AddCounts(tid);
     }
-    
-    
-    
-    
-    IT totsend = std::accumulate(sendcnt.data(), sendcnt.data()+param.nprocs, static_cast<IT>(0));
-    std::vector<int> sdispls (param.nprocs, 0);
-    std::partial_sum(sendcnt.data(), sendcnt.data()+param.nprocs-1, sdispls.data()+1);
-    
-    std::vector< std::tuple<IT,IT,NT> > sendTuples(totsend);
-    std::vector<int> transferCount(param.nprocs,0);
-    int THREAD_BUF_LEN = ThreadBuffLenForBinning(24, param.nprocs);
-    
+    arena.Allocate();
     
     //Step 2: Compile data to be sent to different processors
 #ifdef THREADED
 #pragma omp parallel
 #endif
     {
-        std::vector<int> tsendcnt(param.nprocs,0);
-        std::vector<std::tuple<IT,IT, NT>> tsendTuples (param.nprocs*THREAD_BUF_LEN);
+        int tid = arena.ThreadId();
 #ifdef THREADED
 #pragma omp for
 #endif
@@ -486,7 +606,6 @@ std::vector< std::tuple<IT,IT,NT> > Phase1(const AWPM_param<IT>& param, Dcsc<IT,
         {
             IT mj = RepMateC2R[k];
             IT lj = k;
-            IT j = k + param.localColStart;
             
             for(IT cp = colptr[k]; cp < colptr[k+1]; ++cp)
             {
@@ -496,56 +615,18 @@ std::vector< std::tuple<IT,IT,NT> > Phase1(const AWPM_param<IT>& param, Dcsc<IT,
                 if( i > mj) // TODO : stop when first come to this, may be use <
                 {
                     double w = dcsc->numx[cp]- RepMateWR2C[li] - RepMateWC2R[lj];
-                    int rrank = param.m_perproc != 0 ? std::min(static_cast<int>(mj / param.m_perproc), param.pr-1) : (param.pr-1);
-                    int crank = param.n_perproc != 0 ? std::min(static_cast<int>(mi / param.n_perproc), param.pc-1) : (param.pc-1);
-                    int owner = param.commGrid->GetRank(rrank , crank);
-                    
-                    if (tsendcnt[owner] < THREAD_BUF_LEN)
-                    {
-                        tsendTuples[THREAD_BUF_LEN * owner + tsendcnt[owner]] = std::make_tuple(mi, mj, w);
-                        tsendcnt[owner]++;
-                    }
-                    else
-                    {
-                        int tt = __sync_fetch_and_add(transferCount.data()+owner, THREAD_BUF_LEN);
-                        copy( tsendTuples.data()+THREAD_BUF_LEN * owner, tsendTuples.data()+THREAD_BUF_LEN * (owner+1) , sendTuples.data() + sdispls[owner]+ tt);
-                        
-                        tsendTuples[THREAD_BUF_LEN * owner] = std::make_tuple(mi, mj, w);
-                        tsendcnt[owner] = 1;
-                    }
+                    arena.Push(tid, AWPMOwner(param, mj, mi), std::make_tuple(mi, mj, w));
                 }
             }
         }
-        for(int owner=0; owner < param.nprocs; owner++)
-        {
-            if (tsendcnt[owner] >0)
-            {
-                int tt = __sync_fetch_and_add(transferCount.data()+owner, tsendcnt[owner]);
-                copy( tsendTuples.data()+THREAD_BUF_LEN * owner, tsendTuples.data()+THREAD_BUF_LEN * owner + tsendcnt[owner], sendTuples.data() + sdispls[owner]+ tt);
-            }
-        }
+        arena.Flush(tid);
     }
     
     double t1Comp = MPI_Wtime() - tstart;
     tstart = MPI_Wtime();
     
     // Step 3: Communicate data
-    
-    std::vector<int> recvcnt (param.nprocs);
-    std::vector<int> rdispls (param.nprocs, 0);
-    
-    MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);
-    std::partial_sum(recvcnt.data(), recvcnt.data()+param.nprocs-1, rdispls.data()+1);
-    IT totrecv = std::accumulate(recvcnt.data(), recvcnt.data()+param.nprocs, static_cast<IT>(0));
-    
-    
-    MPI_Datatype MPI_tuple;
-    MPI_Type_contiguous(sizeof(std::tuple<IT,IT,NT>), MPI_CHAR, &MPI_tuple);
-    MPI_Type_commit(&MPI_tuple);
-    
-    std::vector< std::tuple<IT,IT,NT> > recvTuples1(totrecv);
-    MPI_Alltoallv(sendTuples.data(), sendcnt.data(), sdispls.data(), MPI_tuple, recvTuples1.data(), recvcnt.data(), rdispls.data(), MPI_tuple, World);
-    MPI_Type_free(&MPI_tuple);
+    std::vector< std::tuple<IT,IT,NT> > & recvTuples1 = arena.Exchange();
     double t1Comm = MPI_Wtime() - tstart;
     return recvTuples1;
 }
@@ -555,19 +636,16 @@ std::vector< std::tuple<IT,IT,NT> > Phase1(const AWPM_param<IT>& param, Dcsc<IT,
 
 
 template <class IT, class NT>
-std::vector< std::tuple<IT,IT,IT,NT> > Phase2(const AWPM_param<IT>& param, std::vector<std::tuple<IT,IT,NT>>& recvTuples, Dcsc<IT, NT>* dcsc, const std::vector<IT>& colptr, const std::vector<IT>& RepMateR2C, const std::vector<IT>& RepMateC2R, const std::vector<NT>& RepMateWR2C, const std::vector<NT>& RepMateWC2R )
+std::vector< std::tuple<IT,IT,IT,NT> > & Phase2(const AWPM_param<IT>& param, std::vector<std::tuple<IT,IT,NT>>& recvTuples, Dcsc<IT, NT>* dcsc, const std::vector<IT>& colptr, const std::vector<IT>& RepMateR2C, const std::vector<IT>& RepMateC2R, AWPMArena<std::tuple<IT,IT,IT,NT>> & arena )
 {
     
-    MPI_Comm World = param.commGrid->GetWorld();
-    
     double tstart = MPI_Wtime();
     
     // Step 1: Sort for effecient searching of indices
     __gnu_parallel::sort(recvTuples.begin(), recvTuples.end());
-    std::vector<std::vector<std::tuple<IT,IT, IT, NT>>> tempTuples1 (param.nprocs);
+    IT nrecv = recvTuples.size();
+    arena.Reset();
     
-    std::vector<int> sendcnt(param.nprocs,0); // number items to be sent to each processor
-
     //Step 2: Count the amount of data to be sent to different processors
     // Instead of binary search in each column, I am doing linear search
     // Linear search is faster here because, we need to search 40%-50% of nnz
@@ -584,23 +662,24 @@ std::vector< std::tuple<IT,IT,IT,NT> > Phase2(const AWPM_param<IT>& param, std::
 #endif
     for(int i=0; i<nBins; i++)
     {
+        int tid = arena.ThreadId();
         int perBin = recvTuples.size()/nBins;
         int startBinIndex = perBin * i;
         int endBinIndex = perBin * (i+1);
         if(i==nBins-1) endBinIndex  = recvTuples.size();
+        // a column that straddles the bin boundary is handled by the previous bin
+        while(startBinIndex > 0 && startBinIndex < endBinIndex && std::get<0>(recvTuples[startBinIndex-1]) == std::get<0>(recvTuples[startBinIndex]))
+            startBinIndex++;
         
-        
-        std::vector<int> tsendcnt(param.nprocs,0);
         for(int k=startBinIndex; k<endBinIndex;)
         {
             
                 IT mi = std::get<0>(recvTuples[k]);
                 IT lcol = mi - param.localColStart;
-                IT i = RepMateC2R[lcol];
                 IT idx1 = k;
                 IT idx2 = colptr[lcol];
                 
-                for(; std::get<0>(recvTuples[idx1]) == mi && idx2 < colptr[lcol+1];) //**
+                for(; idx1 < nrecv && std::get<0>(recvTuples[idx1]) == mi && idx2 < colptr[lcol+1];) //**
                 {
                     
                     IT mj = std::get<1>(recvTuples[idx1]) ;
@@ -610,13 +689,10 @@ std::vector< std::tuple<IT,IT,IT,NT> > Phase2(const AWPM_param<IT>& param, std::
                     if(lrowMat ==  lrow)
                     {
                         NT weight = std::get<2>(recvTuples[idx1]);
-                        NT cw = weight + RepMateWR2C[lrow]; //w+W[M'[j],M[i]];
+                        NT cw = weight + dcsc->numx[idx2]; //w+W[M'[j],M[i]];
                         if (cw > 0)
                         {
-                            int rrank = (param.m_perproc != 0) ? std::min(static_cast<int>(mj / param.m_perproc), param.pr-1) : (param.pr-1);
-                            int crank = (param.n_perproc != 0) ? std::min(static_cast<int>(j / param.n_perproc), param.pc-1) : (param.pc-1);
-                            int owner = param.commGrid->GetRank(rrank , crank);
-                            tsendcnt[owner]++;
+                            arena.Count(tid, AWPMOwner(param, mj, j));
                         }
                         
                         idx1++; idx2++;
@@ -627,26 +703,13 @@ std::vector< std::tuple<IT,IT,IT,NT> > Phase2(const AWPM_param<IT>& param, std::
                         idx2 ++;
                 }
                 
-                for(;std::get<0>(recvTuples[idx1]) == mi ; idx1++);
+                for(; idx1 < nrecv && std::get<0>(recvTuples[idx1]) == mi ; idx1++);
                 k = idx1;
              
         }
-        for(int i=0; i<param.nprocs; i++)
-        {
-            __sync_fetch_and_add(sendcnt.data()+i, tsendcnt[i]);
-        }
+        arena.AddCounts(tid);
     }
-
-    
-
-    
-    IT totsend = std::accumulate(sendcnt.data(), sendcnt.data()+param.nprocs, static_cast<IT>(0));
-    std::vector<int> sdispls (param.nprocs, 0);
-    std::partial_sum(sendcnt.data(), sendcnt.data()+param.nprocs-1, sdispls.data()+1);
-    
-    std::vector< std::tuple<IT,IT,IT,NT> > sendTuples(totsend);
-    std::vector<int> transferCount(param.nprocs,0);
-    int THREAD_BUF_LEN = ThreadBuffLenForBinning(32, param.nprocs);
+    arena.Allocate();
     
     
     //Step 3: Compile data to be sent to different processors
@@ -655,14 +718,15 @@ std::vector< std::tuple<IT,IT,IT,NT> > Phase2(const AWPM_param<IT>& param, std::
 #endif
     for(int i=0; i<nBins; i++)
     {
+        int tid = arena.ThreadId();
         int perBin = recvTuples.size()/nBins;
         int startBinIndex = perBin * i;
         int endBinIndex = perBin * (i+1);
         if(i==nBins-1) endBinIndex  = recvTuples.size();
+        // a column that straddles the bin boundary is handled by the previous bin
+        while(startBinIndex > 0 && startBinIndex < endBinIndex && std::get<0>(recvTuples[startBinIndex-1]) == std::get<0>(recvTuples[startBinIndex]))
+            startBinIndex++;
         
-        
-        std::vector<int> tsendcnt(param.nprocs,0);
-        std::vector<std::tuple<IT,IT, IT, NT>> tsendTuples (param.nprocs*THREAD_BUF_LEN);
         for(int k=startBinIndex; k<endBinIndex;)
         {
             IT mi = std::get<0>(recvTuples[k]);
@@ -671,7 +735,7 @@ std::vector< std::tuple<IT,IT,IT,NT> > Phase2(const AWPM_param<IT>& param, std::
             IT idx1 = k;
             IT idx2 = colptr[lcol];
             
-            for(; std::get<0>(recvTuples[idx1]) == mi && idx2 < colptr[lcol+1];) //**
+            for(; idx1 < nrecv && std::get<0>(recvTuples[idx1]) == mi && idx2 < colptr[lcol+1];) //**
             {
                 
                 IT mj = std::get<1>(recvTuples[idx1]) ;
@@ -681,27 +745,10 @@ std::vector< std::tuple<IT,IT,IT,NT> > Phase2(const AWPM_param<IT>& param, std::
                 if(lrowMat ==  lrow)
                 {
                     NT weight = std::get<2>(recvTuples[idx1]);
-                    NT cw = weight + RepMateWR2C[lrow]; //w+W[M'[j],M[i]];
+                    NT cw = weight + dcsc->numx[idx2]; //w+W[M'[j],M[i]];
                     if (cw > 0)
                     {
-                        int rrank = (param.m_perproc != 0) ? std::min(static_cast<int>(mj / param.m_perproc), param.pr-1) : (param.pr-1);
-                        int crank = (param.n_perproc != 0) ? std::min(static_cast<int>(j / param.n_perproc), param.pc-1) : (param.pc-1);
-                        int owner = param.commGrid->GetRank(rrank , crank);
-                        
-                        if (tsendcnt[owner] < THREAD_BUF_LEN)
-                        {
-                            tsendTuples[THREAD_BUF_LEN * owner + tsendcnt[owner]] = std::make_tuple(mj, mi, i, cw);
-                            tsendcnt[owner]++;
-                        }
-                        else
-                        {
-                            int tt = __sync_fetch_and_add(transferCount.data()+owner, THREAD_BUF_LEN);
-                            std::copy( tsendTuples.data()+THREAD_BUF_LEN * owner, tsendTuples.data()+THREAD_BUF_LEN * (owner+1) , sendTuples.data() + sdispls[owner]+ tt);
-                            
-                            tsendTuples[THREAD_BUF_LEN * owner] = std::make_tuple(mj, mi, i, cw);
-                            tsendcnt[owner] = 1;
-                        }
-                        
+                        arena.Push(tid, AWPMOwner(param, mj, j), std::make_tuple(mj, mi, i, cw));
                     }
                     
                     idx1++; idx2++;
@@ -712,18 +759,10 @@ std::vector< std::tuple<IT,IT,IT,NT> > Phase2(const AWPM_param<IT>& param, std::
                     idx2 ++;
             }
             
-            for(;std::get<0>(recvTuples[idx1]) == mi ; idx1++);
+            for(; idx1 < nrecv && std::get<0>(recvTuples[idx1]) == mi ; idx1++);
             k = idx1;
         }
-        
-        for(int owner=0; owner < param.nprocs; owner++)
-        {
-            if (tsendcnt[owner] >0)
-            {
-                int tt = __sync_fetch_and_add(transferCount.data()+owner, tsendcnt[owner]);
-                std::copy( tsendTuples.data()+THREAD_BUF_LEN * owner, tsendTuples.data()+THREAD_BUF_LEN * owner + tsendcnt[owner], sendTuples.data() + sdispls[owner]+ tt);
-            }
-        }
+        arena.Flush(tid);
     }
 
     // Step 4: Communicate data
@@ -731,21 +770,7 @@ std::vector< std::tuple<IT,IT,IT,NT> > Phase2(const AWPM_param<IT>& param, std::
     double t2Comp = MPI_Wtime() - tstart;
     tstart = MPI_Wtime();
     
-    std::vector<int> recvcnt (param.nprocs);
-    std::vector<int> rdispls (param.nprocs, 0);
-    
-    MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);
-    std::partial_sum(recvcnt.data(), recvcnt.data()+param.nprocs-1, rdispls.data()+1);
-    IT totrecv = std::accumulate(recvcnt.data(), recvcnt.data()+param.nprocs, static_cast<IT>(0));
-    
-
-    MPI_Datatype MPI_tuple;
-    MPI_Type_contiguous(sizeof(std::tuple<IT,IT,IT,NT>), MPI_CHAR, &MPI_tuple);
-    MPI_Type_commit(&MPI_tuple);
-    
-    std::vector< std::tuple<IT,IT,IT,NT> > recvTuples1(totrecv);
-    MPI_Alltoallv(sendTuples.data(), sendcnt.data(), sdispls.data(), MPI_tuple, recvTuples1.data(), recvcnt.data(), rdispls.data(), MPI_tuple, World);
-    MPI_Type_free(&MPI_tuple);
+    std::vector< std::tuple<IT,IT,IT,NT> > & recvTuples1 = arena.Exchange();
     double t2Comm = MPI_Wtime() - tstart;
     return recvTuples1;
 }
@@ -772,7 +797,7 @@ std::vector<std::vector<std::tuple<IT,IT, IT, NT>>> Phase2_old(const AWPM_param<
             // TODO: Add a function that returns the edge weight directly
             if (ele != dcsc->ir+colptr[mi - param.localColStart+1])
             {
-                NT cw = weight + RepMateWR2C[mj - param.localRowStart]; //w+W[M'[j],M[i]];
+                NT cw = weight + dcsc->numx[ele - dcsc->ir]; //w+W[M'[j],M[i]];
                 if (cw > 0)
                 {
                     IT j = RepMateR2C[mj - param.localRowStart];
@@ -910,6 +935,14 @@ void TwoThirdApprox(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow2
     ReplicateMateWeights(param, dcsc, colptr, RepMateC2R, RepMateWR2C, RepMateWC2R);
     
 	
+    // exchange buffers and best offer slots, reused in every iteration
+    AWPMArena<std::tuple<IT,IT,NT>> arena1(nprocs, World);
+    AWPMArena<std::tuple<IT,IT,IT,NT>> arena2(nprocs, World);
+    AWPMArena<std::tuple<IT,IT,IT,NT>> arena3(nprocs, World);
+    AWPMArena<std::tuple<IT,IT,IT,IT>> arena4(nprocs, World);
+    std::vector<IT> bestPhase3(lncol);
+    std::vector<IT> bestPhase4(lncol);
+    
 	int iterations = 0;
 	NT minw;
 	NT weightCur = MatchingWeight(RepMateWC2R, RowWorld, minw);
@@ -924,122 +957,171 @@ void TwoThirdApprox(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow2
 		// C requests
 		// each row is for a processor where C requests will be sent to
         double tstart = MPI_Wtime();
-        std::vector<std::tuple<IT,IT,NT>> recvTuples = Phase1(param, dcsc, colptr, RepMateR2C, RepMateC2R, RepMateWR2C, RepMateWC2R );
+        std::vector<std::tuple<IT,IT,NT>> & recvTuples = Phase1(param, dcsc, colptr, RepMateR2C, RepMateC2R, RepMateWR2C, RepMateWC2R, arena1 );
         tPhase1 += (MPI_Wtime() - tstart);
         tstart = MPI_Wtime();
-        
-        std::vector<std::tuple<IT,IT,IT,NT>> recvTuples1 = Phase2(param, recvTuples, dcsc, colptr, RepMateR2C, RepMateC2R, RepMateWR2C, RepMateWC2R );
-        std::vector< std::tuple<IT,IT,NT> >().swap(recvTuples);
+
+        std::vector<std::tuple<IT,IT,IT,NT>> & recvTuples1 = Phase2(param, recvTuples, dcsc, colptr, RepMateR2C, RepMateC2R, arena2 );
         tPhase2 += (MPI_Wtime() - tstart);
         tstart = MPI_Wtime();
-        
-        
-		std::vector<std::tuple<IT,IT,IT,NT>> bestTuplesPhase3 (lncol);
+
+
+		// Phase 3: best offer (mj, mi, i, weight) for every column j = M[mj]
+		// heavier offers win, ties go to the smaller (i, mi) so that the result does not depend on the thread schedule
 #ifdef THREADED
 #pragma omp parallel for
 #endif
-		for(int k=0; k<lncol; ++k)
+		for(IT k=0; k<lncol; ++k)
 		{
-			bestTuplesPhase3[k] = std::make_tuple(-1,-1,-1,0); // fix this
+			bestPhase3[k] = -1;
 		}
-		
-		for(int k=0; k<recvTuples1.size(); ++k)
+
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+		for(IT k=0; k<static_cast<IT>(recvTuples1.size()); ++k)
 		{
 			IT mj = std::get<0>(recvTuples1[k]) ;
-			IT mi = std::get<1>(recvTuples1[k]) ;
-			IT i = std::get<2>(recvTuples1[k]) ;
-			NT weight = std::get<3>(recvTuples1[k]);
 			IT j = RepMateR2C[mj - localRowStart];
 			IT lj = j - localColStart;
-			
-			// we can get rid of the first check if edge weights are non negative
-			if( (std::get<0>(bestTuplesPhase3[lj]) == -1)  || (weight > std::get<3>(bestTuplesPhase3[lj])) )
+			AWPMOffer(bestPhase3.data() + lj, k, [&recvTuples1](IT a, IT b)
+				{
+					const std::tuple<IT,IT,IT,NT> & ta = recvTuples1[a];
+					const std::tuple<IT,IT,IT,NT> & tb = recvTuples1[b];
+					if(std::get<3>(ta) != std::get<3>(tb)) return std::get<3>(ta) > std::get<3>(tb);
+					return std::make_pair(std::get<2>(ta), std::get<1>(ta)) < std::make_pair(std::get<2>(tb), std::get<1>(tb));
+				});
+		}
+
+		arena3.Reset();
+#ifdef THREADED
+#pragma omp parallel
+#endif
+		{
+			int tid = arena3.ThreadId();
+#ifdef THREADED
+#pragma omp for
+#endif
+			for(IT k=0; k<lncol; ++k)
 			{
-				bestTuplesPhase3[lj] = std::make_tuple(i,mi,mj,weight);
+				if(bestPhase3[k] != -1)
+				{
+					IT mi = std::get<1>(recvTuples1[bestPhase3[k]]) ;
+					IT i = std::get<2>(recvTuples1[bestPhase3[k]]) ;
+					arena3.Count(tid, AWPMOwner(param, i, mi));
+				}
 			}
+			arena3.AddCounts(tid);
 		}
-		
-		std::vector<std::vector<std::tuple<IT,IT, IT, NT>>> tempTuples1 (nprocs);
-		for(int k=0; k<lncol; ++k)
+		arena3.Allocate();
+#ifdef THREADED
+#pragma omp parallel
+#endif
 		{
-			if( std::get<0>(bestTuplesPhase3[k]) != -1)
+			int tid = arena3.ThreadId();
+#ifdef THREADED
+#pragma omp for
+#endif
+			for(IT k=0; k<lncol; ++k)
 			{
-				//IT j = RepMateR2C[mj - localRowStart]; /// fix me
-				
-				IT i = std::get<0>(bestTuplesPhase3[k]) ;
-				IT mi = std::get<1>(bestTuplesPhase3[k]) ;
-				IT mj = std::get<2>(bestTuplesPhase3[k]) ;
-				IT j = RepMateR2C[mj - localRowStart];
-				NT weight = std::get<3>(bestTuplesPhase3[k]);
-				int owner = OwnerProcs(A,  i, mi, nrows, ncols);
-                
-				tempTuples1[owner].push_back(std::make_tuple(i, j, mj, weight));
+				if(bestPhase3[k] != -1)
+				{
+					IT mj = std::get<0>(recvTuples1[bestPhase3[k]]) ;
+					IT mi = std::get<1>(recvTuples1[bestPhase3[k]]) ;
+					IT i = std::get<2>(recvTuples1[bestPhase3[k]]) ;
+					NT weight = std::get<3>(recvTuples1[bestPhase3[k]]);
+					IT j = RepMateR2C[mj - localRowStart];
+					arena3.Push(tid, AWPMOwner(param, i, mi), std::make_tuple(i, j, mj, weight));
+				}
 			}
+			arena3.Flush(tid);
 		}
-		//vector< tuple<IT,IT,IT, NT> >().swap(recvTuples1);
-		recvTuples1 = ExchangeData1(tempTuples1, World);
-		
+		std::vector<std::tuple<IT,IT,IT,NT>> & recvTuples3 = arena3.Exchange();
+
         tPhase3 += (MPI_Wtime() - tstart);
         tstart = MPI_Wtime();
-		
-		std::vector<std::tuple<IT,IT,IT,IT, NT>> bestTuplesPhase4 (lncol);
-		// we could have used lnrow in both bestTuplesPhase3 and bestTuplesPhase4
-		
+
 		// Phase 4
-		// at the owner of (i,mi)
+		// at the owner of (i,mi): best offer (i, j, mj, weight) for every column mi that did not make an offer in Phase 3
+		// we could have used lnrow in both bestPhase3 and bestPhase4
 #ifdef THREADED
 #pragma omp parallel for
 #endif
-		for(int k=0; k<lncol; ++k)
+		for(IT k=0; k<lncol; ++k)
 		{
-			bestTuplesPhase4[k] = std::make_tuple(-1,-1,-1,-1,0);
+			bestPhase4[k] = -1;
 		}
-		
-		for(int k=0; k<recvTuples1.size(); ++k)
+
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+		for(IT k=0; k<static_cast<IT>(recvTuples3.size()); ++k)
 		{
-			IT i = std::get<0>(recvTuples1[k]) ;
-			IT j = std::get<1>(recvTuples1[k]) ;
-			IT mj = std::get<2>(recvTuples1[k]) ;
+			IT i = std::get<0>(recvTuples3[k]) ;
 			IT mi = RepMateR2C[i-localRowStart];
-			NT weight = std::get<3>(recvTuples1[k]);
 			IT lmi = mi - localColStart;
-			//IT lj = j - localColStart;
-			
-			// cout <<"****" << i << " " << mi << " "<< j << " " << mj << " " << get<0>(bestTuplesPhase4[lj]) << endl;
-			// we can get rid of the first check if edge weights are non negative
-			if( ((std::get<0>(bestTuplesPhase4[lmi]) == -1)  || (weight > std::get<4>(bestTuplesPhase4[lmi]))) && std::get<0>(bestTuplesPhase3[lmi])==-1 )
+			if(bestPhase3[lmi] == -1)
 			{
-				bestTuplesPhase4[lmi] = std::make_tuple(i,j,mi,mj,weight);
-				//cout << "(("<< i << " " << mi << " "<< j << " " << mj << "))"<< endl;
+				AWPMOffer(bestPhase4.data() + lmi, k, [&recvTuples3](IT a, IT b)
+					{
+						const std::tuple<IT,IT,IT,NT> & ta = recvTuples3[a];
+						const std::tuple<IT,IT,IT,NT> & tb = recvTuples3[b];
+						if(std::get<3>(ta) != std::get<3>(tb)) return std::get<3>(ta) > std::get<3>(tb);
+						return std::make_pair(std::get<0>(ta), std::get<1>(ta)) < std::make_pair(std::get<0>(tb), std::get<1>(tb));
+					});
 			}
 		}
-		
-		
-		std::vector<std::vector<std::tuple<IT,IT,IT, IT>>> winnerTuples (nprocs);
-		
-		
-		for(int k=0; k<lncol; ++k)
+
+		// the winner goes to the owner of (mj,j) and, as the opposite of the matching, to the owner of (i,mi)
+		arena4.Reset();
+#ifdef THREADED
+#pragma omp parallel
+#endif
 		{
-			if( std::get<0>(bestTuplesPhase4[k]) != -1)
+			int tid = arena4.ThreadId();
+#ifdef THREADED
+#pragma omp for
+#endif
+			for(IT k=0; k<lncol; ++k)
 			{
-				//int owner = OwnerProcs(A,  get<0>(bestTuples[k]), get<1>(bestTuples[k]), nrows, ncols); // (i,mi)
-				//tempTuples[owner].push_back(bestTuples[k]);
-				IT i = std::get<0>(bestTuplesPhase4[k]) ;
-				IT j = std::get<1>(bestTuplesPhase4[k]) ;
-				IT mi = std::get<2>(bestTuplesPhase4[k]) ;
-				IT mj = std::get<3>(bestTuplesPhase4[k]) ;
-				
-				
-				int owner = OwnerProcs(A,  mj, j, nrows, ncols);
-				winnerTuples[owner].push_back(std::make_tuple(i, j, mi, mj));
-				
-				/// be very careful here
-				// passing the opposite of the matching to the owner of (i,mi)
-				owner = OwnerProcs(A,  i, mi, nrows, ncols);
-				winnerTuples[owner].push_back(std::make_tuple(mj, mi, j, i));
+				if(bestPhase4[k] != -1)
+				{
+					IT i = std::get<0>(recvTuples3[bestPhase4[k]]) ;
+					IT j = std::get<1>(recvTuples3[bestPhase4[k]]) ;
+					IT mj = std::get<2>(recvTuples3[bestPhase4[k]]) ;
+					IT mi = k + localColStart;
+					arena4.Count(tid, AWPMOwner(param, mj, j));
+					arena4.Count(tid, AWPMOwner(param, i, mi));
+				}
+			}
+			arena4.AddCounts(tid);
+		}
+		arena4.Allocate();
+#ifdef THREADED
+#pragma omp parallel
+#endif
+		{
+			int tid = arena4.ThreadId();
+#ifdef THREADED
+#pragma omp for
+#endif
+			for(IT k=0; k<lncol; ++k)
+			{
+				if(bestPhase4[k] != -1)
+				{
+					IT i = std::get<0>(recvTuples3[bestPhase4[k]]) ;
+					IT j = std::get<1>(recvTuples3[bestPhase4[k]]) ;
+					IT mj = std::get<2>(recvTuples3[bestPhase4[k]]) ;
+					IT mi = k + localColStart;
+					arena4.Push(tid, AWPMOwner(param, mj, j), std::make_tuple(i, j, mi, mj));
+					/// be very careful here
+					// passing the opposite of the matching to the owner of (i,mi)
+					arena4.Push(tid, AWPMOwner(param, i, mi), std::make_tuple(mj, mi, j, i));
+				}
 			}
+			arena4.Flush(tid);
 		}
-		std::vector<std::tuple<IT,IT,IT,IT>> recvWinnerTuples = ExchangeData1(winnerTuples, World);
+		std::vector<std::tuple<IT,IT,IT,IT>> & recvWinnerTuples = arena4.Exchange();
         tPhase4 += (MPI_Wtime() - tstart);
         tstart = MPI_Wtime();
 		
@@ -46,7 +46,6 @@
 #include <ctime>
 #include <cmath>
 #include "CombBLAS/CombBLAS.h"
-#include "CC.h"
 
 using namespace std;
 using namespace combblas;
@@ -99,6 +98,7 @@ int main(int argc, char* argv[])
             cout << "-I <INPUT FILE TYPE> (mm: matrix market, triples: (vtx1, vtx2, edge_weight) triples. default:mm)\n";
             cout << "-base <BASE OF MATRIX MARKET> (default:1)\n";
             cout << "-rand <RANDOMLY PERMUTE VERTICES> (default:0)\n";
+            cout << "-mode <dense|sparse|hybrid> (LACC communication, default:hybrid)\n";
             cout << "Example (0-indexed mtx with random permutation): ./cc -M input.mtx -base 0 -rand 1" << endl;
             cout << "Example (triples format): ./cc -I triples -M input.txt" << endl;
         }
@@ -110,6 +110,7 @@ int main(int argc, char* argv[])
         int base = 1;
         int randpermute = 1;
         bool isMatrixMarket = true;
+        LACCParams params;
         
         for (int i = 1; i < argc; i++)
         {
@@ -128,6 +129,13 @@ int main(int argc, char* argv[])
                 base = atoi(argv[i + 1]);
                 if(myrank == 0) printf("\nBase of MM (1 or 0):%d",base);
             }
+            else if (strcmp(argv[i],"-mode")==0)
+            {
+                string mode = string(argv[i+1]);
+                if(mode == "dense") params.mode = LACC_DENSE;
+                else if(mode == "sparse") params.mode = LACC_SPARSE;
+                if(myrank == 0) printf("\nLACC mode: %s",mode.c_str());
+            }
             else if (strcmp(argv[i],"-rand")==0)
             {
                 randpermute = atoi(argv[i + 1]);
@@ -193,7 +201,17 @@ int main(int argc, char* argv[])
         SpParHelper::Print(outs.str());
         double t1 = MPI_Wtime();
         int64_t nCC = 0;
-        FullyDistVec<int64_t, int64_t> cclabels = CC(A, nCC);
+        vector<LACCIteration> iterstats;
+        FullyDistVec<int64_t, int64_t> cclabels = LACCConnectedComponents(A, nCC, params, &iterstats);
+        for(size_t i=0; i< iterstats.size(); ++i)
+        {
+            outs.str("");
+            outs.clear();
+            outs << "Iteration: " << iterstats[i].iteration << (iterstats[i].dense? " (dense)" : " (sparse)") << " active: " << iterstats[i].active;
+            outs << " converged: " << iterstats[i].converged << " stars: " << iterstats[i].stars << " nonstars: " << iterstats[i].nonstars;
+            outs << " time: " << iterstats[i].time << endl;
+            SpParHelper::Print(outs.str());
+        }
         
         double t2 = MPI_Wtime();
 	string outname = ifilename + ".components";
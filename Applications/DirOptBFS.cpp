@@ -59,12 +59,10 @@ double cblas_allgathertime;
 double cblas_mergeconttime;
 double cblas_transvectime;
 double cblas_localspmvtime;
-double cblas_ewisemulttime;
 
 double bottomup_sendrecv;
 double bottomup_allgather;
 double bottomup_total;
-double bottomup_convert;
 
 double bu_local;
 double bu_update;
@@ -175,13 +173,12 @@ int main(int argc, char* argv[])
 		// Declare objects
 		PSpMat_Bool A;	
 		PSpMat_s32p64 Aeff;
-		PSpMat_s32p64 ALocalT;
+		DirOptBFS<int64_t, SpDCCols<int32_t,bool> > * bfs;
 		shared_ptr<CommGrid> fullWorld;
 		fullWorld.reset( new CommGrid(MPI_COMM_WORLD, 0, 0) );
 		FullyDistVec<int64_t, int64_t> degrees(fullWorld);	// degrees of vertices (including multi-edges and self-loops)
 		FullyDistVec<int64_t, int64_t> nonisov(fullWorld);	// id's of non-isolated (connected) vertices
 		unsigned scale;
-		OptBuf<int32_t, int64_t> optbuf;	// let indices be 32-bits
 
 		scale = static_cast<unsigned>(atoi(argv[1]));
 		ostringstream outs;
@@ -260,14 +257,24 @@ int main(int argc, char* argv[])
 		Symmetricize(Aeff);	// A += A';
 		SpParHelper::Print("Symmetricized\n");	
 		
-		Aeff.OptimizeForGraph500(optbuf);		// Should be called before threading is activated
-		ALocalT = PSpMat_s32p64(Aeff.seq().TransposeConstPtr(), Aeff.getcommgrid());	// this should be copied before the threading is activated
+		Aeff.PrintInfo();
+		float balance = Aeff.LoadImbalance();
+		ostringstream lbout;
+		lbout << "Load balance: " << balance << endl;
+		SpParHelper::Print(lbout.str());
+
+		int64_t num_edges = Aeff.getnnz();
+		int64_t num_nodes = Aeff.getncol();
+		DirOptBFSParams params;	// go bottom-up above nnz/20 frontier edges, and back below n*n/(12*nnz) frontier vertices
+		params.beta = 12.0 * static_cast<double>(num_edges) / static_cast<double>(num_nodes);
+
+		// optimization buffers, local transpose for the bottom-up steps and threading are set up by the library
+		bfs = new DirOptBFS<int64_t, SpDCCols<int32_t,bool> >(Aeff, params);
+		Aeff.FreeMemory();
 	#ifdef THREADED
 		tinfo << "Threading activated with " << cblas_splits << " threads" << endl;
 		SpParHelper::Print(tinfo.str());
-		Aeff.ActivateThreading(cblas_splits);	
 	#endif
-		Aeff.PrintInfo();
 			
 		MPI_Barrier(MPI_COMM_WORLD);
 		double t2=MPI_Wtime();
@@ -276,12 +283,6 @@ int main(int argc, char* argv[])
 		k1timeinfo << (t2-t1) - (redtf-redts) << " seconds elapsed for Kernel #1" << endl;
 		SpParHelper::Print(k1timeinfo.str());
 
-		Aeff.PrintInfo();
-		float balance = Aeff.LoadImbalance();
-		ostringstream lbout;
-		lbout << "Load balance: " << balance << endl;
-		SpParHelper::Print(lbout.str());
-
 		MPI_Barrier(MPI_COMM_WORLD);
 		t1 = MPI_Wtime();
 
@@ -329,11 +330,9 @@ int main(int argc, char* argv[])
 			cblas_mergeconttime = 0;
 			cblas_transvectime = 0;
 			cblas_localspmvtime = 0;
-			cblas_ewisemulttime = 0;
 			bottomup_sendrecv = 0;
 			bottomup_allgather  = 0;
 			bottomup_total = 0;
-			bottomup_convert = 0;
 			
 			bu_local = 0;
 			bu_update = 0;
@@ -346,103 +345,26 @@ int main(int argc, char* argv[])
 			for(int i=0; i<ITERS; ++i)
 			{
 				SpParHelper::Print("A BFS iteration is starting\n");
-				
-				// FullyDistVec ( shared_ptr<CommGrid> grid, IT globallen, NT initval);
-				FullyDistVec<int64_t, int64_t> parents ( Aeff.getcommgrid(), Aeff.getncol(), (int64_t) -1);	// identity is -1
 
-				// FullyDistSpVec ( shared_ptr<CommGrid> grid, IT glen);
-				FullyDistSpVec<int64_t, int64_t> fringe(Aeff.getcommgrid(), Aeff.getncol());	// numerical values are stored 0-based
-					
+				FullyDistVec<int64_t, int64_t> parents(A.getcommgrid());
+				FullyDistVec<int64_t, int64_t> levels(A.getcommgrid());
+				vector<DirOptBFSLevel> levelstats;
+
 				ostringstream devout;
 				devout.setf(ios::fixed);
+				devout << "param " << num_nodes << " vertices with " << num_edges << " edges" << endl;
 
 				MPI_Barrier(MPI_COMM_WORLD);
 				double t1 = MPI_Wtime();
+				int iterations = bfs->Run(Cands[i], parents, levels, &levelstats);
+				MPI_Barrier(MPI_COMM_WORLD);
+				double t2 = MPI_Wtime();
 
-				int64_t num_edges = Aeff.getnnz();
-				int64_t num_nodes = Aeff.getncol();
-				int64_t up_cutoff = num_edges / 20;
-				int64_t down_cutoff = (((double) num_nodes) * ((double)num_nodes)) / ((double) num_edges * 12.0);
-
-				devout << "param " << num_nodes << " vertices with " << num_edges << " edges" << endl;
-				devout << up_cutoff << " up and " << down_cutoff << " down" << endl;
-
-				fringe.SetElement(Cands[i], Cands[i]);
-				parents.SetElement(Cands[i], Cands[i]);
-				int iterations = 0;
-
-				BitMapFringe<int64_t,int64_t> bm_fringe(fringe.getcommgrid(), fringe);
-				BitMapCarousel<int64_t,int64_t> done(Aeff.getcommgrid(), parents.TotalLength(), bm_fringe.GetSubWordDisp());
-				SpDCCols<int,bool>::SpColIter *starts = CalcSubStarts(ALocalT, fringe, done);
-				int64_t fringe_size = fringe.getnnz();
-				int64_t last_fringe_size = 0;
-				double pred_start = MPI_Wtime();
-				fringe.Apply(myset<int64_t>(1));
-				int64_t pred = EWiseMult(fringe, degrees, false, (int64_t) 0).Reduce(plus<int64_t>(), (int64_t) 0);
-				double pred_end = MPI_Wtime();
-				devout << "  s" << setw(15) << pred << setw(15) << setprecision(5) << (pred_end - pred_start) << endl;
-				cblas_ewisemulttime += (pred_end - pred_start); 
-
-				while(fringe_size > 0) 
+				for(size_t l=0; l< levelstats.size(); ++l)
 				{
-					if ((pred > up_cutoff) && (last_fringe_size < fringe_size)) 
-					{   // Bottom-up
-						MPI_Barrier(MPI_COMM_WORLD);
-						double conv_start = MPI_Wtime();
-						done.LoadVec(parents);
-						bm_fringe.LoadFromSpVec(fringe);
-						double conv_end = MPI_Wtime();
-						devout << "  c" << setw(30) << setprecision(5) << (conv_end - conv_start) << endl;
-						bottomup_convert += (conv_end - conv_start);
-
-						while (fringe_size > 0) 		
-						{
-							double step_start = MPI_Wtime();
-							BottomUpStep(ALocalT, fringe, bm_fringe, parents, done, starts);
-							double step_end = MPI_Wtime();
-
-							devout << setw(2) << iterations << "u" << setw(15) << fringe_size << setprecision(5) << setw(15) << (step_end-step_start) << endl;
-							bottomup_total += (step_end-step_start);
-							iterations++;
-							last_fringe_size = fringe_size;
-							fringe_size = bm_fringe.GetNumSet();
-							if ((fringe_size < down_cutoff) && (last_fringe_size > fringe_size)) 
-							{
-								conv_start = MPI_Wtime();
-								bm_fringe.UpdateSpVec(fringe);
-								conv_end = MPI_Wtime();
-								devout << "  c" << setw(30) << setprecision(5) << (conv_end - conv_start) << endl;
-								bottomup_convert += (conv_end - conv_start);
-								break;
-							}
-						}
-					} 
-					else 
-					{   // Top-down
-						double step_start = MPI_Wtime();
-						fringe.setNumToInd();
-						fringe = SpMV(Aeff, fringe,optbuf);
-						double ewise_start = MPI_Wtime();
-						fringe = EWiseMult(fringe, parents, true, (int64_t) -1);
-						parents.Set(fringe);
-						double step_end = MPI_Wtime();
-						devout << setw(2) << iterations << "d" << setw(15) << fringe.getnnz() << setw(15) << setprecision(5) << (step_end-step_start) << endl;
-						cblas_ewisemulttime += (step_end - ewise_start); 
-
-						pred_start = MPI_Wtime();
-						fringe.Apply(myset<int64_t>(1));
-						pred = EWiseMult(fringe, degrees, false, (int64_t) 0).Reduce(plus<int64_t>(), (int64_t) 0);
-						pred_end = MPI_Wtime();
-						devout << "  s" << setw(15) << pred << setw(15) << setprecision(5) << (pred_end - pred_start) << endl;
-						cblas_ewisemulttime += (pred_end - pred_start); 
-						iterations++;
-						last_fringe_size = fringe_size;
-						fringe_size = fringe.getnnz();
-					}
+					devout << setw(2) << levelstats[l].level << (levelstats[l].bottomup? "u" : "d") << setw(15) << levelstats[l].frontier << setprecision(5) << setw(15) << levelstats[l].time << endl;
+					if(levelstats[l].bottomup)	bottomup_total += levelstats[l].time;
 				}
-				MPI_Barrier(MPI_COMM_WORLD);
-				double t2 = MPI_Wtime();
-				delete[] starts;
 				SpParHelper::Print(devout.str());
 				
 				FullyDistSpVec<int64_t, int64_t> parentsp = parents.Find(bind2nd(greater<int64_t>(), -1));
@@ -467,33 +389,28 @@ int main(int argc, char* argv[])
 			MPI_Pcontrol(-1,"BFS");
 			SpParHelper::Print("Finished\n");
 #ifdef TIMING
-			double * bu_total, *bu_ag_all, *bu_sr_all, *bu_convert, *td_ag_all, *td_a2a_all, *td_tv_all, *td_mc_all, *td_spmv_all, *td_ewm_all;
+			double * bu_total, *bu_ag_all, *bu_sr_all, *td_ag_all, *td_a2a_all, *td_tv_all, *td_mc_all, *td_spmv_all;
 			if(myrank == 0)
 			{
 				bu_total = new double[nprocs];
 				bu_ag_all = new double[nprocs];
 				bu_sr_all = new double[nprocs];
-				bu_convert = new double[nprocs];
 				td_ag_all = new double[nprocs];
 				td_a2a_all = new double[nprocs];
 				td_tv_all = new double[nprocs];
 				td_mc_all = new double[nprocs];
 				td_spmv_all = new double[nprocs];
-				td_ewm_all = new double[nprocs];
 			}
 			bottomup_allgather /= static_cast<double>(ITERS);
 			bottomup_sendrecv /= static_cast<double>(ITERS);
 			bottomup_total /= static_cast<double>(ITERS);
-			bottomup_convert /= static_cast<double>(ITERS);	// conversion not included in total time
 			
 			cblas_allgathertime /= static_cast<double>(ITERS);
 			cblas_alltoalltime /= static_cast<double>(ITERS);
 			cblas_transvectime /= static_cast<double>(ITERS);
 			cblas_mergeconttime /= static_cast<double>(ITERS);
 			cblas_localspmvtime /= static_cast<double>(ITERS);
-			cblas_ewisemulttime /= static_cast<double>(ITERS);
 			
-			MPI_Gather(&bottomup_convert, 1, MPI_DOUBLE, bu_convert, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 			MPI_Gather(&bottomup_total, 1, MPI_DOUBLE, bu_total, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 			MPI_Gather(&bottomup_allgather, 1, MPI_DOUBLE, bu_ag_all, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 			MPI_Gather(&bottomup_sendrecv, 1, MPI_DOUBLE, bu_sr_all, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
@@ -502,7 +419,6 @@ int main(int argc, char* argv[])
 			MPI_Gather(&cblas_transvectime, 1, MPI_DOUBLE, td_tv_all, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 			MPI_Gather(&cblas_mergeconttime, 1, MPI_DOUBLE, td_mc_all, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 			MPI_Gather(&cblas_localspmvtime, 1, MPI_DOUBLE, td_spmv_all, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-			MPI_Gather(&cblas_ewisemulttime, 1, MPI_DOUBLE, td_ewm_all, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 
 			double bu_local_total = 0;
 			double bu_update_total = 0;
@@ -520,7 +436,7 @@ int main(int argc, char* argv[])
 
 				vector<double> total_time(nprocs, 0);
 				for(int i=0; i< nprocs; ++i) 				// find the mean performing guy
-					total_time[i] += bu_total[i] + bu_convert[i] + td_ag_all[i] +  td_a2a_all[i] + td_tv_all[i] + td_mc_all[i] + td_spmv_all[i] + td_ewm_all[i];
+					total_time[i] += bu_total[i] + td_ag_all[i] +  td_a2a_all[i] + td_tv_all[i] + td_mc_all[i] + td_spmv_all[i];
                 
 				vector<size_t> permutation = SpHelper::find_order(total_time);
 				size_t smallest = permutation[0];
@@ -533,7 +449,6 @@ int main(int argc, char* argv[])
 				cout << "TOTAL (accounted) MEDIAN: " << total_time[nprocs/2] << endl;
 				cout << "-------------------------------" << endl;
 				
-				cout << "Convert median: " << bu_convert[median] << endl;
 				cout << "Bottom-up allgather median: " << bu_ag_all[median] << endl;
 				cout << "Bottom-up send-recv median: " << bu_sr_all[median] << endl;
 				cout << "Bottom-up compute median: " << bu_total[median] - (bu_ag_all[median] + bu_sr_all[median]) << endl;
@@ -544,7 +459,6 @@ int main(int argc, char* argv[])
 				cout << "Top-down spmsv median: " << td_spmv_all[median] << endl;
 				cout << "-------------------------------" << endl;
 				
-				cout << "Convert MEAN: " << accumulate( bu_convert, bu_convert+nprocs, 0.0 )/ static_cast<double> (nprocs) << endl;
 				cout << "Bottom-up total MEAN: " << accumulate( bu_total, bu_total+nprocs, 0.0 )/ static_cast<double> (nprocs) << endl;
 				cout << "Bottom-up allgather MEAN: " << accumulate( bu_ag_all, bu_ag_all+nprocs, 0.0 )/ static_cast<double> (nprocs) << endl;
 				cout << "Bottom-up send-recv MEAN: " << accumulate( bu_sr_all, bu_sr_all+nprocs, 0.0 )/ static_cast<double> (nprocs) << endl;
@@ -624,6 +538,7 @@ int main(int argc, char* argv[])
 			os << "Harmonic standard deviation of MTEPS: " << deviation << endl;
 			SpParHelper::Print(os.str());
 		}
+		delete bfs;
 	}
 	MPI_Finalize();
 	return 0;
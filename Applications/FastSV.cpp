@@ -47,7 +47,6 @@
 #include <cmath>
 #include <chrono>
 #include "CombBLAS/CombBLAS.h"
-#include "FastSV.h"
 
 using namespace std;
 using namespace combblas;
@@ -101,6 +100,7 @@ int main(int argc, char* argv[])
             cout << "-I <INPUT FILE TYPE> (mm: matrix market, triples: (vtx1, vtx2, edge_weight) triples. default:mm)\n";
             cout << "-base <BASE OF MATRIX MARKET> (default:1)\n";
             cout << "-rand <RANDOMLY PERMUTE VERTICES> (default:0)\n";
+            cout << "-switch <FRACTION> (sparse iterations once fewer grandparents change, default:0.02)\n";
             cout << "Example (0-indexed mtx with random permutation): ./fastsv -M input.mtx -base 0 -rand 1" << endl;
             cout << "Example (triples format): ./fastsv -I triples -M input.txt" << endl;
         }
@@ -113,6 +113,7 @@ int main(int argc, char* argv[])
         int randpermute = 0;
         int step = 1;
         bool isMatrixMarket = true;
+        FastSVParams params;
 
         for (int i = 1; i < argc; i++)
         {
@@ -136,6 +137,11 @@ int main(int argc, char* argv[])
                 randpermute = atoi(argv[i + 1]);
                 if(myrank == 0) printf("\nRandomly permute the matrix? (1 or 0):%d\n",randpermute);
             }
+            else if (strcmp(argv[i],"-switch")==0)
+            {
+                params.denseswitch = atof(argv[i + 1]);
+                if(myrank == 0) printf("\nDense/sparse switch: %f\n", params.denseswitch);
+            }
             else if (strcmp(argv[i],"-step")==0)
             {
                 step = atoi(argv[i + 1]);
@@ -205,7 +211,16 @@ int main(int argc, char* argv[])
         double t1 = MPI_Wtime();
 
         Int nCC = 0;
-        FullyDistVec<Int, Int> cclabels = SV(A, nCC);
+        vector<FastSVIteration> iterstats;
+        FullyDistVec<Int, Int> cclabels = FastSVConnectedComponents(A, nCC, params, &iterstats);
+        for(size_t i=0; i< iterstats.size(); ++i)
+        {
+            outs.str("");
+            outs.clear();
+            outs << "Iteration: " << iterstats[i].iteration << (iterstats[i].dense? " (dense)" : " (sparse)");
+            outs << " changed: " << iterstats[i].changed << " time: " << iterstats[i].time << endl;
+            SpParHelper::Print(outs.str());
+        }
 
         double t2 = MPI_Wtime();
         //outs.str("");
@@ -118,6 +118,8 @@ typedef struct
     bool is64bInt; // true: int64_t for local indexing, false: int32_t (for local indexing)
     int layers; // Number of layers to use in communication avoiding SpGEMM. 
     int compute;
+    bool pipelined; // overlap SUMMA broadcasts with local computation
+    bool fusedSelect; // truncate columns to the selection while the expansion is computed
     
     //debugging
     bool show;
@@ -156,6 +158,8 @@ void InitParam(HipMCLParam & param)
     param.compute = 1; // 1 means hash-based computation, 2 means heap-based computation
     param.phases = 1;
     param.perProcessMem = 0;
+    param.pipelined = false;
+    param.fusedSelect = false;
     param.isDoublePrecision = true;
     param.is64bInt = true;
     
@@ -217,6 +221,8 @@ void ShowParam(HipMCLParam & param)
     runinfo << "    Memory avilable per process: ";
     if(param.perProcessMem>0) runinfo << param.perProcessMem << "GB" << endl;
     else runinfo << "not provided" << endl;
+    runinfo << "    Pipelined SUMMA broadcasts: " << (param.pipelined? "yes" : "no") << endl;
+    runinfo << "    Fused expansion and selection: " << (param.fusedSelect? "yes" : "no") << endl;
     if(param.isDoublePrecision) runinfo << "Using double precision floating point" << endl;
     else runinfo << "Using single precision floating point" << endl;
     if(param.is64bInt ) runinfo << "Using 64 bit local indexing" << endl;
@@ -293,6 +299,12 @@ void ProcessParam(int argc, char* argv[], HipMCLParam & param)
         else if (strcmp(argv[i],"-per-process-mem")==0) {
             param.perProcessMem = atoi(argv[i + 1]);
         }
+        else if (strcmp(argv[i],"--pipeline")==0) {
+            param.pipelined = true;
+        }
+        else if (strcmp(argv[i],"--fused-select")==0) {
+            param.fusedSelect = true;
+        }
         else if (strcmp(argv[i],"--single-precision")==0) {
             param.isDoublePrecision = false;
         }
@@ -343,10 +355,12 @@ void ShowOptions()
     runinfo << "    --preprune : if provided, apply prune/select/recovery before the first iteration (needed when dense columns are present) (default: don't preprune. However, if the average nonzero per column is larger than max{S,R}, prepruning is still applied by default)\n";
     
     runinfo << "HipMCL optimization" << endl;
-    runinfo << "    -layers <number of layers> (default:1)\n";
+    runinfo << "    -layers <number of layers, 0 to let the SpGEMM cost model choose> (default:1)\n";
     runinfo << "    -compute <1 or 2> (default:1)\n";
     runinfo << "    -phases <number of phases> (default:1)\n";
     runinfo << "    -per-process-mem <memory (GB) available per process> (default:0, number of phases is not estimated)\n";
+    runinfo << "    --pipeline : if provided, overlap the SUMMA broadcasts of the next stage with the current local multiplication (default: no overlap)\n";
+    runinfo << "    --fused-select : if provided, keep only the columnwise top max(S,R) entries of each phase of the expansion before pruning it, while computing it on a 1x1 grid (default: prune after each phase)\n";
     runinfo << "    --single-precision (if not provided, use double precision floating point numbers)\n" << endl;
     runinfo << "    --32bit-local-index (if not provided, use 64 bit indexing for vertex ids)\n" << endl;
     
@@ -552,9 +566,21 @@ FullyDistVec<IT, IT> HipMCL(SpParMat<IT,NT,DER> & A, HipMCLParam & param)
     // it is in the range {0,1} for stochastic matrices
     NT chaos = 1;
     int it=1;
+    SUMMAPipelineStats pipestats;
     double tInflate = 0;
     double tExpand = 0;
     typedef PlusTimesSRing<NT, NT> PTFF;
+    if(param.layers == 0)
+    {
+        // the iterates stay in 3D, so only the conversion of the input is charged
+        SpGEMMLayoutParams lparams;
+        lparams.convertoutput = false;
+        SpGEMMLayout layout = PlanSpGEMMLayout(A, A, lparams);
+        param.layers = layout.layers;
+        ostringstream outs;
+        outs << "Planned " << param.layers << " layer(s) for " << layout.flops << " flops and an estimated " << static_cast<IT>(layout.nnzC) << " nonzeros per expansion" << endl;
+        SpParHelper::Print(outs.str());
+    }
 	SpParMat3D<IT,NT,DER> A3D_cs(param.layers);
 	if(param.layers > 1) {
     	SpParMat<IT,NT,DER> A2D_cs = SpParMat<IT, NT, DER>(A);
@@ -571,7 +597,7 @@ FullyDistVec<IT, IT> HipMCL(SpParMat<IT,NT,DER> & A, HipMCLParam & param)
         double t1 = MPI_Wtime();
         //A.Square<PTFF>() ;        // expand
 		if(param.layers == 1){
-			A = MemEfficientSpGEMM<PTFF, NT, DER>(A, A, param.phases, param.prunelimit, (IT)param.select, (IT)param.recover_num, param.recover_pct, param.kselectVersion, 1, param.perProcessMem);
+			A = MemEfficientSpGEMM<PTFF, NT, DER>(A, A, param.phases, param.prunelimit, (IT)param.select, (IT)param.recover_num, param.recover_pct, param.kselectVersion, 1, param.perProcessMem, param.pipelined, &pipestats, param.fusedSelect);
 		}
 		else{
 			A3D_cs = MemEfficientSpGEMM3D<PTFF, NT, DER, IT, NT, NT, DER, DER >(
@@ -631,6 +657,14 @@ FullyDistVec<IT, IT> HipMCL(SpParMat<IT,NT,DER> & A, HipMCLParam & param)
         
     }
     
+    if(param.pipelined && param.layers == 1)
+    {
+        stringstream s;
+        s << "Pipelined SUMMA: " << pipestats.hiddenstages << " of " << pipestats.stages << " stages fully hidden behind computation, "
+          << pipestats.exposedcomm << " s exposed broadcast wait, " << pipestats.overlapwindow << " s overlap window" << endl;
+        SpParHelper::Print(s.str());
+    }
+    
     
 #ifdef TIMING    
     double tcc1 = MPI_Wtime();
@@ -0,0 +1,181 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <numeric>
+#include "CombBLAS/CombBLAS.h"
+#include "../Applications/BipartiteMatchings/BPMaximalMatching.h"
+#include "../Applications/BipartiteMatchings/BPMaximumMatching.h"
+#include "../Applications/BipartiteMatchings/ApproxWeightPerfectMatching.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+
+// splitmix64, so that every nonzero gets a distinct weight whatever the number of processes
+uint64_t Mix(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Every process can recompute the kth nonzero of the test matrix: the diagonal first, then every random edge
+// in both directions (with different weights) so that there are cycles to augment
+struct TestMatrix
+{
+    int64_t n, nnz, nedges;
+    uint64_t salt;
+    TestMatrix(int64_t n_, int64_t edgefactor, uint64_t salt_): n(n_), nnz(n_ * (2*edgefactor + 1)), nedges(n_ * edgefactor), salt(salt_) {}
+    int64_t Row(int64_t k) const { return k < n ? k : static_cast<int64_t>(Mix(salt + 2*((k-n) % nedges) + (k-n) / nedges) % n); }
+    int64_t Col(int64_t k) const { return k < n ? k : static_cast<int64_t>(Mix(salt + 2*((k-n) % nedges) + 1 - (k-n) / nedges) % n); }
+    double Val(int64_t k) const { return (Mix(salt + k + 2*nnz) >> 11) * (1.0 / 9007199254740992.0) + 1e-3; }
+
+    PSpMat_Double Build(shared_ptr<CommGrid> grid) const
+    {
+        FullyDistVec<int64_t,int64_t> rows(grid, nnz, 0), cols(grid, nnz, 0);
+        FullyDistVec<int64_t,double> vals(grid, nnz, 0.0);
+        TestMatrix M(*this);
+        rows.ApplyInd([M](int64_t, int64_t k){ return M.Row(k); });
+        cols.ApplyInd([M](int64_t, int64_t k){ return M.Col(k); });
+        vals.ApplyInd([M](double, int64_t k){ return M.Val(k); });
+        return PSpMat_Double(n, n, rows, cols, vals, true);
+    }
+    // dense copy, 0 for no edge (all weights are positive)
+    vector< vector<double> > Dense() const
+    {
+        vector< vector<double> > W(n, vector<double>(n, 0.0));
+        for(int64_t k = 0; k < nnz; ++k)
+            W[Row(k)][Col(k)] += Val(k);
+        return W;
+    }
+};
+
+// Serial reference for tiny matrices: the weight of a maximum weight perfect matching, by enumeration
+double BruteForceMaxWeight(const vector< vector<double> > & W)
+{
+    int64_t n = W.size();
+    vector<int64_t> perm(n);
+    iota(perm.begin(), perm.end(), 0);
+    double best = 0;
+    do
+    {
+        double w = 0;
+        int64_t i = 0;
+        for(; i < n && W[i][perm[i]] > 0; ++i)
+            w += W[i][perm[i]];
+        if(i == n) best = max(best, w);
+    } while(next_permutation(perm.begin(), perm.end()));
+    return best;
+}
+
+// TwoThirdApprox stops when no augmenting 4-cycle is left (tiny matrices converge well within its iteration limit):
+// swapping the mates of two rows must not increase the weight
+bool NoAugmentingFourCycle(const vector< vector<double> > & W, const vector<int64_t> & mate)
+{
+    int64_t n = W.size();
+    for(int64_t r1 = 0; r1 < n; ++r1)
+        for(int64_t r2 = r1+1; r2 < n; ++r2)
+        {
+            double w1 = W[r1][mate[r2]], w2 = W[r2][mate[r1]];
+            if(w1 > 0 && w2 > 0 && w1 + w2 > W[r1][mate[r1]] + W[r2][mate[r2]] + 1e-12)
+                return false;
+        }
+    return true;
+}
+
+// Runs TwoThirdApprox from the diagonal matching; checks that the result is a perfect matching that is at least as heavy
+bool RunFromDiagonal(PSpMat_Double & A, FullyDistVec<int64_t,int64_t> & mateRow2Col, FullyDistVec<int64_t,int64_t> & mateCol2Row,
+                     double & startWeight, double & weight)
+{
+    int64_t n = A.getnrow();
+    mateRow2Col.iota(n, 0);
+    mateCol2Row.iota(n, 0);
+    startWeight = MatchingWeight(A, mateRow2Col, mateCol2Row);
+    TwoThirdApprox(A, mateRow2Col, mateCol2Row);
+    weight = MatchingWeight(A, mateRow2Col, mateCol2Row);
+    bool perfect = CheckMatching(mateRow2Col, mateCol2Row) && (mateRow2Col.Count([](int64_t m){ return m == -1; }) == 0);
+    return perfect && (weight >= startWeight * (1 - 1e-12));
+}
+
+// Checks TwoThirdApprox on a random matrix with a full diagonal and no weight ties, and on tiny matrices
+// against an exhaustive search
+int main(int argc, char* argv[])
+{
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+    int nprocs, myrank;
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./AWPMTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./AWPMTest 12 8" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        shared_ptr<CommGrid> grid(new CommGrid(MPI_COMM_WORLD, 0, 0));
+        FullyDistVec<int64_t,int64_t> mateRow2Col(grid), mateCol2Row(grid);
+        double startWeight, weight;
+
+        TestMatrix M(int64_t(1) << atoi(argv[1]), atoi(argv[2]), 0);
+        PSpMat_Double A = M.Build(grid);
+        double t1 = MPI_Wtime();
+        bool correct = RunFromDiagonal(A, mateRow2Col, mateCol2Row, startWeight, weight);
+        double t2 = MPI_Wtime();
+        ostringstream outs;
+        outs << "Matching weight: initial " << startWeight << ", TwoThirdApprox " << weight << " in " << t2-t1 << " s" << endl;
+        SpParHelper::Print(outs.str());
+        if(correct)
+            SpParHelper::Print("Approximate weight perfect matching working correctly\n");
+        else
+            SpParHelper::Print("ERROR in approximate weight perfect matching, go fix it!\n");
+
+        // tiny matrices: no augmenting 4-cycle is left and the weight is at most the optimum found by enumeration
+        bool tinycorrect = true;
+        for(int64_t n = 4; n <= 8; ++n)
+        {
+            for(uint64_t salt = 1; salt <= 4; ++salt)
+            {
+                TestMatrix T(n, 1, salt * 1000003);
+                PSpMat_Double B = T.Build(grid);
+                bool ok = RunFromDiagonal(B, mateRow2Col, mateCol2Row, startWeight, weight);
+                vector<int64_t> mate(n);
+                for(int64_t i = 0; i < n; ++i)
+                    mate[i] = mateRow2Col.GetElement(i);
+                vector< vector<double> > W = T.Dense();
+                double optimum = BruteForceMaxWeight(W);
+                ok = ok && NoAugmentingFourCycle(W, mate) && weight <= optimum * (1 + 1e-12);
+                if(!ok)
+                {
+                    ostringstream errs;
+                    errs << "n = " << n << ", salt " << salt << ": TwoThirdApprox " << weight << " from " << startWeight << ", optimum " << optimum << endl;
+                    SpParHelper::Print(errs.str());
+                }
+                tinycorrect = tinycorrect && ok;
+            }
+        }
+        if(tinycorrect)
+            SpParHelper::Print("Approximate weight perfect matching on tiny matrices working correctly\n");
+        else
+            SpParHelper::Print("ERROR in approximate weight perfect matching on tiny matrices, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
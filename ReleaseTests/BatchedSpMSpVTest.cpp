@@ -0,0 +1,108 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+// Compares every output of the batched SpMSpV with a single-vector SpMV
+template <typename SR, typename PSPMAT>
+bool CheckBatch(const PSPMAT & A, const vector< FullyDistSpVec<int64_t,double> > & x, const vector< FullyDistSpVec<int64_t,double> > & y)
+{
+    bool correct = (x.size() == y.size());
+    for(size_t j=0; j< x.size() && correct; ++j)
+    {
+        FullyDistSpVec<int64_t, double> control(A.getcommgrid(), A.getnrow());
+        SpMV<SR>(A, x[j], control, false);
+        correct = (control == y[j]);
+    }
+    return correct;
+}
+
+// Checks the batched multi-source SpMSpV against k single-vector SpMVs on a generated R-MAT matrix
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 4)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./BatchedSpMSpVTest <Scale> <Edgefactor> <Sources>" << endl;
+            cout << "Example: ./BatchedSpMSpVTest 14 16 64" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        unsigned scale = static_cast<unsigned>(atoi(argv[1]));
+        unsigned edgefactor = static_cast<unsigned>(atoi(argv[2]));
+        int nsources = atoi(argv[3]);
+        typedef PlusTimesSRing<double, double> PTDD;
+        typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+
+        double initiator[4] = {.57, .19, .19, .05};
+        DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+        DEL->GenGraph500Data(initiator, scale, edgefactor, true, true);
+        PSpMat_Double A(*DEL, false);
+        delete DEL;
+
+        // frontiers of different densities, including an empty one
+        vector< FullyDistSpVec<int64_t,double> > x;
+        for(int j=0; j< nsources; ++j)
+        {
+            int64_t stride = (j == nsources-1)? A.getncol()+1 : 1 + (j * 997) % 4099;
+            int64_t shift = j;
+            FullyDistVec<int64_t, double> dense(A.getcommgrid(), A.getncol(), 0.0);
+            dense.ApplyInd([stride, shift](double val, int64_t ind){ return ((ind + shift) % stride == 0)? static_cast<double>(1 + ind % 5) : 0.0; });
+            x.push_back(FullyDistSpVec<int64_t, double>(dense));
+        }
+
+        vector< FullyDistSpVec<int64_t,double> > y;
+        SpMSpVBatchBuf<double,double> batchbuf;
+        PreAllocatedSPA<double> SPA;
+        SpMSpVBatch<PTDD>(A, x, y, batchbuf, SPA);
+        if(CheckBatch<PTDD>(A, x, y))
+            SpParHelper::Print("Batched SpMSpV working correctly\n");
+        else
+            SpParHelper::Print("ERROR in batched SpMSpV, go fix it!\n");
+
+        // second iteration reuses the buffers, with the outputs fed back as (aliased) inputs
+        vector< FullyDistSpVec<int64_t,double> > yprev(y);
+        SpMSpVBatch<PTDD>(A, y, y, batchbuf, SPA);
+        if(CheckBatch<PTDD>(A, yprev, y))
+            SpParHelper::Print("Batched SpMSpV with reused buffers working correctly\n");
+        else
+            SpParHelper::Print("ERROR in batched SpMSpV with reused buffers, go fix it!\n");
+
+        if(cblas_splits > 1)
+        {
+            // row splitting is only implemented for boolean matrices (as in the BFS codes)
+            typedef SelectMaxSRing<bool, double> SMBD;
+            SpParMat<int64_t, bool, SpDCCols<int64_t,bool> > ABool(A);
+            ABool.ActivateThreading(cblas_splits);
+            vector< FullyDistSpVec<int64_t,double> > ythreaded;
+            SpMSpVBatch<SMBD>(ABool, x, ythreaded);
+            if(CheckBatch<SMBD>(ABool, x, ythreaded))
+                SpParHelper::Print("Multithreaded batched SpMSpV working correctly\n");
+            else
+                SpParHelper::Print("ERROR in multithreaded batched SpMSpV, go fix it!\n");
+        }
+    }
+    MPI_Finalize();
+    return 0;
+}
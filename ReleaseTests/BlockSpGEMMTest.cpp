@@ -0,0 +1,97 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+typedef PlusTimesSRing<double, double> PTFF;
+
+// Streams the blocks of A*A' with inner-dimension blocking and checks each one, and a thresholded count, against the full product
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 6)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./BlockSpGEMMTest <Scale> <Edgefactor> <br> <bc> <bi>" << endl;
+            cout << "Example: ./BlockSpGEMMTest 10 8 3 2 3" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        int scale = atoi(argv[1]);
+        int edgefactor = atoi(argv[2]);
+        int br = atoi(argv[3]);
+        int bc = atoi(argv[4]);
+        int bi = atoi(argv[5]);
+
+        PSpMat_Double A(MPI_COMM_WORLD);
+        A.GenGraph500Data(scale, edgefactor);
+        PSpMat_Double B = A;
+        B.Transpose();
+        PSpMat_Double C = Mult_AnXBn_Synch<PTFF, double, SpDCCols<int64_t,double> >(A, B);
+        double threshold = 2.0;
+        PSpMat_Double CKept = C;
+        CKept.Prune([threshold](double v){ return v < threshold; });
+
+        BlockSpGEMM<int64_t, double, SpDCCols<int64_t,double>, double, SpDCCols<int64_t,double> > bspgemm(A, B, br, bc, bi);
+        vector<int64_t> roffsets = bspgemm.getBlockOffsets(true);
+        vector<int64_t> coffsets = bspgemm.getBlockOffsets(false);
+
+        bool correct = true;
+        int nblocks = 0;
+        int64_t kept = 0;
+        SUMMAPipelineStats pipestats;
+        bspgemm.streamBlocks<PTFF, double, SpDCCols<int64_t,double> >(
+            [&](PSpMat_Double & Cblock, int64_t roffset, int64_t coffset)
+            {
+                int rbid = nblocks / bc, cbid = nblocks % bc;
+                ++nblocks;
+                FullyDistVec<int64_t,int64_t> ri(C.getcommgrid()), ci(C.getcommgrid());
+                ri.iota(roffsets[rbid+1] - roffsets[rbid], roffsets[rbid]);
+                ci.iota(coffsets[cbid+1] - coffsets[cbid], coffsets[cbid]);
+                if(roffset != roffsets[rbid] || coffset != coffsets[cbid] || !(Cblock == C(ri, ci))) correct = false;
+                Cblock.Prune([threshold](double v){ return v < threshold; });	// keep only the similar pairs
+                kept += Cblock.getnnz();
+            }, &pipestats);
+        if(nblocks != br*bc || kept != CKept.getnnz() || bspgemm.hasNext()) correct = false;
+
+        // the same blocks on demand
+        int64_t roffset, coffset;
+        PSpMat_Double CLast = bspgemm.getBlockId<PTFF, double, SpDCCols<int64_t,double> >(br-1, bc-1, roffset, coffset);
+        FullyDistVec<int64_t,int64_t> ri(C.getcommgrid()), ci(C.getcommgrid());
+        ri.iota(roffsets[br] - roffsets[br-1], roffsets[br-1]);
+        ci.iota(coffsets[bc] - coffsets[bc-1], coffsets[bc-1]);
+        if(!(CLast == C(ri, ci)) || roffset != roffsets[br-1] || coffset != coffsets[bc-1]) correct = false;
+
+        ostringstream outs;
+        outs << nblocks << " blocks, " << kept << " of " << C.getnnz() << " entries kept, " << pipestats.hiddenstages << " of " << pipestats.stages << " stages hidden" << endl;
+        SpParHelper::Print(outs.str());
+
+        if(correct)
+            SpParHelper::Print("Streaming block SpGEMM working correctly\n");
+        else
+            SpParHelper::Print("ERROR in streaming block SpGEMM, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
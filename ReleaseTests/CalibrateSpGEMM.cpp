@@ -0,0 +1,115 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+// Calibrates the per-column cost model of LocalHybridSpGEMM on this machine, saves it,
+// and checks that every accumulator (and the calibrated selection) gives the same product
+// Point COMBBLAS_SPGEMM_MODEL to the saved file to use it from any CombBLAS application
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 2)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./CalibrateSpGEMM <modelfile> [nrow] [ncolB]" << endl;
+            cout << "Example: ./CalibrateSpGEMM spgemm_model.txt 16384 2048" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        string modelname(argv[1]);
+        int64_t nrow = (argc > 2)? atoll(argv[2]) : 16384;
+        int64_t ncolB = (argc > 3)? atoll(argv[3]) : 2048;
+        typedef PlusTimesSRing<double, double> PTDD;
+
+        double t0 = MPI_Wtime();
+        LocalSpGEMMCostModel model;
+        CalibrateLocalSpGEMM<int64_t, double>(model, nrow, ncolB);
+        double t1 = MPI_Wtime();
+
+        ostringstream outs;
+        outs << "Calibration took " << t1-t0 << " seconds" << endl;
+        const char * names[] = {"heap", "hash", "spa", "merge"};
+        for(int k=0; k< NUM_LOCAL_KERNELS; ++k)
+        {
+            outs << names[k] << ":";
+            for(int f=0; f< LocalSpGEMMCostModel::nfeatures; ++f)
+                outs << " " << model.GetCoefficients(k)[f];
+            outs << endl;
+        }
+        SpParHelper::Print(outs.str());
+
+        if(myrank == 0)
+        {
+            LocalSpGEMMCostModel reloaded;
+            if(model.Save(modelname) && reloaded.Load(modelname) && reloaded.IsCalibrated())
+                cout << "Cost model saved and reloaded from " << modelname << endl;
+            else
+                cout << "ERROR in saving/loading the cost model" << endl;
+
+            // malformed and truncated files are rejected
+            string badname = modelname + ".bad";
+            ofstream bad(badname.c_str());
+            bad << "CombBLAS-LocalSpGEMMCostModel " << NUM_LOCAL_KERNELS << " " << LocalSpGEMMCostModel::nfeatures << " 1024\n1000000 1 2 3\n";
+            bad.close();
+            LocalSpGEMMCostModel rejected;
+            if(rejected.Load(badname) || rejected.Load(badname + ".missing") || rejected.IsCalibrated())
+                cout << "ERROR in rejecting a malformed cost model file" << endl;
+            remove(badname.c_str());
+        }
+
+        // Correctness of every accumulator on a skewed (R-MAT) matrix
+        double initiator[4] = {.57, .19, .19, .05};
+        DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+        DEL->GenGraph500Data(initiator, 12, 8, true, true);
+        SpParMat < int64_t, double, SpDCCols<int64_t,double> > G(*DEL, false);
+        delete DEL;
+
+        SpDCCols<int64_t,double> Alocal = *(G.seqptr());
+        SpDCCols<int64_t,double> Blocal = *(G.seqptr());
+        SpTuples<int64_t,double> * Control_tuples = LocalSpGEMM<PTDD, double>(Alocal, Blocal, false, false);
+        SpDCCols<int64_t,double> Control(*Control_tuples, false);
+        delete Control_tuples;
+
+        bool correct = true;
+        for(int k=0; k<= NUM_LOCAL_KERNELS; ++k)
+        {
+            LocalSpGEMMCostModel selector = model;
+            if(k < NUM_LOCAL_KERNELS) selector.Force(k);
+            SpTuples<int64_t,double> * C_tuples = LocalHybridSpGEMM<PTDD, double>(Alocal, Blocal, false, false, static_cast<int64_t*>(nullptr), &selector);
+            SpDCCols<int64_t,double> C(*C_tuples, false);
+            delete C_tuples;
+            correct = correct && (C == Control);
+        }
+        int allcorrect = correct, globalcorrect;
+        MPI_Allreduce(&allcorrect, &globalcorrect, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+        if(globalcorrect)
+            SpParHelper::Print("All local SpGEMM accumulators working correctly\n");
+        else
+            SpParHelper::Print("ERROR in local SpGEMM accumulators, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <cstdio>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+// Writes a partitioned checkpoint of a generated R-MAT matrix and reads it back on the same and on different process grids
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 4)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./CheckpointTest <Scale> <Edgefactor> <Checkpoint file>" << endl;
+            cout << "Example: ./CheckpointTest 14 16 rmat.ckpt" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        unsigned scale = static_cast<unsigned>(atoi(argv[1]));
+        unsigned edgefactor = static_cast<unsigned>(atoi(argv[2]));
+        string filename(argv[3]);
+        string regridname = filename + ".regrid";
+        typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+
+        double initiator[4] = {.57, .19, .19, .05};
+        DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+        DEL->GenGraph500Data(initiator, scale, edgefactor, true, true);
+        PSpMat_Double A(*DEL, false);   // duplicate edges are summed, so the values vary
+        delete DEL;
+        A.Apply(bind2nd(multiplies<double>(), 0.5));
+
+        double t1 = MPI_Wtime();
+        A.SaveCheckpoint(filename);
+        double t2 = MPI_Wtime();
+        PSpMat_Double B(A.getcommgrid());
+        B.LoadCheckpoint(filename);
+        double t3 = MPI_Wtime();
+        if (A == B)
+            SpParHelper::Print("Checkpoint on the same grid working correctly\n");
+        else
+            SpParHelper::Print("ERROR in checkpoint on the same grid, go fix it!\n");
+        ostringstream outs;
+        outs << "Checkpoint of " << A.getnnz() << " nonzeros written in " << t2-t1 << " s, loaded in " << t3-t2 << " s" << endl;
+        SpParHelper::Print(outs.str());
+
+        // 1 x p grid and back, or p x 1 when there is a single process row already
+        shared_ptr<CommGrid> regrid;
+        if(A.getcommgrid()->GetGridRows() == 1)
+            regrid.reset(new CommGrid(MPI_COMM_WORLD, nprocs, 1));
+        else
+            regrid.reset(new CommGrid(MPI_COMM_WORLD, 1, nprocs));
+        PSpMat_Double C(regrid);
+        C.LoadCheckpoint(filename);
+        C.SaveCheckpoint(regridname);
+        PSpMat_Double D(A.getcommgrid());
+        D.LoadCheckpoint(regridname);
+        bool sameshape = (C.getnrow() == A.getnrow()) && (C.getncol() == A.getncol()) && (C.getnnz() == A.getnnz());
+        if (sameshape && A == D)
+            SpParHelper::Print("Checkpoint on a different grid working correctly\n");
+        else
+            SpParHelper::Print("ERROR in checkpoint on a different grid, go fix it!\n");
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        if(myrank == 0)
+        {
+            remove(filename.c_str());
+            remove(regridname.c_str());
+        }
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+// Every reached vertex other than the source must be one level below its parent
+bool ValidTree(const FullyDistVec<int64_t,int64_t> & parents, const FullyDistVec<int64_t,int64_t> & levels)
+{
+    FullyDistVec<int64_t,int64_t> ri(parents);
+    ri.Apply([](int64_t p){ return (p == -1)? static_cast<int64_t>(0) : p; });
+    FullyDistVec<int64_t,int64_t> parentlevels = levels(ri);
+
+    FullyDistVec<int64_t,int64_t> bad(levels);
+    bad.EWiseApply(parentlevels, [](int64_t l, int64_t pl){ return (l > 0 && pl != l-1)? static_cast<int64_t>(1) : static_cast<int64_t>(0); });
+    FullyDistVec<int64_t,int64_t> unreached(levels);
+    unreached.EWiseApply(parents, [](int64_t l, int64_t p){ return ((l == -1) != (p == -1))? static_cast<int64_t>(1) : static_cast<int64_t>(0); });
+    return (bad.Reduce(plus<int64_t>(), (int64_t) 0) + unreached.Reduce(plus<int64_t>(), (int64_t) 0)) == 0;
+}
+
+// Checks the direction-optimizing BFS engine against pure top-down and pure bottom-up searches on a generated R-MAT graph
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./DirOptBFSTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./DirOptBFSTest 14 16" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        unsigned scale = static_cast<unsigned>(atoi(argv[1]));
+        unsigned edgefactor = static_cast<unsigned>(atoi(argv[2]));
+        typedef SpParMat < int64_t, bool, SpDCCols<int64_t,bool> > PSpMat_Bool;
+
+        double initiator[4] = {.57, .19, .19, .05};
+        DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+        DEL->GenGraph500Data(initiator, scale, edgefactor, true, true);
+        PSpMat_Bool A(*DEL, false);
+        delete DEL;
+        A.RemoveLoops();
+        PSpMat_Bool AT = A;
+        AT.Transpose();
+        A += AT;
+
+        DirOptBFS<int64_t, SpDCCols<int64_t,bool> > bfs(A);
+        FullyDistVec<int64_t,int64_t> nonisov = bfs.GetDegrees().FindInds(bind2nd(greater<int64_t>(), 0));
+
+        bool correct = true;
+        bool switched = false;
+        for(int s=0; s< 4; ++s)
+        {
+            int64_t source = nonisov[(s * 7919) % nonisov.TotalLength()];
+            FullyDistVec<int64_t,int64_t> parents(A.getcommgrid()), levels(A.getcommgrid());
+            FullyDistVec<int64_t,int64_t> tdparents(A.getcommgrid()), tdlevels(A.getcommgrid());
+            FullyDistVec<int64_t,int64_t> buparents(A.getcommgrid()), bulevels(A.getcommgrid());
+            vector<DirOptBFSLevel> stats;
+
+            bfs.SetParams(DirOptBFSParams());
+            int nlevels = bfs.Run(source, parents, levels, &stats);
+
+            bfs.GetParams().alpha = 0;   // top-down only
+            int tdnlevels = bfs.Run(source, tdparents, tdlevels);
+
+            bfs.GetParams().alpha = 1e15;   // switch to bottom-up immediately
+            bfs.GetParams().beta = 1e15;    // and never switch back
+            int bunlevels = bfs.Run(source, buparents, bulevels);
+
+            correct = correct && (nlevels == tdnlevels) && (nlevels == bunlevels) && ((int) stats.size() == nlevels);
+            correct = correct && (levels == tdlevels) && (levels == bulevels);
+            correct = correct && ValidTree(parents, levels) && ValidTree(tdparents, tdlevels) && ValidTree(buparents, bulevels);
+            for(size_t l=0; l< stats.size(); ++l)
+                switched = switched || stats[l].bottomup;
+
+            if(s == 0)
+            {
+                ostringstream outs;
+                for(size_t l=0; l< stats.size(); ++l)
+                    outs << "level " << stats[l].level << (stats[l].bottomup? " bottom-up " : " top-down ") << stats[l].frontier << " vertices " << stats[l].time << " s" << endl;
+                SpParHelper::Print(outs.str());
+            }
+        }
+        if(correct && switched)
+            SpParHelper::Print("Direction-optimizing BFS working correctly\n");
+        else
+            SpParHelper::Print("ERROR in direction-optimizing BFS, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
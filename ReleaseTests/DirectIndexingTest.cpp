@@ -0,0 +1,153 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+typedef SpDCCols<int64_t,double> DCCols;
+typedef SpParMat<int64_t, double, DCCols> PSpMat_Double;
+typedef PlusTimesSRing<double, double> PTFF;
+
+// same selection semirings under different names, which keeps SubsRef_SR on the multiplication based path
+struct RefCopy1stSRing : public BoolCopy1stSRing<double> {};
+struct RefCopy2ndSRing : public BoolCopy2ndSRing<double> {};
+
+// removes A(ri,ci) with selection matrices, the way Prune used to do it
+void ReferencePrune(PSpMat_Double & A, const FullyDistVec<int64_t,int64_t> & ri, const FullyDistVec<int64_t,int64_t> & ci)
+{
+    int64_t m = A.getnrow(), n = A.getncol();
+    PSpMat_Double S(m, m, ri, ri, 1.0);
+    PSpMat_Double T(n, n, ci, ci, 1.0);
+    PSpMat_Double SA = Mult_AnXBn_Synch<PTFF, double, DCCols>(S, A);
+    PSpMat_Double SAT = Mult_AnXBn_Synch<PTFF, double, DCCols>(SA, T);
+    A.SetDifference(SAT);
+}
+
+// A(ri,ci) = B the way SpAsgn used to do it: prune, then embed B with R*B*Q
+void ReferenceSpAsgn(PSpMat_Double & A, const FullyDistVec<int64_t,int64_t> & ri, const FullyDistVec<int64_t,int64_t> & ci, PSpMat_Double & B)
+{
+    int64_t m = A.getnrow(), n = A.getncol();
+    ReferencePrune(A, ri, ci);
+
+    FullyDistVec<int64_t,int64_t> rvec(ri.getcommgrid()), qvec(ci.getcommgrid());
+    rvec.iota(B.getnrow(), 0);
+    qvec.iota(B.getncol(), 0);
+    PSpMat_Double R(m, B.getnrow(), ri, rvec, 1.0);
+    PSpMat_Double Q(B.getncol(), n, qvec, ci, 1.0);
+    PSpMat_Double RB = Mult_AnXBn_Synch<PTFF, double, DCCols>(R, B);
+    PSpMat_Double RBQ = Mult_AnXBn_Synch<PTFF, double, DCCols>(RB, Q);
+    A += RBQ;
+}
+
+// Checks direct indexing (permutations, selections with repeated indices, row/column only, in place) and SpAsgn against selection matrix products
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./DirectIndexingTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./DirectIndexingTest 12 8" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        int scale = atoi(argv[1]);
+        int edgefactor = atoi(argv[2]);
+
+        PSpMat_Double A(MPI_COMM_WORLD);
+        A.GenGraph500Data(scale, edgefactor);
+        A.Apply([](double){ return 1.0; });
+        PSpMat_Double X(MPI_COMM_WORLD);	// nonsymmetric, with distinct values
+        X.GenGraph500Data(scale, edgefactor/2);
+        X.Apply([](double){ return 2.0; });
+        X += A;
+        int64_t n = A.getnrow();
+        shared_ptr<CommGrid> grid = A.getcommgrid();
+        bool correct = true;
+
+        FullyDistVec<int64_t,int64_t> p(grid), q(grid);
+        p.iota(n, 0);
+        p.RandPerm();
+        q.iota(n, 0);
+        q.RandPerm();
+
+        // permutations
+        MPI_Barrier(MPI_COMM_WORLD);
+        double t1 = MPI_Wtime();
+        PSpMat_Double XPP = X(p, p);
+        double tdirect = MPI_Wtime() - t1;
+        MPI_Barrier(MPI_COMM_WORLD);
+        t1 = MPI_Wtime();
+        PSpMat_Double XPPRef = X.SubsRef_SR<RefCopy1stSRing, RefCopy2ndSRing>(p, p);
+        double tspgemm = MPI_Wtime() - t1;
+        if(!(XPP == XPPRef) || XPP.getnnz() != X.getnnz()) correct = false;
+        if(!(X(p, q) == X.SubsRef_SR<RefCopy1stSRing, RefCopy2ndSRing>(p, q))) correct = false;
+
+        // selections with repeated indices and of different lengths
+        FullyDistVec<int64_t,int64_t> ri(grid, n/3, 0), ci(grid, n/2, 0);
+        ri.ApplyInd([n](int64_t, int64_t i){ return (i*i*31 + 7) % n; });
+        ci.ApplyInd([n](int64_t, int64_t i){ return (i*i*17 + 3*i) % n; });
+        if(!(X(ri, ci) == X.SubsRef_SR<RefCopy1stSRing, RefCopy2ndSRing>(ri, ci))) correct = false;
+        if(!(X(ci, ri) == X.SubsRef_SR<RefCopy1stSRing, RefCopy2ndSRing>(ci, ri))) correct = false;
+        if(!(X(ri, ri) == X.SubsRef_SR<RefCopy1stSRing, RefCopy2ndSRing>(ri, ri))) correct = false;
+
+        // row or column only
+        if(!(X(ri, Row) == X.SubsRef_SR<RefCopy1stSRing, RefCopy2ndSRing>(ri, Row))) correct = false;
+        if(!(X(ci, Column) == X.SubsRef_SR<RefCopy1stSRing, RefCopy2ndSRing>(ci, Column))) correct = false;
+        if(!(X(p, Row) == X.SubsRef_SR<RefCopy1stSRing, RefCopy2ndSRing>(p, Row))) correct = false;
+
+        // in place
+        PSpMat_Double Y = X;
+        Y(p, q, true);
+        if(!(Y == X(p, q))) correct = false;
+
+        // assignment into distinct rows and columns
+        FullyDistVec<int64_t,int64_t> ai(grid, n/4, 0), aj(grid, n/8, 0);
+        ai.ApplyInd([n](int64_t, int64_t i){ return (i*7919 + 11) % n; });
+        aj.ApplyInd([n](int64_t, int64_t i){ return (i*104729 + 5) % n; });
+        FullyDistVec<int64_t,int64_t> bi(grid, n/4, 0), bj(grid, n/8, 0);
+        bi.ApplyInd([n](int64_t, int64_t i){ return (i*i*31 + 7) % n; });
+        bj.ApplyInd([n](int64_t, int64_t i){ return (i*i*17 + 3*i) % n; });
+        PSpMat_Double BAsgn = X(bi, bj);
+        BAsgn.Apply([](double v){ return v + 10.0; });
+        PSpMat_Double Z = X, ZRef = X;
+        Z.SpAsgn(ai, aj, BAsgn);
+        ReferenceSpAsgn(ZRef, ai, aj, BAsgn);
+        if(!(Z == ZRef)) correct = false;
+
+        PSpMat_Double W = X, WRef = X;
+        W.Prune(ri, ci);
+        ReferencePrune(WRef, ri, ci);
+        if(!(W == WRef) || W.getnnz() == X.getnnz()) correct = false;
+
+        ostringstream outs;
+        outs << "A(p,p) with nnz " << X.getnnz() << ": direct " << tdirect << " s, via SpGEMM " << tspgemm << " s" << endl;
+        SpParHelper::Print(outs.str());
+
+        if(correct)
+            SpParHelper::Print("Direct indexing working correctly\n");
+        else
+            SpParHelper::Print("ERROR in direct indexing, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+typedef PlusTimesSRing<double, double> PTFF;
+
+// R'*(A*R) with two SpGEMMs
+PSpMat_Double TwoStepGalerkin(PSpMat_Double & A, PSpMat_Double & R)
+{
+    PSpMat_Double AR = PSpGEMM<PTFF>(A, R);
+    PSpMat_Double RT = R;
+    RT.Transpose();
+    return PSpGEMM<PTFF>(RT, AR);
+}
+
+// same number of nonzeros on every processor but a different pattern: the rows of every local block are reversed
+PSpMat_Double ReverseLocalRows(PSpMat_Double & A)
+{
+    SpTuples<int64_t,double> tuples(*(A.seqptr()));
+    int64_t locm = tuples.getnrow();
+    for(int64_t i=0; i< tuples.getnnz(); ++i)
+        tuples.rowindex(i) = locm - 1 - tuples.rowindex(i);
+    tuples.SortColBased();
+    return PSpMat_Double(new SpDCCols<int64_t,double>(tuples, false), A.getcommgrid());
+}
+
+// Checks the fused triple product, and its numeric-only recomputation after the values change, against two SpGEMMs
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./GalerkinProductTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./GalerkinProductTest 12 8" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        int scale = atoi(argv[1]);
+        int edgefactor = atoi(argv[2]);
+
+        PSpMat_Double A(MPI_COMM_WORLD);
+        A.GenGraph500Data(scale, edgefactor);
+        PSpMat_Double AT = A;
+        AT.Transpose();
+        A += AT;
+        int64_t n = A.getnrow();
+
+        // aggregates of four consecutive vertices, each vertex also interpolating from the next aggregate
+        int64_t m = (n+3)/4;
+        FullyDistVec<int64_t,int64_t> rows(A.getcommgrid()), cols(A.getcommgrid());
+        FullyDistVec<int64_t,double> vals(A.getcommgrid());
+        rows.iota(2*n, 0);
+        cols.iota(2*n, 0);
+        vals.iota(2*n, 0);
+        rows.Apply([n](int64_t k){ return k % n; });
+        cols.Apply([n, m](int64_t k){ return (k < n)? (k/4) : ((k-n)/4 + 1) % m; });
+        vals.Apply([n](double k){ return (k < n)? 1.0 : 0.5; });
+        PSpMat_Double R(n, m, rows, cols, vals, true);
+
+        bool correct = true;
+        GalerkinProduct<PTFF, int64_t, double, SpDCCols<int64_t,double> > rap;
+        double t0 = MPI_Wtime();
+        PSpMat_Double C = rap.Compute(A, R);
+        double t1 = MPI_Wtime();
+        PSpMat_Double CRef = TwoStepGalerkin(A, R);
+        double t2 = MPI_Wtime();
+        if(!(C == CRef)) correct = false;
+
+        // same patterns, new values: only the numeric phase runs
+        A.Apply([](double x){ return 2*x + 0.25; });
+        R.Apply([](double x){ return 0.5*x; });
+        double t3 = MPI_Wtime();
+        C = rap.Compute(A, R);
+        double t4 = MPI_Wtime();
+        CRef = TwoStepGalerkin(A, R);
+        if(!(C == CRef)) correct = false;
+
+        // a different pattern is detected and rebuilt
+        PSpMat_Double A2 = A;
+        A2.Prune([](double x){ return x > 2.5; });
+        C = rap.Compute(A2, R);
+        CRef = TwoStepGalerkin(A2, R);
+        if(!(C == CRef) || !(GalerkinTripleProduct<PTFF>(A2, R) == CRef)) correct = false;
+
+        // so is a different pattern with as many nonzeros on every processor
+        PSpMat_Double A3 = ReverseLocalRows(A2);
+        C = rap.Compute(A3, R);
+        if(!(C == TwoStepGalerkin(A3, R))) correct = false;
+
+        ostringstream outs;
+        outs << "R'AR: " << m << " x " << m << ", " << C.getnnz() << " nonzeros; symbolic+numeric " << t1-t0 << " s, numeric "
+             << t4-t3 << " s, two SpGEMMs " << t2-t1 << " s" << endl;
+        SpParHelper::Print(outs.str());
+
+        if(correct)
+            SpParHelper::Print("Galerkin triple product working correctly\n");
+        else
+            SpParHelper::Print("ERROR in Galerkin triple product, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
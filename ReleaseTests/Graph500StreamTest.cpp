@@ -0,0 +1,70 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+// Checks the streaming Graph500 generator against the edge list based generation and conversion
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./Graph500StreamTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./Graph500StreamTest 14 16" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        int scale = atoi(argv[1]);
+        int edgefactor = atoi(argv[2]);
+        typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+        typedef SpParMat<int64_t, double, SpDCCols<int32_t,double> > PSpMat_Double32;
+
+        double initiator[4] = {.57, .19, .19, .05};
+        DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+        DEL->GenGraph500Data(initiator, scale, edgefactor, true, true);
+        PSpMat_Double Control(*DEL, false);
+        PSpMat_Double ControlNoLoops(*DEL, true);
+        delete DEL;
+
+        // a single round, and many small rounds whose count differs between processes
+        PSpMat_Double A(Control.getcommgrid());
+        A.GenGraph500Data(scale, edgefactor, false);
+        PSpMat_Double B(Control.getcommgrid());
+        B.GenGraph500Data(scale, edgefactor, false, 1000 + 37 * myrank);
+        if(A == Control && B == Control)
+            SpParHelper::Print("Streaming Graph500 generator working correctly\n");
+        else
+            SpParHelper::Print("ERROR in streaming Graph500 generator, go fix it!\n");
+
+        PSpMat_Double32 C(Control.getcommgrid());
+        C.GenGraph500Data(scale, edgefactor, true, 4096);
+        PSpMat_Double D(C);
+        if(D == ControlNoLoops && D.getnnz() < Control.getnnz())
+            SpParHelper::Print("Streaming Graph500 generator without self-loops working correctly\n");
+        else
+            SpParHelper::Print("ERROR in streaming Graph500 generator without self-loops, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <limits>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+
+// Checks incremental connected components against recomputing them from scratch after the insertions
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./IncrementalCCTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./IncrementalCCTest 14 2" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        int scale = atoi(argv[1]);
+        int edgefactor = atoi(argv[2]);
+
+        PSpMat_Double A(MPI_COMM_WORLD);
+        A.GenGraph500Data(scale, edgefactor);
+        PSpMat_Double AT = A;
+        AT.Transpose();
+        A += AT;
+        int64_t fullCC;
+        FullyDistVec<int64_t,int64_t> fulllabel = FastSVConnectedComponents(A, fullCC);
+
+        // hold back about 3% of the (undirected) edges as the delta
+        FullyDistVec<int64_t,int64_t> rows(A.getcommgrid()), cols(A.getcommgrid());
+        FullyDistVec<int64_t,double> vals(A.getcommgrid());
+        A.Find(rows, cols, vals);
+        vals.EWiseApply(rows, [](double v, int64_t i){ return static_cast<double>(i); });
+        vals.EWiseApply(cols, [](double v, int64_t j){ int64_t i = static_cast<int64_t>(v); return static_cast<double>(((std::min(i,j) * 7919 + std::max(i,j)) % 100) < 3); });
+        PSpMat_Double A0(A.getnrow(), A.getncol(), rows, cols, vals);
+        A0.Prune([](double isdelta){ return isdelta > 0; });
+        vector< pair<int64_t,int64_t> > delta;
+        for(int64_t i=0; i< vals.LocArrSize(); ++i)
+        {
+            if(vals.GetLocArr()[i] > 0)
+                delta.push_back(make_pair(rows.GetLocArr()[i], cols.GetLocArr()[i]));
+        }
+
+        int64_t nCC;
+        FullyDistVec<int64_t,int64_t> cclabel = FastSVConnectedComponents(A0, nCC);
+        int64_t oldCC = nCC;
+        FullyDistVec<int64_t,int64_t> oldlabel(cclabel);
+        IncrementalConnectedComponents(cclabel, nCC, vector< pair<int64_t,int64_t> >());
+        bool emptyok = (nCC == oldCC) && (cclabel == oldlabel);
+        IncrementalConnectedComponents(cclabel, nCC, delta);
+        if(emptyok && nCC == fullCC && cclabel == fulllabel && oldCC > fullCC)
+            SpParHelper::Print("Incremental connected components working correctly\n");
+        else
+            SpParHelper::Print("ERROR in incremental connected components, go fix it!\n");
+
+        // a second R-MAT graph as the delta, given as a (packed) distributed edge list
+        double initiator[4] = {.57, .19, .19, .05};
+        for(int packed=0; packed < 2; ++packed)
+        {
+            DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+            DEL->GenGraph500Data(initiator, scale, 1, true, packed);
+            PSpMat_Double D(*DEL, false);
+            PSpMat_Double DT = D;
+            DT.Transpose();
+            D += DT;
+            D += A;
+            int64_t mergedCC;
+            FullyDistVec<int64_t,int64_t> mergedlabel = FastSVConnectedComponents(D, mergedCC);
+
+            int64_t updatedCC = fullCC;
+            FullyDistVec<int64_t,int64_t> updatedlabel(fulllabel);
+            IncrementalConnectedComponents(updatedlabel, updatedCC, *DEL);
+            delete DEL;
+            if(updatedCC == mergedCC && updatedlabel == mergedlabel)
+                SpParHelper::Print(string(packed? "Packed" : "Unpacked") + " edge list delta working correctly\n");
+            else
+                SpParHelper::Print("ERROR in " + string(packed? "packed" : "unpacked") + " edge list delta, go fix it!\n");
+        }
+    }
+    MPI_Finalize();
+    return 0;
+}
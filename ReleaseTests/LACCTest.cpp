@@ -0,0 +1,112 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <limits>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+struct MinLabelSRing
+{
+    static int64_t id() { return numeric_limits<int64_t>::max(); }
+    static bool returnedSAID() { return false; }
+    static MPI_Op mpi_op() { return MPI_MIN; }
+    static int64_t add(const int64_t & a, const int64_t & b) { return std::min(a, b); }
+    static int64_t multiply(const bool & a, const int64_t & x) { return x; }
+    static void axpy(const bool a, const int64_t & x, int64_t & y) { y = add(y, multiply(a, x)); }
+};
+
+typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+
+// Same partition as the (label propagation) reference: labels agree along every edge and there are as many labels as components
+bool SamePartition(const PSpMat_Double & A, FullyDistVec<int64_t,int64_t> & cclabel, int64_t nCC, int64_t refCC)
+{
+    FullyDistVec<int64_t,int64_t> rows(A.getcommgrid()), cols(A.getcommgrid());
+    FullyDistVec<int64_t,double> vals(A.getcommgrid());
+    A.Find(rows, cols, vals);
+    FullyDistVec<int64_t,int64_t> rowlabels = cclabel(rows);
+    FullyDistVec<int64_t,int64_t> collabels = cclabel(cols);
+    int64_t maxlabel = cclabel.Reduce(maximum<int64_t>(), static_cast<int64_t>(-1));
+    int64_t minlabel = cclabel.Reduce(minimum<int64_t>(), numeric_limits<int64_t>::max());
+    return (rowlabels == collabels) && (nCC == refCC) && (maxlabel == nCC-1) && (minlabel == 0);
+}
+
+// Checks the library LACC in its dense, sparse and hybrid modes against label propagation
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./LACCTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./LACCTest 14 2" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        int scale = atoi(argv[1]);
+        int edgefactor = atoi(argv[2]);
+
+        // a sparse R-MAT graph has many components of all sizes and many isolated vertices
+        PSpMat_Double A(MPI_COMM_WORLD);
+        A.GenGraph500Data(scale, edgefactor);
+        PSpMat_Double AT = A;
+        AT.Transpose();
+        A += AT;
+
+        SpParMat<int64_t, bool, SpDCCols<int64_t,bool> > ABool = A;
+        FullyDistVec<int64_t,int64_t> reference(A.getcommgrid());
+        reference.iota(A.getnrow(), 0);
+        while(true)
+        {
+            FullyDistVec<int64_t,int64_t> neighbormin = SpMV<MinLabelSRing>(ABool, reference);
+            neighbormin.EWiseApply(reference, [](int64_t nm, int64_t l){ return std::min(nm, l); });
+            if(neighbormin == reference) break;
+            reference = neighbormin;
+        }
+        FullyDistVec<int64_t,int64_t> refroots(reference);
+        refroots.ApplyInd([](int64_t l, int64_t i){ return static_cast<int64_t>(l == i); });
+        int64_t refCC = refroots.Reduce(std::plus<int64_t>(), static_cast<int64_t>(0));
+
+        LACCMode modes[3] = {LACC_DENSE, LACC_SPARSE, LACC_HYBRID};
+        string names[3] = {"Dense", "Sparse", "Hybrid"};
+        for(int m=0; m< 3; ++m)
+        {
+            LACCParams params;
+            params.mode = modes[m];
+            vector<LACCIteration> stats;
+            int64_t nCC;
+            FullyDistVec<int64_t,int64_t> cclabel = LACCConnectedComponents(A, nCC, params, &stats);
+            bool modesok = !stats.empty();
+            for(size_t i=0; i< stats.size(); ++i)
+            {
+                if(modes[m] == LACC_DENSE) modesok = modesok && stats[i].dense;
+                if(modes[m] == LACC_SPARSE) modesok = modesok && !stats[i].dense;
+                if(i > 0) modesok = modesok && (stats[i].active <= stats[i-1].active);
+            }
+            if(modesok && SamePartition(A, cclabel, nCC, refCC))
+                SpParHelper::Print(names[m] + " LACC working correctly\n");
+            else
+                SpParHelper::Print("ERROR in " + names[m] + " LACC, go fix it!\n");
+        }
+    }
+    MPI_Finalize();
+    return 0;
+}
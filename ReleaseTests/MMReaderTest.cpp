@@ -0,0 +1,135 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+
+// The hand-rolled number parser must agree with strtod bit by bit
+bool CheckTokenizer()
+{
+    const char * samples[] = {"1.5", "-0.001", "3e-5", "1.234567890123456789e10", "6.02214076e23", "  42", "-7", ".5",
+                              "1E+3", "0.1", "00012.50", "4.9e-324", "1.7976931348623157e308", "123456789012345", "1234567890123456789"};
+    bool correct = true;
+    for(size_t i=0; i< sizeof(samples)/sizeof(samples[0]); ++i)
+    {
+        string line = string(samples[i]) + "\n";
+        const char * p = line.c_str();
+        double parsed;
+        correct = correct && SpHelper::ParseReal(p, parsed) && (parsed == strtod(samples[i], NULL)) && (*p == '\n');
+    }
+    srand(1);
+    char text[64];
+    for(int i=0; i< 100000; ++i)
+    {
+        double value = (rand() - RAND_MAX/2) * ((i % 3 == 0)? 1e-7 : 1.37);
+        snprintf(text, sizeof(text), (i % 2 == 0)? "%.17g\n" : "%g\n", value);
+        const char * p = text;
+        double parsed;
+        correct = correct && SpHelper::ParseReal(p, parsed) && (parsed == strtod(text, NULL));
+    }
+    const char * p = "  \n";
+    double dummy;
+    correct = correct && !SpHelper::ParseReal(p, dummy);
+    return correct;
+}
+
+// Checks the multithreaded Matrix Market reader on a generated matrix and on a hand-written symmetric file
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 4)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./MMReaderTest <Scale> <Edgefactor> <Matrix Market file>" << endl;
+            cout << "Example: ./MMReaderTest 14 16 rmat.mtx" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        unsigned scale = static_cast<unsigned>(atoi(argv[1]));
+        unsigned edgefactor = static_cast<unsigned>(atoi(argv[2]));
+        string filename(argv[3]);
+        string symname = filename + ".sym";
+
+        int localtokenizer = CheckTokenizer(), tokenizer;
+        MPI_Allreduce(&localtokenizer, &tokenizer, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+        if (tokenizer)
+            SpParHelper::Print("Number parsing working correctly\n");
+        else
+            SpParHelper::Print("ERROR in number parsing, go fix it!\n");
+
+        double initiator[4] = {.57, .19, .19, .05};
+        DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+        DEL->GenGraph500Data(initiator, scale, edgefactor, true, true);
+        PSpMat_Double A(*DEL, false);   // duplicate edges are summed, so the values vary
+        delete DEL;
+        A.Apply(bind2nd(multiplies<double>(), 0.25));   // exactly representable in the 6 digits written by ParallelWriteMM
+        A.ParallelWriteMM(filename, true);
+
+        PSpMat_Double B(A.getcommgrid());
+        double t1 = MPI_Wtime();
+        B.ParallelReadMM(filename, true, maximum<double>());
+        double t2 = MPI_Wtime();
+        if (A == B)
+            SpParHelper::Print("Parallel Matrix Market reader working correctly\n");
+        else
+            SpParHelper::Print("ERROR in parallel Matrix Market reader, go fix it!\n");
+        ostringstream outs;
+        outs << "Read " << B.getnnz() << " nonzeros in " << t2-t1 << " s" << endl;
+        SpParHelper::Print(outs.str());
+
+        // symmetric, with comments, blank lines, carriage returns, odd spacing and no newline at the end
+        if(myrank == 0)
+        {
+            FILE * f = fopen(symname.c_str(), "w");
+            fprintf(f, "%%%%MatrixMarket matrix coordinate real symmetric\n%% comment\n5 5 5\n");
+            fprintf(f, "1 1 2.5\r\n3 1 -1e-3\n\n5\t2   .5\n4 4 1.25E+2\n5 5 7");
+            fclose(f);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+        PSpMat_Double S(A.getcommgrid());
+        S.ParallelReadMM(symname, true, maximum<double>());
+
+        int64_t rows[] = {0, 2, 0, 4, 1, 3, 4};
+        int64_t cols[] = {0, 0, 2, 1, 4, 3, 4};
+        double vals[] = {2.5, -1e-3, -1e-3, .5, .5, 125, 7};
+        FullyDistVec<int64_t,int64_t> ri(A.getcommgrid(), 7, 0), ci(A.getcommgrid(), 7, 0);
+        FullyDistVec<int64_t,double> vi(A.getcommgrid(), 7, 0.0);
+        for(int64_t k=0; k< 7; ++k)
+        {
+            ri.SetElement(k, rows[k]);
+            ci.SetElement(k, cols[k]);
+            vi.SetElement(k, vals[k]);
+        }
+        PSpMat_Double SControl(5, 5, ri, ci, vi);
+        if (S == SControl)
+            SpParHelper::Print("Parallel Matrix Market reader on symmetric input working correctly\n");
+        else
+            SpParHelper::Print("ERROR in parallel Matrix Market reader on symmetric input, go fix it!\n");
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        if(myrank == 0)
+        {
+            remove(filename.c_str());
+            remove(symname.c_str());
+        }
+    }
+    MPI_Finalize();
+    return 0;
+}
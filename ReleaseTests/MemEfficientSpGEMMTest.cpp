@@ -0,0 +1,134 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <numeric>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+// Checks the phased SpGEMM used by HipMCL against Mult_AnXBn_Synch on a generated R-MAT matrix
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./MemEfficientSpGEMMTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./MemEfficientSpGEMMTest 12 8" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        unsigned scale = static_cast<unsigned>(atoi(argv[1]));
+        unsigned edgefactor = static_cast<unsigned>(atoi(argv[2]));
+        typedef PlusTimesSRing<double, double> PTDD;
+        typedef SpDCCols<int64_t, double> DCCols;
+        typedef SpParMat<int64_t, double, DCCols> PSpMat_Double;
+
+        double initiator[4] = {.57, .19, .19, .05};
+        DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+        DEL->GenGraph500Data(initiator, scale, edgefactor, true, true);
+        PSpMat_Double A(*DEL, false);
+        delete DEL;
+        PSpMat_Double B(A);
+
+        PSpMat_Double CControl = Mult_AnXBn_Synch<PTDD, double, DCCols>(A, B);
+
+        // no pruning, selection or recovery: the product must match the plain SUMMA
+        PSpMat_Double C = MemEfficientSpGEMM<PTDD, double, DCCols>(A, B, 3, 0.0, (int64_t) 0, (int64_t) 0, 0.0, 1, 2, 0);
+        if (CControl == C)
+            SpParHelper::Print("Phased multiplication working correctly\n");
+        else
+            SpParHelper::Print("ERROR in phased multiplication, go fix it!\n");
+
+        // symbolic phase planner: at least as many unmerged as merged nonzeros, cuts cover B and fit the budget
+        vector<int64_t> colnnz = SymbolicSUMMAColumnNnz(A, B);
+        int64_t localsquare = accumulate(colnnz.begin(), colnnz.end(), (int64_t) 0);
+        int64_t budget = max(localsquare / 5, (int64_t) 1);
+        vector<int64_t> cuts = PlanSUMMAPhases<int64_t>(colnnz, budget, 1, 0, 0, MPI_COMM_WORLD);
+        bool planned = (localsquare >= CControl.seqptr()->getnnz()) && (colnnz.size() == (size_t) B.getlocalcols());
+        int64_t begin = 0;
+        for(size_t ph = 0; ph < cuts.size(); ++ph)
+        {
+            int64_t bytes = accumulate(colnnz.begin() + begin, colnnz.begin() + begin + cuts[ph], (int64_t) 0);
+            planned = planned && (bytes <= budget || cuts[ph] == 1);
+            begin += cuts[ph];
+        }
+        planned = planned && (begin == B.getlocalcols());
+        int localplanned = planned, globalplanned;
+        MPI_Allreduce(&localplanned, &globalplanned, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+        if (globalplanned)
+            SpParHelper::Print("Symbolic phase planner working correctly\n");
+        else
+            SpParHelper::Print("ERROR in symbolic phase planner, go fix it!\n");
+
+        // a memory budget small enough for several uneven phases, 1 GB would give a single phase at this scale
+        int64_t perProcessBytes = 1000000000;
+        vector<int64_t> memcuts = PlanMemEfficientPhases<double>(A, B, (int64_t) 0, (int64_t) 0, perProcessBytes);
+        while(memcuts.size() == 1)
+        {
+            perProcessBytes = perProcessBytes / 5 * 4;
+            memcuts = PlanMemEfficientPhases<double>(A, B, (int64_t) 0, (int64_t) 0, perProcessBytes);
+        }
+        C = MemEfficientSpGEMM<PTDD, double, DCCols>(A, B, 1, 0.0, (int64_t) 0, (int64_t) 0, 0.0, 1, 2, 0, false, NULL, false, &memcuts);
+        ostringstream phaseouts;
+        phaseouts << "Memory-planned: " << memcuts.size() << " phases within " << perProcessBytes << " bytes per process" << endl;
+        SpParHelper::Print(phaseouts.str());
+        if (CControl == C && memcuts.size() > 1)
+            SpParHelper::Print("Memory-planned phased multiplication working correctly\n");
+        else
+            SpParHelper::Print("ERROR in memory-planned phased multiplication, go fix it!\n");
+
+        // pruning, selection and recovery: truncating the columns while computing them must give the same result
+        PSpMat_Double CSelect = MemEfficientSpGEMM<PTDD, double, DCCols>(A, B, 3, 1.0, (int64_t) 16, (int64_t) 8, 0.5, 1, 2, 0);
+        C = MemEfficientSpGEMM<PTDD, double, DCCols>(A, B, 3, 1.0, (int64_t) 16, (int64_t) 8, 0.5, 1, 2, 0, false, NULL, true);
+        if (CSelect == C)
+            SpParHelper::Print("Fused selection working correctly\n");
+        else
+            SpParHelper::Print("ERROR in fused selection, go fix it!\n");
+
+        DCCols Alocal = *(A.seqptr());
+        DCCols Blocal = *(B.seqptr());
+        ColumnSelectStats<double> fusedstats, mergedstats;
+        SpTuples<int64_t,double> * fused = LocalSpGEMMSelect<PTDD, double>(Alocal, Blocal, false, false, 1.0, (int64_t) 16, (int64_t) 8, fusedstats);
+        SpTuples<int64_t,double> * merged = SelectTuples(LocalSpGEMM<PTDD, double>(Alocal, Blocal, false, false), 1.0, (int64_t) 16, (int64_t) 8, mergedstats);
+        int localfused = (DCCols(*fused, false) == DCCols(*merged, false)) && (fusedstats.nnz == mergedstats.nnz) && (fusedstats.sumPruned == mergedstats.sumPruned);
+        int globalfused;
+        MPI_Allreduce(&localfused, &globalfused, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+        delete fused;
+        delete merged;
+        if (globalfused)
+            SpParHelper::Print("Fused local SpGEMM and selection working correctly\n");
+        else
+            SpParHelper::Print("ERROR in fused local SpGEMM and selection, go fix it!\n");
+
+        SUMMAPipelineStats stats;
+        C = MemEfficientSpGEMM<PTDD, double, DCCols>(A, B, 3, 0.0, (int64_t) 0, (int64_t) 0, 0.0, 1, 2, 0, true, &stats);
+        if (CControl == C)
+            SpParHelper::Print("Pipelined phased multiplication working correctly\n");
+        else
+            SpParHelper::Print("ERROR in pipelined phased multiplication, go fix it!\n");
+        ostringstream outs;
+        outs << "Pipelined: " << stats.hiddenstages << " of " << stats.stages << " stages hidden, exposed wait " << stats.exposedcomm << " s" << endl;
+        SpParHelper::Print(outs.str());
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+
+// Gathers the local pieces of a vector on processor 0, in index order
+vector<int64_t> GatherOnRoot(const FullyDistVec<int64_t,int64_t> & v)
+{
+    int nprocs, myrank;
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+    int mylen = static_cast<int>(v.LocArrSize());
+    vector<int> lens(nprocs), dpls(nprocs+1, 0);
+    MPI_Gather(&mylen, 1, MPI_INT, lens.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    partial_sum(lens.begin(), lens.end(), dpls.begin()+1);
+    vector<int64_t> all(myrank == 0? dpls[nprocs] : 0);
+    MPI_Gatherv(v.GetLocArr(), mylen, MPIType<int64_t>(), all.data(), lens.data(), dpls.data(), MPIType<int64_t>(), 0, MPI_COMM_WORLD);
+    return all;
+}
+
+// Symmetric matrix with the edges (first(e), second(e)) for e = 0,...,nedges-1, both directions
+template <typename F1, typename F2>
+PSpMat_Double EdgeMatrix(int64_t n, int64_t nedges, F1 first, F2 second)
+{
+    shared_ptr<CommGrid> fullWorld(new CommGrid(MPI_COMM_WORLD, 0, 0));
+    FullyDistVec<int64_t,int64_t> rows(fullWorld), cols(fullWorld);
+    rows.iota(2*nedges, 0);
+    cols.iota(2*nedges, 0);
+    rows.Apply([nedges, first, second](int64_t e){ return (e < nedges)? first(e) : second(e-nedges); });
+    cols.Apply([nedges, first, second](int64_t e){ return (e < nedges)? second(e) : first(e-nedges); });
+    return PSpMat_Double(n, n, rows, cols, 1.0);
+}
+
+// Number of nonzeros in the Cholesky factor of B minus the number in the lower triangle of B, natural order
+int64_t SymbolicFill(const PSpMat_Double & B)
+{
+    int myrank;
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+    int64_t n = B.getnrow();
+    FullyDistVec<int64_t,int64_t> rows(B.getcommgrid()), cols(B.getcommgrid());
+    B.Find(rows, cols);
+    vector<int64_t> allrows = GatherOnRoot(rows);
+    vector<int64_t> allcols = GatherOnRoot(cols);
+    int64_t fill = 0;
+    if(myrank == 0)
+    {
+        vector< vector<int64_t> > below(n), children(n);
+        int64_t nnzlower = 0;
+        for(size_t k=0; k< allrows.size(); ++k)
+        {
+            if(allrows[k] > allcols[k])
+            {
+                below[allcols[k]].push_back(allrows[k]);
+                ++nnzlower;
+            }
+        }
+        int64_t nnzL = 0;
+        for(int64_t j=0; j< n; ++j)
+        {
+            vector<int64_t> & s = below[j];
+            for(int64_t c : children[j])
+                for(int64_t i : below[c])
+                    if(i > j) s.push_back(i);
+            sort(s.begin(), s.end());
+            s.erase(unique(s.begin(), s.end()), s.end());
+            nnzL += s.size();
+            if(!s.empty()) children[s[0]].push_back(j);
+        }
+        fill = nnzL - nnzlower;
+    }
+    MPI_Bcast(&fill, 1, MPIType<int64_t>(), 0, MPI_COMM_WORLD);
+    return fill;
+}
+
+bool IsPermutation(const FullyDistVec<int64_t,int64_t> & perm, int64_t n)
+{
+    int myrank;
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+    vector<int64_t> all = GatherOnRoot(perm);
+    int ok = 1;
+    if(myrank == 0)
+    {
+        if(static_cast<int64_t>(all.size()) != n) ok = 0;
+        sort(all.begin(), all.end());
+        for(int64_t k=0; ok && k< n; ++k)
+            if(all[k] != k) ok = 0;
+    }
+    MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    return ok;
+}
+
+// Orders a random tree, which must not fill, and a 2D grid, which must fill less than in the natural order
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./MinimumDegreeTest <TreeVertices> <GridSide>" << endl;
+            cout << "Example: ./MinimumDegreeTest 5000 40" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        int64_t ntree = atol(argv[1]);
+        int64_t side = atol(argv[2]);
+        bool correct = true;
+
+        // every vertex but the root hangs from a pseudo-random earlier vertex
+        PSpMat_Double T = EdgeMatrix(ntree, ntree-1, [](int64_t e){ return e+1; },
+                                     [](int64_t e){ return ((e+1) * 2654435761LL) % 1000003 % (e+1); });
+        vector<MinimumDegreeRound> stats;
+        FullyDistVec<int64_t,int64_t> tperm = MinimumDegreeOrdering(T, MinimumDegreeParams(), &stats);
+        PSpMat_Double TP = T(tperm, tperm);
+        int64_t tfill = SymbolicFill(TP);
+        if(!IsPermutation(tperm, ntree) || tfill != 0) correct = false;
+        ostringstream outs;
+        outs << "Tree: " << stats.size() << " rounds, fill " << tfill << endl;
+
+        int64_t hedges = side*(side-1);	// horizontal edges, and as many vertical ones
+        PSpMat_Double G = EdgeMatrix(side*side, 2*hedges,
+                                     [side, hedges](int64_t e){ return (e < hedges)? (e/(side-1))*side + e%(side-1) : e-hedges; },
+                                     [side, hedges](int64_t e){ return (e < hedges)? (e/(side-1))*side + e%(side-1) + 1 : e-hedges+side; });
+        MinimumDegreeParams params;
+        params.delta = 1;
+        FullyDistVec<int64_t,int64_t> gperm = MinimumDegreeOrdering(G, params, &stats);
+        PSpMat_Double GP = G(gperm, gperm);
+        int64_t gfill = SymbolicFill(GP);
+        int64_t natfill = SymbolicFill(G);
+        if(!IsPermutation(gperm, side*side) || gfill >= natfill) correct = false;
+        outs << "Grid: " << stats.size() << " rounds, fill " << gfill << " (natural order " << natfill << ")" << endl;
+        SpParHelper::Print(outs.str());
+
+        if(correct)
+            SpParHelper::Print("Minimum degree ordering working correctly\n");
+        else
+            SpParHelper::Print("ERROR in minimum degree ordering, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <limits>
+#include <tuple>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+
+// Gathers the local pieces of a vector on processor 0, in index order
+vector<int64_t> GatherOnRoot(const FullyDistVec<int64_t,int64_t> & v)
+{
+    int nprocs, myrank;
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+    int mylen = static_cast<int>(v.LocArrSize());
+    vector<int> lens(nprocs), dpls(nprocs+1, 0);
+    MPI_Gather(&mylen, 1, MPI_INT, lens.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    partial_sum(lens.begin(), lens.end(), dpls.begin()+1);
+    vector<int64_t> all(myrank == 0? dpls[nprocs] : 0);
+    MPI_Gatherv(v.GetLocArr(), mylen, MPIType<int64_t>(), all.data(), lens.data(), dpls.data(), MPIType<int64_t>(), 0, MPI_COMM_WORLD);
+    return all;
+}
+
+// Component-by-component Cuthill-McKee with a sort per level, the way the RCM application used to do it
+// Returns the position of every vertex relative to the first vertex of its component and the component of every vertex
+void SerialCuthillMcKee(const vector< vector<int64_t> > & adj, vector<int64_t> & rel, vector<int64_t> & comp)
+{
+    int64_t n = adj.size();
+    rel.assign(n, -1);
+    comp.assign(n, -1);
+    vector<int64_t> level(n, -1);
+    int64_t ncomp = 0;
+    for(int64_t r=0; r< n; ++r)
+    {
+        if(comp[r] != -1) continue;
+        vector<int64_t> members(1, r);
+        comp[r] = ncomp;
+        for(size_t k=0; k< members.size(); ++k)
+            for(int64_t w : adj[members[k]])
+                if(comp[w] == -1) { comp[w] = ncomp; members.push_back(w); }
+        ++ncomp;
+
+        int64_t source = members[0];
+        for(int64_t v : members)
+            if(make_pair(adj[v].size(), v) < make_pair(adj[source].size(), source)) source = v;
+        int64_t prevlevel = -1, curlevel = 0;
+        while(curlevel > prevlevel)
+        {
+            prevlevel = curlevel;
+            for(int64_t v : members) level[v] = -1;
+            vector<int64_t> fringe(1, source);
+            level[source] = 1;
+            curlevel = 1;
+            vector<int64_t> last = fringe;
+            while(!fringe.empty())
+            {
+                vector<int64_t> next;
+                for(int64_t u : fringe)
+                    for(int64_t w : adj[u])
+                        if(level[w] == -1) { level[w] = curlevel+1; next.push_back(w); }
+                if(!next.empty()) { ++curlevel; last = next; }
+                fringe.swap(next);
+            }
+            int64_t cand = last[0];
+            for(int64_t v : last)
+                if(make_pair(adj[v].size(), v) < make_pair(adj[cand].size(), cand)) cand = v;
+            if(curlevel > prevlevel) source = cand;
+        }
+
+        int64_t pos = 0;
+        rel[source] = pos++;
+        vector<int64_t> fringe(1, source);
+        while(!fringe.empty())
+        {
+            vector< tuple<int64_t,int64_t,int64_t> > children;	// (parent order, degree, vertex)
+            for(int64_t u : fringe)
+                for(int64_t w : adj[u])
+                    if(rel[w] == -1) children.push_back(make_tuple(rel[u], (int64_t) adj[w].size(), w));
+            sort(children.begin(), children.end());
+            fringe.clear();
+            for(auto & c : children)
+            {
+                if(rel[get<2>(c)] != -1) continue;	// the first one has the smallest parent
+                rel[get<2>(c)] = -2;
+            }
+            for(auto & c : children)
+            {
+                if(rel[get<2>(c)] != -2) continue;
+                rel[get<2>(c)] = pos++;
+                fringe.push_back(get<2>(c));
+            }
+        }
+    }
+}
+
+// Checks the RCM ordering of all components at once against the component-by-component algorithm
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./RCMTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./RCMTest 12 1" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        int scale = atoi(argv[1]);
+        int edgefactor = atoi(argv[2]);
+
+        PSpMat_Double A(MPI_COMM_WORLD);
+        A.GenGraph500Data(scale, edgefactor);
+        PSpMat_Double AT = A;
+        AT.Transpose();
+        A += AT;
+        int64_t n = A.getnrow();
+
+        RCMParams params;
+        params.reverse = false;
+        RCMStats stats;
+        FullyDistVec<int64_t,int64_t> cmorder = RCMOrdering(A, params, &stats);
+        FullyDistVec<int64_t,int64_t> rcmorder = RCMOrdering(A);
+
+        FullyDistVec<int64_t,int64_t> rows(A.getcommgrid()), cols(A.getcommgrid());
+        FullyDistVec<int64_t,double> vals(A.getcommgrid());
+        A.Find(rows, cols, vals);
+        vector<int64_t> allrows = GatherOnRoot(rows);
+        vector<int64_t> allcols = GatherOnRoot(cols);
+        vector<int64_t> cm = GatherOnRoot(cmorder);
+        vector<int64_t> rcm = GatherOnRoot(rcmorder);
+
+        int correct = 1;
+        if(myrank == 0)
+        {
+            vector< vector<int64_t> > adj(n);
+            for(size_t k=0; k< allrows.size(); ++k)
+                if(allrows[k] != allcols[k]) adj[allrows[k]].push_back(allcols[k]);
+            for(auto & a : adj)
+            {
+                sort(a.begin(), a.end());
+                a.erase(unique(a.begin(), a.end()), a.end());
+            }
+            vector<int64_t> rel, comp;
+            SerialCuthillMcKee(adj, rel, comp);
+
+            // every component takes a contiguous range, and within it the same positions as the serial algorithm
+            int64_t ncomp = *max_element(comp.begin(), comp.end()) + 1;
+            vector<int64_t> first(ncomp, numeric_limits<int64_t>::max());
+            for(int64_t v=0; v< n; ++v)
+                first[comp[v]] = min(first[comp[v]], cm[v]);
+            vector<bool> taken(n, false);
+            for(int64_t v=0; v< n; ++v)
+            {
+                if(cm[v] < 0 || cm[v] >= n || taken[cm[v]] || cm[v] - first[comp[v]] != rel[v] || rcm[v] != n-1-cm[v])
+                    correct = 0;
+                else
+                    taken[cm[v]] = true;
+            }
+            if(stats.components != ncomp) correct = 0;
+            cout << ncomp << " components, " << stats.ppvrounds << " pseudo-peripheral rounds, " << stats.levels << " levels" << endl;
+        }
+        MPI_Bcast(&correct, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if(correct)
+            SpParHelper::Print("RCM ordering working correctly\n");
+        else
+            SpParHelper::Print("ERROR in RCM ordering, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+// Sorts the same (key, global index) pairs with the radix sort and with the comparison sort
+template <typename KEY>
+bool SameAsComparisonSort(vector< pair<KEY,int64_t> > pairs, MPI_Comm World)
+{
+    int nprocs, myrank;
+    MPI_Comm_size(World, &nprocs);
+    MPI_Comm_rank(World, &myrank);
+    int64_t length = pairs.size();
+    vector<int64_t> dist(nprocs);
+    dist[myrank] = length;
+    MPI_Allgather(MPI_IN_PLACE, 1, MPI_LONG_LONG, dist.data(), 1, MPI_LONG_LONG, World);
+
+    vector< pair<KEY,int64_t> > control(pairs);
+    SpParHelper::MemoryEfficientPSort(control.data(), length, dist.data(), World);
+    SpParHelper::RadixPSort(pairs.data(), length, dist.data(), World);
+    int localsame = (pairs == control), globalsame;
+    MPI_Allreduce(&localsame, &globalsame, 1, MPI_INT, MPI_LAND, World);
+    return globalsame;
+}
+
+// Checks the distributed radix sort against MemoryEfficientPSort, and the sorting-free RandPerm
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 2)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./RadixSortTest <Length>" << endl;
+            cout << "Example: ./RadixSortTest 100000" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        int64_t n = atoll(argv[1]);
+        shared_ptr<CommGrid> fullWorld;
+        fullWorld.reset( new CommGrid(MPI_COMM_WORLD, 0, 0) );
+
+        // negative keys with many duplicates, a wide 64-bit range (several digit passes), and an unbalanced
+        // distribution where the last process contributes nothing
+        int64_t mylength = (myrank == nprocs-1 && nprocs > 1)? 0 : n / nprocs + myrank * 17;
+        MTRand M(12345 + myrank);
+        vector< pair<int64_t,int64_t> > narrow(mylength), wide(mylength);
+        vector< pair<uint32_t,int64_t> > unsignedkeys(mylength);
+        for(int64_t i=0; i< mylength; ++i)
+        {
+            int64_t gind = static_cast<int64_t>(myrank) * n + i;
+            narrow[i] = make_pair(static_cast<int64_t>(M.randInt(1000)) - 500, gind);
+            wide[i] = make_pair((static_cast<int64_t>(M.randInt()) << 31) ^ static_cast<int64_t>(M.randInt()), gind);
+            unsignedkeys[i] = make_pair(static_cast<uint32_t>(M.randInt()), gind);
+        }
+        if(SameAsComparisonSort(narrow, MPI_COMM_WORLD) && SameAsComparisonSort(wide, MPI_COMM_WORLD) && SameAsComparisonSort(unsignedkeys, MPI_COMM_WORLD))
+            SpParHelper::Print("Distributed radix sort working correctly\n");
+        else
+            SpParHelper::Print("ERROR in distributed radix sort, go fix it!\n");
+
+        // FullyDistVec::sort on integer values (radix) and on floating point values (comparison) must agree
+        FullyDistVec<int64_t, int64_t> ivec(fullWorld, n, 0);
+        ivec.ApplyInd([](int64_t val, int64_t ind){ return (ind * 7919) % 1009 - 300; });
+        FullyDistVec<int64_t, double> dvec(fullWorld, n, 0.0);
+        dvec.ApplyInd([](double val, int64_t ind){ return static_cast<double>((ind * 7919) % 1009 - 300); });
+        FullyDistVec<int64_t, int64_t> iperm = ivec.sort();
+        FullyDistVec<int64_t, int64_t> dperm = dvec.sort();
+        FullyDistVec<int64_t, double> ivecd(fullWorld, n, 0.0);
+        ivecd.EWiseApply(ivec, [](double d, int64_t i){ return static_cast<double>(i); });
+        if(iperm == dperm && ivecd == dvec)
+            SpParHelper::Print("Dense vector sort working correctly\n");
+        else
+            SpParHelper::Print("ERROR in dense vector sort, go fix it!\n");
+
+        // FullyDistSpVec::sort leaves the vector alone and returns the original (global) locations in sorted order of values
+        FullyDistVec<int64_t, int64_t> dense(fullWorld, n, 0);
+        dense.ApplyInd([](int64_t val, int64_t ind){ return (ind % 3 == 0)? (ind * 31) % 101 + 1 : 0; });
+        FullyDistSpVec<int64_t, int64_t> spvec(dense, [](int64_t val){ return val != 0; });
+        FullyDistSpVec<int64_t, int64_t> sorted(spvec);
+        FullyDistSpVec<int64_t, int64_t> spperm = sorted.sort();
+        FullyDistVec<int64_t, int64_t> origlocs(fullWorld);
+        origlocs = spperm.FindVals([](int64_t val){ return true; });
+        FullyDistVec<int64_t, int64_t> refetched = dense(origlocs);
+        vector<int64_t> sortedind = sorted.GetLocalInd(), origind = spvec.GetLocalInd();
+        vector<int64_t> sortednum = sorted.GetLocalNum(), orignum = spvec.GetLocalNum();
+        int localok = (sortedind == origind) && (sortednum == orignum) && (spperm.getlocnnz() == spvec.getlocnnz()), globalok;
+        MPI_Allreduce(&localok, &globalok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+        int64_t descents = 0, zeros = 0;
+        const int64_t * vals = refetched.GetLocArr();
+        for(int64_t i=0; i< refetched.LocArrSize(); ++i)
+        {
+            if(vals[i] == 0) ++zeros;
+            if(i > 0 && vals[i] < vals[i-1]) ++descents;
+        }
+        MPI_Allreduce(MPI_IN_PLACE, &descents, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+        MPI_Allreduce(MPI_IN_PLACE, &zeros, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+        if(globalok && descents == 0 && zeros == 0 && origlocs.TotalLength() == spvec.getnnz())
+            SpParHelper::Print("Sparse vector sort working correctly\n");
+        else
+            SpParHelper::Print("ERROR in sparse vector sort, go fix it!\n");
+
+        // RandPerm must return a permutation with the same distribution, and shuffle across processes
+        FullyDistVec<int64_t, int64_t> perm(fullWorld);
+        perm.iota(n, 0);
+        FullyDistVec<int64_t, int64_t> identity(perm);
+        perm.RandPerm();
+        FullyDistVec<int64_t, int64_t> backtoid(perm);
+        backtoid.sort();
+        FullyDistVec<int64_t, int64_t> stayed(perm);
+        stayed.EWiseApply(identity, [](int64_t p, int64_t i){ return static_cast<int64_t>(p == i); });
+        int64_t fixedpoints = stayed.Reduce(plus<int64_t>(), static_cast<int64_t>(0));
+        if(backtoid == identity && perm.LocArrSize() == identity.LocArrSize() && fixedpoints < n / 2)
+            SpParHelper::Print("Random permutation working correctly\n");
+        else
+            SpParHelper::Print("ERROR in random permutation, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
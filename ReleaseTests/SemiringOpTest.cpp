@@ -0,0 +1,168 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <limits>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+// A struct value type, as in the BFS/matching semirings: shortest distance with the smallest parent on ties
+struct DistParent
+{
+    DistParent(): dist(numeric_limits<double>::max()), parent(-1) {}
+    DistParent(double d, int64_t p): dist(d), parent(p) {}
+    double dist;
+    int64_t parent;
+    bool operator==(const DistParent & rhs) const { return dist == rhs.dist && parent == rhs.parent; }
+};
+
+namespace combblas {
+template <> struct promote_trait<double, DistParent> { typedef DistParent T_promote; };
+}
+
+// No mpi_op(): the registry has to build one out of add()
+struct MinDistParentSRing
+{
+    static DistParent id() { return DistParent(); }
+    static bool returnedSAID() { return false; }
+    static DistParent add(const DistParent & a, const DistParent & b)
+    {
+        if(a.dist < b.dist || (a.dist == b.dist && a.parent < b.parent)) return a;
+        return b;
+    }
+    static DistParent multiply(const double & weight, const DistParent & x)
+    {
+        return DistParent(x.dist + weight, x.parent);
+    }
+    static void axpy(const double & a, const DistParent & x, DistParent & y)
+    {
+        y = add(y, multiply(a, x));
+    }
+};
+
+// Only what reductions need, and no mpi_op() either
+struct MaxDoubleSRing
+{
+    static double id() { return numeric_limits<double>::lowest(); }
+    static double add(const double & a, const double & b) { return std::max(a, b); }
+};
+
+// Checks collective reductions over a semiring without a predefined MPI_Op
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./SemiringOpTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./SemiringOpTest 12 8" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        unsigned scale = static_cast<unsigned>(atoi(argv[1]));
+        unsigned edgefactor = static_cast<unsigned>(atoi(argv[2]));
+        typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+
+        // registry: predefined ops are kept, user ops are created once
+        MPI_Op sumop = SRingMPIOp<PlusTimesSRing<double,double>, double>::op();
+        MPI_Op userop = SRingMPIOp<MinDistParentSRing, DistParent>::op();
+        bool registry = (sumop == MPI_SUM) && (userop != MPI_OP_NULL) && (userop == SRingMPIOp<MinDistParentSRing, DistParent>::op())
+                        && (MPIOp<SRingAddOp<MinDistParentSRing, DistParent>, DistParent>::op() == userop);
+
+        // allreduce of a struct array against gather-and-fold
+        const int len = 1000;
+        vector<DistParent> mine(len), reduced(len), all(len * nprocs);
+        for(int i=0; i< len; ++i)
+            mine[i] = DistParent(static_cast<double>((i * 7 + myrank * 13) % 17), myrank);
+        MPI_Allreduce(mine.data(), reduced.data(), len, MPIType<DistParent>(), userop, MPI_COMM_WORLD);
+        MPI_Allgather(mine.data(), len, MPIType<DistParent>(), all.data(), len, MPIType<DistParent>(), MPI_COMM_WORLD);
+        for(int i=0; i< len; ++i)
+        {
+            DistParent control;
+            for(int p=0; p< nprocs; ++p)
+                control = MinDistParentSRing::add(control, all[p * len + i]);
+            registry = registry && (control == reduced[i]);
+        }
+        int localok = registry, globalok;
+        MPI_Allreduce(&localok, &globalok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+        if(globalok)
+            SpParHelper::Print("Semiring MPI_Op registry working correctly\n");
+        else
+            SpParHelper::Print("ERROR in semiring MPI_Op registry, go fix it!\n");
+
+        double initiator[4] = {.57, .19, .19, .05};
+        DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+        DEL->GenGraph500Data(initiator, scale, edgefactor, true, true);
+        PSpMat_Double A(*DEL, false);
+        delete DEL;
+        A.Apply([](double v){ return 1.0 + static_cast<double>(static_cast<int64_t>(v * 1000) % 7); });
+
+        // SpParMat::Reduce with the semiring addition
+        FullyDistVec<int64_t, DistParent> colmins(A.getcommgrid());
+        A.Reduce<MinDistParentSRing>(colmins, Column, MinDistParentSRing::id(),
+                 [](double v){ return DistParent(v, static_cast<int64_t>(v)); });
+        FullyDistVec<int64_t, DistParent> functormins(A.getcommgrid());
+        A.Reduce(functormins, Column, SRingAddOp<MinDistParentSRing, DistParent>(), MinDistParentSRing::id(),
+                 [](double v){ return DistParent(v, static_cast<int64_t>(v)); });
+        FullyDistVec<int64_t, double> control(A.getcommgrid());
+        A.Reduce(control, Column, minimum<double>(), numeric_limits<double>::max());
+        FullyDistVec<int64_t, double> dists(A.getcommgrid(), A.getncol(), 0.0);
+        dists.EWiseApply(colmins, [](double d, DistParent dp){ return dp.dist; });
+        if(dists == control && colmins == functormins)
+            SpParHelper::Print("Reduce over a semiring working correctly\n");
+        else
+            SpParHelper::Print("ERROR in reduce over a semiring, go fix it!\n");
+
+        // SpParMat::MaskedReduce with the semiring addition, every third row in the mask
+        FullyDistSpVec<int64_t, double> mask(A.getcommgrid(), A.getnrow());
+        for(int64_t i=0; i< A.getnrow(); i+=3)
+            mask.SetElement(i, 1.0);
+        FullyDistVec<int64_t, double> maskedmax(A.getcommgrid()), maskedcontrol(A.getcommgrid());
+        A.MaskedReduce<MaxDoubleSRing>(maskedmax, mask, Column, MaxDoubleSRing::id());
+        A.MaskedReduce(maskedcontrol, mask, Column, maximum<double>(), MaxDoubleSRing::id());
+        bool maskedok = (maskedmax == maskedcontrol);
+        A.MaskedReduce<MaxDoubleSRing>(maskedmax, mask, Column, MaxDoubleSRing::id(), true);
+        A.MaskedReduce(maskedcontrol, mask, Column, maximum<double>(), MaxDoubleSRing::id(), true);
+        if(maskedok && maskedmax == maskedcontrol)
+            SpParHelper::Print("Masked reduce over a semiring working correctly\n");
+        else
+            SpParHelper::Print("ERROR in masked reduce over a semiring, go fix it!\n");
+
+        // dense SpMV: one relaxation step of Bellman-Ford, checked against a row reduction of A + diag(x)
+        FullyDistVec<int64_t, DistParent> x(A.getcommgrid(), A.getncol(), DistParent());
+        x.ApplyInd([](DistParent v, int64_t i){ return DistParent(static_cast<double>(i % 5), i); });
+        FullyDistVec<int64_t, DistParent> y = SpMV<MinDistParentSRing>(A, x);
+        FullyDistVec<int64_t, double> xdist(A.getcommgrid(), A.getncol(), 0.0);
+        xdist.ApplyInd([](double v, int64_t i){ return static_cast<double>(i % 5); });
+        PSpMat_Double AX(A);
+        AX.DimApply(Column, xdist, [](double a, double xd){ return a + xd; });
+        FullyDistVec<int64_t, double> ycontrol(A.getcommgrid());
+        AX.Reduce(ycontrol, Row, minimum<double>(), numeric_limits<double>::max());
+        FullyDistVec<int64_t, double> ydist(A.getcommgrid(), A.getnrow(), 0.0);
+        ydist.EWiseApply(y, [](double d, DistParent dp){ return dp.dist; });
+        if(ydist == ycontrol)
+            SpParHelper::Print("Dense SpMV over a semiring without an MPI_Op working correctly\n");
+        else
+            SpParHelper::Print("ERROR in dense SpMV over a semiring without an MPI_Op, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+typedef SpDCCols<int64_t,double> DCCols;
+typedef SpParMat<int64_t, double, DCCols > PSpMat_Double;
+typedef PlusTimesSRing<double, double> PTFF;
+
+// same number of nonzeros on every processor but a different pattern: the rows of every local block are reversed
+PSpMat_Double ReverseLocalRows(PSpMat_Double & A)
+{
+    SpTuples<int64_t,double> tuples(*(A.seqptr()));
+    int64_t locm = tuples.getnrow();
+    for(int64_t i=0; i< tuples.getnnz(); ++i)
+        tuples.rowindex(i) = locm - 1 - tuples.rowindex(i);
+    tuples.SortColBased();
+    return PSpMat_Double(new SpDCCols<int64_t,double>(tuples, false), A.getcommgrid());
+}
+
+// Checks a reused SpGEMM plan against Mult_AnXBn_Synch after the values of the operands change, and after their pattern does
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./SpGEMMPlanTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./SpGEMMPlanTest 12 8" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        int scale = atoi(argv[1]);
+        int edgefactor = atoi(argv[2]);
+
+        PSpMat_Double A(MPI_COMM_WORLD);
+        A.GenGraph500Data(scale, edgefactor);
+        PSpMat_Double B = A;
+        B.Transpose();
+
+        bool correct = true;
+        double t0 = MPI_Wtime();
+        auto plan = MakeSpGEMMPlan<PTFF, double, DCCols>(A, B);
+        double t1 = MPI_Wtime();
+        PSpMat_Double C = plan.execute(A, B);
+        double t2 = MPI_Wtime();
+        PSpMat_Double CRef = Mult_AnXBn_Synch<PTFF, double, DCCols>(A, B);
+        double t3 = MPI_Wtime();
+        if(!(C == CRef)) correct = false;
+
+        // same patterns, new values
+        for(int it = 0; it < 3; ++it)
+        {
+            A.Apply([](double x){ return 2*x + 0.25; });
+            B.Apply([it](double x){ return x + it; });
+            C = plan.execute(A, B);
+            CRef = Mult_AnXBn_Synch<PTFF, double, DCCols>(A, B);
+            if(!(C == CRef)) correct = false;
+        }
+        if(plan.getrebuilds() != 0) correct = false;
+
+        int64_t cnnz = C.getnnz();
+
+        // a new pattern is detected and planned again
+        PSpMat_Double A2 = A;
+        PSpMat_Double AT = A;
+        AT.Transpose();
+        A2 += AT;
+        C = plan.execute(A2, B);
+        CRef = Mult_AnXBn_Synch<PTFF, double, DCCols>(A2, B);
+        if(!(C == CRef) || plan.getrebuilds() != 1) correct = false;
+
+        // so is a different pattern with as many nonzeros on every processor
+        PSpMat_Double A3 = ReverseLocalRows(A2);
+        C = plan.execute(A3, B);
+        CRef = Mult_AnXBn_Synch<PTFF, double, DCCols>(A3, B);
+        if(!(C == CRef) || plan.getrebuilds() != 2) correct = false;
+
+        ostringstream outs;
+        outs << "C: " << cnnz << " nonzeros, then " << C.getnnz() << " for (A+A')*B; plan " << t1-t0 << " s, execute " << t2-t1 << " s, Mult_AnXBn_Synch " << t3-t2 << " s" << endl;
+        SpParHelper::Print(outs.str());
+
+        if(correct)
+            SpParHelper::Print("Reusable SpGEMM plan working correctly\n");
+        else
+            SpParHelper::Print("ERROR in reusable SpGEMM plan, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
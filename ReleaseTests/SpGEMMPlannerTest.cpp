@@ -0,0 +1,79 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+typedef PlusTimesSRing<double, double> PTFF;
+
+// Checks the planned 2D/3D multiplication, automatic and with every feasible layer count, against 2D SUMMA
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./SpGEMMPlannerTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./SpGEMMPlannerTest 12 8" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        int scale = atoi(argv[1]);
+        int edgefactor = atoi(argv[2]);
+
+        PSpMat_Double A(MPI_COMM_WORLD);
+        A.GenGraph500Data(scale, edgefactor);
+        PSpMat_Double B = A;
+        B.Transpose();
+        PSpMat_Double C = Mult_AnXBn_Synch<PTFF, double, SpDCCols<int64_t,double> >(A, B);
+
+        bool correct = true;
+        SpGEMMLayout layout;
+        PSpMat_Double CP = PlannedSpGEMM<PTFF>(A, B, &layout);
+        int64_t flops = EstimateFLOP<PTFF>(A, B);
+        if(!(CP == C) || layout.flops != flops) correct = false;
+
+        ostringstream outs;
+        outs << "flops: " << layout.flops << ", nnz(C) estimated " << static_cast<int64_t>(layout.nnzC) << ", actual " << C.getnnz() << endl;
+        for(size_t i=0; i< layout.candidates.size(); ++i)
+            outs << "   " << layout.candidates[i] << " layer(s): predicted " << layout.predicted[i] << " s" << endl;
+        outs << "chosen: " << layout.layers << " layer(s)" << endl;
+        SpParHelper::Print(outs.str());
+
+        for(int c : FeasibleLayerCounts(nprocs))
+        {
+            SpGEMMLayoutParams params;
+            params.layers = c;
+            SpGEMMLayout forced;
+            PSpMat_Double CF = PlannedSpGEMM<PTFF>(A, B, &forced, params);
+            if(forced.layers != c || !(CF == C)) correct = false;
+        }
+
+        if(correct)
+            SpParHelper::Print("Planned 2D/3D SpGEMM working correctly\n");
+        else
+            SpParHelper::Print("ERROR in planned 2D/3D SpGEMM, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+// Round trip of a sorted index list through the encoding chosen for it
+bool RoundTrip(const vector<int32_t> & inds, uint8_t expected)
+{
+    uint8_t format;
+    size_t bytes = IndexListEncodedBytes(inds.data(), (int32_t) inds.size(), format);
+    vector<unsigned char> buf(bytes);
+    size_t written = EncodeIndexList(inds.data(), (int32_t) inds.size(), format, buf.data());
+    vector<int32_t> decoded(inds.size());
+    DecodeIndexList(buf.data(), bytes, (int32_t) inds.size(), decoded.data());
+    // the same list padded to whole words, as it is exchanged
+    int words = IndexListEncodedWords(bytes);
+    vector<int32_t> wordbuf(words);
+    EncodeIndexListWords(inds.data(), (int32_t) inds.size(), format, words, wordbuf.data());
+    vector<int32_t> wdecoded(inds.size());
+    DecodeIndexListWords(wordbuf.data(), words, (int32_t) inds.size(), wdecoded.data());
+    return (written == bytes) && (decoded == inds) && (wdecoded == inds) && (inds.empty() || format == expected);
+}
+
+// Checks the index list encodings and the sparse SpMV (whose index lists are encoded) against the dense SpMV
+// for frontiers ranging from nearly empty to nearly full
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./SpMSpVEncodingTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./SpMSpVEncodingTest 14 16" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        vector<int32_t> sparse, clustered, dense, unsorted, empty;
+        for(int32_t i=0; i< 8; ++i) sparse.push_back(i * (1 << 28));    // deltas need 5 bytes as varints
+        for(int32_t i=0; i< 1000; ++i) clustered.push_back(i * 37 + (i % 5));
+        for(int32_t i=0; i< 100000; ++i) if(i % 3 != 0) dense.push_back(i);
+        unsorted = clustered;
+        swap(unsorted[10], unsorted[500]);
+        bool codec = RoundTrip(sparse, SORTED_LIST) && RoundTrip(clustered, DELTA_VARINT) && RoundTrip(dense, BITMAP_SET)
+                    && RoundTrip(unsorted, SORTED_LIST) && RoundTrip(empty, SORTED_LIST);
+        if(codec)
+            SpParHelper::Print("Index list encodings working correctly\n");
+        else
+            SpParHelper::Print("ERROR in index list encodings, go fix it!\n");
+
+        unsigned scale = static_cast<unsigned>(atoi(argv[1]));
+        unsigned edgefactor = static_cast<unsigned>(atoi(argv[2]));
+        typedef PlusTimesSRing<double, double> PTDD;
+        typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+
+        double initiator[4] = {.57, .19, .19, .05};
+        DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+        DEL->GenGraph500Data(initiator, scale, edgefactor, true, true);
+        PSpMat_Double A(*DEL, false);
+        delete DEL;
+
+        bool spmv = true;
+        int64_t strides[] = {4099, 97, 3, 1};  // frontier densities from ~0.02% to 100%
+        for(int s=0; s< 4; ++s)
+        {
+            int64_t stride = strides[s];
+            FullyDistVec<int64_t, double> x(A.getcommgrid(), A.getncol(), 0.0);
+            x.ApplyInd([stride](double val, int64_t ind){ return (ind % stride == 0)? static_cast<double>(1 + ind % 7) : 0.0; });
+            FullyDistSpVec<int64_t, double> spx(x);
+
+            FullyDistVec<int64_t, double> y = SpMV<PTDD>(A, x);
+            FullyDistSpVec<int64_t, double> spy(A.getcommgrid(), A.getnrow());
+            SpMV<PTDD>(A, spx, spy, false);
+            FullyDistVec<int64_t, double> ydense(A.getcommgrid());
+            ydense = spy;
+            spmv = spmv && (ydense == y);
+        }
+        if(spmv)
+            SpParHelper::Print("Sparse SpMV with encoded index lists working correctly\n");
+        else
+            SpParHelper::Print("ERROR in sparse SpMV with encoded index lists, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
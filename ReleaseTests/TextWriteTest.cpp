@@ -0,0 +1,173 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <fstream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <cstdio>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+typedef SpParMat<int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+
+// Goes through the stream (generic) path of the text writers
+class TripleHandler
+{
+public:
+    double getNoNum(int64_t index) { return 1.0; }
+    template <typename c, typename t>
+    double read(std::basic_istream<c,t>& is, int64_t index)
+    {
+        double v;
+        is >> v;
+        return v / 3;
+    }
+    template <typename c, typename t>
+    void save(std::basic_ostream<c,t>& os, const double & v, int64_t index)
+    {
+        os << v * 3;
+    }
+};
+
+string ReadWholeFile(const string & filename)
+{
+    ifstream in(filename.c_str(), ios::binary);
+    stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// Checks the streaming text writers: chunking and the second formatting pass, vectors with and without indices, matrices
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 4)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./TextWriteTest <Scale> <Edgefactor> <Output file>" << endl;
+            cout << "Example: ./TextWriteTest 14 16 output.txt" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        unsigned scale = static_cast<unsigned>(atoi(argv[1]));
+        unsigned edgefactor = static_cast<unsigned>(atoi(argv[2]));
+        string filename(argv[3]);
+        shared_ptr<CommGrid> fullWorld(new CommGrid(MPI_COMM_WORLD, 0, 0));
+
+        // tiny chunks and no budget: every chunk is formatted twice and processes make different numbers of collective writes
+        int64_t nrecords = 1000 + 337 * myrank;
+        int64_t recordsuntil = 0;
+        MPI_Exscan(&nrecords, &recordsuntil, 1, MPIType<int64_t>(), MPI_SUM, MPI_COMM_WORLD);
+        if(myrank == 0) recordsuntil = 0;
+        auto format = [recordsuntil](int64_t begin, int64_t end, string & out)
+        {
+            for(int64_t i = begin; i < end; ++i)
+            {
+                SpHelper::AppendInteger(out, recordsuntil + i);
+                out += (i % 7 == 0)? " seven\n" : "\n";
+            }
+        };
+        int64_t chunks[] = {64, 1 << 20};
+        int64_t budgets[] = {0, 1 << 20};
+        int recordscorrect = 1;
+        for(int k=0; k< 2; ++k)
+        {
+            SpParHelper::WriteTextRecords(filename, "header\n", nrecords, format, MPI_COMM_WORLD, chunks[k], budgets[k]);
+            if(myrank == 0)
+            {
+                stringstream expected;
+                expected << "header\n";
+                int64_t until = 0;
+                for(int p=0; p< nprocs; ++p)
+                {
+                    for(int64_t i=0; i< 1000 + 337 * p; ++i)
+                        expected << until + i << ((i % 7 == 0)? " seven\n" : "\n");
+                    until += 1000 + 337 * p;
+                }
+                recordscorrect = recordscorrect && (ReadWholeFile(filename) == expected.str());
+            }
+            MPI_Barrier(MPI_COMM_WORLD);
+        }
+        MPI_Bcast(&recordscorrect, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (recordscorrect)
+            SpParHelper::Print("Streaming text records working correctly\n");
+        else
+            SpParHelper::Print("ERROR in streaming text records, go fix it!\n");
+
+        // dense vector, with and without indices, through the fast and the stream paths
+        int64_t n = 100003;
+        FullyDistVec<int64_t, double> dense(fullWorld, n, 0.0);
+        dense.ApplyInd([](double val, int64_t ind){ return static_cast<double>(ind) * 0.25; });
+        int densecorrect = 1;
+        for(int k=0; k< 3; ++k)
+        {
+            if(k == 0)  dense.ParallelWrite(filename, true, true);
+            else if(k == 1) dense.ParallelWrite(filename, false, false);
+            else    dense.ParallelWrite(filename, true, TripleHandler(), true);
+            if(myrank == 0)
+            {
+                stringstream expected;
+                for(int64_t i=0; i< n; ++i)
+                {
+                    if(k == 0)  expected << i+1 << '\t' << i * 0.25 << '\n';
+                    else if(k == 1) expected << i * 0.25 << '\n';
+                    else    expected << i+1 << '\t' << i * 0.25 * 3 << '\n';
+                }
+                densecorrect = densecorrect && (ReadWholeFile(filename) == expected.str());
+            }
+            MPI_Barrier(MPI_COMM_WORLD);
+        }
+        MPI_Bcast(&densecorrect, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (densecorrect)
+            SpParHelper::Print("Streaming dense vector output working correctly\n");
+        else
+            SpParHelper::Print("ERROR in streaming dense vector output, go fix it!\n");
+
+        // sparse vector: indices must be global even when processors have different numbers of nonzeros
+        FullyDistSpVec<int64_t, double> sparse(dense, [](double val){ return (static_cast<int64_t>(val * 4) % 5) == 0 || val >= 20000; });
+        sparse.ParallelWrite(filename, true, FullyDistSpVec<int64_t, double>::ScalarReadSaveHandler(), true, true);
+        FullyDistSpVec<int64_t, double> sparseread(fullWorld);
+        sparseread.ParallelRead(filename, true, maximum<double>());
+        if (sparse == sparseread)
+            SpParHelper::Print("Streaming sparse vector output working correctly\n");
+        else
+            SpParHelper::Print("ERROR in streaming sparse vector output, go fix it!\n");
+
+        // matrix round trip
+        double initiator[4] = {.57, .19, .19, .05};
+        DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+        DEL->GenGraph500Data(initiator, scale, edgefactor, true, true);
+        PSpMat_Double A(*DEL, false);
+        delete DEL;
+        A.Apply(bind2nd(multiplies<double>(), 0.25));
+        double t1 = MPI_Wtime();
+        A.ParallelWriteMM(filename, true);
+        double t2 = MPI_Wtime();
+        PSpMat_Double B(A.getcommgrid());
+        B.ParallelReadMM(filename, true, maximum<double>());
+        if (A == B)
+            SpParHelper::Print("Streaming Matrix Market output working correctly\n");
+        else
+            SpParHelper::Print("ERROR in streaming Matrix Market output, go fix it!\n");
+        ostringstream outs;
+        outs << "Wrote " << A.getnnz() << " nonzeros in " << t2-t1 << " s" << endl;
+        SpParHelper::Print(outs.str());
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        if(myrank == 0)
+            remove(filename.c_str());
+    }
+    MPI_Finalize();
+    return 0;
+}
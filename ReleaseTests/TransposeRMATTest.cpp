@@ -0,0 +1,124 @@
+#include <mpi.h>
+#include <sys/time.h>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include "CombBLAS/CombBLAS.h"
+
+using namespace std;
+using namespace combblas;
+
+#ifdef _OPENMP
+int cblas_splits = omp_get_max_threads();
+#else
+int cblas_splits = 1;
+#endif
+
+// Checks the counting sort transpose (local and distributed) against a transpose built from swapped triples
+int main(int argc, char* argv[])
+{
+    int nprocs, myrank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+
+    if(argc < 3)
+    {
+        if(myrank == 0)
+        {
+            cout << "Usage: ./TransposeRMATTest <Scale> <Edgefactor>" << endl;
+            cout << "Example: ./TransposeRMATTest 14 16" << endl;
+        }
+        MPI_Finalize();
+        return -1;
+    }
+    {
+        unsigned scale = static_cast<unsigned>(atoi(argv[1]));
+        unsigned edgefactor = static_cast<unsigned>(atoi(argv[2]));
+        typedef SpDCCols<int64_t, double> DCCols;
+        typedef SpParMat<int64_t, double, DCCols> PSpMat_Double;
+
+        double initiator[4] = {.57, .19, .19, .05};
+        DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+        DEL->GenGraph500Data(initiator, scale, edgefactor, true, true);
+        PSpMat_Double G(*DEL, false);
+        delete DEL;
+        FullyDistVec<int64_t,int64_t> rows(G.getcommgrid()), cols(G.getcommgrid());
+        FullyDistVec<int64_t,double> vals(G.getcommgrid());
+        G.Find(rows, cols, vals);
+        vals.EWiseApply(rows, [](double v, int64_t i){ return static_cast<double>(3 * i); });	// asymmetric values
+        vals.EWiseApply(cols, [](double v, int64_t j){ return v + j; });
+        PSpMat_Double A(G.getnrow(), G.getncol(), rows, cols, vals);
+
+        // local transposes against the sort based one
+        DCCols local = *(A.seqptr());
+        SpTuples<int64_t,double> tuples(local);
+        tuples.SortRowBased();
+        DCCols control(tuples, true);
+        DCCols * transptr = local.TransposeConstPtr();
+        int localok = (local.TransposeConst() == control) && (*transptr == control);
+        local.Transpose();
+        localok = localok && (local == control);
+        local.Transpose();
+        localok = localok && (local == *(A.seqptr()));
+        delete transptr;
+        int globalok;
+        MPI_Allreduce(&localok, &globalok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+        if(globalok)
+            SpParHelper::Print("Local counting sort transpose working correctly\n");
+        else
+            SpParHelper::Print("ERROR in local counting sort transpose, go fix it!\n");
+
+        // distributed transpose against the swapped triples
+        PSpMat_Double AT(A);
+        AT.Transpose();
+        PSpMat_Double ATControl(A.getncol(), A.getnrow(), cols, rows, vals);
+        PSpMat_Double ATT(AT);
+        ATT.Transpose();
+        if(AT == ATControl && ATT == A)
+            SpParHelper::Print("Distributed transpose working correctly\n");
+        else
+            SpParHelper::Print("ERROR in distributed transpose, go fix it!\n");
+
+        // a rectangular matrix whose nonzeros all live in the first row of blocks, so most blocks are empty
+        FullyDistVec<int64_t,int64_t> srows(A.getcommgrid()), scols(A.getcommgrid());
+        FullyDistVec<int64_t,double> svals(A.getcommgrid());
+        srows.iota(100, 0);
+        scols.iota(100, 0);
+        scols.Apply([](int64_t j){ return (j * 37) % 500; });
+        svals.iota(100, 1.0);
+        PSpMat_Double R(100 * nprocs, 500, srows, scols, svals);
+        PSpMat_Double RTControl(500, 100 * nprocs, scols, srows, svals);
+        R.Transpose();
+        if(R == RTControl)
+            SpParHelper::Print("Distributed transpose with empty blocks working correctly\n");
+        else
+            SpParHelper::Print("ERROR in distributed transpose with empty blocks, go fix it!\n");
+
+        // hypersparse: every block has far fewer nonzeros than rows, so Dcsc::Transpose sorts instead of counting
+        FullyDistVec<int64_t,int64_t> hrows(A.getcommgrid()), hcols(A.getcommgrid());
+        FullyDistVec<int64_t,double> hvals(A.getcommgrid());
+        hrows.iota(1000, 0);
+        hrows.Apply([](int64_t i){ return (i * 7919) % (1 << 20); });
+        hcols.iota(1000, 0);
+        hcols.Apply([](int64_t j){ return (j * 37) % 500; });
+        hvals.iota(1000, 1.0);
+        PSpMat_Double H(1 << 20, 500, hrows, hcols, hvals);
+        DCCols hlocal = *(H.seqptr());
+        SpTuples<int64_t,double> htuples(hlocal);
+        htuples.SortRowBased();
+        DCCols hcontrol(htuples, true);
+        localok = (hlocal.TransposeConst() == hcontrol);
+        MPI_Allreduce(&localok, &globalok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+        PSpMat_Double HTControl(500, 1 << 20, hcols, hrows, hvals);
+        H.Transpose();
+        if(globalok && H == HTControl)
+            SpParHelper::Print("Hypersparse transpose working correctly\n");
+        else
+            SpParHelper::Print("ERROR in hypersparse transpose, go fix it!\n");
+    }
+    MPI_Finalize();
+    return 0;
+}
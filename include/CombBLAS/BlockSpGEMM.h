@@ -25,6 +25,224 @@ private:
 
 
 
+	static IT
+	blockOffset (int bid, IT n, int nblocks)
+	{
+		IT	bs = n / nblocks;
+		IT	r  = n % nblocks;
+		return (std::min(static_cast<IT>(bid), r)*(bs+1)) +
+			((bid < r ? 0 : bid-r)*bs);
+	}
+
+
+
+	/*
+	 * SUMMA over the flattened sequence of steps (output block, inner block k,
+	 * stage). The operands of step s+1 are broadcast with IBCastMatrix before
+	 * step s multiplies. The stage products of one inner block are merged into
+	 * the running sum of the output block right away, so at most one output
+	 * block, the stage products of one inner block and two stages of operands
+	 * are held at once.
+	 */
+	template<typename SR,
+			 typename NTC,
+			 typename DERC,
+			 typename CONSUMER>
+	void
+	multiplyBlocks (const std::vector<std::pair<int, int>> &blocks,
+					CONSUMER consume, SUMMAPipelineStats *pipestats)
+	{
+		typedef typename DERA::LocalIT LIA;
+		typedef typename DERB::LocalIT LIB;
+		typedef typename DERC::LocalIT LIC;
+		static_assert(std::is_same<LIA, LIB>::value,
+					  "local index types for both input matrices should be the same");
+		static_assert(std::is_same<LIA, LIC>::value,
+					  "local index types for input and output matrices should be the same");
+
+		if (blocks.empty())
+			return;
+
+		int stages, dummy;
+		std::shared_ptr<CommGrid> GridC =
+			ProductGrid((A_blocks_[0][0].getcommgrid()).get(),
+						(B_blocks_[0][0].getcommgrid()).get(),
+						stages, dummy, dummy);
+		int Aself = GridC->GetRankInProcRow();
+		int Bself = GridC->GetRankInProcCol();
+
+		// sizes of the pieces of every operand block, gathered the first
+		// time the block is broadcast
+		std::vector<LIA **> ASizes(br_*bi_, NULL);
+		std::vector<LIB **> BSizes(bi_*bc_, NULL);
+
+		DERA *APrefetch[2];
+		DERB *BPrefetch[2];
+		std::vector<MPI_Request> AIndReqs[2], ANumReqs[2], BIndReqs[2],
+			BNumReqs[2];
+		for (int slot = 0; slot < 2; ++slot)
+		{
+			AIndReqs[slot].resize(
+				A_blocks_[0][0].seqptr()->GetArrays().indarrs.size(),
+				MPI_REQUEST_NULL);
+			ANumReqs[slot].resize(
+				A_blocks_[0][0].seqptr()->GetArrays().numarrs.size(),
+				MPI_REQUEST_NULL);
+			BIndReqs[slot].resize(
+				B_blocks_[0][0].seqptr()->GetArrays().indarrs.size(),
+				MPI_REQUEST_NULL);
+			BNumReqs[slot].resize(
+				B_blocks_[0][0].seqptr()->GetArrays().numarrs.size(),
+				MPI_REQUEST_NULL);
+		}
+
+		int nsteps = blocks.size() * bi_ * stages;
+		auto postStep = [&] (int s)
+		{
+			int slot = s % 2;
+			int b	 = s / (bi_*stages);
+			int k	 = (s / stages) % bi_;
+			int i	 = s % stages;
+			DERA *Aloc = A_blocks_[blocks[b].first][k].seqptr();
+			DERB *Bloc = B_blocks_[k][blocks[b].second].seqptr();
+
+			LIA **&asizes = ASizes[blocks[b].first*bi_ + k];
+			if (asizes == NULL)
+			{
+				asizes = SpHelper::allocate2D<LIA>(DERA::esscount, stages);
+				SpParHelper::GetSetSizes(*Aloc, asizes, GridC->GetRowWorld());
+			}
+			LIB **&bsizes = BSizes[k*bc_ + blocks[b].second];
+			if (bsizes == NULL)
+			{
+				bsizes = SpHelper::allocate2D<LIB>(DERB::esscount, stages);
+				SpParHelper::GetSetSizes(*Bloc, bsizes, GridC->GetColWorld());
+			}
+
+			std::vector<LIA> ess;
+			if (i == Aself)
+				APrefetch[slot] = Aloc;
+			else
+			{
+				ess.resize(DERA::esscount);
+				for (int j = 0; j < DERA::esscount; ++j)
+					ess[j] = asizes[j][i];
+				APrefetch[slot] = new DERA();
+			}
+			SpParHelper::IBCastMatrix(GridC->GetRowWorld(), *(APrefetch[slot]),
+									  ess, i, AIndReqs[slot], ANumReqs[slot]);
+			ess.clear();
+			if (i == Bself)
+				BPrefetch[slot] = Bloc;
+			else
+			{
+				ess.resize(DERB::esscount);
+				for (int j = 0; j < DERB::esscount; ++j)
+					ess[j] = bsizes[j][i];
+				BPrefetch[slot] = new DERB();
+			}
+			SpParHelper::IBCastMatrix(GridC->GetColWorld(), *(BPrefetch[slot]),
+									  ess, i, BIndReqs[slot], BNumReqs[slot]);
+		};
+		auto stepDone = [&] (int slot)
+		{
+			int flags[4];
+			MPI_Testall(AIndReqs[slot].size(), AIndReqs[slot].data(),
+						&flags[0], MPI_STATUSES_IGNORE);
+			MPI_Testall(ANumReqs[slot].size(), ANumReqs[slot].data(),
+						&flags[1], MPI_STATUSES_IGNORE);
+			MPI_Testall(BIndReqs[slot].size(), BIndReqs[slot].data(),
+						&flags[2], MPI_STATUSES_IGNORE);
+			MPI_Testall(BNumReqs[slot].size(), BNumReqs[slot].data(),
+						&flags[3], MPI_STATUSES_IGNORE);
+			return flags[0] && flags[1] && flags[2] && flags[3];
+		};
+		auto waitStep = [&] (int slot)
+		{
+			MPI_Waitall(AIndReqs[slot].size(), AIndReqs[slot].data(),
+						MPI_STATUSES_IGNORE);
+			MPI_Waitall(ANumReqs[slot].size(), ANumReqs[slot].data(),
+						MPI_STATUSES_IGNORE);
+			MPI_Waitall(BIndReqs[slot].size(), BIndReqs[slot].data(),
+						MPI_STATUSES_IGNORE);
+			MPI_Waitall(BNumReqs[slot].size(), BNumReqs[slot].data(),
+						MPI_STATUSES_IGNORE);
+		};
+
+		SpTuples<LIC, NTC> *acc = NULL;	// sum over the inner blocks so far
+		std::vector<SpTuples<LIC, NTC> *> tomerge;
+		double windowstart = 0;
+		postStep(0);
+		for (int s = 0; s < nsteps; ++s)
+		{
+			int slot = s % 2;
+			int b	 = s / (bi_*stages);
+			int k	 = (s / stages) % bi_;
+			int i	 = s % stages;
+
+			double tw0 = MPI_Wtime();
+			bool hidden = (s > 0) && stepDone(slot);
+			waitStep(slot);
+			double tw1 = MPI_Wtime();
+			if (pipestats != NULL)
+			{
+				if (s > 0)
+				{
+					pipestats->overlapwindow += (tw0 - windowstart);
+					pipestats->exposedcomm += (tw1 - tw0);
+					if (hidden)
+						pipestats->hiddenstages++;
+				}
+				pipestats->stages++;
+			}
+			DERA *ARecv = APrefetch[slot];
+			DERB *BRecv = BPrefetch[slot];
+			if (s+1 < nsteps)
+				postStep(s+1);
+			windowstart = MPI_Wtime();
+
+			SpTuples<LIC, NTC> *C_cont =
+				LocalHybridSpGEMM<SR, NTC>(*ARecv, *BRecv, false, false);
+			if (i != Aself)
+				delete ARecv;
+			if (i != Bself)
+				delete BRecv;
+			if (!C_cont->isZero())
+				tomerge.push_back(C_cont);
+			else
+				delete C_cont;
+
+			if (i+1 < stages)
+				continue;
+
+			// inner block k is complete
+			LIC C_m = A_blocks_[blocks[b].first][k].seqptr()->getnrow();
+			LIC C_n = B_blocks_[k][blocks[b].second].seqptr()->getncol();
+			if (acc != NULL)
+				tomerge.push_back(acc);
+			acc = MultiwayMerge<SR>(tomerge, C_m, C_n, true);
+			tomerge.clear();
+			if (k+1 < bi_)
+				continue;
+
+			DERC *Cloc = new DERC(*acc, false);
+			delete acc;
+			acc = NULL;
+			SpParMat<IT, NTC, DERC> Cblock(Cloc, GridC);
+			consume(Cblock, blockOffset(blocks[b].first, nr_, br_),
+					blockOffset(blocks[b].second, nc_, bc_));
+		}
+
+		for (LIA **sizes : ASizes)
+			if (sizes != NULL)
+				SpHelper::deallocate2D(sizes, DERA::esscount);
+		for (LIB **sizes : BSizes)
+			if (sizes != NULL)
+				SpHelper::deallocate2D(sizes, DERB::esscount);
+	}
+
+
+
 	
 public:
 
@@ -50,26 +268,11 @@ public:
 	SpParMat<IT, NTC, DERC>
 	getNextBlock (IT &roffset, IT &coffset)
 	{
-		assert(bi_ == 1);
-		
 		int rbid = cur_block_ / bc_;
 		int cbid = cur_block_ % bc_;
 		++cur_block_;
 
-		IT	bs = nr_ / br_;
-		IT	r  = nr_ % br_;
-		roffset = (std::min(static_cast<IT>(rbid), r)*(bs+1)) +
-			((rbid < r ? 0 : rbid-r)*bs);
-			// (std::max(static_cast<IT>(0), rbid-r)*bs);
-
-		bs = nc_ / bc_;
-		r  = nc_ % bc_;
-		coffset = (std::min(static_cast<IT>(cbid), r)*(bs+1)) +
-			((cbid < r ? 0 : cbid-r)*bs);
-			// (std::max(static_cast<IT>(0), cbid-r)*bs);
-
-		return Mult_AnXBn_DoubleBuff<SR, NTC, DERC>
-			(A_blocks_[rbid][0], B_blocks_[0][cbid], false, false);
+		return getBlockId<SR, NTC, DERC>(rbid, cbid, roffset, coffset);
 	}
 
 
@@ -88,22 +291,46 @@ public:
 	SpParMat<IT, NTC, DERC>
 	getBlockId (int rbid, int cbid, IT &roffset, IT &coffset)
 	{
-		assert(bi_ == 1);
-		
-		IT	bs = nr_ / br_;
-		IT	r  = nr_ % br_;
-		roffset = (std::min(static_cast<IT>(rbid), r)*(bs+1)) +
-			((rbid < r ? 0 : rbid-r)*bs);
-			// (std::max(static_cast<IT>(0), rbid-r)*bs);
-
-		bs = nc_ / bc_;
-		r  = nc_ % bc_;
-		coffset = (std::min(static_cast<IT>(cbid), r)*(bs+1)) +
-			((cbid < r ? 0 : cbid-r)*bs);
-			// (std::max(static_cast<IT>(0), cbid-r)*bs);
-
-		return Mult_AnXBn_DoubleBuff<SR, NTC, DERC>
-			(A_blocks_[rbid][0], B_blocks_[0][cbid], false, false);
+		SpParMat<IT, NTC, DERC> C;
+		std::vector<std::pair<int, int>> blocks(1, std::make_pair(rbid, cbid));
+		multiplyBlocks<SR, NTC, DERC>
+			(blocks,
+			 [&C, &roffset, &coffset] (SpParMat<IT, NTC, DERC> &Cblock,
+									  IT ro, IT co)
+			 {
+				 C = Cblock;
+				 roffset = ro;
+				 coffset = co;
+			 },
+			 NULL);
+
+		return C;
+	}
+
+
+
+	/**
+	 * Multiplies all remaining blocks in row-major order and hands each one to
+	 * consume(SpParMat<IT, NTC, DERC> &Cblock, IT roffset, IT coffset) as soon as
+	 * it is complete. The consumer may filter, reduce, write or keep the block;
+	 * only one output block is alive at a time, so C as a whole never exists.
+	 * The broadcasts of the next SUMMA stage, including the first stage of the
+	 * next block, are in flight while the current stage multiplies, merges and
+	 * runs the consumer.
+	 * @param[out] pipestats if not NULL, overlap statistics of the pipeline
+	 */
+	template<typename SR,
+			 typename NTC,
+			 typename DERC,
+			 typename CONSUMER>
+	void
+	streamBlocks (CONSUMER consume, SUMMAPipelineStats *pipestats = NULL)
+	{
+		std::vector<std::pair<int, int>> blocks;
+		for (; cur_block_ < br_*bc_; ++cur_block_)
+			blocks.push_back(std::make_pair(cur_block_ / bc_,
+											cur_block_ % bc_));
+		multiplyBlocks<SR, NTC, DERC>(blocks, consume, pipestats);
 	}
 
 
@@ -111,19 +338,10 @@ public:
 	std::vector<IT>
 	getBlockOffsets (bool is_row)
 	{
-		IT	bs = nr_ / br_;
-		IT	r  = nr_ % br_;
-		if (!is_row)
-		{
-			bs = nc_ / bc_;
-			r  = nc_ % bc_;
-		}
-
 		int nblocks = (is_row ? br_ : bc_);
 		std::vector<IT> offsets(nblocks+1);
 		for (int b = 0; b < nblocks; ++b)
-			offsets[b] = (std::min(static_cast<IT>(b), r)*(bs+1)) +
-				((b < r ? 0 : b-r)*bs);
+			offsets[b] = blockOffset(b, (is_row ? nr_ : nc_), nblocks);
 		offsets[nblocks] = (is_row ? nr_ : nc_);
 
 		return offsets;
@@ -129,7 +129,16 @@ class EWiseExtToPlainAdapter
 #include "PreAllocatedSPA.h"
 #include "ParFriends.h"
 #include "BlockSpGEMM.h"
+#include "SpGEMMPlanner.h"
+#include "GalerkinProduct.h"
+#include "SpGEMMPlan.h"
 #include "BFSFriends.h"
+#include "DirOptBFS.h"
+#include "LACC.h"
+#include "FastSV.h"
+#include "IncrementalCC.h"
+#include "RCM.h"
+#include "MinimumDegree.h"
 #include "DistEdgeList.h"
 #include "Semirings.h"
 #include "Operations.h"
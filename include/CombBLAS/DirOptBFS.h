@@ -0,0 +1,213 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _DIR_OPT_BFS_H_
+#define _DIR_OPT_BFS_H_
+
+#include <limits>
+#include <vector>
+#include "SpParMat.h"
+#include "FullyDistVec.h"
+#include "FullyDistSpVec.h"
+#include "OptBuf.h"
+#include "BFSFriends.h"
+
+namespace combblas {
+
+/**
+ * Switching thresholds of the direction-optimizing BFS (Beamer, Asanovic and Patterson, SC'12)
+ * Top-down -> bottom-up when the edges out of the frontier exceed nnz(A)/alpha and the frontier is growing
+ * Bottom-up -> top-down when the frontier has less than n/beta vertices and is shrinking
+ * alpha <= 0 disables the bottom-up steps altogether
+ * The paper compares the frontier edges against the edges still to be checked from unexplored vertices, with alpha = 14;
+ * here they are compared against all of nnz(A), as Applications/DirOptBFS.cpp always did, so the default alpha = 20 is
+ * the one of that code. The default beta = 24 is the paper's; Applications/DirOptBFS.cpp sets beta = 12*nnz(A)/n
+ **/
+struct DirOptBFSParams
+{
+	DirOptBFSParams(): alpha(20.0), beta(24.0) {}
+	double alpha;
+	double beta;
+};
+
+//! Statistics of a single BFS level
+struct DirOptBFSLevel
+{
+	int level;
+	bool bottomup;
+	int64_t frontier;	// vertices discovered at this level
+	double time;		// seconds, including the conversions when switching direction
+};
+
+/**
+ * Direction-optimizing BFS engine, the library version of Applications/DirOptBFS.cpp
+ * The constructor does the one-time preprocessing (32-bit local indices, the local transpose used by the bottom-up steps,
+ * the communication buffers of the top-down steps and the vertex degrees), so many sources can be searched with the same object
+ * A(i,j) is an edge from j to i; for undirected graphs A should be symmetric and without self loops
+ * The thresholds can be changed between calls through GetParams()/SetParams()
+ **/
+template <typename IT, typename DER>
+class DirOptBFS
+{
+public:
+	typedef SpParMat < IT, bool, SpDCCols<int32_t,bool> > PSpMat_s32;	// sequentially use 32-bits for local matrices
+
+	DirOptBFS(const SpParMat<IT,bool,DER> & A, const DirOptBFSParams & myparams = DirOptBFSParams()):
+		Aeff(static_cast<PSpMat_s32>(A)),
+		ALocalT(Aeff.seq().TransposeConstPtr(), Aeff.getcommgrid()),	// this should be copied before the threading is activated
+		degrees(Aeff.getcommgrid()), params(myparams)
+	{
+		Aeff.Reduce(degrees, Column, std::plus<IT>(), static_cast<IT>(0));	// out-degrees
+		Aeff.OptimizeForGraph500(optbuf);	// should be called before threading is activated
+	#ifdef THREADED
+		Aeff.ActivateThreading(cblas_splits);
+	#endif
+	}
+
+	DirOptBFSParams & GetParams() { return params; }
+	void SetParams(const DirOptBFSParams & myparams) { params = myparams; }
+	const FullyDistVec<IT,IT> & GetDegrees() const { return degrees; }
+
+	/**
+	 * Searches from source
+	 * @param[out] parents parent of every reached vertex (the source is its own parent), -1 for unreached vertices
+	 * @param[out] levels distance from the source, -1 for unreached vertices
+	 * @param[out] levelstats if not NULL, filled with the direction, the discovered vertices and the time of every level
+	 * @return number of levels (eccentricity of the source + 1)
+	 **/
+	int Run(IT source, FullyDistVec<IT,IT> & parents, FullyDistVec<IT,IT> & levels, std::vector<DirOptBFSLevel> * levelstats = NULL)
+	{
+		std::shared_ptr<CommGrid> grid = Aeff.getcommgrid();
+		parents = FullyDistVec<IT,IT>(grid, Aeff.getncol(), static_cast<IT>(-1));	// identity is -1
+		levels = FullyDistVec<IT,IT>(grid, Aeff.getncol(), static_cast<IT>(-1));
+		if(levelstats != NULL) levelstats->clear();
+
+		FullyDistSpVec<IT,IT> fringe(grid, Aeff.getncol());	// numerical values are stored 0-based
+		fringe.SetElement(source, source);
+		parents.SetElement(source, source);
+		levels.SetElement(source, 0);
+
+		double num_edges = static_cast<double>(Aeff.getnnz());
+		double num_nodes = static_cast<double>(Aeff.getncol());
+		double up_cutoff = (params.alpha > 0)? num_edges / params.alpha : std::numeric_limits<double>::max();
+		double down_cutoff = num_nodes / params.beta;
+
+		BitMapFringe<int64_t,int64_t> bm_fringe(grid, fringe);
+		BitMapCarousel<IT,IT> done(grid, parents.TotalLength(), bm_fringe.GetSubWordDisp());
+		SpDCCols<int,bool>::SpColIter *starts = CalcSubStarts(ALocalT, fringe, done);
+		IT fringe_size = fringe.getnnz();
+		IT last_fringe_size = 0;
+		IT pred = FrontierEdges(fringe);
+		int level = 0;
+
+		while(fringe_size > 0)
+		{
+			if ((pred > up_cutoff) && (last_fringe_size < fringe_size))
+			{   // Bottom-up
+				double t1 = MPI_Wtime();
+				done.LoadVec(parents);
+				bm_fringe.LoadFromSpVec(fringe);
+				while (fringe_size > 0)
+				{
+					BottomUpStep(ALocalT, fringe, bm_fringe, parents, done, starts);
+					++level;
+					levels.EWiseApply(parents, [level](IT l, IT p){ return (l == -1 && p != -1)? static_cast<IT>(level) : l; });
+					last_fringe_size = fringe_size;
+					fringe_size = bm_fringe.GetNumSet();
+					bool switchdown = (fringe_size < down_cutoff) && (last_fringe_size > fringe_size);
+					if (switchdown)
+						bm_fringe.UpdateSpVec(fringe);
+					double t2 = MPI_Wtime();
+					RecordLevel(levelstats, level, true, fringe_size, t2-t1);
+					t1 = t2;
+					if (switchdown) break;
+				}
+			}
+			else
+			{   // Top-down
+				double t1 = MPI_Wtime();
+				fringe.setNumToInd();
+				fringe = SpMV(Aeff, fringe, optbuf);
+				fringe = EWiseMult(fringe, parents, true, static_cast<IT>(-1));	// clean-up vertices that already have parents
+				parents.Set(fringe);
+				++level;
+				FullyDistSpVec<IT,IT> newlevels = fringe;
+				newlevels.Apply(myset<IT>(level));
+				levels.Set(newlevels);
+				pred = FrontierEdges(fringe);
+				last_fringe_size = fringe_size;
+				fringe_size = fringe.getnnz();
+				RecordLevel(levelstats, level, false, fringe_size, MPI_Wtime()-t1);
+			}
+		}
+		delete [] starts;
+		return level;	// the last step discovered no vertices
+	}
+
+private:
+	//! Number of edges out of the frontier (the values of fringe are overwritten)
+	IT FrontierEdges(FullyDistSpVec<IT,IT> & fringe)
+	{
+		fringe.Apply(myset<IT>(1));
+		return EWiseMult(fringe, degrees, false, static_cast<IT>(0)).Reduce(std::plus<IT>(), static_cast<IT>(0));
+	}
+
+	void RecordLevel(std::vector<DirOptBFSLevel> * levelstats, int level, bool bottomup, IT discovered, double time)
+	{
+		if(levelstats == NULL) return;
+		DirOptBFSLevel stat;
+		stat.level = level;
+		stat.bottomup = bottomup;
+		stat.frontier = static_cast<int64_t>(discovered);
+		stat.time = time;
+		levelstats->push_back(stat);
+	}
+
+	PSpMat_s32 Aeff;
+	PSpMat_s32 ALocalT;
+	OptBuf<int32_t, IT> optbuf;	// let indices be 32-bits
+	FullyDistVec<IT,IT> degrees;
+	DirOptBFSParams params;
+};
+
+/**
+ * Single-source convenience wrapper; construct a DirOptBFS object instead when searching from many sources
+ * @return number of levels
+ **/
+template <typename IT, typename DER>
+int DirectionOptimizingBFS(const SpParMat<IT,bool,DER> & A, IT source, FullyDistVec<IT,IT> & parents, FullyDistVec<IT,IT> & levels,
+						   std::vector<DirOptBFSLevel> * levelstats = NULL, const DirOptBFSParams & params = DirOptBFSParams())
+{
+	DirOptBFS<IT,DER> engine(A, params);
+	return engine.Run(source, parents, levels, levelstats);
+}
+
+}
+
+#endif
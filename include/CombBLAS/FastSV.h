@@ -0,0 +1,513 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _FAST_SV_H_
+#define _FAST_SV_H_
+
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include "SpParMat.h"
+#include "FullyDistVec.h"
+
+namespace combblas {
+
+struct FastSVParams
+{
+	FastSVParams(): denseswitch(0.02) {}
+	double denseswitch;	// the grandparents are exchanged and the min-label SpMV is redone from scratch while more than denseswitch*n of them changed
+};
+
+//! Statistics of a single FastSV iteration
+struct FastSVIteration
+{
+	int iteration;
+	bool dense;
+	int64_t changed;	// grandparents changed by the iteration
+	double time;		// seconds
+};
+
+/**
+ * Connected components of an undirected graph with FastSV (Zhang, Azad and Hu, SIAM PP'20)
+ * Every iteration computes the minimum grandparent of the neighbors (mngp) of each vertex, hooks stochastically
+ * f[f[u]] = min(f[f[u]], mngp[u]), aggressively f[u] = min(f[u], mngp[u]), shortcuts f[u] = min(f[u], gp[u]), and
+ * recomputes the grandparents gp = f[f] until they no longer change
+ *
+ * The SpMV with the Select2nd-min semiring is a fused local kernel: the grandparents stay replicated along the
+ * processor columns and the per-row minima of the local block stay in place between iterations. Grandparents never
+ * increase, so once few of them change only those (index, value) pairs are exchanged and only the columns they belong to
+ * are swept. The changed counts of all processes are allgathered once per iteration; that single collective is the global
+ * convergence test, and it also tells each process whether its processor column has anything to exchange and multiply.
+ * Processor rows whose local minima did not move skip their reduction. The hooking is done on the local pieces directly,
+ * only the hooks and the grandparent requests (one per distinct remote parent) are communicated.
+ * A should be symmetric; the values of A are ignored
+ **/
+template <typename IT, typename NT, typename DER>
+class FastSV
+{
+public:
+	typedef SpParMat < IT, bool, SpDCCols<IT,bool> > PSpMat_Bool;
+
+	FastSV(const SpParMat<IT,NT,DER> & A, const FastSVParams & myparams = FastSVParams()):
+		Abool(static_cast<PSpMat_Bool>(A)), params(myparams)
+	{
+		int nthreads = 1;
+	#ifdef THREADED
+	#pragma omp parallel
+		{
+			nthreads = omp_get_num_threads();
+		}
+	#endif
+		Abool.ActivateThreading(nthreads*4);
+	}
+
+	FastSVParams & GetParams() { return params; }
+	void SetParams(const FastSVParams & myparams) { params = myparams; }
+
+	/**
+	 * @param[out] cclabel component of every vertex, numbered 0,...,nCC-1 in the order of their smallest vertex
+	 * @param[out] iterstats if not NULL, filled with the statistics of every iteration
+	 * @return number of connected components (nCC)
+	 **/
+	IT Run(FullyDistVec<IT,IT> & cclabel, std::vector<FastSVIteration> * iterstats = NULL)
+	{
+		std::shared_ptr<CommGrid> commGrid = Abool.getcommgrid();
+		MPI_Comm World = commGrid->GetWorld();
+		MPI_Comm ColWorld = commGrid->GetColWorld();
+		MPI_Comm RowWorld = commGrid->GetRowWorld();
+		int nprocs = commGrid->GetSize();
+		int diagneigh = commGrid->GetComplementRank();
+		int colneighs = commGrid->GetGridRows();
+		int rowneighs = commGrid->GetGridCols();
+		if(iterstats != NULL) iterstats->clear();
+
+		IT nrows = Abool.getnrow();
+		cclabel = FullyDistVec<IT,IT>(commGrid, nrows, static_cast<IT>(0));	// also the layout of every vector below
+		IT mylen = cclabel.LocArrSize();
+		IT myoffset = cclabel.LengthUntil();
+
+		// sizes of the transposed pieces along the processor column, as in the dense SpMV
+		int trxsize = 0;
+		int xsize = static_cast<int>(mylen);
+		MPI_Sendrecv(&xsize, 1, MPI_INT, diagneigh, TRX, &trxsize, 1, MPI_INT, diagneigh, TRX, World, MPI_STATUS_IGNORE);
+		std::vector<int> colsize(colneighs), coldpls(colneighs, 0);
+		MPI_Allgather(&trxsize, 1, MPI_INT, colsize.data(), 1, MPI_INT, ColWorld);
+		std::partial_sum(colsize.begin(), colsize.end()-1, coldpls.begin()+1);
+
+		IT locrows = Abool.getlocalrows();
+		std::vector<int> recvcounts(rowneighs);	// reduce-scatter along the processor row
+		for(int i=0; i< rowneighs; ++i)
+		{
+			IT begptr = cclabel.RowLenUntil(i);
+			IT endptr = (i == rowneighs-1)? locrows : cclabel.RowLenUntil(i+1);
+			recvcounts[i] = static_cast<int>(endptr-begptr);
+		}
+
+		std::vector<IT> f(mylen), gp(mylen), mngp(mylen, Select2ndMin::id());
+		for(IT i=0; i< mylen; ++i)
+			f[i] = gp[i] = myoffset + i;
+		std::vector<IT> gpcol(Abool.getlocalcols());	// grandparents replicated along the processor column
+		std::vector<IT> ymin(locrows, Select2ndMin::id());	// per-row minima of the local block
+		std::vector<IT> changed(mylen);			// local indices whose grandparent changed in the last iteration
+		std::iota(changed.begin(), changed.end(), static_cast<IT>(0));	// initially every grandparent is new
+		std::vector<IT> counts(nprocs);			// lengths of the changed lists of all processes
+		MPI_Allgather(&mylen, 1, MPIType<IT>(), counts.data(), 1, MPIType<IT>(), World);
+		IT diff = nrows;
+
+		int iteration = 1;
+		while(diff > 0)
+		{
+			double t1 = MPI_Wtime();
+			bool dense = (diff > params.denseswitch * nrows);
+
+			// min-label SpMV: mngp[u] = min over the neighbors v of u of gp[v]
+			int ychanged = 1;
+			if(dense)
+			{
+				std::vector<IT> trxnums(trxsize);
+				MPI_Sendrecv(gp.data(), xsize, MPIType<IT>(), diagneigh, TRX, trxnums.data(), trxsize, MPIType<IT>(), diagneigh, TRX, World, MPI_STATUS_IGNORE);
+				MPI_Allgatherv(trxnums.data(), trxsize, MPIType<IT>(), gpcol.data(), colsize.data(), coldpls.data(), MPIType<IT>(), ColWorld);
+				std::fill(ymin.begin(), ymin.end(), Select2ndMin::id());
+				MinLabel(gpcol, ymin);
+			}
+			else
+			{
+				std::vector<IT> colchanged;
+				ExchangeChanged(gp, changed, counts, coldpls, gpcol, colchanged);
+				ychanged = colchanged.empty()? 0 : MinLabelChanged(gpcol, colchanged, ymin);
+				MPI_Allreduce(MPI_IN_PLACE, &ychanged, 1, MPI_INT, MPI_LOR, RowWorld);
+			}
+			if(ychanged)	// otherwise nobody in my processor row moved and mngp is the same as in the last iteration
+				MPI_Reduce_scatter(ymin.data(), mngp.data(), recvcounts.data(), MPIType<IT>(), Select2ndMin::mpi_op(), RowWorld);
+
+			// stochastic hooking of the parents (only useful if it lowers f[f[u]] = gp[u]), aggressive hooking and shortcutting
+			std::vector<IT> hooktgt, hookval;
+			for(IT i=0; i< mylen; ++i)
+			{
+				if(mngp[i] < gp[i])
+				{
+					hooktgt.push_back(f[i]);
+					hookval.push_back(mngp[i]);
+				}
+			}
+		#ifdef THREADED
+		#pragma omp parallel for
+		#endif
+			for(IT i=0; i< mylen; ++i)
+				f[i] = std::min(f[i], std::min(mngp[i], gp[i]));
+			ScatterMin(cclabel, hooktgt, hookval, f);
+
+			// new grandparents and the convergence test
+			std::vector<IT> newgp;
+			Gather(cclabel, f, f, newgp);
+			changed.clear();
+			for(IT i=0; i< mylen; ++i)
+			{
+				if(newgp[i] != gp[i])
+					changed.push_back(i);
+			}
+			gp.swap(newgp);
+			IT mychanged = static_cast<IT>(changed.size());
+			MPI_Allgather(&mychanged, 1, MPIType<IT>(), counts.data(), 1, MPIType<IT>(), World);
+			diff = std::accumulate(counts.begin(), counts.end(), static_cast<IT>(0));
+
+			if(iterstats != NULL)
+			{
+				FastSVIteration stat;
+				stat.iteration = iteration;
+				stat.dense = dense;
+				stat.changed = static_cast<int64_t>(diff);
+				stat.time = MPI_Wtime() - t1;
+				iterstats->push_back(stat);
+			}
+			++iteration;
+		}
+		return LabelCC(cclabel, gp);
+	}
+
+private:
+	//! Select2nd-min semiring, only its identity and MPI_Op are used by the fused kernels
+	struct Select2ndMin
+	{
+		static IT id() { return std::numeric_limits<IT>::max(); }
+		static MPI_Op mpi_op() { return MPI_MIN; }
+	};
+
+	//! ymin[i] = min(ymin[i], gpcol[j]) for every nonzero A(i,j) of the local block; a column's label is read once
+	void MinLabel(const std::vector<IT> & gpcol, std::vector<IT> & ymin)
+	{
+		SpDCCols<IT,bool> * spSeq = Abool.seqptr();
+		int splits = spSeq->getnsplit();
+		if(splits > 0)
+		{
+			IT perpiece = spSeq->getnrow() / splits;
+		#ifdef THREADED
+		#pragma omp parallel for
+		#endif
+			for(int s=0; s< splits; ++s)
+				MinLabelBlock(spSeq->GetDCSC(s), gpcol, ymin.data() + s*perpiece);
+		}
+		else
+		{
+			MinLabelBlock(spSeq->GetDCSC(), gpcol, ymin.data());
+		}
+	}
+
+	static void MinLabelBlock(const Dcsc<IT,bool> * dcsc, const std::vector<IT> & gpcol, IT * ymin)
+	{
+		if(dcsc == NULL) return;
+		for(IT j=0; j< dcsc->nzc; ++j)
+		{
+			IT label = gpcol[dcsc->jc[j]];
+			for(IT i = dcsc->cp[j]; i < dcsc->cp[j+1]; ++i)
+				ymin[dcsc->ir[i]] = std::min(ymin[dcsc->ir[i]], label);
+		}
+	}
+
+	/**
+	 * Same as MinLabel but only sweeps the (sorted) columns in colchanged; exact because labels only decrease
+	 * @return 1 if any minimum decreased
+	 **/
+	int MinLabelChanged(const std::vector<IT> & gpcol, const std::vector<IT> & colchanged, std::vector<IT> & ymin)
+	{
+		SpDCCols<IT,bool> * spSeq = Abool.seqptr();
+		int splits = spSeq->getnsplit();
+		int decreased = 0;
+		if(splits > 0)
+		{
+			IT perpiece = spSeq->getnrow() / splits;
+		#ifdef THREADED
+		#pragma omp parallel for reduction(|:decreased)
+		#endif
+			for(int s=0; s< splits; ++s)
+				decreased |= MinLabelBlockChanged(spSeq->GetDCSC(s), gpcol, colchanged, ymin.data() + s*perpiece);
+		}
+		else
+		{
+			decreased = MinLabelBlockChanged(spSeq->GetDCSC(), gpcol, colchanged, ymin.data());
+		}
+		return decreased;
+	}
+
+	static int MinLabelBlockChanged(const Dcsc<IT,bool> * dcsc, const std::vector<IT> & gpcol, const std::vector<IT> & colchanged, IT * ymin)
+	{
+		if(dcsc == NULL) return 0;
+		int decreased = 0;
+		IT * jcpos = dcsc->jc;
+		IT * jcend = dcsc->jc + dcsc->nzc;
+		for(auto col : colchanged)
+		{
+			jcpos = std::lower_bound(jcpos, jcend, col);	// colchanged is sorted, so the search only moves forward
+			if(jcpos == jcend) break;
+			if(*jcpos != col) continue;
+			IT j = jcpos - dcsc->jc;
+			IT label = gpcol[col];
+			for(IT i = dcsc->cp[j]; i < dcsc->cp[j+1]; ++i)
+			{
+				if(label < ymin[dcsc->ir[i]])
+				{
+					ymin[dcsc->ir[i]] = label;
+					decreased = 1;
+				}
+			}
+		}
+		return decreased;
+	}
+
+	/**
+	 * Sparse version of the transpose + column allgather: only the changed grandparents travel, as (index, value) pairs
+	 * counts holds the changed list lengths of all processes, so empty messages and idle processor columns are skipped
+	 * piecedpls[k] is where the transposed piece of the k-th process of my processor column starts in gpcol
+	 * @param[out] colchanged sorted local column indices that were updated in gpcol
+	 **/
+	void ExchangeChanged(const std::vector<IT> & gp, const std::vector<IT> & changed, const std::vector<IT> & counts,
+			     const std::vector<int> & piecedpls, std::vector<IT> & gpcol, std::vector<IT> & colchanged)
+	{
+		std::shared_ptr<CommGrid> commGrid = Abool.getcommgrid();
+		int myrank = commGrid->GetRank();
+		int diagneigh = commGrid->GetComplementRank();
+		int mycol = commGrid->GetRankInProcRow();
+		int colneighs = commGrid->GetGridRows();
+
+		std::vector<int> colsize(colneighs), coldpls(colneighs, 0);
+		for(int k=0; k< colneighs; ++k)	// the k-th process of my processor column got its piece from P(mycol,k)
+			colsize[k] = 2 * static_cast<int>(counts[commGrid->GetRank(mycol, k)]);
+		std::partial_sum(colsize.begin(), colsize.end()-1, coldpls.begin()+1);
+		int colnz = coldpls[colneighs-1] + colsize[colneighs-1];
+
+		int sendsize = 2 * static_cast<int>(counts[myrank]);
+		int trxsize = 2 * static_cast<int>(counts[diagneigh]);
+		std::vector<IT> trxpairs(trxsize);
+		if(sendsize > 0 || trxsize > 0)
+		{
+			std::vector<IT> pairs(sendsize);
+			for(size_t i=0; i< changed.size(); ++i)
+			{
+				pairs[2*i] = changed[i];
+				pairs[2*i+1] = gp[changed[i]];
+			}
+			MPI_Sendrecv(pairs.data(), sendsize, MPIType<IT>(), diagneigh, TRX, trxpairs.data(), trxsize, MPIType<IT>(), diagneigh, TRX,
+				     commGrid->GetWorld(), MPI_STATUS_IGNORE);
+		}
+		if(colnz == 0) return;
+
+		std::vector<IT> colpairs(colnz);
+		MPI_Allgatherv(trxpairs.data(), trxsize, MPIType<IT>(), colpairs.data(), colsize.data(), coldpls.data(), MPIType<IT>(), commGrid->GetColWorld());
+		colchanged.resize(colnz/2);
+		for(int k=0; k< colneighs; ++k)
+		{
+			for(int i = coldpls[k]; i < coldpls[k] + colsize[k]; i += 2)
+			{
+				IT col = piecedpls[k] + colpairs[i];
+				gpcol[col] = colpairs[i+1];
+				colchanged[i/2] = col;
+			}
+		}
+	}
+
+	/**
+	 * out[i] = global vector (local pieces in mine, laid out as layout) at index req[i]
+	 * Remote indices are bucketed by owner and every distinct one is requested once; in the later iterations most vertices
+	 * point to a handful of roots, so this keeps the grandparent exchange proportional to the number of distinct parents
+	 **/
+	static void Gather(const FullyDistVec<IT,IT> & layout, const std::vector<IT> & mine, const std::vector<IT> & req, std::vector<IT> & out)
+	{
+		MPI_Comm World = layout.getcommgrid()->GetWorld();
+		int nprocs = layout.getcommgrid()->GetSize();
+		int myrank = layout.getcommgrid()->GetRank();
+		IT length = static_cast<IT>(req.size());
+		out.resize(length);
+
+		std::vector< std::vector<IT> > data_req(nprocs);
+		std::vector<int> owners(length);
+		std::vector<IT> lindices(length);
+		for(IT i=0; i< length; ++i)
+		{
+			IT locind;
+			int owner = layout.Owner(req[i], locind);
+			owners[i] = owner;
+			lindices[i] = locind;
+			if(owner == myrank)
+				out[i] = mine[locind];
+			else
+				data_req[owner].push_back(locind);
+		}
+		std::vector<int> sendcnt(nprocs), recvcnt(nprocs), sdispls(nprocs+1, 0), rdispls(nprocs+1, 0);
+		for(int p=0; p< nprocs; ++p)
+		{
+			std::sort(data_req[p].begin(), data_req[p].end());
+			data_req[p].erase(std::unique(data_req[p].begin(), data_req[p].end()), data_req[p].end());
+			sendcnt[p] = static_cast<int>(data_req[p].size());
+		}
+		MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);
+		std::partial_sum(sendcnt.begin(), sendcnt.end(), sdispls.begin()+1);
+		std::partial_sum(recvcnt.begin(), recvcnt.end(), rdispls.begin()+1);
+
+		std::vector<IT> sendbuf(sdispls[nprocs]), recvbuf(rdispls[nprocs]);
+		for(int p=0; p< nprocs; ++p)
+			std::copy(data_req[p].begin(), data_req[p].end(), sendbuf.begin() + sdispls[p]);
+		MPI_Alltoallv(sendbuf.data(), sendcnt.data(), sdispls.data(), MPIType<IT>(), recvbuf.data(), recvcnt.data(), rdispls.data(), MPIType<IT>(), World);
+	#ifdef THREADED
+	#pragma omp parallel for
+	#endif
+		for(IT i=0; i< static_cast<IT>(recvbuf.size()); ++i)
+			recvbuf[i] = mine[recvbuf[i]];
+		std::vector<IT> databuf(sdispls[nprocs]);	// the response counts are the same as the request counts
+		MPI_Alltoallv(recvbuf.data(), recvcnt.data(), rdispls.data(), MPIType<IT>(), databuf.data(), sendcnt.data(), sdispls.data(), MPIType<IT>(), World);
+
+	#ifdef THREADED
+	#pragma omp parallel for
+	#endif
+		for(IT i=0; i< length; ++i)
+		{
+			int owner = owners[i];
+			if(owner != myrank)
+			{
+				IT pos = std::lower_bound(data_req[owner].begin(), data_req[owner].end(), lindices[i]) - data_req[owner].begin();
+				out[i] = databuf[sdispls[owner] + pos];
+			}
+		}
+	}
+
+	//! mine[tgt[i]] = min(mine[tgt[i]], val[i]); hooks to the same remote parent are combined before they are sent
+	static void ScatterMin(const FullyDistVec<IT,IT> & layout, const std::vector<IT> & tgt, const std::vector<IT> & val, std::vector<IT> & mine)
+	{
+		MPI_Comm World = layout.getcommgrid()->GetWorld();
+		int nprocs = layout.getcommgrid()->GetSize();
+		int myrank = layout.getcommgrid()->GetRank();
+
+		std::vector< std::vector< std::pair<IT,IT> > > hookBuf(nprocs);
+		for(size_t i=0; i< tgt.size(); ++i)
+		{
+			IT locind;
+			int owner = layout.Owner(tgt[i], locind);
+			if(owner == myrank)
+				mine[locind] = std::min(mine[locind], val[i]);
+			else
+				hookBuf[owner].push_back(std::make_pair(locind, val[i]));
+		}
+		std::vector<int> sendcnt(nprocs), recvcnt(nprocs), sdispls(nprocs+1, 0), rdispls(nprocs+1, 0);
+		for(int p=0; p< nprocs; ++p)
+		{
+			std::sort(hookBuf[p].begin(), hookBuf[p].end());	// the first pair of every target has the smallest hook
+			hookBuf[p].erase(std::unique(hookBuf[p].begin(), hookBuf[p].end(),
+						     [](const std::pair<IT,IT> & a, const std::pair<IT,IT> & b){ return a.first == b.first; }), hookBuf[p].end());
+			sendcnt[p] = 2 * static_cast<int>(hookBuf[p].size());
+		}
+		MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);
+		std::partial_sum(sendcnt.begin(), sendcnt.end(), sdispls.begin()+1);
+		std::partial_sum(recvcnt.begin(), recvcnt.end(), rdispls.begin()+1);
+
+		std::vector<IT> sendbuf(sdispls[nprocs]), recvbuf(rdispls[nprocs]);
+		for(int p=0; p< nprocs; ++p)
+		{
+			for(size_t i=0; i< hookBuf[p].size(); ++i)
+			{
+				sendbuf[sdispls[p] + 2*i] = hookBuf[p][i].first;
+				sendbuf[sdispls[p] + 2*i+1] = hookBuf[p][i].second;
+			}
+		}
+		MPI_Alltoallv(sendbuf.data(), sendcnt.data(), sdispls.data(), MPIType<IT>(), recvbuf.data(), recvcnt.data(), rdispls.data(), MPIType<IT>(), World);
+		for(size_t i=0; i< recvbuf.size(); i += 2)
+			mine[recvbuf[i]] = std::min(mine[recvbuf[i]], recvbuf[i+1]);
+	}
+
+	/**
+	 * At convergence every vertex points to the smallest vertex of its component (its root)
+	 * Roots are numbered incrementally, every other vertex takes the number of its root
+	 **/
+	static IT LabelCC(FullyDistVec<IT,IT> & cclabel, const std::vector<IT> & gp)
+	{
+		MPI_Comm World = cclabel.getcommgrid()->GetWorld();
+		IT mylen = cclabel.LocArrSize();
+		IT myoffset = cclabel.LengthUntil();
+		std::vector<IT> rootlabel(mylen, static_cast<IT>(-1));
+		IT myroots = 0;
+		for(IT i=0; i< mylen; ++i)
+		{
+			if(gp[i] == myoffset + i)
+				rootlabel[i] = myroots++;
+		}
+		IT rootsbefore = 0, nCC = 0;
+		MPI_Exscan(&myroots, &rootsbefore, 1, MPIType<IT>(), MPI_SUM, World);
+		MPI_Allreduce(&myroots, &nCC, 1, MPIType<IT>(), MPI_SUM, World);
+		if(cclabel.getcommgrid()->GetRank() == 0) rootsbefore = 0;	// MPI_Exscan leaves it undefined on the first process
+		for(IT i=0; i< mylen; ++i)
+		{
+			if(rootlabel[i] >= 0) rootlabel[i] += rootsbefore;
+		}
+		std::vector<IT> label;
+		Gather(cclabel, rootlabel, gp, label);
+		for(IT i=0; i< mylen; ++i)
+			cclabel.SetLocalElement(i, label[i]);
+		return nCC;
+	}
+
+	PSpMat_Bool Abool;
+	FastSVParams params;
+};
+
+/**
+ * Single-call convenience wrapper
+ * @return component labels, nCC is set to the number of components
+ **/
+template <typename IT, typename NT, typename DER>
+FullyDistVec<IT,IT> FastSVConnectedComponents(const SpParMat<IT,NT,DER> & A, IT & nCC, const FastSVParams & params = FastSVParams(),
+					      std::vector<FastSVIteration> * iterstats = NULL)
+{
+	FastSV<IT,NT,DER> engine(A, params);
+	FullyDistVec<IT,IT> cclabel(A.getcommgrid());
+	nCC = engine.Run(cclabel, iterstats);
+	return cclabel;
+}
+
+}
+
+#endif
@@ -30,6 +30,8 @@
 #ifndef _COMBBLAS_FILE_HEADER_
 #define _COMBBLAS_FILE_HEADER_
 
+#include <sys/mman.h>
+#include <unistd.h>
 #include "CombBLAS.h"
 
 namespace combblas {
@@ -102,8 +104,97 @@ inline HeaderInfo ParseHeader(const std::string & inputname, FILE * & f, int & s
 	seeklength = 4 + 6 * sizeof(uint64_t);
 	return hinfo;
 }
-				  
 
+
+/**
+ * Partitioned checkpoint of a SpParMat<IT,NT,SpDCCols<LIT,NT>> (see SpParMat::SaveCheckpoint)
+ * Layout: CheckpointHeader, one CheckpointBlock per process (in rank order), then the blocks themselves
+ * Every block starts at a multiple of CHECKPOINTALIGN and holds jc[nzc], cp[nzc+1], ir[nnz], numx[nnz] of the local DCSC,
+ * each section padded to 8 bytes, so that a block can be memory mapped and copied with no parsing
+ **/
+#define CHECKPOINTALIGN 4096
+#define CHECKPOINTVERSION 1
+
+struct CheckpointHeader
+{
+	char magic[4];		// "CBCK"
+	uint32_t version;
+	uint64_t itsize;	// sizeof(LIT)
+	uint64_t ntsize;	// sizeof(NT)
+	uint64_t m;
+	uint64_t n;
+	uint64_t nnz;
+	uint64_t gridrows;	// process grid of the writer
+	uint64_t gridcols;
+};
+
+struct CheckpointBlock
+{
+	uint64_t offset;	// in bytes, from the beginning of the file
+	uint64_t nnz;
+	uint64_t nzc;
+	uint64_t nrow;
+	uint64_t ncol;
+	uint64_t roffset;	// global index of the first row of the block
+	uint64_t coffset;	// global index of the first column of the block
+};
+
+inline uint64_t CheckpointRoundUp(uint64_t bytes, uint64_t alignment)
+{
+	return ((bytes + alignment - 1) / alignment) * alignment;
 }
-#endif 
 
+/**
+ * Offsets of the jc, cp, ir and numx sections within a block
+ * @return size of the block in bytes, including the padding up to the beginning of the next block
+ **/
+template <typename LIT, typename NT>
+uint64_t CheckpointSections(uint64_t nnz, uint64_t nzc, uint64_t * sections)
+{
+	if(nnz == 0)
+	{
+		std::fill_n(sections, 4, 0);
+		return 0;
+	}
+	sections[0] = 0;
+	sections[1] = sections[0] + CheckpointRoundUp(nzc * sizeof(LIT), 8);
+	sections[2] = sections[1] + CheckpointRoundUp((nzc+1) * sizeof(LIT), 8);
+	sections[3] = sections[2] + CheckpointRoundUp(nnz * sizeof(LIT), 8);
+	return CheckpointRoundUp(sections[3] + nnz * sizeof(NT), CHECKPOINTALIGN);
+}
+
+/**
+ * Read-only memory mapping of [offset, offset+length) of an open file; offset does not need to be page aligned
+ * data is NULL if the mapping failed (or length is zero)
+ **/
+class MappedFileRange
+{
+public:
+	MappedFileRange(int fd, uint64_t offset, uint64_t length, bool sequential): data(NULL), base(NULL), maplength(0)
+	{
+		if(length == 0) return;
+		uint64_t pagesize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+		uint64_t aligned = offset - (offset % pagesize);
+		maplength = length + (offset - aligned);
+		void * mapped = mmap(NULL, maplength, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(aligned));
+		if(mapped == MAP_FAILED) return;
+		base = mapped;
+		data = static_cast<char*>(base) + (offset - aligned);
+		if(sequential)
+			madvise(base, maplength, MADV_SEQUENTIAL);
+	}
+	~MappedFileRange()
+	{
+		if(base != NULL) munmap(base, maplength);
+	}
+	char * data;
+
+private:
+	MappedFileRange(const MappedFileRange &);
+	MappedFileRange & operator=(const MappedFileRange &);
+	void * base;
+	size_t maplength;
+};
+
+}
+#endif
@@ -756,15 +756,11 @@ FullyDistSpVec<IT, IT> FullyDistSpVec<IT, NT>::sort()
 */
 
 
-/*
- TODO: This function is just a hack at this moment.
- The indices of the return vector is not correct.
- FIX this
- */
-// - sorts the entries with respect to nonzero values
+// - sorts the nonzeros with respect to their values, without changing the vector itself
 // - ignores structural zeros
-// - keeps the sparsity structure intact
-// - returns a permutation representing the mapping from old to new locations
+// - returns the permutation: the original (global) index of the kth smallest nonzero is the kth numerical value,
+//   each processor keeps as many as it has nonzeros, stored at local positions 0,1,2,...
+// integral values go through the distributed radix sort, others through MemoryEfficientPSort
 template <class IT, class NT>
 FullyDistSpVec<IT, IT> FullyDistSpVec<IT, NT>::sort()
 {
@@ -774,8 +770,6 @@ FullyDistSpVec<IT, IT> FullyDistSpVec<IT, NT>::sort()
 	IT nnz = getlocnnz();
 	std::pair<NT,IT> * vecpair = new std::pair<NT,IT>[nnz];
 
-
-
 	int nprocs, rank;
 	MPI_Comm_size(World, &nprocs);
 	MPI_Comm_rank(World, &rank);
@@ -791,22 +785,17 @@ FullyDistSpVec<IT, IT> FullyDistSpVec<IT, NT>::sort()
 	{
 		vecpair[i].first = num[i];	// we'll sort wrt numerical values
 		vecpair[i].second = ind[i] + until;
-
 	}
-	std::vector<std::pair<NT,IT>> sorted = SpParHelper::KeyValuePSort(vecpair, nnz, dist, World);
+	SpParHelper::PSortByKey(vecpair, nnz, dist, World);
 
-    nnz = sorted.size();
     temp.num.resize(nnz);
     temp.ind.resize(nnz);
-
 #ifdef THREADED
 #pragma omp parallel for
 #endif
 	for(IT i=0; i< nnz; ++i)
 	{
-		//num[i] = sorted[i].first;	// sorted range (change the object itself)
-		//nind[i] = ind[i];		// make sure the sparsity distribution is the same
-		temp.num[i] = sorted[i].second;	// inverse permutation stored as numerical values
+		temp.num[i] = vecpair[i].second;	// inverse permutation stored as numerical values
         temp.ind[i] = i; // we are not using this information at this moment
 	}
 
@@ -1310,84 +1299,41 @@ template <class HANDLER>
 void FullyDistSpVec<IT,NT>::ParallelWrite(const std::string & filename, bool onebased, HANDLER handler, bool includeindices, bool includeheader)
 {
        	int myrank = commGrid->GetRank();
-    	int nprocs = commGrid->GetSize();
 	IT totalLength = TotalLength();
 	IT totalNNZ = getnnz();
 
-	std::stringstream ss;
+	std::string header;
 	if(includeheader && myrank == 0)
 	{
+		std::stringstream ss;
 		ss << totalLength << '\t' << totalNNZ << '\n';	// rank-0 has the header
+		header = ss.str();
 	}
-	IT entries =  getlocnnz();
-	IT sizeuntil = 0;
-	MPI_Exscan( &entries, &sizeuntil, 1, MPIType<IT>(), MPI_SUM, commGrid->GetWorld() );
-	if(myrank == 0) sizeuntil = 0;	// because MPI_Exscan says the recvbuf in process 0 is undefined
+	IT offset = LengthUntil();	// local indices are relative to the beginning of this processor's piece
+	if(onebased)	offset += 1;	// increment by 1
 
-	if(includeindices)
-	{
-		if(onebased)	sizeuntil += 1;	// increment by 1
-
-		for(IT i=0; i< entries; ++i)
-		{
-			ss << ind[i]+sizeuntil << '\t';
-			handler.save(ss, num[i], ind[i]+sizeuntil);
-			ss << '\n';
-		}
-	}
-	else	// the base doesn't matter if we don't include indices
+	typedef TextValueWriter<NT, std::is_same<HANDLER, ScalarReadSaveHandler>::value && IsFastText<NT>::value> ValueWriter;
+	auto format = [&](int64_t begin, int64_t end, std::string & out)
 	{
+		HANDLER myhandler(handler);	// handlers are not required to be thread-safe
+		ValueWriter writer;
 		IT dummy = 0;	// dummy because we don't want indices to be printed
-		for(IT i=0; i< entries; ++i)
+		for(int64_t i = begin; i < end; ++i)
 		{
-			handler.save(ss, num[i], dummy);
-			ss << '\n';
+			if(includeindices)
+			{
+				SpHelper::AppendInteger(out, ind[i]+offset);
+				out += '\t';
+				writer.Append(out, myhandler, num[i], ind[i]+offset);
+			}
+			else	// the base doesn't matter if we don't include indices
+			{
+				writer.Append(out, myhandler, num[i], dummy);
+			}
+			out += '\n';
 		}
-	}
-
-	std::string text = ss.str();
-
-	int64_t * bytes = new int64_t[nprocs];
-    	bytes[myrank] = text.size();
-    	MPI_Allgather(MPI_IN_PLACE, 1, MPIType<int64_t>(), bytes, 1, MPIType<int64_t>(), commGrid->GetWorld());
-	int64_t bytesuntil = std::accumulate(bytes, bytes+myrank, static_cast<int64_t>(0));
-	int64_t bytestotal = std::accumulate(bytes, bytes+nprocs, static_cast<int64_t>(0));
-
-    	if(myrank == 0)	// only leader rights the original file with no content
-    	{
-		std::ofstream ofs(filename.c_str(), std::ios::binary | std::ios::out);
-#ifdef COMBBLAS_DEBUG
-    std::cout << "Creating file with " << bytestotal << " bytes" << std::endl;
-#endif
-    		ofs.seekp(bytestotal - 1);
-    		ofs.write("", 1);	// this will likely create a sparse file so the actual disks won't spin yet
-		ofs.close();
-   	}
-     	MPI_Barrier(commGrid->GetWorld());
-
-	struct stat st;     // get file size
-    	if (stat(filename.c_str(), &st) == -1)
-    	{
-       		MPI_Abort(commGrid->GetWorld(), NOFILE);
-    	}
-	if(myrank == nprocs-1)	// let some other processor do the testing
-	{
-#ifdef COMBBLAS_DEBUG
-    std::cout << "File is actually " << st.st_size << " bytes seen from process " << myrank << std::endl;
-#endif
-	}
-
-    	FILE *ffinal;
-	if ((ffinal = fopen(filename.c_str(), "rb+")) == NULL)	// then everyone fills it
-        {
-		printf("COMBBLAS: Vector output file %s failed to open at process %d\n", filename.c_str(), myrank);
-            	MPI_Abort(commGrid->GetWorld(), NOFILE);
-       	}
-	fseek (ffinal , bytesuntil , SEEK_SET );
-	fwrite(text.c_str(),1, bytes[myrank] ,ffinal);
-	fflush(ffinal);
-	fclose(ffinal);
-	delete [] bytes;
+	};
+	SpParHelper::WriteTextRecords(filename, header, static_cast<int64_t>(getlocnnz()), format, commGrid->GetWorld());
 }
 
 //! Called on an existing object
@@ -189,7 +189,7 @@ public:
 	NT operator[](IT indx);
 	bool WasFound() const { return wasFound; }
 
-	//! sort the vector itself, return the permutation vector (0-based)
+	//! return the permutation vector (0-based) that sorts the nonzeros by value, the vector itself is not changed
 	FullyDistSpVec<IT, IT> sort();	
 
 #if __cplusplus > 199711L
@@ -360,6 +360,10 @@ private:
     template <typename SR, typename IVT, typename OVT, typename IU, typename NUM, typename UDER>
     friend void SpMV (const SpParMat<IU,NUM,UDER> & A, const FullyDistSpVec<IU,IVT> & x, FullyDistSpVec<IU,OVT> & y,bool indexisvalue, OptBuf<int32_t, OVT > & optbuf, PreAllocatedSPA<OVT> & SPA);
 
+    template <typename SR, typename IVT, typename OVT, typename IU, typename NUM, typename UDER>
+    friend void SpMSpVBatch (const SpParMat<IU,NUM,UDER> & A, const std::vector< FullyDistSpVec<IU,IVT> > & x, std::vector< FullyDistSpVec<IU,OVT> > & y,
+                             SpMSpVBatchBuf<IVT,OVT> & batchbuf, PreAllocatedSPA<OVT> & SPA);
+
 	template <typename IU, typename NU1, typename NU2>
 	friend FullyDistSpVec<IU,typename promote_trait<NU1,NU2>::T_promote> 
 	EWiseMult (const FullyDistSpVec<IU,NU1> & V, const FullyDistVec<IU,NU2> & W , bool exclude, NU2 zero);
@@ -509,6 +509,38 @@ void FullyDistVec<IT,NT>::SaveGathered(std::ofstream& outfile, int master, HANDL
 	tmpSpVec.SaveGathered(outfile, master, handler, printProcSplits);
 }
 
+//! Every entry is written, formatted directly from the local array (see SpParHelper::WriteTextRecords)
+template <class IT, class NT>
+template <class HANDLER>
+void FullyDistVec<IT,NT>::ParallelWrite(const std::string & filename, bool onebased, HANDLER handler, bool includeindices)
+{
+	IT offset = LengthUntil();
+	if(onebased)	offset += 1;	// increment by 1
+
+	typedef TextValueWriter<NT, std::is_same<HANDLER, ScalarReadSaveHandler>::value && IsFastText<NT>::value> ValueWriter;
+	auto format = [&](int64_t begin, int64_t end, std::string & out)
+	{
+		HANDLER myhandler(handler);	// handlers are not required to be thread-safe
+		ValueWriter writer;
+		IT dummy = 0;	// dummy because we don't want indices to be printed
+		for(int64_t i = begin; i < end; ++i)
+		{
+			if(includeindices)
+			{
+				SpHelper::AppendInteger(out, static_cast<IT>(i)+offset);
+				out += '\t';
+				writer.Append(out, myhandler, arr[i], static_cast<IT>(i)+offset);
+			}
+			else
+			{
+				writer.Append(out, myhandler, arr[i], dummy);
+			}
+			out += '\n';
+		}
+	};
+	SpParHelper::WriteTextRecords(filename, std::string(), static_cast<int64_t>(arr.size()), format, commGrid->GetWorld());
+}
+
 template <class IT, class NT>
 void FullyDistVec<IT,NT>::SetElement (IT indx, NT numx)
 {
@@ -761,7 +793,7 @@ FullyDistVec<IT, IT> FullyDistVec<IT, NT>::sort()
 		vecpair[i].first = arr[i];	// we'll sort wrt numerical values
 		vecpair[i].second = i + sizeuntil;	
 	}
-	SpParHelper::MemoryEfficientPSort(vecpair, nnz, dist, World);
+	SpParHelper::PSortByKey(vecpair, nnz, dist, World);	// radix sort for integral values
 
 	std::vector< IT > narr(nnz);
 	for(IT i=0; i< nnz; ++i)
@@ -788,11 +820,11 @@ void FullyDistVec<IT,NT>::RandPerm()
 	uint64_t seed= time(NULL);
 #endif
     
-	MTRand M(seed);	// generate random numbers with Mersenne Twister
     MPI_Comm World = commGrid->GetWorld();
 	int nprocs = commGrid->GetSize();
 	int rank = commGrid->GetRank();
     IT size = LocArrSize();
+	MTRand M(seed + rank);	// generate random numbers with Mersenne Twister, independent streams on each process
 
 #ifdef COMBBLAS_LEGACY
   std::pair<double,NT> * vecpair = new std::pair<double,NT>[size];
@@ -811,102 +843,46 @@ void FullyDistVec<IT,NT>::RandPerm()
     DeleteAll(vecpair, dist);
 	arr.swap(nnum);
 #else
-    std::vector< std::vector< NT > > data_send(nprocs);
-	for(int i=0; i<size; ++i)
-    {
-		// send each entry to a random process
-		uint32_t dest = M.randInt(nprocs-1);
-		data_send[dest].push_back(arr[i]);
+	// Direct scatter, no sorting: every entry goes to a uniformly random process, each process shuffles what it got,
+	// and the concatenation (in rank order) is moved back to the original distribution
+	std::vector<int> dest(size);
+	int * sendcnt = new int[nprocs]();
+	int * sdispls = new int[nprocs]();
+	int * recvcnt = new int[nprocs];
+	int * rdispls = new int[nprocs]();
+	for(IT i=0; i<size; ++i)
+	{
+		dest[i] = static_cast<int>(M.randInt(nprocs-1));
+		++sendcnt[dest[i]];
 	}
-    int * sendcnt = new int[nprocs];
-    int * sdispls = new int[nprocs];
-    for(int i=0; i<nprocs; ++i) sendcnt[i] = (int) data_send[i].size();
-    
-    int * rdispls = new int[nprocs];
-    int * recvcnt = new int[nprocs];
-    MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, World);  // share the request counts
-    sdispls[0] = 0;
-    rdispls[0] = 0;
-    for(int i=0; i<nprocs-1; ++i)
-    {
-        sdispls[i+1] = sdispls[i] + sendcnt[i];
-        rdispls[i+1] = rdispls[i] + recvcnt[i];
-    }
-    IT totrecv = std::accumulate(recvcnt,recvcnt+nprocs, static_cast<IT>(0));
+	MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, World);  // share the request counts
+	std::partial_sum(sendcnt, sendcnt+nprocs-1, sdispls+1);
+	std::partial_sum(recvcnt, recvcnt+nprocs-1, rdispls+1);
+	IT totrecv = std::accumulate(recvcnt,recvcnt+nprocs, static_cast<IT>(0));
 	if(totrecv > std::numeric_limits<int>::max())
 	{
 		std::cout << "COMBBLAS_WARNING: total data to receive exceeds max int: " << totrecv << std::endl;
 	}
-    std::vector<NT>().swap(arr);  // make space for temporaries
-    
+
 	NT * sendbuf = new NT[size];
-    for(int i=0; i<nprocs; ++i)
-    {
-        std::copy(data_send[i].begin(), data_send[i].end(), sendbuf+sdispls[i]);
-        std::vector<NT>().swap(data_send[i]);	// free memory
-    }
+	std::vector<int> fill(sdispls, sdispls+nprocs);
+	for(IT i=0; i<size; ++i)
+		sendbuf[fill[dest[i]]++] = arr[i];
+	std::vector<int>().swap(dest);
+	std::vector<NT>().swap(arr);  // make space for temporaries
+
 	NT * recvbuf = new NT[totrecv];
-    MPI_Alltoallv(sendbuf, sendcnt, sdispls, MPIType<NT>(), recvbuf, recvcnt, rdispls, MPIType<NT>(), World);
-	//std::random_shuffle(recvbuf, recvbuf+ totrecv);
-    std::default_random_engine gen(seed);
-    std::shuffle(recvbuf, recvbuf+ totrecv,gen); // locally shuffle data
-    
-	int64_t * localcounts = new int64_t[nprocs];
-	localcounts[rank] = totrecv;
-	MPI_Allgather(MPI_IN_PLACE, 1, MPI_LONG_LONG, localcounts, 1, MPI_LONG_LONG, World);
-	int64_t glenuntil = std::accumulate(localcounts, localcounts+rank, static_cast<int64_t>(0));
-    
-	std::vector< std::vector< IT > > locs_send(nprocs);
-	for(IT i=0; i< totrecv; ++i)    // determine new locations w/ prefix sums
-	{
-		IT remotelocind;
-		int owner = Owner(glenuntil+i, remotelocind);
-		locs_send[owner].push_back(remotelocind);
-		data_send[owner].push_back(recvbuf[i]);
-	}
-    
-    for(int i=0; i<nprocs; ++i) sendcnt[i] = (int) data_send[i].size(); // = locs_send.size()
-    MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, World);
-    sdispls[0] = 0;
-    rdispls[0] = 0;
-    for(int i=0; i<nprocs-1; ++i)
-    {
-        sdispls[i+1] = sdispls[i] + sendcnt[i];
-        rdispls[i+1] = rdispls[i] + recvcnt[i];
-    }
-    IT newsize = std::accumulate(recvcnt,recvcnt+nprocs, static_cast<IT>(0));
-	if(newsize > std::numeric_limits<int>::max())
-	{
-		std::cout << "COMBBLAS_WARNING: total data to receive exceeds max int: " << newsize << std::endl;
-	}
-	// re-use the receive buffer as sendbuf of second stage
-    IT totalsend = std::accumulate(sendcnt, sendcnt+nprocs, static_cast<IT>(0));
-    if(totalsend != totrecv || newsize != size)
-    {
-        std::cout << "COMBBLAS_WARNING: sending different sized data than received: " << totalsend << "=" << totrecv << " , " << newsize << "=" << size << std::endl;
-    }
-    for(int i=0; i<nprocs; ++i)
-    {
-        std::copy(data_send[i].begin(), data_send[i].end(), recvbuf+sdispls[i]);
-        std::vector<NT>().swap(data_send[i]);	// free memory
-    }
-    // re-use the send buffer as receive buffer of second stage
-    MPI_Alltoallv(recvbuf, sendcnt, sdispls, MPIType<NT>(), sendbuf, recvcnt, rdispls, MPIType<NT>(), World);
-    delete [] recvbuf;
-    IT * newinds = new IT[totalsend];
-    for(int i=0; i<nprocs; ++i)
-    {
-        std::copy(locs_send[i].begin(), locs_send[i].end(), newinds+sdispls[i]);
-        std::vector<IT>().swap(locs_send[i]);	// free memory
-    }
-    IT * indsbuf = new IT[size];
-	MPI_Alltoallv(newinds, sendcnt, sdispls, MPIType<IT>(), indsbuf, recvcnt, rdispls, MPIType<IT>(), World);
-    DeleteAll(newinds, sendcnt, sdispls, rdispls, recvcnt);
-    arr.resize(size);
-    for(IT i=0; i<size; ++i)
-    {
-        arr[indsbuf[i]] = sendbuf[i];
-    }
+	MPI_Alltoallv(sendbuf, sendcnt, sdispls, MPIType<NT>(), recvbuf, recvcnt, rdispls, MPIType<NT>(), World);
+	DeleteAll(sendbuf, sendcnt, sdispls, recvcnt, rdispls);
+	std::default_random_engine gen(seed + rank);
+	std::shuffle(recvbuf, recvbuf+ totrecv,gen); // locally shuffle data
+
+	IT * dist = new IT[nprocs];
+	dist[rank] = size;
+	MPI_Allgather(MPI_IN_PLACE, 1, MPIType<IT>(), dist, 1, MPIType<IT>(), World);
+	arr.resize(size);
+	SpParHelper::RebalanceOrdered(recvbuf, totrecv, arr.data(), dist, MPIType<NT>(), World);
+	DeleteAll(recvbuf, dist);
 #endif
 }
 
@@ -93,11 +93,7 @@ public:
 	};
 
 	template <class HANDLER>
-	void ParallelWrite(const std::string & filename, bool onebased, HANDLER handler, bool includeindices = true)
-	{
-        	FullyDistSpVec<IT,NT> tmpSpVec = *this;	// delegate
-        	tmpSpVec.ParallelWrite(filename, onebased, handler, includeindices);
-	}
+	void ParallelWrite(const std::string & filename, bool onebased, HANDLER handler, bool includeindices = true);
 	void ParallelWrite(const std::string & filename, bool onebased, bool includeindices = true) { ParallelWrite(filename, onebased, ScalarReadSaveHandler(), includeindices); };
 
 
@@ -0,0 +1,478 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _GALERKIN_PRODUCT_H_
+#define _GALERKIN_PRODUCT_H_
+
+#include <vector>
+#include <tuple>
+#include <numeric>
+#include <algorithm>
+#include "SpParMat.h"
+#include "SpParHelper.h"
+
+namespace combblas {
+
+/**
+ * Galerkin triple product C = R'*A*R of an n x n matrix A and an n x m restriction (prolongation) matrix R
+ * Processor (i,j) of the q x q grid gathers the row strips R(I,:) and R(J,:) that match the rows and columns of its
+ * block A(I,J), and computes its share R(I,:)' * (A(I,J) * R(J,:)) locally, one column of A(I,J)*R(J,:) at a time, so the
+ * intermediate product is never formed beyond a sparse accumulator. The m x m contributions are summed into the
+ * 2D distribution of C with a single all-to-all.
+ * Symbolic() caches the strips' structure, the pattern of every local contribution and where each of its entries lands
+ * in C; Numeric() then only moves values: it refreshes the strips of R, recomputes the contributions into the cached
+ * patterns and sends one value per entry. Numeric() needs A and R to have the patterns Symbolic() was called with.
+ * Memory: each processor holds two row strips of R, about 2 nnz(R)/q nonzeros, which is small for the tall and very
+ * sparse transfer operators of algebraic multigrid
+ * @pre { A and R are on the same square grid; SR::id() is the additive identity of SR }
+ **/
+template <typename SR, typename IT, typename NT, typename DER>
+class GalerkinProduct
+{
+public:
+	typedef typename DER::LocalIT LIT;
+
+	GalerkinProduct(): symbolic(false), anz(0), rnz(0), ahash(0), rhash(0) {}
+
+	bool HasSymbolic() const { return symbolic; }
+
+	//! Builds the cached structure for A and R; does not compute any values
+	void Symbolic(SpParMat<IT,NT,DER> & A, SpParMat<IT,NT,DER> & R);
+
+	//! C = R'*A*R for A and R with the patterns given to Symbolic()
+	SpParMat<IT,NT,DER> Numeric(SpParMat<IT,NT,DER> & A, SpParMat<IT,NT,DER> & R);
+
+	//! Reuses the cached structure when A and R still have the same patterns on every processor, otherwise rebuilds it
+	SpParMat<IT,NT,DER> Compute(SpParMat<IT,NT,DER> & A, SpParMat<IT,NT,DER> & R)
+	{
+		int stale = (!symbolic || A.seqptr()->getnnz() != anz || R.seqptr()->getnnz() != rnz ||
+				SpHelper::PatternHash(*(A.seqptr())) != ahash || SpHelper::PatternHash(*(R.seqptr())) != rhash)? 1 : 0;
+		MPI_Allreduce(MPI_IN_PLACE, &stale, 1, MPI_INT, MPI_MAX, A.getcommgrid()->GetWorld());
+		if(stale) Symbolic(A, R);
+		return Numeric(A, R);
+	}
+
+private:
+	void GatherStrips(SpParMat<IT,NT,DER> & R, std::vector<NT> & mine, std::vector<NT> & partners, bool withindices,
+			  std::vector<LIT> & myrows, std::vector<IT> & mycols, std::vector<LIT> & prows, std::vector<IT> & pcols);
+
+	bool symbolic;
+	LIT anz, rnz;			// local nonzeros of A and R at the time of Symbolic()
+	uint64_t ahash, rhash;		// and fingerprints of their local patterns
+	IT m;				// columns of R, i.e. dimension of C
+	std::vector<int> stripcnt, stripdspl;	// sizes of the local blocks of R in the processor row
+	int partner;			// the transpose processor, which holds the strip R(J,:)
+	LIT partnernz;
+
+	// R(I,:) as CSR over the local rows, with its coarse columns compressed to 0..gI.size()-1
+	std::vector<LIT> riptr, ricol;
+	std::vector<NT> rival;
+	std::vector<LIT> ripos;		// gathered entry k of R(I,:) is stored at ripos[k]
+	std::vector<IT> gI;
+	// R(J,:) as CSC over its compressed coarse columns
+	std::vector<LIT> rjptr, rjrow;
+	std::vector<NT> rjval;
+	std::vector<LIT> rjpos;
+	std::vector<IT> gJ;
+
+	std::vector<LIT> acol;		// dcsc index of every local column of A, -1 if empty
+	LIT ni;				// local rows of A
+
+	// pattern of the local contribution R(I,:)'*A(I,J)*R(J,:), compressed gI.size() x gJ.size(), in CSC
+	std::vector<LIT> pptr, prow;
+	std::vector<NT> pval;
+
+	std::vector<int> sendcnt, senddspl, recvcnt, recvdspl;
+	std::vector<LIT> sendpos;	// entry e of the contribution is sent from sendpos[e]
+	std::vector<LIT> cpos;		// received value k is added to the local nonzero cpos[k] of C
+	SpParMat<IT,NT,DER> C;		// the structure of the result
+};
+
+
+/**
+ * Gathers R(I,:) over the processor row and swaps it with the transpose processor for R(J,:)
+ * The values always move; the indices only when withindices is set, i.e. in the symbolic phase
+ **/
+template <typename SR, typename IT, typename NT, typename DER>
+void GalerkinProduct<SR,IT,NT,DER>::GatherStrips(SpParMat<IT,NT,DER> & R, std::vector<NT> & mine, std::vector<NT> & partners,
+						bool withindices, std::vector<LIT> & myrows, std::vector<IT> & mycols,
+						std::vector<LIT> & prows, std::vector<IT> & pcols)
+{
+	std::shared_ptr<CommGrid> grid = R.getcommgrid();
+	MPI_Comm RowWorld = grid->GetRowWorld();
+	DER * Rloc = R.seqptr();
+	LIT locnnz = Rloc->getnnz();
+	std::vector<NT> locval(locnnz);
+	std::vector<LIT> locrow(withindices? locnnz : 0);
+	std::vector<IT> loccol(withindices? locnnz : 0);
+	IT coloffset = static_cast<IT>(grid->GetRankInProcRow()) * (m / grid->GetGridCols());
+	if(locnnz > 0)
+	{
+		Dcsc<LIT,NT> * dcsc = Rloc->GetDCSC();
+		for(LIT c = 0; c < dcsc->nzc; ++c)
+		{
+			for(LIT k = dcsc->cp[c]; k < dcsc->cp[c+1]; ++k)
+			{
+				locval[k] = dcsc->numx[k];
+				if(withindices)
+				{
+					locrow[k] = dcsc->ir[k];
+					loccol[k] = coloffset + dcsc->jc[c];
+				}
+			}
+		}
+	}
+	LIT stripnz = stripdspl.back();
+	mine.resize(stripnz);
+	MPI_Allgatherv(locval.data(), locnnz, MPIType<NT>(), mine.data(), stripcnt.data(), stripdspl.data(), MPIType<NT>(), RowWorld);
+	partners.resize(partnernz);
+	MPI_Sendrecv(mine.data(), stripnz, MPIType<NT>(), partner, 0, partners.data(), partnernz, MPIType<NT>(), partner, 0,
+		     grid->GetWorld(), MPI_STATUS_IGNORE);
+	if(withindices)
+	{
+		myrows.resize(stripnz);
+		mycols.resize(stripnz);
+		MPI_Allgatherv(locrow.data(), locnnz, MPIType<LIT>(), myrows.data(), stripcnt.data(), stripdspl.data(), MPIType<LIT>(), RowWorld);
+		MPI_Allgatherv(loccol.data(), locnnz, MPIType<IT>(), mycols.data(), stripcnt.data(), stripdspl.data(), MPIType<IT>(), RowWorld);
+		prows.resize(partnernz);
+		pcols.resize(partnernz);
+		MPI_Sendrecv(myrows.data(), stripnz, MPIType<LIT>(), partner, 1, prows.data(), partnernz, MPIType<LIT>(), partner, 1,
+			     grid->GetWorld(), MPI_STATUS_IGNORE);
+		MPI_Sendrecv(mycols.data(), stripnz, MPIType<IT>(), partner, 2, pcols.data(), partnernz, MPIType<IT>(), partner, 2,
+			     grid->GetWorld(), MPI_STATUS_IGNORE);
+	}
+}
+
+
+template <typename SR, typename IT, typename NT, typename DER>
+void GalerkinProduct<SR,IT,NT,DER>::Symbolic(SpParMat<IT,NT,DER> & A, SpParMat<IT,NT,DER> & R)
+{
+	std::shared_ptr<CommGrid> grid = A.getcommgrid();
+	int q = grid->GetGridRows();
+	int myrow = grid->GetRankInProcCol();
+	int mycol = grid->GetRankInProcRow();
+	m = R.getncol();
+	anz = A.seqptr()->getnnz();
+	rnz = R.seqptr()->getnnz();
+	ahash = SpHelper::PatternHash(*(A.seqptr()));
+	rhash = SpHelper::PatternHash(*(R.seqptr()));
+	ni = A.seqptr()->getnrow();
+	LIT nj = A.seqptr()->getncol();
+
+	// sizes of the strips
+	int mynz = static_cast<int>(rnz);
+	stripcnt.resize(q);
+	stripdspl.assign(q+1, 0);
+	MPI_Allgather(&mynz, 1, MPI_INT, stripcnt.data(), 1, MPI_INT, grid->GetRowWorld());
+	std::partial_sum(stripcnt.begin(), stripcnt.end(), stripdspl.begin()+1);
+	partner = grid->GetRank(mycol, myrow);
+	LIT stripnz = stripdspl.back();
+	MPI_Sendrecv(&stripnz, 1, MPIType<LIT>(), partner, 0, &partnernz, 1, MPIType<LIT>(), partner, 0, grid->GetWorld(), MPI_STATUS_IGNORE);
+
+	std::vector<NT> ivals, jvals;
+	std::vector<LIT> irows, jrows;
+	std::vector<IT> icols, jcols;
+	GatherStrips(R, ivals, jvals, true, irows, icols, jrows, jcols);
+
+	// R(I,:) in CSR over the ni local rows, columns compressed
+	gI = icols;
+	std::sort(gI.begin(), gI.end());
+	gI.erase(std::unique(gI.begin(), gI.end()), gI.end());
+	riptr.assign(ni+1, 0);
+	for(LIT r : irows) ++riptr[r+1];
+	std::partial_sum(riptr.begin(), riptr.end(), riptr.begin());
+	ricol.resize(irows.size());
+	rival.resize(irows.size());
+	ripos.resize(irows.size());
+	std::vector<LIT> fill(riptr.begin(), riptr.end()-1);
+	for(size_t k = 0; k < irows.size(); ++k)
+	{
+		LIT pos = fill[irows[k]]++;
+		ripos[k] = pos;
+		ricol[pos] = std::lower_bound(gI.begin(), gI.end(), icols[k]) - gI.begin();
+	}
+
+	// R(J,:) in CSC over its compressed columns
+	gJ = jcols;
+	std::sort(gJ.begin(), gJ.end());
+	gJ.erase(std::unique(gJ.begin(), gJ.end()), gJ.end());
+	LIT mJ = gJ.size();
+	std::vector<LIT> jc(jcols.size());
+	rjptr.assign(mJ+1, 0);
+	for(size_t k = 0; k < jcols.size(); ++k)
+	{
+		jc[k] = std::lower_bound(gJ.begin(), gJ.end(), jcols[k]) - gJ.begin();
+		++rjptr[jc[k]+1];
+	}
+	std::partial_sum(rjptr.begin(), rjptr.end(), rjptr.begin());
+	rjrow.resize(jcols.size());
+	rjval.resize(jcols.size());
+	rjpos.resize(jcols.size());
+	fill.assign(rjptr.begin(), rjptr.end()-1);
+	for(size_t k = 0; k < jcols.size(); ++k)
+	{
+		LIT pos = fill[jc[k]]++;
+		rjpos[k] = pos;
+		rjrow[pos] = jrows[k];
+	}
+
+	// column index of A
+	acol.assign(nj, -1);
+	Dcsc<LIT,NT> * adcsc = A.seqptr()->GetDCSC();
+	if(anz > 0)
+		for(LIT c = 0; c < adcsc->nzc; ++c)
+			acol[adcsc->jc[c]] = c;
+
+	// pattern of the contribution, one column of A(I,J)*R(J,:) at a time
+	LIT mI = gI.size();
+	std::vector<bool> tmark(ni, false), pmark(mI, false);
+	std::vector<LIT> trows, prows;
+	pptr.assign(mJ+1, 0);
+	prow.clear();
+	for(LIT c = 0; c < mJ; ++c)
+	{
+		for(LIT k = rjptr[c]; k < rjptr[c+1]; ++k)
+		{
+			LIT a = acol[rjrow[k]];
+			if(a < 0) continue;
+			for(LIT e = adcsc->cp[a]; e < adcsc->cp[a+1]; ++e)
+			{
+				if(!tmark[adcsc->ir[e]])
+				{
+					tmark[adcsc->ir[e]] = true;
+					trows.push_back(adcsc->ir[e]);
+				}
+			}
+		}
+		for(LIT t : trows)
+		{
+			tmark[t] = false;
+			for(LIT k = riptr[t]; k < riptr[t+1]; ++k)
+			{
+				if(!pmark[ricol[k]])
+				{
+					pmark[ricol[k]] = true;
+					prows.push_back(ricol[k]);
+				}
+			}
+		}
+		for(LIT r : prows) pmark[r] = false;	// the order within a column is irrelevant to Numeric()
+		prow.insert(prow.end(), prows.begin(), prows.end());
+		pptr[c+1] = prow.size();
+		trows.clear();
+		prows.clear();
+	}
+	pval.resize(prow.size());
+
+	// destinations of the entries of the contribution in the 2D distribution of C
+	int nprocs = grid->GetSize();
+	C = SpParMat<IT,NT,DER>(grid);
+	std::vector<int> owner(prow.size());
+	std::vector<LIT> lrow(prow.size()), lcol(prow.size());
+	sendcnt.assign(nprocs, 0);
+	for(LIT c = 0; c < mJ; ++c)
+	{
+		for(LIT e = pptr[c]; e < pptr[c+1]; ++e)
+		{
+			owner[e] = C.Owner(m, m, gI[prow[e]], gJ[c], lrow[e], lcol[e]);
+			++sendcnt[owner[e]];
+		}
+	}
+	senddspl.assign(nprocs+1, 0);
+	std::partial_sum(sendcnt.begin(), sendcnt.end(), senddspl.begin()+1);
+	sendpos.resize(prow.size());
+	std::vector<LIT> sendidx(2*prow.size());
+	std::vector<int> cursor(senddspl.begin(), senddspl.end()-1);
+	for(size_t e = 0; e < prow.size(); ++e)
+	{
+		LIT pos = cursor[owner[e]]++;
+		sendpos[e] = pos;
+		sendidx[2*pos] = lrow[e];
+		sendidx[2*pos+1] = lcol[e];
+	}
+	recvcnt.resize(nprocs);
+	MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, grid->GetWorld());
+	recvdspl.assign(nprocs+1, 0);
+	std::partial_sum(recvcnt.begin(), recvcnt.end(), recvdspl.begin()+1);
+	std::vector<int> sendcnt2(nprocs), senddspl2(nprocs), recvcnt2(nprocs), recvdspl2(nprocs);
+	for(int i = 0; i < nprocs; ++i)
+	{
+		sendcnt2[i] = 2*sendcnt[i];
+		senddspl2[i] = 2*senddspl[i];
+		recvcnt2[i] = 2*recvcnt[i];
+		recvdspl2[i] = 2*recvdspl[i];
+	}
+	LIT nrecv = recvdspl.back();
+	std::vector<LIT> recvidx(2*nrecv);
+	MPI_Alltoallv(sendidx.data(), sendcnt2.data(), senddspl2.data(), MPIType<LIT>(),
+		      recvidx.data(), recvcnt2.data(), recvdspl2.data(), MPIType<LIT>(), grid->GetWorld());
+
+	IT m_perproc = m / q;
+	LIT mloc = (myrow != q-1)? m_perproc : m - (q-1)*m_perproc;
+	LIT nloc = (mycol != q-1)? m_perproc : m - (q-1)*m_perproc;
+
+	// local nonzeros of C in column-major order, which is the order of their values in the DCSC:
+	// bucket the received entries by column, then number the distinct rows of every column in increasing order
+	std::vector<LIT> colptr(nloc+1, 0);
+	for(LIT k = 0; k < nrecv; ++k) ++colptr[recvidx[2*k+1]+1];
+	std::partial_sum(colptr.begin(), colptr.end(), colptr.begin());
+	std::vector<LIT> bycol(nrecv);
+	fill.assign(colptr.begin(), colptr.end()-1);
+	for(LIT k = 0; k < nrecv; ++k) bycol[fill[recvidx[2*k+1]]++] = k;
+	std::vector<LIT> rowslot(mloc, -1), colrows;
+	std::vector< std::tuple<LIT,LIT,NT> > nonzeros;
+	cpos.resize(nrecv);
+	for(LIT c = 0; c < nloc; ++c)
+	{
+		for(LIT k = colptr[c]; k < colptr[c+1]; ++k)
+		{
+			LIT r = recvidx[2*bycol[k]];
+			if(rowslot[r] < 0)
+			{
+				rowslot[r] = 0;
+				colrows.push_back(r);
+			}
+		}
+		std::sort(colrows.begin(), colrows.end());
+		for(LIT r : colrows)
+		{
+			rowslot[r] = nonzeros.size();
+			nonzeros.push_back(std::make_tuple(r, c, SR::id()));
+		}
+		for(LIT k = colptr[c]; k < colptr[c+1]; ++k)
+			cpos[bycol[k]] = rowslot[recvidx[2*bycol[k]]];
+		for(LIT r : colrows) rowslot[r] = -1;
+		colrows.clear();
+	}
+
+	std::tuple<LIT,LIT,NT> * tuples = new std::tuple<LIT,LIT,NT>[nonzeros.size()];
+	std::copy(nonzeros.begin(), nonzeros.end(), tuples);
+	SpTuples<LIT,NT> spTuples(nonzeros.size(), mloc, nloc, tuples, true);
+	C = SpParMat<IT,NT,DER>(new DER(spTuples, false), grid);
+	symbolic = true;
+}
+
+
+template <typename SR, typename IT, typename NT, typename DER>
+SpParMat<IT,NT,DER> GalerkinProduct<SR,IT,NT,DER>::Numeric(SpParMat<IT,NT,DER> & A, SpParMat<IT,NT,DER> & R)
+{
+	std::vector<NT> ivals, jvals;
+	std::vector<LIT> dummyrows;
+	std::vector<IT> dummycols;
+	GatherStrips(R, ivals, jvals, false, dummyrows, dummycols, dummyrows, dummycols);
+	for(size_t k = 0; k < ivals.size(); ++k) rival[ripos[k]] = ivals[k];
+	for(size_t k = 0; k < jvals.size(); ++k) rjval[rjpos[k]] = jvals[k];
+
+	LIT mI = gI.size();
+	LIT mJ = gJ.size();
+	Dcsc<LIT,NT> * adcsc = A.seqptr()->GetDCSC();
+#ifdef THREADED
+#pragma omp parallel
+#endif
+	{
+		// sparse accumulator for a column of A(I,J)*R(J,:) and positions within a column of the contribution
+		std::vector<NT> tval(ni);
+		std::vector<bool> tmark(ni, false);
+		std::vector<LIT> trows;
+		std::vector<LIT> ppos(mI);
+#ifdef THREADED
+#pragma omp for schedule(dynamic, 64)
+#endif
+		for(LIT c = 0; c < mJ; ++c)
+		{
+			if(pptr[c] == pptr[c+1]) continue;
+			for(LIT k = rjptr[c]; k < rjptr[c+1]; ++k)
+			{
+				LIT a = acol[rjrow[k]];
+				if(a < 0) continue;
+				for(LIT e = adcsc->cp[a]; e < adcsc->cp[a+1]; ++e)
+				{
+					LIT t = adcsc->ir[e];
+					NT prod = SR::multiply(adcsc->numx[e], rjval[k]);
+					if(tmark[t])
+						tval[t] = SR::add(tval[t], prod);
+					else
+					{
+						tmark[t] = true;
+						tval[t] = prod;
+						trows.push_back(t);
+					}
+				}
+			}
+			for(LIT e = pptr[c]; e < pptr[c+1]; ++e)
+			{
+				ppos[prow[e]] = e;
+				pval[e] = SR::id();
+			}
+			for(LIT t : trows)
+			{
+				tmark[t] = false;
+				for(LIT k = riptr[t]; k < riptr[t+1]; ++k)
+				{
+					LIT e = ppos[ricol[k]];
+					pval[e] = SR::add(pval[e], SR::multiply(rival[k], tval[t]));
+				}
+			}
+			trows.clear();
+		}
+	}
+
+	std::shared_ptr<CommGrid> grid = A.getcommgrid();
+	std::vector<NT> sendval(pval.size());
+	for(size_t e = 0; e < pval.size(); ++e)
+		sendval[sendpos[e]] = pval[e];
+	std::vector<NT> recvval(cpos.size());
+	MPI_Alltoallv(sendval.data(), sendcnt.data(), senddspl.data(), MPIType<NT>(),
+		      recvval.data(), recvcnt.data(), recvdspl.data(), MPIType<NT>(), grid->GetWorld());
+	DER * Cloc = C.seqptr();
+	if(Cloc->getnnz() > 0)
+	{
+		NT * cval = Cloc->GetDCSC()->numx;
+		std::fill(cval, cval + Cloc->getnnz(), SR::id());
+		for(size_t k = 0; k < cpos.size(); ++k)
+			cval[cpos[k]] = SR::add(cval[cpos[k]], recvval[k]);
+	}
+	return C;
+}
+
+
+/**
+ * C = R'*A*R in one pass, without reuse. For repeated products with fixed patterns keep a GalerkinProduct instead
+ **/
+template <typename SR, typename IT, typename NT, typename DER>
+SpParMat<IT,NT,DER> GalerkinTripleProduct(SpParMat<IT,NT,DER> & A, SpParMat<IT,NT,DER> & R)
+{
+	GalerkinProduct<SR,IT,NT,DER> rap;
+	rap.Symbolic(A, R);
+	return rap.Numeric(A, R);
+}
+
+}
+
+#endif
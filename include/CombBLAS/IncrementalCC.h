@@ -0,0 +1,316 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _INCREMENTAL_CC_H_
+#define _INCREMENTAL_CC_H_
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include "FullyDistVec.h"
+#include "DistEdgeList.h"
+
+namespace combblas {
+
+/**
+ * Connected components under edge insertions
+ * The labels of the old graph are updated with a delta edge list instead of recomputing from scratch. The labels at the
+ * two ends of every delta edge form a (small) label graph, whose components are found by distributed union-find:
+ * every label is kept by the process that owns the vertex with the same index, but only the labels that were hooked are
+ * stored; roots hook to the smallest neighboring root until all edges of the label graph are inside a tree, with full
+ * pointer jumping in between. Communication and memory scale with the delta; the only O(n/p) work is a local sweep
+ * over the labels at the end
+ **/
+template <typename IT>
+class IncrementalCC
+{
+public:
+	/**
+	 * @param[in,out] cclabel component labels numbered 0,...,nCC-1 in the order of their smallest vertex (the output of
+	 *		  LACC and FastSV); the same convention holds on return
+	 * @param[in,out] nCC number of components
+	 * @param[in] delta edges inserted since cclabel was computed, each process passes its own share (either direction of an
+	 *		  edge is enough, endpoints are global vertex ids)
+	 * @return number of hooking rounds
+	 **/
+	static int Update(FullyDistVec<IT,IT> & cclabel, IT & nCC, const std::vector< std::pair<IT,IT> > & delta)
+	{
+		MPI_Comm World = cclabel.getcommgrid()->GetWorld();
+		IT offset = cclabel.LengthUntil();
+
+		// labels at the ends of the delta edges; edges inside an existing component are dropped
+		std::vector<IT> endpoints(2*delta.size());
+		for(size_t i=0; i< delta.size(); ++i)
+		{
+			endpoints[2*i] = delta[i].first;
+			endpoints[2*i+1] = delta[i].second;
+		}
+		std::vector<IT> labels;
+		const IT * locarr = cclabel.GetLocArr();
+		Request(cclabel, endpoints, labels, [locarr](IT lind){ return locarr[lind]; });
+		std::vector< std::pair<IT,IT> > ledges;
+		for(size_t i=0; i< delta.size(); ++i)
+		{
+			if(labels[2*i] != labels[2*i+1])
+				ledges.push_back(std::make_pair(std::min(labels[2*i], labels[2*i+1]), std::max(labels[2*i], labels[2*i+1])));
+		}
+		std::sort(ledges.begin(), ledges.end());
+		ledges.erase(std::unique(ledges.begin(), ledges.end()), ledges.end());
+
+		std::unordered_map<IT,IT> parent;	// local index of a label -> its parent label, only for the hooked labels
+		auto getparent = [&parent, offset](IT lind){ auto it = parent.find(lind); return (it == parent.end())? offset + lind : it->second; };
+		int rounds = 0;
+		while(true)
+		{
+			// roots of the label edges (every tree is a star here)
+			std::vector<IT> ends(2*ledges.size()), roots;
+			for(size_t i=0; i< ledges.size(); ++i)
+			{
+				ends[2*i] = ledges[i].first;
+				ends[2*i+1] = ledges[i].second;
+			}
+			Request(cclabel, ends, roots, getparent);
+			std::vector<IT> hooktgt, hookval;
+			std::vector< std::pair<IT,IT> > active;
+			for(size_t i=0; i< ledges.size(); ++i)
+			{
+				if(roots[2*i] != roots[2*i+1])	// edges within a tree stay within it
+				{
+					hooktgt.push_back(std::max(roots[2*i], roots[2*i+1]));
+					hookval.push_back(std::min(roots[2*i], roots[2*i+1]));
+					active.push_back(ledges[i]);
+				}
+			}
+			ledges.swap(active);
+			IT nactive = static_cast<IT>(ledges.size());
+			MPI_Allreduce(MPI_IN_PLACE, &nactive, 1, MPIType<IT>(), MPI_SUM, World);
+			if(nactive == 0) break;
+			++rounds;
+
+			// roots only hook to smaller roots, so there are no cycles; competing hooks keep the smallest
+			HookMin(cclabel, hooktgt, hookval, parent);
+			Shortcut(cclabel, parent, getparent);
+		}
+
+		// every hooked label now points to the smallest label of its new component; all processes get the hooked labels
+		std::vector<IT> merged;
+		for(auto kv : parent)
+		{
+			merged.push_back(offset + kv.first);
+			merged.push_back(kv.second);
+		}
+		int nprocs = cclabel.getcommgrid()->GetSize();
+		int mysize = static_cast<int>(merged.size());
+		std::vector<int> recvcnt(nprocs), dpls(nprocs, 0);
+		MPI_Allgather(&mysize, 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);
+		std::partial_sum(recvcnt.begin(), recvcnt.end()-1, dpls.begin()+1);
+		IT totmerged = static_cast<IT>(dpls[nprocs-1] + recvcnt[nprocs-1]);
+		if(totmerged == 0) return rounds;
+
+		std::vector<IT> allmerged(totmerged);
+		MPI_Allgatherv(merged.data(), mysize, MPIType<IT>(), allmerged.data(), recvcnt.data(), dpls.data(), MPIType<IT>(), World);
+		std::vector< std::pair<IT,IT> > mergemap(totmerged/2);
+		for(IT i=0; i< totmerged/2; ++i)
+			mergemap[i] = std::make_pair(allmerged[2*i], allmerged[2*i+1]);
+		std::sort(mergemap.begin(), mergemap.end());
+
+		// relabel, then close the gaps the merged labels left so the labels stay 0,...,nCC-1 in the same order
+		IT mylen = cclabel.LocArrSize();
+	#ifdef THREADED
+	#pragma omp parallel for
+	#endif
+		for(IT i=0; i< mylen; ++i)
+		{
+			IT label = locarr[i];
+			auto it = std::lower_bound(mergemap.begin(), mergemap.end(), std::make_pair(label, static_cast<IT>(0)),
+						   [](const std::pair<IT,IT> & a, const std::pair<IT,IT> & b){ return a.first < b.first; });
+			if(it != mergemap.end() && it->first == label)
+				label = it->second;
+			IT gaps = std::lower_bound(mergemap.begin(), mergemap.end(), std::make_pair(label, static_cast<IT>(0)),
+						   [](const std::pair<IT,IT> & a, const std::pair<IT,IT> & b){ return a.first < b.first; }) - mergemap.begin();
+			cclabel.SetLocalElement(i, label - gaps);
+		}
+		nCC -= static_cast<IT>(mergemap.size());
+		return rounds;
+	}
+
+	//! Delta given as a distributed edge list (either packed or not); empty slots (negative endpoints) are skipped
+	static int Update(FullyDistVec<IT,IT> & cclabel, IT & nCC, const DistEdgeList<IT> & delta)
+	{
+		std::vector< std::pair<IT,IT> > edges;
+		IT nedges = delta.getNumLocalEdges();
+		edges.reserve(nedges);
+		packed_edge * pedges = delta.getPackedEdges();
+		IT * uedges = delta.getEdges();
+		for(IT i=0; i< nedges; ++i)
+		{
+			IT u = (pedges != NULL)? static_cast<IT>(get_v0_from_edge(pedges + i)) : uedges[2*i];
+			IT v = (pedges != NULL)? static_cast<IT>(get_v1_from_edge(pedges + i)) : uedges[2*i+1];
+			if(u >= 0 && v >= 0)
+				edges.push_back(std::make_pair(u, v));
+		}
+		return Update(cclabel, nCC, edges);
+	}
+
+private:
+	/**
+	 * out[i] = lookup(local index of req[i]), evaluated on the owner of req[i] (laid out as layout)
+	 * Every distinct remote index is requested once
+	 **/
+	template <typename LOOKUP>
+	static void Request(const FullyDistVec<IT,IT> & layout, const std::vector<IT> & req, std::vector<IT> & out, LOOKUP lookup)
+	{
+		MPI_Comm World = layout.getcommgrid()->GetWorld();
+		int nprocs = layout.getcommgrid()->GetSize();
+		int myrank = layout.getcommgrid()->GetRank();
+		IT length = static_cast<IT>(req.size());
+		out.resize(length);
+
+		std::vector< std::vector<IT> > data_req(nprocs);
+		std::vector<int> owners(length);
+		std::vector<IT> lindices(length);
+		for(IT i=0; i< length; ++i)
+		{
+			owners[i] = layout.Owner(req[i], lindices[i]);
+			if(owners[i] == myrank)
+				out[i] = lookup(lindices[i]);
+			else
+				data_req[owners[i]].push_back(lindices[i]);
+		}
+		std::vector<int> sendcnt(nprocs), recvcnt(nprocs), sdispls(nprocs+1, 0), rdispls(nprocs+1, 0);
+		for(int p=0; p< nprocs; ++p)
+		{
+			std::sort(data_req[p].begin(), data_req[p].end());
+			data_req[p].erase(std::unique(data_req[p].begin(), data_req[p].end()), data_req[p].end());
+			sendcnt[p] = static_cast<int>(data_req[p].size());
+		}
+		MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);
+		std::partial_sum(sendcnt.begin(), sendcnt.end(), sdispls.begin()+1);
+		std::partial_sum(recvcnt.begin(), recvcnt.end(), rdispls.begin()+1);
+
+		std::vector<IT> sendbuf(sdispls[nprocs]), recvbuf(rdispls[nprocs]);
+		for(int p=0; p< nprocs; ++p)
+			std::copy(data_req[p].begin(), data_req[p].end(), sendbuf.begin() + sdispls[p]);
+		MPI_Alltoallv(sendbuf.data(), sendcnt.data(), sdispls.data(), MPIType<IT>(), recvbuf.data(), recvcnt.data(), rdispls.data(), MPIType<IT>(), World);
+		for(size_t i=0; i< recvbuf.size(); ++i)
+			recvbuf[i] = lookup(recvbuf[i]);
+		MPI_Alltoallv(recvbuf.data(), recvcnt.data(), rdispls.data(), MPIType<IT>(), sendbuf.data(), sendcnt.data(), sdispls.data(), MPIType<IT>(), World);
+
+		for(IT i=0; i< length; ++i)
+		{
+			if(owners[i] != myrank)
+			{
+				IT pos = std::lower_bound(data_req[owners[i]].begin(), data_req[owners[i]].end(), lindices[i]) - data_req[owners[i]].begin();
+				out[i] = sendbuf[sdispls[owners[i]] + pos];
+			}
+		}
+	}
+
+	//! parent[tgt[i]] = min(parent[tgt[i]], val[i]) on the owners of the targets
+	static void HookMin(const FullyDistVec<IT,IT> & layout, const std::vector<IT> & tgt, const std::vector<IT> & val, std::unordered_map<IT,IT> & parent)
+	{
+		MPI_Comm World = layout.getcommgrid()->GetWorld();
+		int nprocs = layout.getcommgrid()->GetSize();
+		IT offset = layout.LengthUntil();
+
+		std::vector< std::vector<IT> > hookBuf(nprocs);
+		for(size_t i=0; i< tgt.size(); ++i)
+		{
+			IT locind;
+			int owner = layout.Owner(tgt[i], locind);
+			hookBuf[owner].push_back(locind);
+			hookBuf[owner].push_back(val[i]);
+		}
+		std::vector<int> sendcnt(nprocs), recvcnt(nprocs), sdispls(nprocs+1, 0), rdispls(nprocs+1, 0);
+		for(int p=0; p< nprocs; ++p)
+			sendcnt[p] = static_cast<int>(hookBuf[p].size());
+		MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);
+		std::partial_sum(sendcnt.begin(), sendcnt.end(), sdispls.begin()+1);
+		std::partial_sum(recvcnt.begin(), recvcnt.end(), rdispls.begin()+1);
+
+		std::vector<IT> sendbuf(sdispls[nprocs]), recvbuf(rdispls[nprocs]);
+		for(int p=0; p< nprocs; ++p)
+			std::copy(hookBuf[p].begin(), hookBuf[p].end(), sendbuf.begin() + sdispls[p]);
+		MPI_Alltoallv(sendbuf.data(), sendcnt.data(), sdispls.data(), MPIType<IT>(), recvbuf.data(), recvcnt.data(), rdispls.data(), MPIType<IT>(), World);
+		for(size_t i=0; i< recvbuf.size(); i += 2)
+		{
+			auto ins = parent.insert(std::make_pair(recvbuf[i], offset + recvbuf[i]));
+			ins.first->second = std::min(ins.first->second, recvbuf[i+1]);
+		}
+	}
+
+	//! Pointer jumping over the hooked labels until every one of them points to its root
+	template <typename GETPARENT>
+	static void Shortcut(const FullyDistVec<IT,IT> & layout, std::unordered_map<IT,IT> & parent, GETPARENT getparent)
+	{
+		MPI_Comm World = layout.getcommgrid()->GetWorld();
+		while(true)
+		{
+			std::vector<IT> keys, parents, grandparents;
+			for(auto kv : parent)
+			{
+				keys.push_back(kv.first);
+				parents.push_back(kv.second);
+			}
+			Request(layout, parents, grandparents, getparent);
+			IT changed = 0;
+			for(size_t i=0; i< keys.size(); ++i)
+			{
+				if(grandparents[i] != parents[i])
+				{
+					parent[keys[i]] = grandparents[i];
+					++changed;
+				}
+			}
+			MPI_Allreduce(MPI_IN_PLACE, &changed, 1, MPIType<IT>(), MPI_SUM, World);
+			if(changed == 0) break;
+		}
+	}
+};
+
+/**
+ * Updates the connected components of a graph after edges were inserted into it
+ * @return number of hooking rounds
+ **/
+template <typename IT>
+int IncrementalConnectedComponents(FullyDistVec<IT,IT> & cclabel, IT & nCC, const DistEdgeList<IT> & delta)
+{
+	return IncrementalCC<IT>::Update(cclabel, nCC, delta);
+}
+
+template <typename IT>
+int IncrementalConnectedComponents(FullyDistVec<IT,IT> & cclabel, IT & nCC, const std::vector< std::pair<IT,IT> > & delta)
+{
+	return IncrementalCC<IT>::Update(cclabel, nCC, delta);
+}
+
+}
+
+#endif
@@ -0,0 +1,210 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#ifndef _INDEX_LIST_CODEC_H_
+#define _INDEX_LIST_CODEC_H_
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "BitMap.h"
+
+namespace combblas {
+
+/**
+ * Wire formats for the (local, 32-bit) index lists of sparse vectors exchanged by the distributed SpMSpV
+ * The format is picked by the sender for every message from the observed density, and written as a one byte header:
+ *	- SORTED_LIST: the raw int32_t indices (4 bytes per entry)
+ *	- DELTA_VARINT: differences of consecutive sorted indices in LEB128 (1-2 bytes per entry for clustered lists)
+ *	- BITMAP_SET: one bit for every position up to the largest index (dense frontiers, 1/8 byte per position)
+ * An empty list is sent as zero bytes (no header)
+ **/
+enum IndexListFormat
+{
+	SORTED_LIST = 0,
+	DELTA_VARINT = 1,
+	BITMAP_SET = 2
+};
+
+/**
+ * Picks the smallest encoding for inds[0..n) and returns its size in bytes, header included
+ * Lists that are not strictly increasing are always sent as SORTED_LIST
+ **/
+inline size_t IndexListEncodedBytes(const int32_t * inds, int32_t n, uint8_t & format)
+{
+	format = SORTED_LIST;
+	if(n == 0) return 0;
+	size_t bytes = static_cast<size_t>(n) * sizeof(int32_t);
+
+	size_t varbytes = 0;
+	uint32_t prev = 0;
+	for(int32_t i=0; i< n; ++i)
+	{
+		if(inds[i] < 0 || (i > 0 && static_cast<uint32_t>(inds[i]) <= prev))
+			return 1 + bytes;
+		uint32_t delta = static_cast<uint32_t>(inds[i]) - prev;
+		prev = static_cast<uint32_t>(inds[i]);
+		do { ++varbytes; delta >>= 7; } while(delta);
+	}
+	size_t bitbytes = ((static_cast<uint64_t>(inds[n-1]) + 64) / 64) * sizeof(uint64_t);
+	if(varbytes < bytes)
+	{
+		format = DELTA_VARINT;
+		bytes = varbytes;
+	}
+	if(bitbytes < bytes)
+	{
+		format = BITMAP_SET;
+		bytes = bitbytes;
+	}
+	return 1 + bytes;
+}
+
+//! Writes inds[0..n) to out in the given format; out should have IndexListEncodedBytes() bytes
+inline size_t EncodeIndexList(const int32_t * inds, int32_t n, uint8_t format, unsigned char * out)
+{
+	if(n == 0) return 0;
+	unsigned char * ptr = out;
+	*ptr++ = format;
+	switch(format)
+	{
+		case DELTA_VARINT:
+		{
+			uint32_t prev = 0;
+			for(int32_t i=0; i< n; ++i)
+			{
+				uint32_t delta = static_cast<uint32_t>(inds[i]) - prev;
+				prev = static_cast<uint32_t>(inds[i]);
+				while(delta >= 0x80)
+				{
+					*ptr++ = static_cast<unsigned char>(delta | 0x80);
+					delta >>= 7;
+				}
+				*ptr++ = static_cast<unsigned char>(delta);
+			}
+			break;
+		}
+		case BITMAP_SET:
+		{
+			uint64_t nbits = static_cast<uint64_t>(inds[n-1]) + 1;
+			BitMap bm(nbits);
+			for(int32_t i=0; i< n; ++i)
+				bm.set_bit(inds[i]);
+			size_t nbytes = ((nbits + 63) / 64) * sizeof(uint64_t);
+			std::memcpy(ptr, bm.data(), nbytes);
+			ptr += nbytes;
+			break;
+		}
+		default:
+		{
+			std::memcpy(ptr, inds, static_cast<size_t>(n) * sizeof(int32_t));
+			ptr += static_cast<size_t>(n) * sizeof(int32_t);
+			break;
+		}
+	}
+	return ptr - out;
+}
+
+//! Reads n indices encoded by EncodeIndexList (nbytes long, header included) into out
+inline void DecodeIndexList(const unsigned char * in, size_t nbytes, int32_t n, int32_t * out)
+{
+	if(n == 0) return;
+	const unsigned char * ptr = in + 1;
+	switch(in[0])
+	{
+		case DELTA_VARINT:
+		{
+			uint32_t prev = 0;
+			for(int32_t i=0; i< n; ++i)
+			{
+				uint32_t delta = 0;
+				int shift = 0;
+				unsigned char byte;
+				do
+				{
+					byte = *ptr++;
+					delta |= static_cast<uint32_t>(byte & 0x7f) << shift;
+					shift += 7;
+				} while(byte & 0x80);
+				prev += delta;
+				out[i] = static_cast<int32_t>(prev);
+			}
+			break;
+		}
+		case BITMAP_SET:
+		{
+			size_t nwords = (nbytes - 1) / sizeof(uint64_t);
+			int32_t k = 0;
+			for(size_t w=0; w< nwords && k < n; ++w)
+			{
+				uint64_t word;
+				std::memcpy(&word, ptr + w * sizeof(uint64_t), sizeof(uint64_t));
+				for(int bit = 0; word; ++bit, word >>= 1)
+				{
+					if(word & 1)
+						out[k++] = static_cast<int32_t>(w * 64 + bit);
+				}
+			}
+			break;
+		}
+		default:
+		{
+			std::memcpy(out, ptr, static_cast<size_t>(n) * sizeof(int32_t));
+			break;
+		}
+	}
+}
+
+/**
+ * Encoded lists are exchanged as 32-bit words so that the int counts and displacements of MPI reach as far as for
+ * unencoded int32 lists (a raw list of n indices takes n+1 words rather than 4n+1 bytes); the last word is zero padded
+ **/
+inline int IndexListEncodedWords(size_t bytes)
+{
+	return static_cast<int>((bytes + sizeof(int32_t) - 1) / sizeof(int32_t));
+}
+
+//! EncodeIndexList into IndexListEncodedWords() words
+inline void EncodeIndexListWords(const int32_t * inds, int32_t n, uint8_t format, int words, int32_t * out)
+{
+	if(words == 0) return;
+	out[words-1] = 0;
+	EncodeIndexList(inds, n, format, reinterpret_cast<unsigned char *>(out));
+}
+
+//! DecodeIndexList from words written by EncodeIndexListWords
+inline void DecodeIndexListWords(const int32_t * in, int words, int32_t n, int32_t * out)
+{
+	DecodeIndexList(reinterpret_cast<const unsigned char *>(in), static_cast<size_t>(words) * sizeof(int32_t), n, out);
+}
+
+}
+
+#endif
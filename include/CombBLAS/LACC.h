@@ -0,0 +1,624 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _LACC_H_
+#define _LACC_H_
+
+#include <limits>
+#include <vector>
+#include <cmath>
+#include "SpParMat.h"
+#include "FullyDistVec.h"
+#include "FullyDistSpVec.h"
+#include "ParFriends.h"
+
+namespace combblas {
+
+/**
+ * How LACC (Azad and Buluc, IPDPS'19) communicates
+ * LACC_DENSE: hooking by SpMV over all vertices; Extract/Assign broadcast or reduce whole vector pieces whenever that is cheaper
+ *             than the point-to-point requests (HipMCL runs this mode through Applications/CC.h)
+ * LACC_SPARSE: only the active (not converged) vertices enter the hooking SpMSpVs, Extract/Assign are always point-to-point
+ * LACC_HYBRID: dense while more than denseswitch*n vertices are active, sparse afterwards
+ **/
+enum LACCMode { LACC_DENSE, LACC_SPARSE, LACC_HYBRID };
+
+struct LACCParams
+{
+	LACCParams(): mode(LACC_HYBRID), denseswitch(0.05) {}
+	LACCMode mode;
+	double denseswitch;
+};
+
+//! Statistics of a single LACC iteration
+struct LACCIteration
+{
+	int iteration;
+	bool dense;
+	int64_t active;		// vertices that were not converged when the iteration started
+	int64_t converged;	// at the end of the iteration
+	int64_t stars;
+	int64_t nonstars;
+	double time;		// seconds
+};
+
+enum LACCVertexState { LACC_NONSTAR = 0, LACC_STAR = 1, LACC_CONVERGED = 2 };
+
+/**
+ * Connected components of an undirected graph with LACC, the linear algebraic Awerbuch-Shiloach algorithm
+ * A converged star has no edges leaving it, so once a vertex converges neither it nor its edges can change any hook;
+ * the sparse iterations work only on the active vertices, and their SpMSpV and exchange volumes shrink with them
+ * A should be symmetric; the values of A are ignored
+ **/
+template <typename IT, typename NT, typename DER>
+class LACC
+{
+public:
+	typedef SpParMat < IT, bool, SpDCCols<IT,bool> > PSpMat_Bool;
+
+	LACC(const SpParMat<IT,NT,DER> & A, const LACCParams & myparams = LACCParams()):
+		Abool(static_cast<PSpMat_Bool>(A)), degrees(Abool.getcommgrid()), params(myparams)
+	{
+		Abool.Reduce(degrees, Column, std::plus<IT>(), static_cast<IT>(0), [](bool){ return static_cast<IT>(1); });
+		int nthreads = 1;
+	#ifdef THREADED
+	#pragma omp parallel
+		{
+			nthreads = omp_get_num_threads();
+		}
+	#endif
+		Abool.ActivateThreading(nthreads*4);
+	}
+
+	LACCParams & GetParams() { return params; }
+	void SetParams(const LACCParams & myparams) { params = myparams; }
+
+	/**
+	 * @param[out] cclabel component of every vertex, numbered 0,...,nCC-1 in the order of their smallest vertex
+	 * @param[out] iterstats if not NULL, filled with the statistics of every iteration
+	 * @return number of connected components (nCC)
+	 **/
+	IT Run(FullyDistVec<IT,IT> & cclabel, std::vector<LACCIteration> * iterstats = NULL)
+	{
+		IT nrows = Abool.getnrow();
+		FullyDistVec<IT,IT> parent(Abool.getcommgrid());
+		parent.iota(nrows, 0);	// parent(i)=i initially
+		FullyDistVec<IT,short> stars(Abool.getcommgrid(), nrows, LACC_STAR);	// initially every vertex belongs to a star
+		if(iterstats != NULL) iterstats->clear();
+
+		// isolated vertices are converged from the start
+		stars.EWiseApply(degrees, [](short isStar, IT deg){ return deg == 0? static_cast<short>(LACC_CONVERGED) : isStar; });
+		IT nconverged = CountState(stars, LACC_CONVERGED);
+
+		int iteration = 1;
+		while(nconverged < nrows)
+		{
+			double t1 = MPI_Wtime();
+			IT nactive = nrows - nconverged;
+			bool dense = (params.mode == LACC_DENSE) || (params.mode == LACC_HYBRID && nactive > params.denseswitch * nrows);
+
+			FullyDistSpVec<IT,IT> condhooks = ConditionalHook(parent, stars, iteration, dense);
+			// Any iteration other than the first iteration, a non-star is formed after a conditional hooking
+			// In the first iteration, we can hook two vertices to create a star
+			if(iteration > 1)
+			{
+				StarCheckAfterHooking(parent, stars, condhooks, true, dense);
+			}
+			else
+			{
+				// hooks and their parents are nonstars; this does not create any cycle in the unconditional hooking
+				stars.EWiseApply(condhooks, [](short, IT){ return static_cast<short>(LACC_NONSTAR); }, false, static_cast<IT>(LACC_NONSTAR));
+				FullyDistSpVec<IT,short> pNonStar = Assign(condhooks, static_cast<short>(LACC_NONSTAR), dense);
+				stars.Set(pNonStar);
+			}
+
+			FullyDistSpVec<IT,IT> uncondHooks = UnconditionalHook(parent, stars, dense);
+			if(iteration > 1)
+			{
+				StarCheckAfterHooking(parent, stars, uncondHooks, false, dense);
+				stars.Apply([](short isStar){ return isStar == LACC_STAR? static_cast<short>(LACC_CONVERGED) : isStar; });
+			}
+			else
+			{
+				stars.EWiseApply(uncondHooks, [](short, IT){ return static_cast<short>(LACC_NONSTAR); }, false, static_cast<IT>(LACC_NONSTAR));
+			}
+
+			nconverged = CountState(stars, LACC_CONVERGED);
+			IT nonstars = 0;
+			if(nconverged < nrows)
+			{
+				Shortcut(parent, stars, dense);
+				StarCheck(parent, stars, dense);
+				nonstars = CountState(stars, LACC_NONSTAR);
+			}
+			if(iterstats != NULL)
+			{
+				LACCIteration stat;
+				stat.iteration = iteration;
+				stat.dense = dense;
+				stat.active = static_cast<int64_t>(nactive);
+				stat.converged = static_cast<int64_t>(nconverged);
+				stat.stars = static_cast<int64_t>(nrows - nconverged - nonstars);
+				stat.nonstars = static_cast<int64_t>(nonstars);
+				stat.time = MPI_Wtime() - t1;
+				iterstats->push_back(stat);
+			}
+			++iteration;
+		}
+		return LabelCC(parent, cclabel, params.mode != LACC_SPARSE);
+	}
+
+private:
+	struct MinParentSR
+	{
+		static IT id() { return std::numeric_limits<IT>::max(); }
+		static bool returnedSAID() { return false; }
+		static MPI_Op mpi_op() { return MPI_MIN; }
+		static IT add(const IT & arg1, const IT & arg2) { return std::min(arg1, arg2); }
+		static IT multiply(const bool &, const IT & arg2) { return arg2; }
+		static void axpy(const bool a, const IT & x, IT & y) { y = add(y, multiply(a, x)); }
+	};
+
+	static IT CountState(const FullyDistVec<IT,short> & stars, short state)
+	{
+		return stars.Reduce(std::plus<IT>(), static_cast<IT>(0), [state](short isStar){ return static_cast<IT>(isStar == state); });
+	}
+
+	//! Values of dense at the indices whose positions are the nonzeros of src
+	template <typename NT1>
+	static FullyDistSpVec<IT,IT> GatherIndices(const FullyDistSpVec<IT,NT1> & src, const FullyDistVec<IT,IT> & dense, NT1 zero)
+	{
+		return EWiseApply<IT>(src, dense, [](NT1, IT p){ return p; }, [](NT1, IT){ return true; }, false, zero);
+	}
+
+	//! Point-to-point when only a few pairs of processes talk, a collective otherwise
+	template <typename T>
+	static void Exchange(T * sbuf, int * scnt, int * sdispls, T * rbuf, int * rcnt, int * rdispls, MPI_Comm World)
+	{
+		int nprocs, myrank;
+		MPI_Comm_size(World, &nprocs);
+		MPI_Comm_rank(World, &myrank);
+		int commCnt = 0;
+		for(int i=0; i< nprocs; ++i)
+		{
+			if(i == myrank) continue;
+			if(scnt[i] > 0) ++commCnt;
+			if(rcnt[i] > 0) ++commCnt;
+		}
+		int totalCommCnt;
+		MPI_Allreduce(&commCnt, &totalCommCnt, 1, MPI_INT, MPI_SUM, World);
+		if(totalCommCnt < 2*std::log2(nprocs))
+			par::Mpi_Alltoallv_sparse(sbuf, scnt, sdispls, rbuf, rcnt, rdispls, World);
+		else
+			MPI_Alltoallv(sbuf, scnt, sdispls, MPIType<T>(), rbuf, rcnt, rdispls, MPIType<T>(), World);
+	}
+
+	/**
+	 * If many processes request the same entries of dense (usually from the low rank processes in LACC), it is cheaper
+	 * for their owners to broadcast the whole local piece; only considered when densexchange
+	 * @return number of broadcasting processes, their pieces are in bcastBuffer
+	 **/
+	template <typename VT>
+	static int Replicate(const FullyDistVec<IT,VT> & dense, FullyDistSpVec<IT,IT> & ri, std::vector< std::vector<VT> > & bcastBuffer, bool densexchange)
+	{
+		if(!densexchange) return 0;
+		MPI_Comm World = dense.getcommgrid()->GetWorld();
+		int nprocs = dense.getcommgrid()->GetSize();
+
+		std::vector<int> sendcnt(nprocs, 0);
+		std::vector<int> recvcnt(nprocs, 0);
+		std::vector<IT> rinum = ri.GetLocalNum();
+		for(size_t i=0; i < rinum.size(); ++i)
+		{
+			IT locind;
+			sendcnt[dense.Owner(rinum[i], locind)]++;
+		}
+		MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);
+		IT totrecv = std::accumulate(recvcnt.begin(), recvcnt.end(), static_cast<IT>(0));
+
+		double broadcast_cost = dense.LocArrSize() * std::log2(nprocs);	// bandwidth cost
+		IT bcastsize = (broadcast_cost < totrecv)? static_cast<IT>(dense.LocArrSize()) : 0;
+		std::vector<IT> bcastcnt(nprocs, 0);
+		MPI_Allgather(&bcastsize, 1, MPIType<IT>(), bcastcnt.data(), 1, MPIType<IT>(), World);
+
+		std::vector<MPI_Request> requests;
+		const VT * arr = dense.GetLocArr();
+		for(int i=0; i< nprocs; ++i)
+		{
+			if(bcastcnt[i] > 0)
+			{
+				bcastBuffer[i].resize(bcastcnt[i]);
+				std::copy(arr, arr+bcastcnt[i], bcastBuffer[i].begin());	// only the root's copy matters
+				requests.push_back(MPI_REQUEST_NULL);
+				MPI_Ibcast(bcastBuffer[i].data(), bcastcnt[i], MPIType<VT>(), i, World, &requests.back());
+			}
+		}
+		MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+		return static_cast<int>(requests.size());
+	}
+
+	//! out[i] = dense[ri[i]] for every nonzero i of ri
+	template <typename VT>
+	static FullyDistSpVec<IT,VT> Extract(const FullyDistVec<IT,VT> & dense, FullyDistSpVec<IT,IT> & ri, bool densexchange)
+	{
+		std::shared_ptr<CommGrid> commGrid = ri.getcommgrid();
+		MPI_Comm World = commGrid->GetWorld();
+		int nprocs = commGrid->GetSize();
+
+		std::vector< std::vector<VT> > bcastBuffer(nprocs);
+		Replicate(dense, ri, bcastBuffer, densexchange);
+
+		std::vector< std::vector<IT> > data_req(nprocs);
+		std::vector< std::vector<IT> > revr_map(nprocs);	// to put the incoming data to the correct location
+		std::vector<IT> rinum = ri.GetLocalNum();
+		IT riloclen = rinum.size();
+		std::vector<VT> num(riloclen);	// final output
+		for(IT i=0; i < riloclen; ++i)
+		{
+			IT locind;
+			int owner = dense.Owner(rinum[i], locind);
+			if(bcastBuffer[owner].empty())
+			{
+				data_req[owner].push_back(locind);
+				revr_map[owner].push_back(i);
+			}
+			else
+			{
+				num[i] = bcastBuffer[owner][locind];
+			}
+		}
+
+		std::vector<int> sendcnt(nprocs), recvcnt(nprocs), sdispls(nprocs+1, 0), rdispls(nprocs+1, 0);
+		for(int i=0; i<nprocs; ++i)
+			sendcnt[i] = static_cast<int>(data_req[i].size());
+		MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);	// share the request counts
+		std::partial_sum(sendcnt.begin(), sendcnt.end(), sdispls.begin()+1);
+		std::partial_sum(recvcnt.begin(), recvcnt.end(), rdispls.begin()+1);
+		IT totsend = sdispls[nprocs];
+		IT totrecv = rdispls[nprocs];
+
+		std::vector<IT> sendbuf(totsend), reversemap(totsend);
+		for(int i=0; i<nprocs; ++i)
+		{
+			std::copy(data_req[i].begin(), data_req[i].end(), sendbuf.begin()+sdispls[i]);
+			std::vector<IT>().swap(data_req[i]);
+			std::copy(revr_map[i].begin(), revr_map[i].end(), reversemap.begin()+sdispls[i]);
+			std::vector<IT>().swap(revr_map[i]);
+		}
+		std::vector<IT> recvbuf(totrecv);
+		Exchange(sendbuf.data(), sendcnt.data(), sdispls.data(), recvbuf.data(), recvcnt.data(), rdispls.data(), World);
+		std::vector<IT>().swap(sendbuf);
+
+		// access requested data, the response counts are the same as the request counts
+		const VT * arr = dense.GetLocArr();
+		std::vector<VT> databack(totrecv);
+	#ifdef THREADED
+	#pragma omp parallel for
+	#endif
+		for(IT i=0; i<totrecv; ++i)
+			databack[i] = arr[recvbuf[i]];
+		std::vector<IT>().swap(recvbuf);
+		std::vector<VT> databuf(totsend);
+		Exchange(databack.data(), recvcnt.data(), rdispls.data(), databuf.data(), sendcnt.data(), sdispls.data(), World);
+
+		for(IT i=0; i<totsend; ++i)
+			num[reversemap[i]] = databuf[i];
+		std::vector<IT> ind = ri.GetLocalInd();
+		return FullyDistSpVec<IT,VT>(commGrid, ri.TotalLength(), ind, num, true, true);
+	}
+
+	/**
+	 * Owners that receive more requests than they own entries get them min-reduced into their whole local piece instead;
+	 * only considered when densexchange
+	 * @return number of such owners, the reduced pieces are in reduceBuffer (MAX_FOR_REDUCE where nothing was assigned)
+	 **/
+	template <typename VT, typename GETVAL>
+	static int ReduceAssign(FullyDistSpVec<IT,IT> & ind, GETVAL getval, std::vector< std::vector<VT> > & reduceBuffer, VT MAX_FOR_REDUCE, bool densexchange)
+	{
+		if(!densexchange) return 0;
+		MPI_Comm World = ind.getcommgrid()->GetWorld();
+		int nprocs = ind.getcommgrid()->GetSize();
+		int myrank;
+		MPI_Comm_rank(World, &myrank);
+
+		std::vector<int> sendcnt(nprocs, 0);
+		std::vector<int> recvcnt(nprocs);
+		std::vector< std::vector<IT> > indBuf(nprocs);
+		std::vector< std::vector<VT> > valBuf(nprocs);
+		std::vector<IT> indices = ind.GetLocalNum();
+		for(size_t i=0; i < indices.size(); ++i)
+		{
+			IT locind;
+			int owner = ind.Owner(indices[i], locind);
+			indBuf[owner].push_back(locind);
+			valBuf[owner].push_back(getval(i));
+			sendcnt[owner]++;
+		}
+		MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);
+		IT totrecv = std::accumulate(recvcnt.begin(), recvcnt.end(), static_cast<IT>(0));
+		double reduceCost = ind.MyLocLength() * std::log2(nprocs);	// bandwidth cost
+		IT reducesize = (reduceCost < totrecv)? ind.MyLocLength() : 0;
+		std::vector<IT> reducecnt(nprocs, 0);
+		MPI_Allgather(&reducesize, 1, MPIType<IT>(), reducecnt.data(), 1, MPIType<IT>(), World);
+
+		std::vector<MPI_Request> requests;
+		for(int i=0; i<nprocs; ++i)
+		{
+			if(reducecnt[i] > 0)
+			{
+				reduceBuffer[i].resize(reducecnt[i], MAX_FOR_REDUCE);
+				for(int j=0; j<sendcnt[i]; j++)
+					reduceBuffer[i][indBuf[i][j]] = std::min(reduceBuffer[i][indBuf[i][j]], valBuf[i][j]);
+				requests.push_back(MPI_REQUEST_NULL);
+				if(myrank == i)
+					MPI_Ireduce(MPI_IN_PLACE, reduceBuffer[i].data(), reducecnt[i], MPIType<VT>(), MPI_MIN, i, World, &requests.back());
+				else
+					MPI_Ireduce(reduceBuffer[i].data(), NULL, reducecnt[i], MPIType<VT>(), MPI_MIN, i, World, &requests.back());
+			}
+		}
+		MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+		return static_cast<int>(requests.size());
+	}
+
+	/**
+	 * out[ind[i]] = getval(i) for every nonzero i of ind (the i-th local nonzero); the smallest value wins on collisions
+	 * when the reduction path is taken, otherwise an arbitrary one
+	 **/
+	template <typename VT, typename GETVAL>
+	static FullyDistSpVec<IT,VT> AssignCommon(FullyDistSpVec<IT,IT> & ind, GETVAL getval, bool densexchange)
+	{
+		std::shared_ptr<CommGrid> commGrid = ind.getcommgrid();
+		MPI_Comm World = commGrid->GetWorld();
+		int nprocs = commGrid->GetSize();
+		int myrank;
+		MPI_Comm_rank(World, &myrank);
+		IT globallen = ind.TotalLength();
+
+		std::vector< std::vector<VT> > reduceBuffer(nprocs);
+		VT MAX_FOR_REDUCE = std::numeric_limits<VT>::max();	// never a vertex or a state
+		ReduceAssign(ind, getval, reduceBuffer, MAX_FOR_REDUCE, densexchange);
+
+		std::vector< std::vector<IT> > indBuf(nprocs);
+		std::vector< std::vector<VT> > valBuf(nprocs);
+		std::vector<IT> indices = ind.GetLocalNum();
+		for(size_t i=0; i < indices.size(); ++i)
+		{
+			IT locind;
+			int owner = ind.Owner(indices[i], locind);
+			if(reduceBuffer[owner].empty())
+			{
+				indBuf[owner].push_back(locind);
+				valBuf[owner].push_back(getval(i));
+			}
+		}
+		std::vector<int> sendcnt(nprocs), recvcnt(nprocs), sdispls(nprocs+1, 0), rdispls(nprocs+1, 0);
+		for(int i=0; i<nprocs; ++i)
+			sendcnt[i] = static_cast<int>(indBuf[i].size());
+		MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);
+		std::partial_sum(sendcnt.begin(), sendcnt.end(), sdispls.begin()+1);
+		std::partial_sum(recvcnt.begin(), recvcnt.end(), rdispls.begin()+1);
+
+		std::vector<IT> sendInd(sdispls[nprocs]);
+		std::vector<VT> sendVal(sdispls[nprocs]);
+		for(int i=0; i<nprocs; ++i)
+		{
+			std::copy(indBuf[i].begin(), indBuf[i].end(), sendInd.begin()+sdispls[i]);
+			std::vector<IT>().swap(indBuf[i]);
+			std::copy(valBuf[i].begin(), valBuf[i].end(), sendVal.begin()+sdispls[i]);
+			std::vector<VT>().swap(valBuf[i]);
+		}
+		std::vector<IT> recvInd(rdispls[nprocs]);
+		std::vector<VT> recvVal(rdispls[nprocs]);
+		Exchange(sendInd.data(), sendcnt.data(), sdispls.data(), recvInd.data(), recvcnt.data(), rdispls.data(), World);
+		Exchange(sendVal.data(), sendcnt.data(), sdispls.data(), recvVal.data(), recvcnt.data(), rdispls.data(), World);
+
+		for(size_t i=0; i < reduceBuffer[myrank].size(); ++i)
+		{
+			if(reduceBuffer[myrank][i] < MAX_FOR_REDUCE)
+			{
+				recvInd.push_back(i);
+				recvVal.push_back(reduceBuffer[myrank][i]);
+			}
+		}
+		return FullyDistSpVec<IT,VT>(commGrid, globallen, recvInd, recvVal, false, false);
+	}
+
+	template <typename VT>
+	static FullyDistSpVec<IT,VT> Assign(FullyDistSpVec<IT,IT> & ind, FullyDistSpVec<IT,VT> & val, bool densexchange)
+	{
+		std::vector<VT> values = val.GetLocalNum();
+		return AssignCommon<VT>(ind, [&values](size_t i){ return values[i]; }, densexchange);
+	}
+
+	static FullyDistSpVec<IT,short> Assign(FullyDistSpVec<IT,IT> & ind, short val, bool densexchange)
+	{
+		return AssignCommon<short>(ind, [val](size_t){ return val; }, densexchange);
+	}
+
+	FullyDistSpVec<IT,IT> ConditionalHook(FullyDistVec<IT,IT> & parent, const FullyDistVec<IT,short> & stars, int iteration, bool dense)
+	{
+		FullyDistSpVec<IT,IT> hooksMNP(Abool.getcommgrid());
+		if(dense)
+		{
+			FullyDistVec<IT,IT> minNeighborparent = SpMV<MinParentSR>(Abool, parent);	// value is the minimum of all neighbors' parents
+			FullyDistSpVec<IT,short> spStars(stars, [](short isStar){ return isStar == LACC_STAR; });
+			hooksMNP = EWiseApply<IT>(spStars, minNeighborparent, [](short, IT mnp){ return mnp; },
+						[](short, IT){ return true; }, false, static_cast<short>(0));
+		}
+		else
+		{
+			// a star's neighbors are never converged, so the active parents give the same minimum for every star
+			FullyDistSpVec<IT,short> active(stars, [](short isStar){ return isStar != LACC_CONVERGED; });
+			FullyDistSpVec<IT,IT> activeParents = GatherIndices(active, parent, static_cast<short>(0));
+			FullyDistSpVec<IT,IT> minNeighborparent(Abool.getcommgrid(), Abool.getnrow());
+			SpMV<MinParentSR>(Abool, activeParents, minNeighborparent, false);
+			hooksMNP = EWiseApply<IT>(minNeighborparent, stars, [](IT mnp, short){ return mnp; },
+						[](IT, short isStar){ return isStar == LACC_STAR; }, false, static_cast<IT>(0));
+		}
+		hooksMNP = EWiseApply<IT>(hooksMNP, parent, [](IT mnp, IT){ return mnp; },
+					[](IT mnp, IT p){ return p > mnp; }, false, static_cast<IT>(0));
+
+		FullyDistSpVec<IT,IT> finalhooks(Abool.getcommgrid());
+		if(iteration == 1)
+		{
+			finalhooks = hooksMNP;
+		}
+		else
+		{
+			FullyDistSpVec<IT,IT> hooksP = GatherIndices(hooksMNP, parent, static_cast<IT>(0));
+			finalhooks = Assign(hooksP, hooksMNP, dense);
+		}
+		parent.Set(finalhooks);
+		return finalhooks;
+	}
+
+	FullyDistSpVec<IT,IT> UnconditionalHook(FullyDistVec<IT,IT> & parents, const FullyDistVec<IT,short> & stars, bool dense)
+	{
+		IT nv = Abool.getnrow();
+		FullyDistSpVec<IT,IT> hooks(Abool.getcommgrid(), nv);
+		bool densespmv = dense && (CountState(stars, LACC_NONSTAR) * 50 >= nv);
+		if(densespmv)
+		{
+			FullyDistVec<IT,IT> parents1 = parents;
+			parents1.EWiseApply(stars, [nv](IT p, short isStar){ return isStar == LACC_STAR? nv: p; });
+			FullyDistVec<IT,IT> minNeighborParent = SpMV<MinParentSR>(Abool, parents1);	// value is the minimum of all neighbors' parents
+			hooks = minNeighborParent.Find([nv](IT mnf){ return mnf != nv; });
+		}
+		else
+		{
+			FullyDistSpVec<IT,short> nonStars(stars, [](short isStar){ return isStar == LACC_NONSTAR; });
+			FullyDistSpVec<IT,IT> pOfNonStars = GatherIndices(nonStars, parents, static_cast<short>(0));
+			SpMV<MinParentSR>(Abool, pOfNonStars, hooks, false);
+		}
+		hooks = EWiseApply<IT>(hooks, stars, [](IT mnp, short){ return mnp; },
+				       [](IT, short isStar){ return isStar == LACC_STAR; }, false, static_cast<IT>(0));
+
+		FullyDistSpVec<IT,IT> hooksP = GatherIndices(hooks, parents, static_cast<IT>(0));
+		FullyDistSpVec<IT,IT> finalHooks = Assign(hooksP, hooks, dense);
+		parents.Set(finalHooks);
+		return finalHooks;
+	}
+
+	//! Hooks are nonstars; after a conditional hooking (isStar2StarHookPossible) so are the parents of hooks
+	static void StarCheckAfterHooking(const FullyDistVec<IT,IT> & parent, FullyDistVec<IT,short> & star, FullyDistSpVec<IT,IT> & condhooks,
+					  bool isStar2StarHookPossible, bool dense)
+	{
+		star.EWiseApply(condhooks, [](short, IT){ return static_cast<short>(LACC_NONSTAR); }, false, static_cast<IT>(LACC_NONSTAR));
+		if(isStar2StarHookPossible)
+		{
+			FullyDistSpVec<IT,short> pNonStar = Assign(condhooks, static_cast<short>(LACC_NONSTAR), dense);
+			star.Set(pNonStar);
+		}
+		// children of nonstars are nonstars: every star asks for the star information of its parent
+		FullyDistSpVec<IT,short> spStars(star, [](short isStar){ return isStar == LACC_STAR; });
+		FullyDistSpVec<IT,IT> parentOfStars = GatherIndices(spStars, parent, static_cast<short>(0));
+		FullyDistSpVec<IT,short> isParentStar = Extract(star, parentOfStars, dense);
+		star.Set(isParentStar);
+	}
+
+	/**
+	 * After the shortcut, some nonstars may have become stars: identify them
+	 * In iteration 1 there are STAR and NONSTAR vertices, later only CONVERGED and NONSTAR ones; CONVERGED vertices are never touched
+	 **/
+	static void StarCheck(const FullyDistVec<IT,IT> & parents, FullyDistVec<IT,short> & stars, bool dense)
+	{
+		FullyDistSpVec<IT,short> nonStars(stars, [](short isStar){ return isStar == LACC_NONSTAR; });
+		stars.Apply([](short isStar){ return isStar == LACC_NONSTAR? static_cast<short>(LACC_STAR) : isStar; });	// initialize all nonstars to stars
+
+		// parents of current nonstars, indexed by the parent: vertices with a child (roots included, leaves not)
+		FullyDistSpVec<IT,IT> pOfNonStars = GatherIndices(nonStars, parents, static_cast<short>(0));
+		FullyDistSpVec<IT,short> pOfNonStarsIdx = Assign(pOfNonStars, static_cast<short>(LACC_NONSTAR), dense);
+		FullyDistSpVec<IT,IT> gpOfNonStars_pindexed = GatherIndices(pOfNonStarsIdx, parents, static_cast<short>(0));	// values are grandparents
+		// keep the parents/grandparents of vertices with level > 2
+		FullyDistSpVec<IT,IT> temp = gpOfNonStars_pindexed;
+		temp.setNumToInd();
+		gpOfNonStars_pindexed = EWiseApply<IT>(temp, gpOfNonStars_pindexed, [](IT, IT gp){ return gp; }, [](IT p, IT gp){ return p != gp; },
+						       false, false, static_cast<IT>(0), static_cast<IT>(0));
+		// all vertices of a nonstar tree except its root and its leaves
+		stars.EWiseApply(gpOfNonStars_pindexed, [](short, IT){ return static_cast<short>(LACC_NONSTAR); }, false, static_cast<IT>(LACC_NONSTAR));
+
+		// roots of nonstars (indexed by level-1 vertices)
+		FullyDistSpVec<IT,IT> rootsOfNonStars = EWiseApply<IT>(pOfNonStars, stars, [](IT p, short){ return p; },
+									[](IT, short isStar){ return isStar == LACC_NONSTAR; }, false, static_cast<IT>(0));
+		FullyDistSpVec<IT,short> rootsOfNonStarsIdx = Assign(rootsOfNonStars, static_cast<short>(LACC_NONSTAR), dense);
+		stars.Set(rootsOfNonStarsIdx);
+
+		// the remaining former nonstars are either in new stars or level-1 leaves of a nonstar: ask the parent
+		FullyDistSpVec<IT,IT> pOflevel1V = EWiseApply<IT>(nonStars, stars, [](short s, short){ return static_cast<IT>(s); },
+								   [](short, short isStar){ return isStar == LACC_STAR; }, false, static_cast<short>(0));
+		pOflevel1V = GatherIndices(pOflevel1V, parents, static_cast<IT>(0));
+		FullyDistSpVec<IT,short> isParentStar = Extract(stars, pOflevel1V, dense);
+		stars.Set(isParentStar);
+	}
+
+	//! Shortcut of the nonstars only
+	static void Shortcut(FullyDistVec<IT,IT> & parents, const FullyDistVec<IT,short> & stars, bool dense)
+	{
+		FullyDistSpVec<IT,short> spNonStars(stars, [](short isStar){ return isStar == LACC_NONSTAR; });
+		FullyDistSpVec<IT,IT> parentsOfNonStars = GatherIndices(spNonStars, parents, static_cast<short>(0));
+		FullyDistSpVec<IT,IT> grandParentsOfNonStars = Extract(parents, parentsOfNonStars, dense);
+		parents.Set(grandParentsOfNonStars);
+	}
+
+	//! Roots are numbered incrementally, every other vertex takes the number of its parent (a root)
+	static IT LabelCC(const FullyDistVec<IT,IT> & parent, FullyDistVec<IT,IT> & cclabel, bool dense)
+	{
+		cclabel = parent;
+		cclabel.ApplyInd([](IT val, IT ind){ return val == ind? -1 : val; });
+		FullyDistSpVec<IT,IT> roots(cclabel, [](IT val){ return val == -1; });
+		FullyDistSpVec<IT,IT> pOfLeaves(cclabel, [](IT val){ return val != -1; });	// parents of leaves are still correct
+		roots.nziota(0);
+		cclabel.Set(roots);
+		FullyDistSpVec<IT,IT> labelOfParents = Extract(cclabel, pOfLeaves, dense);
+		cclabel.Set(labelOfParents);
+		return roots.getnnz();
+	}
+
+	PSpMat_Bool Abool;
+	FullyDistVec<IT,IT> degrees;
+	LACCParams params;
+};
+
+/**
+ * Single-call convenience wrapper
+ * @return component labels, nCC is set to the number of components
+ **/
+template <typename IT, typename NT, typename DER>
+FullyDistVec<IT,IT> LACCConnectedComponents(const SpParMat<IT,NT,DER> & A, IT & nCC, const LACCParams & params = LACCParams(),
+					    std::vector<LACCIteration> * iterstats = NULL)
+{
+	LACC<IT,NT,DER> engine(A, params);
+	FullyDistVec<IT,IT> cclabel(A.getcommgrid());
+	nCC = engine.Run(cclabel, iterstats);
+	return cclabel;
+}
+
+}
+
+#endif
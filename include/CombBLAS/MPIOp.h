@@ -5,6 +5,7 @@
 #include <typeinfo>
 #include <map>
 #include <functional>
+#include <type_traits>
 #include <mpi.h>
 #include <stdint.h>
 #include "Operations.h"
@@ -59,6 +60,15 @@ public:
 extern MPIOpCache mpioc;	// global variable
 
 
+// Binary functors that declare "static const bool commutative = true" get commutative MPI_Ops,
+// which lets the MPI library pick any reduction order (and offload it)
+template <typename Op, typename Enable = void>
+struct IsCommutativeOp { static const bool value = false; };
+
+template <typename Op>
+struct IsCommutativeOp<Op, typename std::enable_if<Op::commutative>::type> { static const bool value = true; };
+
+
 // MPIOp: A class that has a static op() function that takes no arguments and returns the corresponding MPI_Op
 // if and only if the given Op has a mapping to a valid MPI_Op
 // No concepts checking for the applicability of Op on the datatype T at the moment
@@ -79,17 +89,17 @@ struct MPIOp
     }
     static MPI_Op op()
     {
-        std::type_info const* t = &typeid(Op);
+        std::type_info const* t = &typeid(MPIOp<Op,T,Enable>);	// the same functor over different types needs different ops
         MPI_Op foundop = mpioc.get(t);
         
         if (foundop == MPI_OP_NULL)
         {
-            MPI_Op_create(funcmpi, false, &foundop);
+            MPI_Op_create(funcmpi, IsCommutativeOp<Op>::value, &foundop);
           
             int myrank;
             MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
             if(myrank == 0)
-                std::cout << "Creating a new MPI Op for " << t->name() << std::endl;
+                std::cout << "Creating a new MPI Op for " << typeid(Op).name() << std::endl;
             
             mpioc.set(t, foundop);
         }
@@ -108,6 +118,53 @@ template<typename T> struct MPIOp< bitwise_and<T>,T,typename std::enable_if<std:
 template<typename T> struct MPIOp< bitwise_or<T>,T,typename std::enable_if<std::is_pod<T>::value, void>::type > {  static MPI_Op op() { return MPI_BOR; } };
 template<typename T> struct MPIOp< bitwise_xor<T>,T,typename std::enable_if<std::is_pod<T>::value, void>::type > { static MPI_Op op() { return MPI_BXOR; } };
 
+
+/**
+ * Registry of MPI_Ops for semiring additions, so that collectives can reduce values of any semiring
+ * SRingMPIOp<SR,T>::op() is SR::mpi_op() when the semiring provides one (typically a predefined op like MPI_SUM),
+ * otherwise a commutative user op that applies SR::add, created on first use and cached in mpioc
+ * SpParMat::Reduce<SR> and SpParMat::MaskedReduce<SR> combine their partial results with it, as does dense SpMV
+ * Reductions written for binary functors take SRingAddOp<SR,T>() and end up with the same MPI_Op
+ **/
+template <typename SR, typename T, typename Enable = void>
+struct SRingMPIOp
+{
+    static void funcmpi(void * invec, void * inoutvec, int * len, MPI_Datatype *)
+    {
+        T * pinvec = static_cast<T*>(invec);
+        T * pinoutvec = static_cast<T*>(inoutvec);
+        for (int i = 0; i < *len; i++)
+        {
+            pinoutvec[i] = SR::add(pinvec[i], pinoutvec[i]);
+        }
+    }
+    static MPI_Op op()
+    {
+        std::type_info const* t = &typeid(SRingMPIOp<SR,T>);
+        MPI_Op foundop = mpioc.get(t);
+        if (foundop == MPI_OP_NULL)
+        {
+            MPI_Op_create(funcmpi, true, &foundop);	// semiring addition is a commutative monoid
+            mpioc.set(t, foundop);
+        }
+        return foundop;
+    }
+};
+
+template <typename SR, typename T>
+struct SRingMPIOp< SR, T, decltype(void(SR::mpi_op())) > { static MPI_Op op() { return SR::mpi_op(); } };
+
+//! Semiring addition as a binary functor
+template <typename SR, typename T>
+struct SRingAddOp
+{
+    static const bool commutative = true;
+    T operator()(const T & a, const T & b) const { return SR::add(a, b); }
+};
+
+template <typename SR, typename T>
+struct MPIOp< SRingAddOp<SR,T>, T > { static MPI_Op op() { return SRingMPIOp<SR,T>::op(); } };
+
 }
 
 #endif
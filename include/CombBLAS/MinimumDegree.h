@@ -0,0 +1,317 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _MINIMUM_DEGREE_H_
+#define _MINIMUM_DEGREE_H_
+
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include "SpParMat.h"
+#include "FullyDistVec.h"
+#include "FullyDistSpVec.h"
+#include "ParFriends.h"
+#include "Semirings.h"
+
+namespace combblas {
+
+struct MinimumDegreeParams
+{
+	MinimumDegreeParams(): delta(0) {}
+	int64_t delta;	// vertices whose approximate degree is at most mindeg+delta are candidates for elimination (as in MMD)
+};
+
+//! Statistics of a single elimination round
+struct MinimumDegreeRound
+{
+	int round;
+	int64_t mindeg;		// smallest approximate degree
+	int64_t candidates;	// vertices with degree at most mindeg+delta
+	int64_t eliminated;	// independent set eliminated in the round
+	double time;		// seconds
+};
+
+/**
+ * Approximate minimum degree ordering with multiple elimination on the quotient graph
+ * The quotient graph is kept as two n x n matrices: Avv holds the original edges between uneliminated vertices (variables)
+ * and E(i,e) = 1 iff variable i belongs to element e, the clique created when e was eliminated. The reach of the variables
+ * in a set C is Avv(:,C) + E * E'(:,C), one pair of SpGEMMs for all of C.
+ * Every round takes the candidates whose approximate degree is at most mindeg+delta, and keeps those whose (degree, random)
+ * key is smaller than the key of every other candidate they reach; these are independent in the elimination graph and are
+ * eliminated together. A new element p takes the reach Lp of pivot p, and absorbs the elements p belonged to as well as the
+ * old elements that fall inside Lp (aggressive absorption).
+ * Degrees are AMD's approximate external degrees (Amestoy, Davis and Duff), updated only for the variables reached by the
+ * pivots: d(i) = min(nvar-1, d(i) + sum_{p} (|Lp|-1), |A_i \ Lq| + sum_{e} |Le \ Lq| + sum_{p} (|Lp|-1)) for the pivots p with
+ * i in Lp and the old elements e containing i, where q is the pivot that maximizes the overlap. The overlaps |Le & Lp| come
+ * from the SpGEMM E' * Reach, and |A_i & Lq| + sum_{e} |Le & Lq| from (A + E * E') * Reach masked to the reach.
+ * A variable that lies in a single new element Lp and has nothing outside of it is mass eliminated right after the pivots,
+ * which creates no fill. Supervariables (indistinguishable vertices) are not detected otherwise.
+ * A should be symmetric; the values and the diagonal of A are ignored
+ **/
+template <typename IT, typename NT, typename DER>
+class MinimumDegree
+{
+public:
+	typedef SpParMat < IT, IT, SpDCCols<IT,IT> > PSpMat_IT;
+	typedef PlusTimesSRing<IT,IT> PTIT;
+
+	MinimumDegree(const SpParMat<IT,NT,DER> & A, const MinimumDegreeParams & myparams = MinimumDegreeParams()):
+		Avv(static_cast<PSpMat_IT>(A)), params(myparams)
+	{
+		Avv.RemoveLoops();
+		Avv.Apply([](IT val){ return static_cast<IT>(1); });
+	}
+
+	MinimumDegreeParams & GetParams() { return params; }
+	void SetParams(const MinimumDegreeParams & myparams) { params = myparams; }
+
+	/**
+	 * @param[out] perm perm[k] is the k-th vertex in elimination order, A(perm,perm) is the reordered matrix
+	 * @param[out] roundstats if not NULL, filled with the statistics of every round
+	 **/
+	void Run(FullyDistVec<IT,IT> & perm, std::vector<MinimumDegreeRound> * roundstats = NULL)
+	{
+		std::shared_ptr<CommGrid> commGrid = Avv.getcommgrid();
+		IT n = Avv.getnrow();
+		const IT inf = std::numeric_limits<IT>::max();
+		if(roundstats != NULL) roundstats->clear();
+
+		PSpMat_IT A(Avv);	// consumed by the elimination
+		PSpMat_IT E(n, n, FullyDistVec<IT,IT>(commGrid), FullyDistVec<IT,IT>(commGrid), static_cast<IT>(1));
+		FullyDistVec<IT,IT> order(commGrid, n, static_cast<IT>(-1));
+		FullyDistVec<IT,IT> alive(commGrid, n, static_cast<IT>(1));
+		FullyDistVec<IT,IT> deg(commGrid);
+		A.Reduce(deg, Column, std::plus<IT>(), static_cast<IT>(0));
+		FullyDistVec<IT,IT> elsize(commGrid, n, static_cast<IT>(0));
+
+		// a multiplicative bijection on 0,...,n-1 breaks the degree ties pseudo-randomly
+		IT mult = std::max(n/2, static_cast<IT>(1)) | 1;
+		while(GCD(mult, n) != 1) mult += 2;
+		FullyDistVec<IT,IT> tiebreak(commGrid);
+		tiebreak.iota(n, 0);
+		tiebreak.Apply([mult, n](IT v){ return (v * mult) % n; });
+
+		IT nelim = 0;
+		int round = 1;
+		while(nelim < n)
+		{
+			double t1 = MPI_Wtime();
+			IT nvar = n - nelim;
+
+			// candidates and their keys
+			IT mindeg = deg.Reduce(minimum<IT>(), inf);
+			IT threshold = (params.delta > inf - mindeg)? inf-1 : mindeg + params.delta;
+			FullyDistVec<IT,IT> cand = deg.FindInds([threshold](IT d){ return d <= threshold; });
+			IT ncand = cand.TotalLength();
+			FullyDistVec<IT,IT> key = deg;
+			key.EWiseApply(tiebreak, [threshold, n](IT d, IT t){ return (d <= threshold)? d*n + t : std::numeric_limits<IT>::max(); });
+
+			// reach of the candidates: R(i,j) = 1 iff variable i != cand[j] is reachable from cand[j]
+			PSpMat_IT P = Selection(n, cand);
+			PSpMat_IT ET = E;
+			ET.Transpose();
+			PSpMat_IT R = PSpGEMM<PTIT>(A, P);
+			if(E.getnnz() > 0)
+			{
+				PSpMat_IT ETP = PSpGEMM<PTIT>(ET, P);
+				R += PSpGEMM<PTIT>(E, ETP);
+			}
+			R = EWiseMult(R, P, true);
+			R.Apply([](IT val){ return static_cast<IT>(1); });
+
+			// a candidate is a pivot if its key is smaller than the keys of all candidates it reaches
+			PSpMat_IT RK = R;
+			RK.DimApply(Row, key, [](IT val, IT k){ return k; });
+			FullyDistVec<IT,IT> nbrmin(commGrid);
+			RK.Reduce(nbrmin, Column, minimum<IT>(), inf);
+			FullyDistVec<IT,IT> candkey = key(cand);
+			candkey.EWiseApply(nbrmin, [](IT k, IT m){ return static_cast<IT>(k < m); });
+			FullyDistVec<IT,IT> sel = candkey.FindInds([](IT s){ return s == 1; });
+			FullyDistVec<IT,IT> pivots = cand(sel);
+			IT npivots = pivots.TotalLength();
+
+			PSpMat_IT Q = Selection(ncand, sel);
+			PSpMat_IT Rs = PSpGEMM<PTIT>(R, Q);	// Rs(:,t) is the new element of pivots[t]
+			FullyDistVec<IT,IT> lsize(commGrid);
+			Rs.Reduce(lsize, Column, std::plus<IT>(), static_cast<IT>(0));
+
+			// number the pivots
+			FullyDistVec<IT,IT> pivotorder(commGrid);
+			pivotorder.iota(npivots, nelim);
+			order.Set(FullyDistSpVec<IT,IT>(n, pivots, pivotorder));
+			FullyDistVec<IT,IT> ispivot(commGrid, n, static_cast<IT>(0));
+			ispivot.Set(FullyDistSpVec<IT,IT>(n, pivots, FullyDistVec<IT,IT>(commGrid, npivots, static_cast<IT>(1))));
+			alive.EWiseApply(ispivot, [](IT a, IT p){ return p? static_cast<IT>(0) : a; });
+
+			// the pivots leave the variable graph and become elements
+			A.DimApply(Row, alive, [](IT val, IT a){ return val*a; });
+			A.DimApply(Column, alive, [](IT val, IT a){ return val*a; });
+			A.Prune([](IT val){ return val == 0; });
+
+			// elements of the pivots are absorbed, and so are the old elements that lie inside a new element
+			// W(i,t) = |A_i & Lt| + sum_{e} |Le & Lt| over the remaining old elements e containing i, for the new elements Lt
+			FullyDistVec<IT,IT> absorbed(commGrid, n, static_cast<IT>(0));
+			FullyDistVec<IT,IT> elsum(commGrid, n, static_cast<IT>(0));
+			PSpMat_IT W = PSpGEMM<PTIT>(A, Rs);
+			if(E.getnnz() > 0)
+			{
+				PSpMat_IT EP = E;
+				EP.DimApply(Row, ispivot, [](IT val, IT p){ return p; });
+				EP.Prune([](IT val){ return val == 0; });
+				EP.Reduce(absorbed, Column, maximum<IT>(), static_cast<IT>(0));
+
+				PSpMat_IT O = PSpGEMM<PTIT>(ET, Rs);	// O(e,t) = |Le & Lt|
+				FullyDistVec<IT,IT> omax(commGrid);
+				O.Reduce(omax, Row, maximum<IT>(), static_cast<IT>(0));
+				omax.EWiseApply(elsize, [](IT o, IT s){ return static_cast<IT>(s > 0 && o == s); });
+				absorbed.EWiseApply(omax, [](IT a, IT o){ return static_cast<IT>(a || o); });
+				FullyDistVec<IT,IT> keep = absorbed;
+				keep.Apply([](IT a){ return static_cast<IT>(!a); });
+				E.DimApply(Column, keep, [](IT val, IT k){ return val*k; });
+				E.DimApply(Row, alive, [](IT val, IT a){ return val*a; });
+				E.Prune([](IT val){ return val == 0; });
+
+				PSpMat_IT ES = E;
+				ES.DimApply(Column, elsize, [](IT val, IT s){ return s; });
+				ES.Reduce(elsum, Row, std::plus<IT>(), static_cast<IT>(0));
+				W += PSpGEMM<PTIT>(E, O);
+			}
+			W = EWiseMult(W, Rs, false);
+			FullyDistVec<IT,IT> maxov(commGrid);
+			W.Reduce(maxov, Row, maximum<IT>(), static_cast<IT>(0));
+
+			// ext(i) = |A_i \ Lq| + sum_{e} |Le \ Lq| for the new element Lq that overlaps the most
+			FullyDistVec<IT,IT> ext(commGrid), nreach(commGrid);
+			A.Reduce(ext, Row, std::plus<IT>(), static_cast<IT>(0));
+			ext.EWiseApply(elsum, std::plus<IT>());
+			ext.EWiseApply(maxov, std::minus<IT>());
+			Rs.Reduce(nreach, Row, std::plus<IT>(), static_cast<IT>(0));
+
+			// mass elimination: a variable in a single new element, with nothing outside it, follows its pivot without fill
+			FullyDistVec<IT,IT> mass = ext;
+			mass.EWiseApply(nreach, [](IT x, IT r){ return static_cast<IT>(r == 1 && x == 0); });
+			FullyDistVec<IT,IT> massvars = mass.FindInds([](IT m){ return m == 1; });
+			IT nmass = massvars.TotalLength();
+			if(nmass > 0)
+			{
+				FullyDistVec<IT,IT> massorder(commGrid);
+				massorder.iota(nmass, nelim + npivots);
+				order.Set(FullyDistSpVec<IT,IT>(n, massvars, massorder));
+				alive.EWiseApply(mass, [](IT a, IT m){ return m? static_cast<IT>(0) : a; });
+				A.DimApply(Row, alive, [](IT val, IT a){ return val*a; });
+				A.DimApply(Column, alive, [](IT val, IT a){ return val*a; });
+				A.Prune([](IT val){ return val == 0; });
+				E.DimApply(Row, alive, [](IT val, IT a){ return val*a; });
+				E.Prune([](IT val){ return val == 0; });
+				Rs.DimApply(Row, alive, [](IT val, IT a){ return val*a; });
+				Rs.Prune([](IT val){ return val == 0; });
+				Rs.Reduce(lsize, Column, std::plus<IT>(), static_cast<IT>(0));
+			}
+
+			if(npivots > 0)
+			{
+				FullyDistVec<IT,IT> ri(commGrid), ci(commGrid);
+				Rs.Find(ri, ci);
+				FullyDistVec<IT,IT> ei = pivots(ci);
+				E += PSpMat_IT(n, n, ri, ei, static_cast<IT>(1));
+			}
+			E.Reduce(elsize, Column, std::plus<IT>(), static_cast<IT>(0));
+
+			// approximate degrees of the reached variables: min(d(i) + sum_{t} (|Lt|-1), ext(i) + sum_{t} (|Lt|-1))
+			PSpMat_IT RL = Rs;
+			lsize.Apply([](IT s){ return s-1; });
+			RL.DimApply(Column, lsize, [](IT val, IT s){ return s; });
+			FullyDistVec<IT,IT> newsum(commGrid);
+			RL.Reduce(newsum, Row, std::plus<IT>(), static_cast<IT>(0));
+			ext.EWiseApply(newsum, std::plus<IT>());
+			FullyDistVec<IT,IT> upd = deg;
+			upd.EWiseApply(newsum, std::plus<IT>());
+			upd.EWiseApply(ext, minimum<IT>());
+			upd.EWiseApply(nreach, [](IT u, IT r){ return (r > 0)? u : static_cast<IT>(-1); });
+			deg.EWiseApply(upd, [](IT d, IT u){ return (u >= 0)? u : d; });
+			IT cap = std::max(nvar - npivots - nmass - 1, static_cast<IT>(0));
+			deg.EWiseApply(alive, [cap, inf](IT d, IT a){ return a? std::min(d, cap) : inf; });
+
+			nelim += npivots + nmass;
+			if(roundstats != NULL)
+			{
+				MinimumDegreeRound stat;
+				stat.round = round;
+				stat.mindeg = static_cast<int64_t>(mindeg);
+				stat.candidates = static_cast<int64_t>(ncand);
+				stat.eliminated = static_cast<int64_t>(npivots + nmass);
+				stat.time = MPI_Wtime() - t1;
+				roundstats->push_back(stat);
+			}
+			++round;
+		}
+		perm = order.sort();
+	}
+
+private:
+	static IT GCD(IT a, IT b)
+	{
+		while(b != 0)
+		{
+			IT t = a % b;
+			a = b;
+			b = t;
+		}
+		return a;
+	}
+
+	//! m x k matrix with a single nonzero (sel[j], j) in every column
+	static PSpMat_IT Selection(IT m, const FullyDistVec<IT,IT> & sel)
+	{
+		FullyDistVec<IT,IT> ci(sel.getcommgrid());
+		ci.iota(sel.TotalLength(), 0);
+		return PSpMat_IT(m, sel.TotalLength(), sel, ci, static_cast<IT>(1));
+	}
+
+	PSpMat_IT Avv;
+	MinimumDegreeParams params;
+};
+
+/**
+ * Single-call convenience wrapper
+ * @return perm, the vertices in elimination order; A(perm,perm) is the reordered matrix
+ **/
+template <typename IT, typename NT, typename DER>
+FullyDistVec<IT,IT> MinimumDegreeOrdering(const SpParMat<IT,NT,DER> & A, const MinimumDegreeParams & params = MinimumDegreeParams(),
+					  std::vector<MinimumDegreeRound> * roundstats = NULL)
+{
+	MinimumDegree<IT,NT,DER> engine(A, params);
+	FullyDistVec<IT,IT> perm(A.getcommgrid());
+	engine.Run(perm, roundstats);
+	return perm;
+}
+
+}
+
+#endif
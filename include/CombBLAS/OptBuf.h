@@ -125,6 +125,32 @@ public:
 	int localm;
 };
 
+
+/**
+  * Scratch space of the batched sparse matrix X multiple sparse vectors (SpMSpVBatch in ParFriends.h)
+  * Every communication step packs all k vectors into a single buffer, per-vector counts are kept next to it
+  * Buffers are std::vectors that are only resized (never shrunk), so passing the same object to
+  * every iteration of a multi-source traversal keeps the memory allocated once
+  */
+template <class IVT, class OVT>
+class SpMSpVBatchBuf
+{
+public:
+	// input side: local pieces of x, after the transpose, and after the allgather along the processor column
+	std::vector<int> xcnts, trcnts, colcnts, acccnts;
+	std::vector<int32_t> xinds, trinds, colinds, accinds;
+	std::vector<IVT> xnums, trnums, colnums, accnums;
+
+	// output side: local products (per vector, bucketed by recipient) and the fold along the processor row
+	std::vector<int> ycnts, sendcnts, recvcnts;
+	std::vector<int32_t> yinds, sendinds, recvinds;
+	std::vector<OVT> ynums, sendnums, recvnums;
+
+	// output of a single local SpMSpV
+	std::vector<int32_t> indy;
+	std::vector<OVT> numy;
+};
+
 }
 
 #endif
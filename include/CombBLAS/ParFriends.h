@@ -39,6 +39,7 @@
 #include "MPIType.h"
 #include "Friends.h"
 #include "OptBuf.h"
+#include "IndexListCodec.h"
 #include "mtSpGEMM.h"
 #include "MultiwayMerge.h"
 #include <unistd.h>
@@ -182,8 +183,11 @@ bool CheckSpGEMMCompliance(const MATRIXA & A, const MATRIXB & B)
 
 
 // Combined logic for prune, recovery, and select
+// Column statistics (nnz before and after the hard threshold, and sum after it) are given, either because A was
+// truncated while it was computed (see LocalSpGEMMSelect) or by the overload below
 template <typename IT, typename NT, typename DER>
-void MCLPruneRecoverySelect(SpParMat<IT,NT,DER> & A, NT hardThreshold, IT selectNum, IT recoverNum, NT recoverPct, int kselectVersion)
+void MCLPruneRecoverySelect(SpParMat<IT,NT,DER> & A, NT hardThreshold, IT selectNum, IT recoverNum, NT recoverPct, int kselectVersion,
+                            FullyDistVec<IT,NT> & nnzPerColumnUnpruned, FullyDistVec<IT,NT> & nnzPerColumn, FullyDistVec<IT,NT> & colSums)
 {
     int myrank;
     MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
@@ -192,18 +196,10 @@ void MCLPruneRecoverySelect(SpParMat<IT,NT,DER> & A, NT hardThreshold, IT select
     double t0, t1;
 #endif
     
-    // Prune and create a new pruned matrix
-    SpParMat<IT,NT,DER> PrunedA = A.Prune(std::bind2nd(std::less_equal<NT>(), hardThreshold), false);
-    // column-wise statistics of the pruned matrix
-    FullyDistVec<IT,NT> colSums = PrunedA.Reduce(Column, std::plus<NT>(), 0.0);
-    FullyDistVec<IT,NT> nnzPerColumnUnpruned = A.Reduce(Column, std::plus<NT>(), 0.0, [](NT val){return 1.0;});
-    FullyDistVec<IT,NT> nnzPerColumn = PrunedA.Reduce(Column, std::plus<NT>(), 0.0, [](NT val){return 1.0;});
     //FullyDistVec<IT,NT> pruneCols(A.getcommgrid(), A.getncol(), hardThreshold);
     FullyDistVec<IT,NT> pruneCols(nnzPerColumn);
     pruneCols = hardThreshold;
 
-    PrunedA.FreeMemory();
-
     FullyDistSpVec<IT,NT> recoverCols(nnzPerColumn, std::bind2nd(std::less<NT>(), recoverNum));
     
     // recover only when nnzs in unprunned columns are greater than nnzs in pruned column
@@ -352,6 +348,20 @@ void MCLPruneRecoverySelect(SpParMat<IT,NT,DER> & A, NT hardThreshold, IT select
 
 }
 
+template <typename IT, typename NT, typename DER>
+void MCLPruneRecoverySelect(SpParMat<IT,NT,DER> & A, NT hardThreshold, IT selectNum, IT recoverNum, NT recoverPct, int kselectVersion)
+{
+    // Prune and create a new pruned matrix
+    SpParMat<IT,NT,DER> PrunedA = A.Prune(std::bind2nd(std::less_equal<NT>(), hardThreshold), false);
+    // column-wise statistics of the pruned matrix
+    FullyDistVec<IT,NT> colSums = PrunedA.Reduce(Column, std::plus<NT>(), 0.0);
+    FullyDistVec<IT,NT> nnzPerColumnUnpruned = A.Reduce(Column, std::plus<NT>(), 0.0, [](NT val){return 1.0;});
+    FullyDistVec<IT,NT> nnzPerColumn = PrunedA.Reduce(Column, std::plus<NT>(), 0.0, [](NT val){return 1.0;});
+    PrunedA.FreeMemory();
+
+    MCLPruneRecoverySelect(A, hardThreshold, selectNum, recoverNum, recoverPct, kselectVersion, nnzPerColumnUnpruned, nnzPerColumn, colSums);
+}
+
 template <typename SR, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB> 
 IU EstimateFLOP 
 		(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B, bool clearA = false, bool clearB = false)
@@ -440,15 +450,237 @@ IU EstimateFLOP
     return global_flops;
 }
 
+/**
+  * Exact symbolic SUMMA: the number of nonzeros SUMMA stores for every local column of C before the multiway merge
+  * Each stage is broadcast as in the numeric multiplication and estimateNNZ_Hash counts the nonzeros it contributes
+  * to every column. Processes in the same column of the grid share the columns of B (and hence the phase boundaries
+  * of MemEfficientSpGEMM), so the counts are maximized over the processor column.
+  * @return vector of length B.getlocalcols(), unlike EstPerProcessNnzSUMMA this is exact and per column
+  * A and B may alias (MemEfficientSpGEMM plans A*A this way), neither is modified
+  **/
+template <typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
+std::vector<int64_t> SymbolicSUMMAColumnNnz(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B)
+{
+    typedef typename UDERA::LocalIT LIA;
+    typedef typename UDERB::LocalIT LIB;
+    static_assert(std::is_same<LIA, LIB>::value, "local index types for both input matrices should be the same");
+
+    int stages, dummy;     // last two parameters of ProductGrid are ignored for Synch multiplication
+    std::shared_ptr<CommGrid> GridC = ProductGrid((A.commGrid).get(), (B.commGrid).get(), stages, dummy, dummy);
+
+    LIB ncols = B.spSeq->getncol();
+    std::vector<int64_t> colnnz(ncols, 0);
+
+    LIA ** ARecvSizes = SpHelper::allocate2D<LIA>(UDERA::esscount, stages);
+    LIB ** BRecvSizes = SpHelper::allocate2D<LIB>(UDERB::esscount, stages);
+    SpParHelper::GetSetSizes( *(A.spSeq), ARecvSizes, (A.commGrid)->GetRowWorld());
+    SpParHelper::GetSetSizes( *(B.spSeq), BRecvSizes, (B.commGrid)->GetColWorld());
+
+    UDERA * ARecv;
+    UDERB * BRecv;
+    int Aself = (A.commGrid)->GetRankInProcRow();
+    int Bself = (B.commGrid)->GetRankInProcCol();
+
+    for(int i = 0; i < stages; ++i)
+    {
+        std::vector<LIA> ess;
+        if(i == Aself)
+        {
+            ARecv = A.spSeq;    // shallow-copy
+        }
+        else
+        {
+            ess.resize(UDERA::esscount);
+            for(int j=0; j< UDERA::esscount; ++j)
+                ess[j] = ARecvSizes[j][i];
+            ARecv = new UDERA();
+        }
+        SpParHelper::BCastMatrix(GridC->GetRowWorld(), *ARecv, ess, i);
+        ess.clear();
+
+        if(i == Bself)
+        {
+            BRecv = B.spSeq;    // shallow-copy
+        }
+        else
+        {
+            ess.resize(UDERB::esscount);
+            for(int j=0; j< UDERB::esscount; ++j)
+                ess[j] = BRecvSizes[j][i];
+            BRecv = new UDERB();
+        }
+        SpParHelper::BCastMatrix(GridC->GetColWorld(), *BRecv, ess, i);
+
+        LIB* flopC = estimateFLOP(*ARecv, *BRecv);
+        LIB* colnnzC = estimateNNZ_Hash(*ARecv, *BRecv, flopC);
+        if(colnnzC)
+        {
+            // colnnzC is indexed by the nonzero columns of BRecv, which has the same columns as B.spSeq
+            Dcsc<LIB,NU2> * Bdcsc = BRecv->GetDCSC();
+            for(LIB k=0; k< Bdcsc->nzc; ++k)
+                colnnz[Bdcsc->jc[k]] += colnnzC[k];
+        }
+        if(flopC) delete [] flopC;
+        if(colnnzC) delete [] colnnzC;
+
+        if(i != Aself)
+            delete ARecv;
+        if(i != Bself)
+            delete BRecv;
+    }
+    SpHelper::deallocate2D(ARecvSizes, UDERA::esscount);
+    SpHelper::deallocate2D(BRecvSizes, UDERB::esscount);
+
+    MPI_Allreduce(MPI_IN_PLACE, colnnz.data(), static_cast<int>(ncols), MPIType<int64_t>(), MPI_MAX, GridC->GetColWorld());
+
+    return colnnz;
+}
+
+/**
+  * Uneven column phases for MemEfficientSpGEMM, cut by cumulative output size rather than by column count
+  * Column j costs colnnz[j]*bytesPerNnz plus min(colnnz[j], kselectPerCol)*bytesPerSelected bytes.
+  * Phases are cut greedily so that each costs at most bytesPerPhase; a single column that does not fit becomes a phase of its own.
+  * The number of phases is the maximum over World, processes that need fewer split their widest phases further.
+  * @param[in] colnnz output of SymbolicSUMMAColumnNnz
+  * @return the number of columns in each phase, same length on all processes of World (zero-width phases only if there are fewer columns than phases)
+  **/
+template <typename LIB>
+std::vector<LIB> PlanSUMMAPhases(const std::vector<int64_t> & colnnz, int64_t bytesPerPhase, int64_t bytesPerNnz,
+                                 int64_t kselectPerCol, int64_t bytesPerSelected, MPI_Comm World)
+{
+    LIB ncols = static_cast<LIB>(colnnz.size());
+    std::vector<LIB> cutSizes;
+    int64_t phaseBytes = 0;
+    LIB phaseBegin = 0;
+    for(LIB j=0; j< ncols; ++j)
+    {
+        int64_t colBytes = colnnz[j] * bytesPerNnz + std::min(colnnz[j], kselectPerCol) * bytesPerSelected;
+        if(j > phaseBegin && phaseBytes + colBytes > bytesPerPhase)
+        {
+            cutSizes.push_back(j - phaseBegin);
+            phaseBegin = j;
+            phaseBytes = 0;
+        }
+        phaseBytes += colBytes;
+    }
+    cutSizes.push_back(ncols - phaseBegin);
+
+    int localphases = static_cast<int>(cutSizes.size());
+    int phases;
+    MPI_Allreduce(&localphases, &phases, 1, MPI_INT, MPI_MAX, World);
+    while(static_cast<int>(cutSizes.size()) < phases)
+    {
+        typename std::vector<LIB>::iterator widest = std::max_element(cutSizes.begin(), cutSizes.end());
+        if(*widest < 2)
+        {
+            cutSizes.resize(phases, 0);
+            break;
+        }
+        LIB half = *widest / 2;
+        *widest -= half;
+        cutSizes.insert(widest+1, half);
+    }
+    return cutSizes;
+}
+
+
+/**
+  * Phases for MemEfficientSpGEMM that fit perProcessBytes of memory per process, from the exact symbolic pass
+  * Accounts for the inputs (four copies, six when pipelined), the output after selection/recovery, and the
+  * unmerged SUMMA output plus the k-select buffers of the largest phase.
+  * @return the number of columns of the local piece of B in each phase, empty if the inputs and the output alone do not fit
+  **/
+template <typename NUO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
+std::vector<typename UDERB::LocalIT> PlanMemEfficientPhases(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B,
+                                                            IU selectNum, IU recoverNum, int64_t perProcessBytes, bool pipelined = false)
+{
+    MPI_Comm World = A.getcommgrid()->GetWorld();
+    int myrank;
+    MPI_Comm_rank(World,&myrank);
+    
+    int64_t perNNZMem_in = sizeof(IU)*2 + sizeof(NU1);
+    int64_t perNNZMem_out = sizeof(IU)*2 + sizeof(NUO);
+    
+    // max nnz(A) in a porcess
+    int64_t lannz = A.getlocalnnz();
+    int64_t gannz;
+    MPI_Allreduce(&lannz, &gannz, 1, MPIType<int64_t>(), MPI_MAX, World);
+    int64_t inputMem = gannz * perNNZMem_in * (pipelined? 6 : 4); // for four copies (two for SUMMA), plus the prefetched pieces when pipelined
+    
+    // exact nnz stored by SUMMA for each local column of A^2 before merging
+    std::vector<int64_t> colnnz = SymbolicSUMMAColumnNnz(A,B);
+    int64_t k = int64_t(std::max(selectNum, recoverNum));
+    int64_t loutputNNZ = 0;
+    for(size_t j=0; j< colnnz.size(); ++j)
+    {
+        if(k > 0)   // columns keep at most k entries after selection/recovery
+            loutputNNZ += std::min(colnnz[j], k);
+        else loutputNNZ += colnnz[j];
+    }
+    int64_t outputNNZ;
+    MPI_Allreduce(&loutputNNZ, &outputNNZ, 1, MPIType<int64_t>(), MPI_MAX, World);
+    int64_t outputMem = outputNNZ * perNNZMem_in * 2;
+    
+    //inputMem + outputMem + (asquareMem + kselectmem of the largest phase) < memory
+    // PlanSUMMAPhases charges every column its share of asquareMem and kselectmem
+    int64_t remainingMem = perProcessBytes - inputMem - outputMem;
+    std::vector<typename UDERB::LocalIT> phaseCuts;
+    if(remainingMem > 0)
+        phaseCuts = PlanSUMMAPhases<typename UDERB::LocalIT>(colnnz, remainingMem, perNNZMem_out * 2, k, 8 * 3, World);
+    
+#ifdef SHOW_MEMORY_USAGE
+    int64_t lsquareNNZ = 0;
+    for(size_t j=0; j< colnnz.size(); ++j)
+        lsquareNNZ += colnnz[j];
+    int64_t lselectNNZ = (k > 0)? loutputNNZ : 0;
+    int64_t asquareNNZ, selectNNZ;
+    MPI_Allreduce(&lsquareNNZ, &asquareNNZ, 1, MPIType<int64_t>(), MPI_MAX, World);
+    MPI_Allreduce(&lselectNNZ, &selectNNZ, 1, MPIType<int64_t>(), MPI_MAX, World);
+    int64_t asquareMem = asquareNNZ * perNNZMem_out * 2; // an extra copy in multiway merge and in selection/recovery step
+    int64_t kselectmem = selectNNZ * 8 * 3;
+#endif
+    
+    if(myrank==0)
+    {
+        if(remainingMem < 0)
+        {
+            std::cout << "!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n Warning: input and output memory requirement is greater than per-process avaiable memory. Keeping phase to the value supplied at the command line. The program may go out of memory and crash! \n !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!" << std::endl;
+        }
+#ifdef SHOW_MEMORY_USAGE
+        int phases = std::max(static_cast<int>(phaseCuts.size()), 1);
+        int64_t maxMemory = kselectmem/phases + inputMem + outputMem + asquareMem / phases;
+        if(maxMemory>1000000000)
+        std::cout << "phases: " << phases << ": per process memory: " << perProcessBytes/1000000000.00 << " GB asquareMem: " << asquareMem/1000000000.00 << " GB" << " inputMem: " << inputMem/1000000000.00 << " GB" << " outputMem: " << outputMem/1000000000.00 << " GB" << " kselectmem: " << kselectmem/1000000000.00 << " GB" << std::endl;
+        else
+        std::cout << "phases: " << phases << ": per process memory: " << perProcessBytes/1000000000.00 << " GB asquareMem: " << asquareMem/1000000.00 << " MB" << " inputMem: " << inputMem/1000000.00 << " MB" << " outputMem: " << outputMem/1000000.00 << " MB" << " kselectmem: " << kselectmem/1000000.00 << " MB" << std::endl;
+#endif
+        
+    }
+    return phaseCuts;
+}
+
+
 /**
  * Broadcasts A multiple times (#phases) in order to save storage in the output
  * Only uses 1/phases of C memory if the threshold/max limits are proper
  * Parameters:
  *  - computationKernel: 1 means hash-based, 2 means heap-based
+ *  - pipelined: post the broadcasts of the next SUMMA stage (or of the first stage of the next phase) with
+ *    nonblocking collectives before multiplying the current one, so that they overlap with the local multiply,
+ *    and at phase boundaries with the multiway merge and prune/select/recovery. Costs one extra piece of A and B in memory.
+ *  - pipestats: if not null, accumulates how much of the broadcast time was hidden in pipelined mode
+ *  - fusedSelect: truncate every column to what MCLPruneRecoverySelect may keep (local top max(selectNum, recoverNum)),
+ *    and pass it the column statistics, so that it does not prune a copy of the phase. Gives the same result.
+ *    Fused into the local multiplication only when SUMMA has a single stage. With more stages a partial sum says nothing
+ *    about the final rank of an entry, so the truncation runs after the multiway merge and the peak memory of a phase
+ *    (the unmerged stage products) is the same as without fusedSelect; phases have to be planned as usual.
+ *  - plannedCuts: if not null, phases from PlanMemEfficientPhases to use instead of phases and perProcessMemory
  */
 template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
 SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B,
-                                           int phases, NUO hardThreshold, IU selectNum, IU recoverNum, NUO recoverPct, int kselectVersion, int computationKernel, int64_t perProcessMemory)
+                                           int phases, NUO hardThreshold, IU selectNum, IU recoverNum, NUO recoverPct, int kselectVersion, int computationKernel, int64_t perProcessMemory,
+                                           bool pipelined = false, SUMMAPipelineStats * pipestats = nullptr, bool fusedSelect = false,
+                                           const std::vector<typename UDERB::LocalIT> * plannedCuts = nullptr)
 {
     typedef typename UDERA::LocalIT LIA;
     typedef typename UDERB::LocalIT LIB;
@@ -479,60 +711,13 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
     MPI_Barrier(A.getcommgrid()->GetWorld());
     t0 = MPI_Wtime();
 #endif
-    if(perProcessMemory>0) // estimate the number of phases permitted by memory
-    {
-        int p;
-        MPI_Comm World = GridC->GetWorld();
-        MPI_Comm_size(World,&p);
-        
-        int64_t perNNZMem_in = sizeof(IU)*2 + sizeof(NU1);
-        int64_t perNNZMem_out = sizeof(IU)*2 + sizeof(NUO);
-        
-        // max nnz(A) in a porcess
-        int64_t lannz = A.getlocalnnz();
-        int64_t gannz;
-        MPI_Allreduce(&lannz, &gannz, 1, MPIType<int64_t>(), MPI_MAX, World);
-        int64_t inputMem = gannz * perNNZMem_in * 4; // for four copies (two for SUMMA)
-        
-        // max nnz(A^2) stored by SUMMA in a porcess
-        int64_t asquareNNZ = EstPerProcessNnzSUMMA(A,B, false);
-		int64_t asquareMem = asquareNNZ * perNNZMem_out * 2; // an extra copy in multiway merge and in selection/recovery step
-        
-        
-        // estimate kselect memory
-        int64_t d = ceil( (asquareNNZ * sqrt(p))/ B.getlocalcols() ); // average nnz per column in A^2 (it is an overestimate because asquareNNZ is estimated based on unmerged matrices)
-        // this is equivalent to (asquareNNZ * p) / B.getcol()
-        int64_t k = std::min(int64_t(std::max(selectNum, recoverNum)), d );
-        int64_t kselectmem = B.getlocalcols() * k * 8 * 3;
-        
-        // estimate output memory
-        int64_t outputNNZ = (B.getlocalcols() * k)/sqrt(p);
-        int64_t outputMem = outputNNZ * perNNZMem_in * 2;
-        
-        //inputMem + outputMem + asquareMem/phases + kselectmem/phases < memory
-        int64_t remainingMem = perProcessMemory*1000000000 - inputMem - outputMem;
-        if(remainingMem > 0)
-        {
-            phases = 1 + (asquareMem+kselectmem) / remainingMem;
-        }
-        
-        
-        if(myrank==0)
-        {
-            if(remainingMem < 0)
-            {
-                std::cout << "!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n Warning: input and output memory requirement is greater than per-process avaiable memory. Keeping phase to the value supplied at the command line. The program may go out of memory and crash! \n !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!" << std::endl;
-            }
-#ifdef SHOW_MEMORY_USAGE
-            int64_t maxMemory = kselectmem/phases + inputMem + outputMem + asquareMem / phases;
-            if(maxMemory>1000000000)
-            std::cout << "phases: " << phases << ": per process memory: " << perProcessMemory << " GB asquareMem: " << asquareMem/1000000000.00 << " GB" << " inputMem: " << inputMem/1000000000.00 << " GB" << " outputMem: " << outputMem/1000000000.00 << " GB" << " kselectmem: " << kselectmem/1000000000.00 << " GB" << std::endl;
-            else
-            std::cout << "phases: " << phases << ": per process memory: " << perProcessMemory << " GB asquareMem: " << asquareMem/1000000.00 << " MB" << " inputMem: " << inputMem/1000000.00 << " MB" << " outputMem: " << outputMem/1000000.00 << " MB" << " kselectmem: " << kselectmem/1000000.00 << " MB" << std::endl;
-#endif
-            
-        }
-    }
+    std::vector<typename UDERB::LocalIT> phaseCuts;    // uneven phases planned from the exact symbolic pass, empty otherwise
+    if(plannedCuts != nullptr)
+        phaseCuts = *plannedCuts;
+    else if(perProcessMemory>0) // choose the phases permitted by memory
+        phaseCuts = PlanMemEfficientPhases<NUO>(A, B, selectNum, recoverNum, perProcessMemory*1000000000, pipelined);
+    if(!phaseCuts.empty())
+        phases = static_cast<int>(phaseCuts.size());
 
     //if(myrank == 0){
         //fprintf(stderr, "[MemEfficientSpGEMM] Running with phase: %d\n", phases);
@@ -550,7 +735,10 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
     std::vector< UDERB > PiecesOfB;
     UDERB CopyB = *(B.spSeq); // we allow alias matrices as input because of this local copy
     
-    CopyB.ColSplit(phases, PiecesOfB); // CopyB's memory is destroyed at this point
+    if(phaseCuts.empty())
+        CopyB.ColSplit(phases, PiecesOfB); // CopyB's memory is destroyed at this point
+    else
+        CopyB.ColSplit(phaseCuts, PiecesOfB);
     MPI_Barrier(GridC->GetWorld());
     
     LIA ** ARecvSizes = SpHelper::allocate2D<LIA>(UDERA::esscount, stages);
@@ -571,60 +759,155 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
     int Aself = (A.commGrid)->GetRankInProcRow();
     int Bself = (B.commGrid)->GetRankInProcCol();
 
+    // Pipelined mode: step s = p*stages+i uses slot s%2; the broadcasts of step s+1 are posted right before step s multiplies
+    std::vector<LIB **> BPhaseSizes;
+    UDERA * APrefetch[2];
+    UDERB * BPrefetch[2];
+    std::vector<MPI_Request> AIndReqs[2], ANumReqs[2], BIndReqs[2], BNumReqs[2];
+    if(pipelined)
+    {
+        for(int p = 0; p< phases; ++p)  // sizes of all pieces of B are needed ahead of time
+        {
+            BPhaseSizes.push_back(SpHelper::allocate2D<LIB>(UDERB::esscount, stages));
+            SpParHelper::GetSetSizes( PiecesOfB[p], BPhaseSizes[p], (B.commGrid)->GetColWorld());
+        }
+        Arr<LIA,NU1> Aarrinfo = A.seqptr()->GetArrays();
+        Arr<LIB,NU2> Barrinfo = PiecesOfB[0].GetArrays();
+        for(int slot = 0; slot < 2; ++slot)
+        {
+            AIndReqs[slot].resize(Aarrinfo.indarrs.size(), MPI_REQUEST_NULL);
+            ANumReqs[slot].resize(Aarrinfo.numarrs.size(), MPI_REQUEST_NULL);
+            BIndReqs[slot].resize(Barrinfo.indarrs.size(), MPI_REQUEST_NULL);
+            BNumReqs[slot].resize(Barrinfo.numarrs.size(), MPI_REQUEST_NULL);
+        }
+    }
+    auto PostStage = [&](int p, int i)
+    {
+        int slot = (p*stages+i) % 2;
+        std::vector<LIA> ess;
+        if(i == Aself)  APrefetch[slot] = A.spSeq;
+        else
+        {
+            ess.resize(UDERA::esscount);
+            for(int j=0; j< UDERA::esscount; ++j)
+                ess[j] = ARecvSizes[j][i];
+            APrefetch[slot] = new UDERA();
+        }
+        SpParHelper::IBCastMatrix(GridC->GetRowWorld(), *(APrefetch[slot]), ess, i, AIndReqs[slot], ANumReqs[slot]);
+        ess.clear();
+        if(i == Bself)  BPrefetch[slot] = &(PiecesOfB[p]);
+        else
+        {
+            ess.resize(UDERB::esscount);
+            for(int j=0; j< UDERB::esscount; ++j)
+                ess[j] = BPhaseSizes[p][j][i];
+            BPrefetch[slot] = new UDERB();
+        }
+        SpParHelper::IBCastMatrix(GridC->GetColWorld(), *(BPrefetch[slot]), ess, i, BIndReqs[slot], BNumReqs[slot]);
+    };
+    auto StageDone = [&](int slot)
+    {
+        int flags[4];
+        MPI_Testall(AIndReqs[slot].size(), AIndReqs[slot].data(), &flags[0], MPI_STATUSES_IGNORE);
+        MPI_Testall(ANumReqs[slot].size(), ANumReqs[slot].data(), &flags[1], MPI_STATUSES_IGNORE);
+        MPI_Testall(BIndReqs[slot].size(), BIndReqs[slot].data(), &flags[2], MPI_STATUSES_IGNORE);
+        MPI_Testall(BNumReqs[slot].size(), BNumReqs[slot].data(), &flags[3], MPI_STATUSES_IGNORE);
+        return flags[0] && flags[1] && flags[2] && flags[3];
+    };
+    auto WaitStage = [&](int slot, double & adone)  // adone: when the pieces of A had arrived
+    {
+        MPI_Waitall(AIndReqs[slot].size(), AIndReqs[slot].data(), MPI_STATUSES_IGNORE);
+        MPI_Waitall(ANumReqs[slot].size(), ANumReqs[slot].data(), MPI_STATUSES_IGNORE);
+        adone = MPI_Wtime();
+        MPI_Waitall(BIndReqs[slot].size(), BIndReqs[slot].data(), MPI_STATUSES_IGNORE);
+        MPI_Waitall(BNumReqs[slot].size(), BNumReqs[slot].data(), MPI_STATUSES_IGNORE);
+    };
+    double windowstart = 0;  // start of the computation that overlaps with the in-flight broadcasts
+    if(pipelined) PostStage(0, 0);
+
     for(int p = 0; p< phases; ++p)
     {
-        SpParHelper::GetSetSizes( PiecesOfB[p], BRecvSizes, (B.commGrid)->GetColWorld());
+        if(!pipelined) SpParHelper::GetSetSizes( PiecesOfB[p], BRecvSizes, (B.commGrid)->GetColWorld());
         std::vector< SpTuples<LIC,NUO>  *> tomerge;
+        ColumnSelectStats<NUO> colstats;    // statistics of the untruncated columns in fusedSelect mode
         for(int i = 0; i < stages; ++i)
         {
-            std::vector<LIA> ess;
-            if(i == Aself)  ARecv = A.spSeq;	// shallow-copy
-            else
+            if(pipelined)
             {
-                ess.resize(UDERA::esscount);
-                for(int j=0; j< UDERA::esscount; ++j)
-                    ess[j] = ARecvSizes[j][i];		// essentials of the ith matrix in this row
-                ARecv = new UDERA();				// first, create the object
+                int slot = (p*stages+i) % 2;
+                double tw0 = MPI_Wtime();
+                bool hidden = (p+i > 0) && StageDone(slot);
+                double twa;
+                WaitStage(slot, twa);
+                double tw1 = MPI_Wtime();
+                if(pipestats && p+i > 0)    // everything since the previous post overlapped with this stage's broadcasts
+                {
+                    pipestats->overlapwindow += (tw0 - windowstart);
+                    pipestats->exposedcomm += (tw1 - tw0);
+                    if(hidden) pipestats->hiddenstages++;
+                }
+#ifdef TIMING
+                mcl_Abcasttime += (twa-tw0);    // only the exposed part, the rest of the broadcasts overlapped with computation
+                mcl_Bbcasttime += (tw1-twa);
+#endif
+                if(pipestats) pipestats->stages++;
+                ARecv = APrefetch[slot];
+                BRecv = BPrefetch[slot];
+                if(i+1 < stages) PostStage(p, i+1);
+                else if(p+1 < phases) PostStage(p+1, 0);    // overlaps with the merge and prune of this phase as well
+                windowstart = MPI_Wtime();
             }
+            else
+            {
+                std::vector<LIA> ess;
+                if(i == Aself)  ARecv = A.spSeq;	// shallow-copy
+                else
+                {
+                    ess.resize(UDERA::esscount);
+                    for(int j=0; j< UDERA::esscount; ++j)
+                        ess[j] = ARecvSizes[j][i];		// essentials of the ith matrix in this row
+                    ARecv = new UDERA();				// first, create the object
+                }
             
 #ifdef TIMING
-            MPI_Barrier(A.getcommgrid()->GetWorld());
-            t0 = MPI_Wtime();
+                MPI_Barrier(A.getcommgrid()->GetWorld());
+                t0 = MPI_Wtime();
 #endif
-            SpParHelper::BCastMatrix(GridC->GetRowWorld(), *ARecv, ess, i);	// then, receive its elements
+                SpParHelper::BCastMatrix(GridC->GetRowWorld(), *ARecv, ess, i);	// then, receive its elements
 #ifdef TIMING
-            MPI_Barrier(A.getcommgrid()->GetWorld());
-            t1 = MPI_Wtime();
-            mcl_Abcasttime += (t1-t0);
+                MPI_Barrier(A.getcommgrid()->GetWorld());
+                t1 = MPI_Wtime();
+                mcl_Abcasttime += (t1-t0);
 #endif
-            ess.clear();
+                ess.clear();
 
-            if(i == Bself)  BRecv = &(PiecesOfB[p]);	// shallow-copy
-            else
-            {
-                ess.resize(UDERB::esscount);
-                for(int j=0; j< UDERB::esscount; ++j)
-                    ess[j] = BRecvSizes[j][i];
-                BRecv = new UDERB();
-            }
+                if(i == Bself)  BRecv = &(PiecesOfB[p]);	// shallow-copy
+                else
+                {
+                    ess.resize(UDERB::esscount);
+                    for(int j=0; j< UDERB::esscount; ++j)
+                        ess[j] = BRecvSizes[j][i];
+                    BRecv = new UDERB();
+                }
 #ifdef TIMING
-            MPI_Barrier(A.getcommgrid()->GetWorld());
-            double t2=MPI_Wtime();
+                MPI_Barrier(A.getcommgrid()->GetWorld());
+                double t2=MPI_Wtime();
 #endif
-            SpParHelper::BCastMatrix(GridC->GetColWorld(), *BRecv, ess, i);	// then, receive its elements
+                SpParHelper::BCastMatrix(GridC->GetColWorld(), *BRecv, ess, i);	// then, receive its elements
 #ifdef TIMING
-            MPI_Barrier(A.getcommgrid()->GetWorld());
-            double t3=MPI_Wtime();
-            mcl_Bbcasttime += (t3-t2);
+                MPI_Barrier(A.getcommgrid()->GetWorld());
+                double t3=MPI_Wtime();
+                mcl_Bbcasttime += (t3-t2);
 #endif
-            
+            }
             
 #ifdef TIMING
             MPI_Barrier(A.getcommgrid()->GetWorld());
             double t4=MPI_Wtime();
 #endif
             SpTuples<LIC,NUO> * C_cont;
-            if(computationKernel == 1) C_cont = LocalSpGEMMHash<SR, NUO>(*ARecv, *BRecv,i != Aself, i != Bself, false); // Hash SpGEMM without per-column sorting
+            if(fusedSelect && stages == 1) C_cont = LocalSpGEMMSelect<SR, NUO>(*ARecv, *BRecv, i != Aself, i != Bself, hardThreshold, selectNum, recoverNum, colstats);
+            else if(computationKernel == 1) C_cont = LocalSpGEMMHash<SR, NUO>(*ARecv, *BRecv,i != Aself, i != Bself, false); // Hash SpGEMM without per-column sorting
             else if(computationKernel == 2) C_cont=LocalSpGEMM<SR, NUO>(*ARecv, *BRecv,i != Aself, i != Bself);
 
 #ifdef TIMING
@@ -667,6 +950,8 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
         SpTuples<LIC,NUO> * OnePieceOfC_tuples;
         if(computationKernel == 1) OnePieceOfC_tuples = MultiwayMergeHash<SR>(tomerge, C_m, PiecesOfB[p].getncol(), true, false);
         else if(computationKernel == 2) OnePieceOfC_tuples = MultiwayMerge<SR>(tomerge, C_m, PiecesOfB[p].getncol(), true);
+        if(fusedSelect && stages > 1)
+            OnePieceOfC_tuples = SelectTuples(OnePieceOfC_tuples, hardThreshold, selectNum, recoverNum, colstats);
         
 #ifdef SHOW_MEMORY_USAGE
         int64_t gcnnz_merged, lcnnz_merged ;
@@ -695,7 +980,17 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
         delete OnePieceOfC_tuples;
         
         SpParMat<IU,NUO,UDERO> OnePieceOfC_mat(OnePieceOfC, GridC);
-        MCLPruneRecoverySelect(OnePieceOfC_mat, hardThreshold, selectNum, recoverNum, recoverPct, kselectVersion);
+        if(fusedSelect)
+        {
+            FullyDistVec<IU,NUO> nnzPerColumnUnpruned(GridC, OnePieceOfC_mat.getncol(), 0);
+            FullyDistVec<IU,NUO> nnzPerColumn(GridC, OnePieceOfC_mat.getncol(), 0);
+            FullyDistVec<IU,NUO> colSums(GridC, OnePieceOfC_mat.getncol(), 0);
+            OnePieceOfC_mat.ReduceLocalColumns(nnzPerColumnUnpruned, colstats.nnz, std::plus<NUO>());
+            OnePieceOfC_mat.ReduceLocalColumns(nnzPerColumn, colstats.nnzPruned, std::plus<NUO>());
+            OnePieceOfC_mat.ReduceLocalColumns(colSums, colstats.sumPruned, std::plus<NUO>());
+            MCLPruneRecoverySelect(OnePieceOfC_mat, hardThreshold, selectNum, recoverNum, recoverPct, kselectVersion, nnzPerColumnUnpruned, nnzPerColumn, colSums);
+        }
+        else MCLPruneRecoverySelect(OnePieceOfC_mat, hardThreshold, selectNum, recoverNum, recoverPct, kselectVersion);
 
 #ifdef SHOW_MEMORY_USAGE
         int64_t gcnnz_pruned, lcnnz_pruned ;
@@ -726,6 +1021,8 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
 
     SpHelper::deallocate2D(ARecvSizes, UDERA::esscount);
     SpHelper::deallocate2D(BRecvSizes, UDERA::esscount);
+    for(size_t p = 0; p < BPhaseSizes.size(); ++p)
+        SpHelper::deallocate2D(BPhaseSizes[p], UDERB::esscount);
     return SpParMat<IU,NUO,UDERO> (C, GridC);
 }
 
@@ -1320,7 +1617,12 @@ int64_t EstPerProcessNnzSUMMA(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB>
             //LIB * colnnzC = estimateNNZ(*ARecv, *BRecv);
 			LIB* flopC = estimateFLOP(*ARecv, *BRecv);
 			LIB* colnnzC = estimateNNZ_Hash(*ARecv, *BRecv, flopC);
-            LIB nzc = BRecv->GetDCSC()->nzc;
+            if(colnnzC)
+            {
+                LIB nzc = BRecv->GetDCSC()->nzc;
+                for(LIB k=0; k< nzc; ++k)
+                    nnzC_SUMMA += colnnzC[k];
+            }
 
             if (flopC) delete [] flopC;
             if(colnnzC) delete [] colnnzC;
@@ -1393,22 +1695,33 @@ void TransposeVector(MPI_Comm & World, const FullyDistSpVec<IU,NV> & x, int32_t
 	IU luntil = x.LengthUntil();
 	int diagneigh = x.commGrid->GetComplementRank();
 
-	MPI_Status status;
-	MPI_Sendrecv(&roffst, 1, MPIType<int32_t>(), diagneigh, TROST, &roffset, 1, MPIType<int32_t>(), diagneigh, TROST, World, &status);
-	MPI_Sendrecv(&xlocnz, 1, MPIType<int32_t>(), diagneigh, TRNNZ, &trxlocnz, 1, MPIType<int32_t>(), diagneigh, TRNNZ, World, &status);
-	MPI_Sendrecv(&luntil, 1, MPIType<IU>(), diagneigh, TRLUT, &lenuntil, 1, MPIType<IU>(), diagneigh, TRLUT, World, &status);
-	
 	// ABAB: Important observation is that local indices (given by x.ind) is 32-bit addressible
 	// Copy them to 32 bit integers and transfer that to save 50% of off-node bandwidth
-	trxinds = new int32_t[trxlocnz];
 	int32_t * temp_xind = new int32_t[xlocnz];
 #ifdef THREADED
 #pragma omp parallel for
 #endif
 	for(int i=0; i< xlocnz; ++i)
         temp_xind[i] = (int32_t) x.ind[i];
-	MPI_Sendrecv(temp_xind, xlocnz, MPIType<int32_t>(), diagneigh, TRI, trxinds, trxlocnz, MPIType<int32_t>(), diagneigh, TRI, World, &status);
+	// ... further compressed to a delta-varint list or a bitmap if the density makes it smaller (IndexListCodec.h)
+	uint8_t format;
+	int32_t sendsizes[2] = {xlocnz, IndexListEncodedWords(IndexListEncodedBytes(temp_xind, xlocnz, format))};
+	int32_t recvsizes[2];
+
+	MPI_Status status;
+	MPI_Sendrecv(&roffst, 1, MPIType<int32_t>(), diagneigh, TROST, &roffset, 1, MPIType<int32_t>(), diagneigh, TROST, World, &status);
+	MPI_Sendrecv(sendsizes, 2, MPIType<int32_t>(), diagneigh, TRNNZ, recvsizes, 2, MPIType<int32_t>(), diagneigh, TRNNZ, World, &status);
+	MPI_Sendrecv(&luntil, 1, MPIType<IU>(), diagneigh, TRLUT, &lenuntil, 1, MPIType<IU>(), diagneigh, TRLUT, World, &status);
+	trxlocnz = recvsizes[0];
+
+	int32_t * sendwords = new int32_t[sendsizes[1]];
+	int32_t * recvwords = new int32_t[recvsizes[1]];
+	EncodeIndexListWords(temp_xind, xlocnz, format, sendsizes[1], sendwords);
 	delete [] temp_xind;
+	MPI_Sendrecv(sendwords, sendsizes[1], MPIType<int32_t>(), diagneigh, TRI, recvwords, recvsizes[1], MPIType<int32_t>(), diagneigh, TRI, World, &status);
+	trxinds = new int32_t[trxlocnz];
+	DecodeIndexListWords(recvwords, recvsizes[1], trxlocnz, trxinds);
+	DeleteAll(sendwords, recvwords);
 	if(!indexisvalue)
 	{
 		trxnums = new NV[trxlocnz];
@@ -1433,12 +1746,26 @@ void AllGatherVector(MPI_Comm & ColWorld, int trxlocnz, IU lenuntil, int32_t * &
     int colneighs, colrank;
 	MPI_Comm_size(ColWorld, &colneighs);
 	MPI_Comm_rank(ColWorld, &colrank);
+	// every process encodes its index list independently (IndexListCodec.h), nnz and encoded words are gathered together
+	uint8_t format;
+	int * colsizes = new int[2*colneighs];
+	colsizes[2*colrank] = trxlocnz;
+	colsizes[2*colrank+1] = IndexListEncodedWords(IndexListEncodedBytes(trxinds, trxlocnz, format));
+	MPI_Allgather(MPI_IN_PLACE, 2, MPI_INT, colsizes, 2, MPI_INT, ColWorld);
 	int * colnz = new int[colneighs];
-	colnz[colrank] = trxlocnz;
-	MPI_Allgather(MPI_IN_PLACE, 1, MPI_INT, colnz, 1, MPI_INT, ColWorld);
+	int * colwords = new int[colneighs];
+	for(int i=0; i< colneighs; ++i)
+	{
+		colnz[i] = colsizes[2*i];
+		colwords[i] = colsizes[2*i+1];
+	}
+	delete [] colsizes;
 	int * dpls = new int[colneighs]();	// displacements (zero initialized pid) 
+	int * worddpls = new int[colneighs]();
 	std::partial_sum(colnz, colnz+colneighs-1, dpls+1);
+	std::partial_sum(colwords, colwords+colneighs-1, worddpls+1);
 	accnz = std::accumulate(colnz, colnz+colneighs, 0);
+	int accwords = std::accumulate(colwords, colwords+colneighs, 0);
 	indacc = new int32_t[accnz];
 	numacc = new NV[accnz];
 	
@@ -1452,9 +1779,18 @@ void AllGatherVector(MPI_Comm & ColWorld, int trxlocnz, IU lenuntil, int32_t * &
 #ifdef TIMING
 	double t0=MPI_Wtime();
 #endif
-	MPI_Allgatherv(trxinds, trxlocnz, MPIType<int32_t>(), indacc, colnz, dpls, MPIType<int32_t>(), ColWorld);
-	
+	int32_t * sendwords = new int32_t[colwords[colrank]];
+	int32_t * recvwords = new int32_t[accwords];
+	EncodeIndexListWords(trxinds, trxlocnz, format, colwords[colrank], sendwords);
 	delete [] trxinds;
+	MPI_Allgatherv(sendwords, colwords[colrank], MPIType<int32_t>(), recvwords, colwords, worddpls, MPIType<int32_t>(), ColWorld);
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+	for(int i=0; i< colneighs; ++i)
+		DecodeIndexListWords(recvwords + worddpls[i], colwords[i], colnz[i], indacc + dpls[i]);
+	DeleteAll(sendwords, recvwords, colwords, worddpls);
+	
 	if(indexisvalue)
 	{
 		IU lenuntilcol;
@@ -1553,6 +1889,8 @@ void LocalSpMV(const SpParMat<IU,NUM,UDER> & A, int rowneighs, OptBuf<int32_t, O
 
 
 // non threaded
+// The sparse SpMV contributions arrive through MPI_Alltoallv as sorted index lists of different lengths and supports,
+// which no MPI reduction can combine, so they are merged here with SR::add instead of an SRingMPIOp
 template <typename SR, typename IU, typename OVT>
 void MergeContributions(int*  listSizes, std::vector<int32_t *> & indsvec, std::vector<OVT *> & numsvec, std::vector<IU>& mergedind, std::vector<OVT>& mergednum)
 {
@@ -1814,34 +2152,74 @@ void SpMV (const SpParMat<IU,NUM,UDER> & A, const FullyDistSpVec<IU,IVT> & x, Fu
     }
 	int * rdispls = new int[rowneighs];
 	int * recvcnt = new int[rowneighs];
-	MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, RowWorld);       // share the request counts
+
+	// the index list to every neighbor is encoded independently (IndexListCodec.h)
+	int32_t * sendinds = (optbuf.totmax > 0)? optbuf.inds : sendindbuf;
+	int * senddispls = (optbuf.totmax > 0)? optbuf.dspls : sdispls;
+	std::vector<uint8_t> formats(rowneighs);
+	int * sendsizes = new int[2*rowneighs];
+	int * recvsizes = new int[2*rowneighs];
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+	for(int i=0; i<rowneighs; ++i)
+	{
+		sendsizes[2*i] = sendcnt[i];
+		sendsizes[2*i+1] = IndexListEncodedWords(IndexListEncodedBytes(sendinds + senddispls[i], sendcnt[i], formats[i]));
+	}
+	MPI_Alltoall(sendsizes, 2, MPI_INT, recvsizes, 2, MPI_INT, RowWorld);       // share the request counts and encoded sizes
 	
 	// receive displacements are exact whereas send displacements have slack
+	int * sendwordcnt = new int[rowneighs];
+	int * recvwordcnt = new int[rowneighs];
+	int * swordispls = new int[rowneighs]();
+	int * rwordispls = new int[rowneighs]();
+	for(int i=0; i<rowneighs; ++i)
+	{
+		recvcnt[i] = recvsizes[2*i];
+		sendwordcnt[i] = sendsizes[2*i+1];
+		recvwordcnt[i] = recvsizes[2*i+1];
+	}
+	DeleteAll(sendsizes, recvsizes);
 	rdispls[0] = 0;
 	for(int i=0; i<rowneighs-1; ++i)
 	{
 		rdispls[i+1] = rdispls[i] + recvcnt[i];
+		swordispls[i+1] = swordispls[i] + sendwordcnt[i];
+		rwordispls[i+1] = rwordispls[i] + recvwordcnt[i];
 	}
 	
 	int totrecv = std::accumulate(recvcnt,recvcnt+rowneighs,0);	
 	int32_t * recvindbuf = new int32_t[totrecv];
 	OVT * recvnumbuf = new OVT[totrecv];
+	int32_t * sendwords = new int32_t[swordispls[rowneighs-1] + sendwordcnt[rowneighs-1]];
+	int32_t * recvwords = new int32_t[rwordispls[rowneighs-1] + recvwordcnt[rowneighs-1]];
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+	for(int i=0; i<rowneighs; ++i)
+		EncodeIndexListWords(sendinds + senddispls[i], sendcnt[i], formats[i], sendwordcnt[i], sendwords + swordispls[i]);
 	
 #ifdef TIMING
 	double t4=MPI_Wtime();
 #endif
+	MPI_Alltoallv(sendwords, sendwordcnt, swordispls, MPIType<int32_t>(), recvwords, recvwordcnt, rwordispls, MPIType<int32_t>(), RowWorld);
 	if(optbuf.totmax > 0 )	// graph500 optimization enabled
 	{
-		MPI_Alltoallv(optbuf.inds, sendcnt, optbuf.dspls, MPIType<int32_t>(), recvindbuf, recvcnt, rdispls, MPIType<int32_t>(), RowWorld);
 		MPI_Alltoallv(optbuf.nums, sendcnt, optbuf.dspls, MPIType<OVT>(), recvnumbuf, recvcnt, rdispls, MPIType<OVT>(), RowWorld);
 		delete [] sendcnt;
 	}
 	else
     {
-		MPI_Alltoallv(sendindbuf, sendcnt, sdispls, MPIType<int32_t>(), recvindbuf, recvcnt, rdispls, MPIType<int32_t>(), RowWorld);
 		MPI_Alltoallv(sendnumbuf, sendcnt, sdispls, MPIType<OVT>(), recvnumbuf, recvcnt, rdispls, MPIType<OVT>(), RowWorld);
 		DeleteAll(sendindbuf, sendnumbuf, sendcnt, sdispls);
 	}
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+	for(int i=0; i<rowneighs; ++i)
+		DecodeIndexListWords(recvwords + rwordispls[i], recvwordcnt[i], recvcnt[i], recvindbuf + rdispls[i]);
+	DeleteAll(sendwords, recvwords, sendwordcnt, recvwordcnt, swordispls, rwordispls);
 #ifdef TIMING
 	double t5=MPI_Wtime();
 	cblas_alltoalltime += (t5-t4);
@@ -1904,6 +2282,232 @@ void SpMV (const SpParMat<IU,NUM,UDER> & A, const FullyDistSpVec<IU,IVT> & x, Fu
 }
 
 
+/**
+ * Sparse matrix X multiple sparse vectors (multi-source BFS, personalized PageRank, ...)
+ * Performs the same three steps as SpMV (transpose, allgather along the processor column, fold along the processor row)
+ * but each step is a single exchange for all k vectors, so an iteration pays the latency once instead of k times
+ * The local multiplications share the SPA, and all communication buffers live in batchbuf which is meant to be reused across iterations
+ * Input (x[j]) and output (y[j]) vectors can be ALIASED; y is resized to k vectors if needed
+ * indexisvalue (the BFS shortcut of SpMV) is not supported: values are always transferred
+ **/
+template <typename SR, typename IVT, typename OVT, typename IU, typename NUM, typename UDER>
+void SpMSpVBatch (const SpParMat<IU,NUM,UDER> & A, const std::vector< FullyDistSpVec<IU,IVT> > & x, std::vector< FullyDistSpVec<IU,OVT> > & y,
+			SpMSpVBatchBuf<IVT,OVT> & batchbuf, PreAllocatedSPA<OVT> & SPA)
+{
+	int k = static_cast<int>(x.size());
+	for(int j=0; j<k; ++j)
+		CheckSpMVCompliance(A, x[j]);
+	if(y.size() != x.size())
+		y.resize(k, FullyDistSpVec<IU,OVT>(A.getcommgrid(), A.getnrow()));
+	if(k == 0) return;
+
+	SpMSpVBatchBuf<IVT,OVT> & bb = batchbuf;
+	std::shared_ptr<CommGrid> grid = A.getcommgrid();
+	MPI_Comm World = grid->GetWorld();
+	MPI_Comm ColWorld = grid->GetColWorld();
+	MPI_Comm RowWorld = grid->GetRowWorld();
+	int colneighs, rowneighs;
+	MPI_Comm_size(ColWorld, &colneighs);
+	MPI_Comm_size(RowWorld, &rowneighs);
+
+	// Step 1: pack the local pieces of all vectors (as 32-bit local indices) and exchange them with the diagonal neighbor
+	bb.xcnts.resize(k);
+	bb.trcnts.resize(k);
+	std::vector<int> xdspls(k+1, 0);
+	for(int j=0; j<k; ++j)
+	{
+		bb.xcnts[j] = static_cast<int>(x[j].getlocnnz());
+		xdspls[j+1] = xdspls[j] + bb.xcnts[j];
+	}
+	bb.xinds.resize(xdspls[k]);
+	bb.xnums.resize(xdspls[k]);
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+	for(int j=0; j<k; ++j)
+	{
+		for(int i=0; i< bb.xcnts[j]; ++i)
+			bb.xinds[xdspls[j]+i] = static_cast<int32_t>(x[j].ind[i]);
+		std::copy(x[j].num.begin(), x[j].num.end(), bb.xnums.begin() + xdspls[j]);
+	}
+
+	int32_t roffst = static_cast<int32_t>(x[0].RowLenUntil());	// same for all vectors as they have the same length
+	int32_t roffset;
+	int diagneigh = grid->GetComplementRank();
+	MPI_Status status;
+	MPI_Sendrecv(&roffst, 1, MPIType<int32_t>(), diagneigh, TROST, &roffset, 1, MPIType<int32_t>(), diagneigh, TROST, World, &status);
+	MPI_Sendrecv(bb.xcnts.data(), k, MPI_INT, diagneigh, TRNNZ, bb.trcnts.data(), k, MPI_INT, diagneigh, TRNNZ, World, &status);
+	int trtotal = std::accumulate(bb.trcnts.begin(), bb.trcnts.end(), 0);
+	bb.trinds.resize(trtotal);
+	bb.trnums.resize(trtotal);
+	MPI_Sendrecv(bb.xinds.data(), xdspls[k], MPIType<int32_t>(), diagneigh, TRI, bb.trinds.data(), trtotal, MPIType<int32_t>(), diagneigh, TRI, World, &status);
+	MPI_Sendrecv(bb.xnums.data(), xdspls[k], MPIType<IVT>(), diagneigh, TRX, bb.trnums.data(), trtotal, MPIType<IVT>(), diagneigh, TRX, World, &status);
+	std::transform(bb.trinds.begin(), bb.trinds.end(), bb.trinds.begin(), std::bind2nd(std::plus<int32_t>(), roffset)); // fullydist indexing (p pieces) -> matrix indexing (sqrt(p) pieces)
+
+	// Step 2: allgather along the processor column, the per-vector counts of every neighbor go first
+	bb.colcnts.resize(colneighs*k);	// colcnts[i*k+j]: entries of x[j] coming from column neighbor i
+	MPI_Allgather(bb.trcnts.data(), k, MPI_INT, bb.colcnts.data(), k, MPI_INT, ColWorld);
+	std::vector<int> colnz(colneighs, 0);
+	std::vector<int> coldpls(colneighs, 0);
+	std::vector<int> coloffs(colneighs*k+1, 0);	// start of each (neighbor, vector) piece in the gathered buffer
+	for(int i=0; i<colneighs; ++i)
+		colnz[i] = std::accumulate(bb.colcnts.begin() + i*k, bb.colcnts.begin() + (i+1)*k, 0);
+	std::partial_sum(colnz.begin(), colnz.end()-1, coldpls.begin()+1);
+	std::partial_sum(bb.colcnts.begin(), bb.colcnts.end(), coloffs.begin()+1);
+	int acctotal = coloffs[colneighs*k];
+	bb.colinds.resize(acctotal);
+	bb.colnums.resize(acctotal);
+	MPI_Allgatherv(bb.trinds.data(), trtotal, MPIType<int32_t>(), bb.colinds.data(), colnz.data(), coldpls.data(), MPIType<int32_t>(), ColWorld);
+	MPI_Allgatherv(bb.trnums.data(), trtotal, MPIType<IVT>(), bb.colnums.data(), colnz.data(), coldpls.data(), MPIType<IVT>(), ColWorld);
+
+	// regroup by vector: pieces of x[j] from consecutive neighbors cover consecutive column ranges, so they stay sorted
+	bb.acccnts.assign(k, 0);
+	for(int i=0; i<colneighs; ++i)
+		for(int j=0; j<k; ++j)
+			bb.acccnts[j] += bb.colcnts[i*k+j];
+	std::vector<int> accdpls(k+1, 0);
+	std::partial_sum(bb.acccnts.begin(), bb.acccnts.end(), accdpls.begin()+1);
+	bb.accinds.resize(acctotal);
+	bb.accnums.resize(acctotal);
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+	for(int j=0; j<k; ++j)
+	{
+		int dest = accdpls[j];
+		for(int i=0; i<colneighs; ++i)
+		{
+			int src = coloffs[i*k+j];
+			int cnt = bb.colcnts[i*k+j];
+			std::copy(bb.colinds.begin() + src, bb.colinds.begin() + src + cnt, bb.accinds.begin() + dest);
+			std::copy(bb.colnums.begin() + src, bb.colnums.begin() + src + cnt, bb.accnums.begin() + dest);
+			dest += cnt;
+		}
+	}
+
+	// Step 3: local multiplications with the shared SPA, outputs are bucketed by recipient (ycnts[j*rowneighs+i])
+	int32_t nlocrows = static_cast<int32_t>(A.getlocalrows());
+	int32_t perproc = nlocrows / rowneighs;
+	bb.ycnts.assign(k*rowneighs, 0);
+	bb.yinds.clear();
+	bb.ynums.clear();
+	for(int j=0; j<k; ++j)
+	{
+		const int32_t * indx = bb.accinds.data() + accdpls[j];
+		const IVT * numx = bb.accnums.data() + accdpls[j];
+		int * ycnts = bb.ycnts.data() + j*rowneighs;
+		if(A.seqptr()->getnsplit() > 0)
+		{
+			int32_t * sendindbuf;
+			OVT * sendnumbuf;
+			int * sdispls;
+			int totalsent = generic_gespmv_threaded<SR>(*(A.seqptr()), indx, numx, bb.acccnts[j], sendindbuf, sendnumbuf, sdispls, rowneighs, SPA);
+			for(int i=0; i<rowneighs-1; ++i)
+				ycnts[i] = sdispls[i+1] - sdispls[i];
+			ycnts[rowneighs-1] = totalsent - sdispls[rowneighs-1];
+			bb.yinds.insert(bb.yinds.end(), sendindbuf, sendindbuf + totalsent);
+			bb.ynums.insert(bb.ynums.end(), sendnumbuf, sendnumbuf + totalsent);
+			DeleteAll(sendindbuf, sendnumbuf, sdispls);
+		}
+		else
+		{
+			bb.indy.clear();
+			bb.numy.clear();
+			generic_gespmv<SR>(*(A.seqptr()), indx, numx, static_cast<int32_t>(bb.acccnts[j]), bb.indy, bb.numy, SPA);
+			int32_t bufsize = static_cast<int32_t>(bb.indy.size());
+			int32_t cur = 0;
+			for(int i=0; i<rowneighs; ++i)
+			{
+				int32_t end_this = (i==rowneighs-1) ? nlocrows: (i+1)*perproc;
+				while(cur < bufsize && bb.indy[cur] < end_this)
+				{
+					bb.yinds.push_back(bb.indy[cur] - i*perproc);	// convert to receiver's local index
+					bb.ynums.push_back(bb.numy[cur]);
+					++ycnts[i];
+					++cur;
+				}
+			}
+		}
+	}
+
+	// Step 4: fold along the processor row, one all-to-all of counts and one for each of indices and values
+	std::vector<int> yoffs(k*rowneighs+1, 0);
+	std::partial_sum(bb.ycnts.begin(), bb.ycnts.end(), yoffs.begin()+1);
+	bb.sendcnts.resize(rowneighs*k);	// sendcnts[i*k+j]: entries of y[j] going to row neighbor i
+	for(int i=0; i<rowneighs; ++i)
+		for(int j=0; j<k; ++j)
+			bb.sendcnts[i*k+j] = bb.ycnts[j*rowneighs+i];
+	std::vector<int> sendoffs(rowneighs*k+1, 0);
+	std::partial_sum(bb.sendcnts.begin(), bb.sendcnts.end(), sendoffs.begin()+1);
+	int sendtotal = sendoffs[rowneighs*k];
+	bb.sendinds.resize(sendtotal);
+	bb.sendnums.resize(sendtotal);
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+	for(int i=0; i<rowneighs; ++i)
+	{
+		for(int j=0; j<k; ++j)
+		{
+			int src = yoffs[j*rowneighs+i];
+			int cnt = bb.ycnts[j*rowneighs+i];
+			std::copy(bb.yinds.begin() + src, bb.yinds.begin() + src + cnt, bb.sendinds.begin() + sendoffs[i*k+j]);
+			std::copy(bb.ynums.begin() + src, bb.ynums.begin() + src + cnt, bb.sendnums.begin() + sendoffs[i*k+j]);
+		}
+	}
+
+	bb.recvcnts.resize(rowneighs*k);
+	MPI_Alltoall(bb.sendcnts.data(), k, MPI_INT, bb.recvcnts.data(), k, MPI_INT, RowWorld);
+	std::vector<int> sendnz(rowneighs), recvnz(rowneighs), sdispls(rowneighs), rdispls(rowneighs);
+	for(int i=0; i<rowneighs; ++i)
+	{
+		sendnz[i] = sendoffs[(i+1)*k] - sendoffs[i*k];
+		sdispls[i] = sendoffs[i*k];
+	}
+	std::vector<int> recvoffs(rowneighs*k+1, 0);
+	std::partial_sum(bb.recvcnts.begin(), bb.recvcnts.end(), recvoffs.begin()+1);
+	for(int i=0; i<rowneighs; ++i)
+	{
+		recvnz[i] = recvoffs[(i+1)*k] - recvoffs[i*k];
+		rdispls[i] = recvoffs[i*k];
+	}
+	int recvtotal = recvoffs[rowneighs*k];
+	bb.recvinds.resize(recvtotal);
+	bb.recvnums.resize(recvtotal);
+	MPI_Alltoallv(bb.sendinds.data(), sendnz.data(), sdispls.data(), MPIType<int32_t>(), bb.recvinds.data(), recvnz.data(), rdispls.data(), MPIType<int32_t>(), RowWorld);
+	MPI_Alltoallv(bb.sendnums.data(), sendnz.data(), sdispls.data(), MPIType<OVT>(), bb.recvnums.data(), recvnz.data(), rdispls.data(), MPIType<OVT>(), RowWorld);
+
+	// Step 5: merge the contributions of the row neighbors, vectors are independent of each other
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for(int j=0; j<k; ++j)
+	{
+		std::vector<int> listSizes(rowneighs);
+		std::vector<int32_t *> indsvec(rowneighs);
+		std::vector<OVT *> numsvec(rowneighs);
+		for(int i=0; i<rowneighs; ++i)
+		{
+			listSizes[i] = bb.recvcnts[i*k+j];
+			indsvec[i] = bb.recvinds.data() + recvoffs[i*k+j];
+			numsvec[i] = bb.recvnums.data() + recvoffs[i*k+j];
+		}
+		// free memory of y[j], in case it was aliased
+		std::vector<IU>().swap(y[j].ind);
+		std::vector<OVT>().swap(y[j].num);
+		y[j].glen = A.getnrow();
+		MergeContributions<SR>(listSizes.data(), indsvec, numsvec, y[j].ind, y[j].num);
+	}
+}
+
+template <typename SR, typename IVT, typename OVT, typename IU, typename NUM, typename UDER>
+void SpMSpVBatch (const SpParMat<IU,NUM,UDER> & A, const std::vector< FullyDistSpVec<IU,IVT> > & x, std::vector< FullyDistSpVec<IU,OVT> > & y)
+{
+	SpMSpVBatchBuf<IVT,OVT> batchbuf;
+	PreAllocatedSPA<OVT> SPA;
+	SpMSpVBatch<SR>(A, x, y, batchbuf, SPA);
+}
+
 /**
  * Automatic type promotion is ONLY done here, all the callee functions (in Friends.h and below) are initialized with the promoted type
  * If indexisvalues = true, then we do not need to transfer values for x (happens for BFS iterations with boolean matrices and integer rhs vectors)
@@ -1977,21 +2581,15 @@ FullyDistVec<IU,typename promote_trait<NUM,NUV>::T_promote>  SpMV
 	int rowneighs;
 	MPI_Comm_size(RowWorld, &rowneighs);
 
-	IU begptr, endptr;
+	int * recvcounts = new int[rowneighs];	// a single reduce-scatter along the processor row
 	for(int i=0; i< rowneighs; ++i)
 	{
-		begptr = y.RowLenUntil(i);
-		if(i == rowneighs-1)
-		{
-			endptr = ysize;
-		}
-		else
-		{
-			endptr = y.RowLenUntil(i+1);
-		}
-		MPI_Reduce(localy+begptr, SpHelper::p2a(y.arr), endptr-begptr, MPIType<T_promote>(), SR::mpi_op(), i, RowWorld);
+		IU begptr = y.RowLenUntil(i);
+		IU endptr = (i == rowneighs-1)? ysize : y.RowLenUntil(i+1);
+		recvcounts[i] = static_cast<int>(endptr-begptr);
 	}
-	delete [] localy;
+	MPI_Reduce_scatter(localy, SpHelper::p2a(y.arr), recvcounts, MPIType<T_promote>(), SRingMPIOp<SR,T_promote>::op(), RowWorld);
+	DeleteAll(localy, recvcounts);
 	return y;
 }
 
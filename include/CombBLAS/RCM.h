@@ -0,0 +1,541 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _RCM_H_
+#define _RCM_H_
+
+#include <limits>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include "SpParMat.h"
+#include "FullyDistVec.h"
+#include "FullyDistSpVec.h"
+#include "PreAllocatedSPA.h"
+#include "FastSV.h"
+
+namespace combblas {
+
+struct RCMParams
+{
+	RCMParams(): reverse(true) {}
+	bool reverse;	// false returns the Cuthill-McKee ordering
+};
+
+//! Statistics of a single RCM run
+struct RCMStats
+{
+	int64_t components;
+	int ppvrounds;		// rounds of the pseudo-peripheral vertex search (BFS from every unfinished component)
+	int ppvlevels;		// SpMSpVs of the pseudo-peripheral vertex search
+	int levels;		// SpMSpVs of the ordering, i.e. the largest number of levels of a component
+	double tcc, tppv, torder;	// seconds
+};
+
+/**
+ * Reverse Cuthill-McKee ordering of an undirected graph, every connected component is processed at the same time
+ * The components are labeled with FastSV and each of them gets a contiguous range of the ordering (in label order)
+ * All components search for their pseudo-peripheral vertex together: every round is one multi-source BFS from the current
+ * sources of the unfinished components. Components are vertex disjoint, so the fringes of all of them form a single sparse
+ * vector and each BFS level is one SpMSpV no matter how many components are active.
+ * The ordering is level synchronous as well. A newly reached vertex takes the smallest order of its parents (SpMSpV with the
+ * select-min semiring) and is sent to the owner of that order. The owner buckets the children by parent, sorts each bucket by
+ * (degree, index), and a segmented scan over the orders of the current level gives every child its order; the level of
+ * component c starts right after the previous level of c. No global sort is needed.
+ * Within each component the result is the same as ordering the components one at a time (sorting every level by
+ * (parent order, degree, index))
+ * A should be symmetric; the values and the diagonal of A are ignored
+ **/
+template <typename IT, typename NT, typename DER>
+class RCM
+{
+public:
+	typedef SpParMat < IT, bool, SpDCCols<IT,bool> > PSpMat_Bool;
+	typedef SpParMat < IT, bool, SpCCols<IT,bool> > PSpMat_CSC_Bool;
+
+	/**
+	 * The components and the degrees are computed here, once; the SpMSpVs run on a CSC copy of A with a pre-allocated SPA,
+	 * as the component-by-component application did
+	 **/
+	RCM(const SpParMat<IT,NT,DER> & A, const RCMParams & myparams = RCMParams()):
+		params(myparams), cclabel(A.getcommgrid()), degrees(A.getcommgrid())
+	{
+		double t1 = MPI_Wtime();
+		PSpMat_Bool Abool = static_cast<PSpMat_Bool>(A);
+		Abool.RemoveLoops();
+		{
+			FastSV<IT,bool,SpDCCols<IT,bool> > cc(Abool);
+			nCC = cc.Run(cclabel, NULL);
+		}
+		Abool.Reduce(degrees, Column, std::plus<IT>(), static_cast<IT>(0));
+		Acsc = PSpMat_CSC_Bool(Abool);
+		tcc = MPI_Wtime() - t1;
+
+		int nthreads = 1;
+	#ifdef THREADED
+	#pragma omp parallel
+		{
+			nthreads = omp_get_num_threads();
+		}
+	#endif
+		SPA = PreAllocatedSPA<IT>(Acsc.seq(), nthreads*4);
+	}
+
+	RCMParams & GetParams() { return params; }
+	void SetParams(const RCMParams & myparams) { params = myparams; }
+
+	/**
+	 * @param[out] order position of every vertex in the ordering (0,...,n-1)
+	 * @param[out] stats if not NULL, filled with the statistics of the run (tcc is the time of the constructor)
+	 **/
+	void Run(FullyDistVec<IT,IT> & order, RCMStats * stats = NULL)
+	{
+		std::shared_ptr<CommGrid> commGrid = Acsc.getcommgrid();
+		MPI_Comm World = commGrid->GetWorld();
+		int nprocs = commGrid->GetSize();
+		IT n = Acsc.getnrow();
+		RCMStats mystats;
+		mystats.ppvrounds = mystats.ppvlevels = mystats.levels = 0;
+		mystats.components = static_cast<int64_t>(nCC);
+		mystats.tcc = tcc;
+
+		order = FullyDistVec<IT,IT>(commGrid, n, static_cast<IT>(-1));	// also the layout of the vertices and of the orders
+		FullyDistVec<IT,IT> cclayout(commGrid, nCC, static_cast<IT>(0));
+		IT mylen = order.LocArrSize();
+		IT myoffset = order.LengthUntil();
+		IT myncc = cclayout.LocArrSize();
+		const IT * label = cclabel.GetLocArr();
+		const IT * deg = degrees.GetLocArr();
+
+		// sizes of the components and their min-degree vertices
+		std::vector<IT> ccsize(myncc, 0), ccstart(myncc, 0), src(myncc, -1), srcdeg(myncc, std::numeric_limits<IT>::max());
+		{
+			std::unordered_map<IT, std::tuple<IT,IT,IT> > local;	// label -> (size, degree, vertex)
+			for(IT i=0; i< mylen; ++i)
+			{
+				auto it = local.find(label[i]);
+				if(it == local.end())
+					local[label[i]] = std::make_tuple(1, deg[i], myoffset+i);
+				else
+				{
+					std::get<0>(it->second)++;
+					if(std::make_pair(deg[i], myoffset+i) < std::make_pair(std::get<1>(it->second), std::get<2>(it->second)))
+					{
+						std::get<1>(it->second) = deg[i];
+						std::get<2>(it->second) = myoffset+i;
+					}
+				}
+			}
+			std::vector< std::vector<IT> > sendbuf(nprocs);
+			for(auto it = local.begin(); it != local.end(); ++it)
+			{
+				IT lc;
+				int owner = cclayout.Owner(it->first, lc);
+				sendbuf[owner].insert(sendbuf[owner].end(), {lc, std::get<0>(it->second), std::get<1>(it->second), std::get<2>(it->second)});
+			}
+			std::vector<IT> recvbuf = Exchange(sendbuf, World);
+			for(size_t k=0; k< recvbuf.size(); k += 4)
+			{
+				IT lc = recvbuf[k];
+				ccsize[lc] += recvbuf[k+1];
+				if(std::make_pair(recvbuf[k+2], recvbuf[k+3]) < std::make_pair(srcdeg[lc], src[lc]))
+				{
+					srcdeg[lc] = recvbuf[k+2];
+					src[lc] = recvbuf[k+3];
+				}
+			}
+		}
+		// components take contiguous ranges of the ordering in label order
+		IT mytotal = std::accumulate(ccsize.begin(), ccsize.end(), static_cast<IT>(0));
+		IT sizebefore = 0;
+		MPI_Exscan(&mytotal, &sizebefore, 1, MPIType<IT>(), MPI_SUM, World);
+		if(commGrid->GetRank() == 0) sizebefore = 0;	// MPI_Exscan leaves it undefined on the first process
+		for(IT c=0; c< myncc; ++c)
+		{
+			ccstart[c] = sizebefore;
+			sizebefore += ccsize[c];
+		}
+
+		double t1 = MPI_Wtime();
+		PseudoPeripheral(cclayout, label, deg, src, mystats);
+		mystats.tppv = MPI_Wtime() - t1;
+
+		t1 = MPI_Wtime();
+		std::vector<IT> ord(mylen, -1);
+		CuthillMcKee(cclayout, deg, src, ccstart, ord, mystats);
+		for(IT i=0; i< mylen; ++i)
+			order.SetLocalElement(i, params.reverse? (n-1-ord[i]) : ord[i]);
+		mystats.torder = MPI_Wtime() - t1;
+
+		if(stats != NULL) *stats = mystats;
+	}
+
+private:
+	//! Select-min semiring on the orders of the parents
+	struct SelectMinSR
+	{
+		typedef IT T_promote;
+		static T_promote id(){ return std::numeric_limits<IT>::max(); }
+		static bool returnedSAID() { return false; }
+		static T_promote add(const T_promote & arg1, const T_promote & arg2) { return std::min(arg1, arg2); }
+		static T_promote multiply(const bool & arg1, const T_promote & arg2) { return arg2; }
+		static void axpy(bool a, const T_promote & x, T_promote & y) { y = std::min(y, x); }
+	};
+
+	//! Records of sendbuf[p] go to process p, all of them are concatenated in the returned vector
+	static std::vector<IT> Exchange(std::vector< std::vector<IT> > & sendbuf, MPI_Comm World)
+	{
+		int nprocs = static_cast<int>(sendbuf.size());
+		std::vector<int> sendcnt(nprocs), recvcnt(nprocs), sdispls(nprocs+1, 0), rdispls(nprocs+1, 0);
+		for(int p=0; p< nprocs; ++p)
+			sendcnt[p] = static_cast<int>(sendbuf[p].size());
+		MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);
+		std::partial_sum(sendcnt.begin(), sendcnt.end(), sdispls.begin()+1);
+		std::partial_sum(recvcnt.begin(), recvcnt.end(), rdispls.begin()+1);
+
+		std::vector<IT> senddata(sdispls[nprocs]), recvdata(rdispls[nprocs]);
+		for(int p=0; p< nprocs; ++p)
+		{
+			std::copy(sendbuf[p].begin(), sendbuf[p].end(), senddata.begin() + sdispls[p]);
+			std::vector<IT>().swap(sendbuf[p]);
+		}
+		MPI_Alltoallv(senddata.data(), sendcnt.data(), sdispls.data(), MPIType<IT>(), recvdata.data(), recvcnt.data(), rdispls.data(), MPIType<IT>(), World);
+		return recvdata;
+	}
+
+	/**
+	 * Every round is a BFS from the sources of all unfinished components; a component whose BFS got deeper moves its source
+	 * to the min-degree vertex of the last level, otherwise its source is pseudo-peripheral and it is finished
+	 **/
+	void PseudoPeripheral(const FullyDistVec<IT,IT> & cclayout, const IT * label, const IT * deg, std::vector<IT> & src, RCMStats & stats)
+	{
+		std::shared_ptr<CommGrid> commGrid = Acsc.getcommgrid();
+		MPI_Comm World = commGrid->GetWorld();
+		int nprocs = commGrid->GetSize();
+		IT n = Acsc.getnrow();
+		FullyDistVec<IT,IT> level(commGrid, n, static_cast<IT>(-1));
+		IT mylen = level.LocArrSize();
+		IT myoffset = level.LengthUntil();
+		IT myncc = cclayout.LocArrSize();
+		std::vector<IT> cur(myncc, 0), prev(myncc, -1), active(myncc, 1);	// depth of the last two BFSs of every component
+
+		IT nactive = myncc;
+		MPI_Allreduce(MPI_IN_PLACE, &nactive, 1, MPIType<IT>(), MPI_SUM, World);
+		while(nactive > 0)
+		{
+			std::vector< std::vector<IT> > sendbuf(nprocs);
+			for(IT c=0; c< myncc; ++c)
+			{
+				if(active[c])
+				{
+					IT lv;
+					int owner = level.Owner(src[c], lv);
+					sendbuf[owner].push_back(lv);
+				}
+			}
+			std::vector<IT> sources = Exchange(sendbuf, World);
+			level = static_cast<IT>(-1);
+			FullyDistSpVec<IT,IT> fringe(commGrid, n, sources, std::vector<IT>(sources.size(), 1));
+			level.Set(fringe);
+			IT curlevel = 2;
+			while(fringe.getnnz() > 0)
+			{
+				SpMV<SelectMinSR>(Acsc, fringe, fringe, false, SPA);
+				fringe = EWiseMult(fringe, level, true, static_cast<IT>(-1));
+				fringe = curlevel++;
+				level.Set(fringe);
+				++stats.ppvlevels;
+			}
+
+			// deepest level, then smallest degree, then smallest index of every component visited in this round
+			const IT * lev = level.GetLocArr();
+			std::unordered_map<IT, std::tuple<IT,IT,IT> > local;	// label -> (-level, degree, vertex)
+			for(IT i=0; i< mylen; ++i)
+			{
+				if(lev[i] == -1) continue;
+				std::tuple<IT,IT,IT> cand = std::make_tuple(-lev[i], deg[i], myoffset+i);
+				auto it = local.find(label[i]);
+				if(it == local.end())
+					local[label[i]] = cand;
+				else if(cand < it->second)
+					it->second = cand;
+			}
+			for(auto it = local.begin(); it != local.end(); ++it)
+			{
+				IT lc;
+				int owner = cclayout.Owner(it->first, lc);
+				sendbuf[owner].insert(sendbuf[owner].end(), {lc, std::get<0>(it->second), std::get<1>(it->second), std::get<2>(it->second)});
+			}
+			std::vector<IT> recvbuf = Exchange(sendbuf, World);
+			std::vector< std::tuple<IT,IT,IT> > best(myncc, std::make_tuple(std::numeric_limits<IT>::max(), 0, 0));
+			for(size_t k=0; k< recvbuf.size(); k += 4)
+			{
+				std::tuple<IT,IT,IT> cand = std::make_tuple(recvbuf[k+1], recvbuf[k+2], recvbuf[k+3]);
+				if(cand < best[recvbuf[k]]) best[recvbuf[k]] = cand;
+			}
+			nactive = 0;
+			for(IT c=0; c< myncc; ++c)
+			{
+				if(!active[c]) continue;
+				prev[c] = cur[c];
+				cur[c] = -std::get<0>(best[c]);
+				if(cur[c] > prev[c])
+				{
+					src[c] = std::get<2>(best[c]);
+					++nactive;
+				}
+				else
+				{
+					active[c] = 0;
+				}
+			}
+			MPI_Allreduce(MPI_IN_PLACE, &nactive, 1, MPIType<IT>(), MPI_SUM, World);
+			++stats.ppvrounds;
+		}
+	}
+
+	/**
+	 * Level synchronous Cuthill-McKee from the pseudo-peripheral vertices of all components
+	 * The orders use the layout of the vertices; the owner of a current order o keeps the range [levstart[o], levend[o]] of the
+	 * level of its component that o belongs to
+	 **/
+	void CuthillMcKee(const FullyDistVec<IT,IT> & cclayout, const IT * deg, const std::vector<IT> & src, const std::vector<IT> & ccstart,
+			  std::vector<IT> & ord, RCMStats & stats)
+	{
+		std::shared_ptr<CommGrid> commGrid = Acsc.getcommgrid();
+		MPI_Comm World = commGrid->GetWorld();
+		int nprocs = commGrid->GetSize();
+		IT n = Acsc.getnrow();
+		FullyDistVec<IT,IT> layout(commGrid, n, static_cast<IT>(0));
+		IT mylen = layout.LocArrSize();
+		IT myoffset = layout.LengthUntil();
+		IT myncc = cclayout.LocArrSize();
+
+		std::vector<IT> levstart(mylen), levend(mylen), childcnt(mylen, 0);
+		std::vector<IT> frontier;		// local indices of the orders of the current level, sorted
+		std::vector<IT> fringeind, fringeord;	// vertices of the current level and their orders
+
+		std::vector< std::vector<IT> > tovertex(nprocs), toorder(nprocs);
+		for(IT c=0; c< myncc; ++c)
+		{
+			IT lv, lo;
+			int owner = layout.Owner(src[c], lv);
+			tovertex[owner].insert(tovertex[owner].end(), {lv, ccstart[c]});
+			owner = layout.Owner(ccstart[c], lo);
+			toorder[owner].insert(toorder[owner].end(), {lo, ccstart[c], ccstart[c]});
+		}
+		while(true)
+		{
+			std::vector<IT> recvbuf = Exchange(tovertex, World);
+			fringeind.clear();
+			fringeord.clear();
+			for(size_t k=0; k< recvbuf.size(); k += 2)
+			{
+				ord[recvbuf[k]] = recvbuf[k+1];
+				fringeind.push_back(recvbuf[k]);
+				fringeord.push_back(recvbuf[k+1]);
+			}
+			recvbuf = Exchange(toorder, World);
+			frontier.clear();
+			for(size_t k=0; k< recvbuf.size(); k += 3)
+			{
+				levstart[recvbuf[k]] = recvbuf[k+1];
+				levend[recvbuf[k]] = recvbuf[k+2];
+				frontier.push_back(recvbuf[k]);
+			}
+			std::sort(frontier.begin(), frontier.end());
+
+			// unvisited neighbors with the smallest order of their parents go to the owner of that order
+			FullyDistSpVec<IT,IT> fringe(commGrid, n, fringeind, fringeord);
+			SpMV<SelectMinSR>(Acsc, fringe, fringe, false, SPA);
+			std::vector<IT> yind = fringe.GetLocalInd();
+			std::vector<IT> ynum = fringe.GetLocalNum();
+			std::vector< std::vector<IT> > toparent(nprocs);
+			IT mychildren = 0;
+			for(size_t k=0; k< yind.size(); ++k)
+			{
+				if(ord[yind[k]] != -1) continue;
+				IT lo;
+				int owner = layout.Owner(ynum[k], lo);
+				toparent[owner].insert(toparent[owner].end(), {lo, deg[yind[k]], myoffset + yind[k]});
+				++mychildren;
+			}
+			MPI_Allreduce(MPI_IN_PLACE, &mychildren, 1, MPIType<IT>(), MPI_SUM, World);
+			if(mychildren == 0) break;
+			++stats.levels;
+			std::vector<IT> children = Exchange(toparent, World);
+
+			// bucket the children by parent, each bucket ordered by (degree, index)
+			IT nchildren = static_cast<IT>(children.size() / 3);
+			for(IT k=0; k< nchildren; ++k)
+				childcnt[children[3*k]]++;
+			std::vector<IT> bucketptr(frontier.size()+1, 0);
+			for(size_t f=0; f< frontier.size(); ++f)
+			{
+				bucketptr[f+1] = bucketptr[f] + childcnt[frontier[f]];
+				childcnt[frontier[f]] = bucketptr[f];	// insertion point
+			}
+			std::vector< std::pair<IT,IT> > bucket(nchildren);	// (degree, vertex)
+			for(IT k=0; k< nchildren; ++k)
+				bucket[childcnt[children[3*k]]++] = std::make_pair(children[3*k+1], children[3*k+2]);
+		#ifdef THREADED
+		#pragma omp parallel for schedule(dynamic)
+		#endif
+			for(size_t f=0; f< frontier.size(); ++f)
+			{
+				std::sort(bucket.begin() + bucketptr[f], bucket.begin() + bucketptr[f+1]);
+				childcnt[frontier[f]] = 0;
+			}
+
+			// children before the bucket and in total, within the level of the component
+			std::vector<IT> before, total;
+			SegmentedScan(frontier, levstart, myoffset, bucketptr, before, total, World);
+
+			for(size_t f=0; f< frontier.size(); ++f)
+			{
+				IT nextstart = levend[frontier[f]] + 1;
+				IT nextend = levend[frontier[f]] + total[f];
+				for(IT k = bucketptr[f]; k < bucketptr[f+1]; ++k)
+				{
+					IT q = nextstart + before[f] + (k - bucketptr[f]);
+					IT lv, lo;
+					int owner = layout.Owner(bucket[k].second, lv);
+					tovertex[owner].insert(tovertex[owner].end(), {lv, q});
+					owner = layout.Owner(q, lo);
+					toorder[owner].insert(toorder[owner].end(), {lo, nextstart, nextend});
+				}
+			}
+		}
+	}
+
+	/**
+	 * Exclusive scan of the bucket sizes over the orders of the current level, restarting at the first order of every
+	 * component's level (levstart[o] == o); before[f] is the sum within the segment of frontier[f] before it, total[f] the
+	 * sum of the whole segment. Orders are distributed in rank order, so only the first segment of a process can start on an
+	 * earlier process and only the last one can continue on a later process; their carries come from one allgather.
+	 **/
+	static void SegmentedScan(const std::vector<IT> & frontier, const std::vector<IT> & levstart, IT myoffset,
+				  const std::vector<IT> & bucketptr, std::vector<IT> & before, std::vector<IT> & total, MPI_Comm World)
+	{
+		int nprocs, myrank;
+		MPI_Comm_size(World, &nprocs);
+		MPI_Comm_rank(World, &myrank);
+		size_t nf = frontier.size();
+		before.resize(nf);
+		total.resize(nf);
+
+		std::vector<IT> segsum;		// sums of the local segments
+		std::vector<size_t> segof(nf);
+		IT headsum = 0;			// sum before the first local segment start
+		size_t firststart = nf;
+		bool hasstart = false;
+		IT run = 0;
+		for(size_t f=0; f< nf; ++f)
+		{
+			if(levstart[frontier[f]] == myoffset + frontier[f])
+			{
+				if(hasstart) segsum.push_back(run);
+				else
+				{
+					headsum = run;
+					firststart = f;
+				}
+				hasstart = true;
+				run = 0;
+			}
+			before[f] = run;
+			segof[f] = segsum.size();
+			run += bucketptr[f+1] - bucketptr[f];
+		}
+		if(hasstart) segsum.push_back(run);
+		else headsum = run;
+		IT tailsum = hasstart? segsum.back() : 0;
+
+		std::vector<IT> summary(3*nprocs);
+		IT mysummary[3] = {headsum, static_cast<IT>(hasstart), tailsum};
+		MPI_Allgather(mysummary, 3, MPIType<IT>(), summary.data(), 3, MPIType<IT>(), World);
+		IT leftcarry = 0, rightcarry = 0;
+		for(int p = myrank-1; p >= 0; --p)
+		{
+			if(summary[3*p+1])
+			{
+				leftcarry += summary[3*p+2];
+				break;
+			}
+			leftcarry += summary[3*p];
+		}
+		for(int p = myrank+1; p < nprocs; ++p)
+		{
+			rightcarry += summary[3*p];
+			if(summary[3*p+1]) break;
+		}
+
+		IT headtotal = leftcarry + headsum + (hasstart? 0 : rightcarry);
+		if(hasstart) segsum.back() += rightcarry;
+		for(size_t f=0; f< nf; ++f)
+		{
+			if(f < firststart)
+			{
+				before[f] += leftcarry;
+				total[f] = headtotal;
+			}
+			else
+			{
+				total[f] = segsum[segof[f]];
+			}
+		}
+	}
+
+	PSpMat_CSC_Bool Acsc;
+	RCMParams params;
+	PreAllocatedSPA<IT> SPA;
+	FullyDistVec<IT,IT> cclabel;
+	FullyDistVec<IT,IT> degrees;
+	IT nCC;
+	double tcc;
+};
+
+/**
+ * Single-call convenience wrapper
+ * @return position of every vertex in the (reverse) Cuthill-McKee ordering
+ **/
+template <typename IT, typename NT, typename DER>
+FullyDistVec<IT,IT> RCMOrdering(const SpParMat<IT,NT,DER> & A, const RCMParams & params = RCMParams(), RCMStats * stats = NULL)
+{
+	RCM<IT,NT,DER> engine(A, params);
+	FullyDistVec<IT,IT> order(A.getcommgrid());
+	engine.Run(order, stats);
+	return order;
+}
+
+}
+
+#endif
@@ -268,18 +268,23 @@ public:
   		*end_idx = (rankc + 1) * (M / sizec) + (rankc + 1 < (M % sizec) ? rankc + 1 : (M % sizec));
 	}
 
-	static inline void make_graph(int log_numverts, int64_t M, int64_t* nedges_ptr, packed_edge** result_ptr, MPI_Comm & world)
+	/* The seed of make_graph; anything that generates a range of its edges separately has to start from the same seed */
+	static inline void make_graph_seed(uint_fast32_t seed[5])
 	{
-  		int rank, size;
 #ifdef DETERMINISTIC
 		uint64_t userseed1 = 0;
 #else
 		uint64_t userseed1 = (uint64_t) init_random();
 #endif
-
   		/* Spread the two 64-bit numbers into five nonzero values in the correct range. */
-  		uint_fast32_t seed[5];
   		make_mrg_seed(userseed1, userseed1, seed);
+	}
+
+	static inline void make_graph(int log_numverts, int64_t M, int64_t* nedges_ptr, packed_edge** result_ptr, MPI_Comm & world)
+	{
+  		int rank, size;
+  		uint_fast32_t seed[5];
+  		make_graph_seed(seed);
 
   		MPI_Comm_rank(world, &rank);
   		MPI_Comm_size(world, &size);
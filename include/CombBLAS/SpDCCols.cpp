@@ -846,14 +846,21 @@ Arr<IT,NT> SpDCCols<IT,NT>::GetArrays() const
 }
 
 /**
-  * O(nnz log(nnz)) time Transpose function
-  * \remarks Performs a lexicographical sort
+  * O(nnz + m) time Transpose function
+  * \remarks Counting sort on the row indices (Dcsc::Transpose), threaded
   * \remarks Mutator function (replaces the calling object with its transpose)
   */
 template <class IT, class NT>
 void SpDCCols<IT,NT>::Transpose()
 {
-	if(nnz > 0)
+	if(nnz > 0 && splits == 0)
+	{
+		Dcsc<IT,NT> * trans = dcsc->Transpose(m);
+		delete dcsc;
+		dcsc = trans;
+		std::swap(m, n);
+	}
+	else if(nnz > 0)
 	{
 		SpTuples<IT,NT> Atuples(*this);
 		Atuples.SortRowBased();
@@ -869,13 +876,16 @@ void SpDCCols<IT,NT>::Transpose()
 
 
 /**
-  * O(nnz log(nnz)) time Transpose function
-  * \remarks Performs a lexicographical sort
+  * O(nnz + m) time Transpose function
+  * \remarks Counting sort on the row indices (Dcsc::Transpose), threaded
   * \remarks Const function (doesn't mutate the calling object)
   */
 template <class IT, class NT>
 SpDCCols<IT,NT> SpDCCols<IT,NT>::TransposeConst() const
 {
+	if(splits == 0)
+		return SpDCCols<IT,NT>(n, m, (nnz > 0)? dcsc->Transpose(m) : NULL);
+
 	SpTuples<IT,NT> Atuples(*this);
 	Atuples.SortRowBased();
 
@@ -883,13 +893,16 @@ SpDCCols<IT,NT> SpDCCols<IT,NT>::TransposeConst() const
 }
 
 /**
- * O(nnz log(nnz)) time Transpose function
- * \remarks Performs a lexicographical sort
+ * O(nnz + m) time Transpose function
+ * \remarks Counting sort on the row indices (Dcsc::Transpose), threaded
  * \remarks Const function (doesn't mutate the calling object)
  */
 template <class IT, class NT>
 SpDCCols<IT,NT> * SpDCCols<IT,NT>::TransposeConstPtr() const
 {
+	if(splits == 0)
+		return new SpDCCols<IT,NT>(n, m, (nnz > 0)? dcsc->Transpose(m) : NULL);
+
 	SpTuples<IT,NT> Atuples(*this);
 	Atuples.SortRowBased();
 	
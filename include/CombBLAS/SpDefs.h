@@ -116,6 +116,16 @@ Column,
 Row
 };
 
+// Communication/computation overlap achieved by the pipelined mode of MemEfficientSpGEMM
+struct SUMMAPipelineStats
+{
+	SUMMAPipelineStats(): exposedcomm(0), overlapwindow(0), stages(0), hiddenstages(0) {}
+	double exposedcomm;	// time spent blocked on broadcasts that had not completed when their stage started
+	double overlapwindow;	// multiply/merge/prune time that ran while the next stage's broadcasts were in flight
+	int stages;		// number of pipelined SUMMA stages (over all phases)
+	int hiddenstages;	// stages whose broadcasts had fully completed behind computation
+};
+
 
 // force 8-bytes alignment in heap allocated memory
 #ifndef ALIGN
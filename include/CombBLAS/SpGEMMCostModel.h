@@ -0,0 +1,214 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _SPGEMM_COST_MODEL_H_
+#define _SPGEMM_COST_MODEL_H_
+
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <limits>
+
+namespace combblas {
+
+/**
+ * Column accumulators available to the local (threaded) SpGEMM kernels
+ **/
+enum LocalSpGEMMKernel
+{
+	HEAP_KERNEL = 0,	// k-way heap merge of the selected columns of A
+	HASH_KERNEL = 1,	// linear probing hash table, sorted at the end
+	SPA_KERNEL = 2,		// dense sparse accumulator of length nrow(A)
+	MERGE_KERNEL = 3,	// repeated two-way merging of the sorted columns of A
+	NUM_LOCAL_KERNELS = 4
+};
+
+/**
+ * Per-column cost model used by LocalHybridSpGEMM to pick an accumulator
+ * Every kernel is modeled as a linear combination of the features below, all computed from
+ * the symbolic phase (flop and nnz of the output column, nnz of the column of B):
+ *	[ 1, flop, flop*log2(nnzB), flop*nnzB, nnzC*log2(nnzC) ]
+ * An uncalibrated model reproduces the original heap/hash compression-ratio heuristic.
+ * Coefficients are fitted by CalibrateLocalSpGEMM (mtSpGEMM.h) and can be saved to and loaded from a text file.
+ * If the environment variable COMBBLAS_SPGEMM_MODEL points to such a file, Default() loads it once per process.
+ **/
+class LocalSpGEMMCostModel
+{
+public:
+	static const int nfeatures = 5;
+
+	LocalSpGEMMCostModel(): calibrated(false), forced(-1), maxSpaRows(static_cast<int64_t>(1) << 22)
+	{
+		for(int k=0; k< NUM_LOCAL_KERNELS; ++k)
+			for(int f=0; f< nfeatures; ++f)
+				coeffs[k][f] = 0.0;
+	}
+
+	bool IsCalibrated() const { return calibrated; }
+
+	//! Always select the given kernel (used by the calibration microbenchmark and for testing)
+	void Force(int kernel) { forced = kernel; }
+	void Unforce() { forced = -1; }
+
+	//! Dense SPA is not considered when nrow(A) is larger than this (it needs nrow(A) words per thread)
+	void SetMaxSpaRows(int64_t rows) { maxSpaRows = rows; }
+	int64_t GetMaxSpaRows() const { return maxSpaRows; }
+
+	static void Features(int64_t flop, int64_t nnzc, int64_t nnzcolB, double * feat)
+	{
+		double lb = std::log2(static_cast<double>(nnzcolB) + 1.0);
+		double lc = std::log2(static_cast<double>(nnzc) + 1.0);
+		feat[0] = 1.0;
+		feat[1] = static_cast<double>(flop);
+		feat[2] = static_cast<double>(flop) * lb;
+		feat[3] = static_cast<double>(flop) * static_cast<double>(nnzcolB);
+		feat[4] = static_cast<double>(nnzc) * lc;
+	}
+
+	double Cost(int kernel, int64_t flop, int64_t nnzc, int64_t nnzcolB) const
+	{
+		double feat[nfeatures];
+		Features(flop, nnzc, nnzcolB, feat);
+		double cost = 0.0;
+		for(int f=0; f< nfeatures; ++f)
+			cost += coeffs[kernel][f] * feat[f];
+		return cost;
+	}
+
+	/**
+	 * Pick the accumulator for a single output column
+	 * @param[in] mdim number of rows of A (restricts the use of the dense SPA)
+	 **/
+	int Select(int64_t flop, int64_t nnzc, int64_t nnzcolB, int64_t mdim) const
+	{
+		if(forced >= 0)
+		{
+			if(forced == SPA_KERNEL && mdim > maxSpaRows) return HASH_KERNEL;
+			return forced;
+		}
+		if(nnzc == 0) return HEAP_KERNEL;	// empty output column, no accumulator does any work
+		if(!calibrated)
+		{
+			double cr = static_cast<double>(flop) / static_cast<double>(nnzc);
+			return (cr < 2.0)? HEAP_KERNEL : HASH_KERNEL;
+		}
+		int best = HASH_KERNEL;
+		double bestcost = std::numeric_limits<double>::max();
+		for(int k=0; k< NUM_LOCAL_KERNELS; ++k)
+		{
+			if(k == SPA_KERNEL && mdim > maxSpaRows) continue;
+			double cost = Cost(k, flop, nnzc, nnzcolB);
+			if(cost < bestcost)
+			{
+				bestcost = cost;
+				best = k;
+			}
+		}
+		return best;
+	}
+
+	void SetCoefficients(int kernel, const double * c)
+	{
+		for(int f=0; f< nfeatures; ++f)
+			coeffs[kernel][f] = c[f];
+		calibrated = true;
+	}
+	const double * GetCoefficients(int kernel) const { return coeffs[kernel]; }
+
+	//! Writes one line per kernel: kernel id followed by its coefficients
+	bool Save(const std::string & filename) const
+	{
+		std::ofstream out(filename.c_str());
+		if(!out.is_open()) return false;
+		out.precision(17);
+		out << "CombBLAS-LocalSpGEMMCostModel " << NUM_LOCAL_KERNELS << " " << nfeatures << " " << maxSpaRows << "\n";
+		for(int k=0; k< NUM_LOCAL_KERNELS; ++k)
+		{
+			out << k;
+			for(int f=0; f< nfeatures; ++f)
+				out << " " << coeffs[k][f];
+			out << "\n";
+		}
+		return out.good();
+	}
+
+	bool Load(const std::string & filename)
+	{
+		std::ifstream in(filename.c_str());
+		if(!in.is_open()) return false;
+		std::string magic;
+		int nkernels, nfeat;
+		int64_t spaRows;
+		in >> magic >> nkernels >> nfeat >> spaRows;
+		if(!in || magic != "CombBLAS-LocalSpGEMMCostModel" || nkernels != NUM_LOCAL_KERNELS || nfeat != nfeatures)
+			return false;
+		double loaded[NUM_LOCAL_KERNELS][nfeatures];
+		for(int k=0; k< NUM_LOCAL_KERNELS; ++k)
+		{
+			int id;
+			in >> id;
+			if(!in || id != k) return false;
+			for(int f=0; f< nfeatures; ++f)
+				in >> loaded[k][f];
+			if(!in) return false;
+		}
+		for(int k=0; k< NUM_LOCAL_KERNELS; ++k)
+			SetCoefficients(k, loaded[k]);
+		maxSpaRows = spaRows;
+		return true;
+	}
+
+	//! Process-wide model used when LocalHybridSpGEMM is not given one explicitly
+	static LocalSpGEMMCostModel & Default()
+	{
+		static LocalSpGEMMCostModel model = FromEnvironment();
+		return model;
+	}
+
+private:
+	static LocalSpGEMMCostModel FromEnvironment()
+	{
+		LocalSpGEMMCostModel model;
+		const char * fname = getenv("COMBBLAS_SPGEMM_MODEL");
+		if(fname != NULL)
+			model.Load(std::string(fname));	// stays uncalibrated on failure
+		return model;
+	}
+
+	double coeffs[NUM_LOCAL_KERNELS][nfeatures];
+	bool calibrated;
+	int forced;
+	int64_t maxSpaRows;
+};
+
+}
+
+#endif
@@ -0,0 +1,330 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _SPGEMM_PLAN_H_
+#define _SPGEMM_PLAN_H_
+
+#include <vector>
+#include <tuple>
+#include <numeric>
+#include <algorithm>
+#include "SpParMat.h"
+#include "SpParHelper.h"
+#include "ParFriends.h"
+
+namespace combblas {
+
+/**
+ * Reusable 2D SUMMA plan for C = A*B when A and B keep their patterns and only their values change
+ * The constructor runs the symbolic phase once: it broadcasts the stage operands as Mult_AnXBn_Synch does, keeps their
+ * index arrays, matches every nonzero of a stage piece of B with its column of the stage piece of A, and allocates the
+ * output with its final pattern. execute(A,B) then broadcasts only the values of the stage pieces, all stages at once with
+ * nonblocking broadcasts, and accumulates every column of C in place through a row-position map: there is no symbolic
+ * sizing, no hashing or sorting, no merge of stage products and no allocation of the output.
+ * Memory: the index arrays of the row strip of A and the column strip of B, about (nnz(A)+nnz(B))/q per processor,
+ * stay with the plan
+ * @pre { A and B are on the same square grid and have SpDCCols local matrices; SR::id() is the additive identity of SR }
+ **/
+template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
+class SpGEMMPlan
+{
+public:
+	typedef typename UDERA::LocalIT LIA;
+	typedef typename UDERB::LocalIT LIB;
+	typedef typename UDERO::LocalIT LIC;
+
+	SpGEMMPlan(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B): rebuilds(0)
+	{
+		static_assert(std::is_same<LIA, LIB>::value, "local index types for both input matrices should be the same");
+		static_assert(std::is_same<LIA, LIC>::value, "local index types for input and output matrices should be the same");
+		Symbolic(A, B);
+	}
+
+	/**
+	 * C = A*B for A and B with the patterns of the plan, in the output owned by the plan
+	 * If the pattern of A or B changed on any processor (compared through the local nonzero counts and pattern
+	 * fingerprints), the plan is rebuilt first
+	 * @return the product, which is overwritten by the next call
+	 **/
+	SpParMat<IU,NUO,UDERO> & execute(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B)
+	{
+		int stale = (A.seqptr()->getnnz() != anz || B.seqptr()->getnnz() != bnz ||
+				SpHelper::PatternHash(*(A.seqptr())) != ahash || SpHelper::PatternHash(*(B.seqptr())) != bhash)? 1 : 0;
+		MPI_Allreduce(MPI_IN_PLACE, &stale, 1, MPI_INT, MPI_MAX, C.getcommgrid()->GetWorld());
+		if(stale)
+		{
+			++rebuilds;
+			Symbolic(A, B);
+		}
+		Numeric(A, B);
+		return C;
+	}
+
+	SpParMat<IU,NUO,UDERO> & product() { return C; }
+	int getrebuilds() const { return rebuilds; }	//!< number of times execute() found a changed pattern
+
+private:
+	void Symbolic(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B);
+	void Numeric(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B);
+
+	int stages, Aself, Bself, rebuilds;
+	LIA anz, bnz;			// local nonzeros of A and B at the time of Symbolic()
+	uint64_t ahash, bhash;		// and fingerprints of their local patterns
+
+	// index arrays of the stage pieces: column pointers and rows of A_i, column pointers of B_i, and for every
+	// nonzero of B_i the dcsc index of the matching column of A_i, -1 if that column is empty
+	std::vector< std::vector<LIA> > acp, air, bcp, amatch;
+	std::vector<LIA> astagenz, bstagenz;
+
+	// for every nonempty column of C, the stage pieces of B that have it: (stage, dcsc index in B_i)
+	std::vector<LIC> cstageptr;
+	std::vector< std::pair<int,LIB> > cstages;
+
+	std::vector<NU1> avals;		// values of the stage pieces received from others, concatenated
+	std::vector<NU2> bvals;
+	std::vector<LIA> avaloff, bvaloff;
+
+	SpParMat<IU,NUO,UDERO> C;
+};
+
+
+template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
+void SpGEMMPlan<SR,NUO,UDERO,IU,NU1,NU2,UDERA,UDERB>::Symbolic(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B)
+{
+	int dummy;
+	std::shared_ptr<CommGrid> GridC = ProductGrid((A.getcommgrid()).get(), (B.getcommgrid()).get(), stages, dummy, dummy);
+	Aself = (A.getcommgrid())->GetRankInProcRow();
+	Bself = (B.getcommgrid())->GetRankInProcCol();
+	anz = A.seqptr()->getnnz();
+	bnz = B.seqptr()->getnnz();
+	ahash = SpHelper::PatternHash(*(A.seqptr()));
+	bhash = SpHelper::PatternHash(*(B.seqptr()));
+	LIC C_m = A.seqptr()->getnrow();
+	LIC C_n = B.seqptr()->getncol();
+
+	LIA ** ARecvSizes = SpHelper::allocate2D<LIA>(UDERA::esscount, stages);
+	LIB ** BRecvSizes = SpHelper::allocate2D<LIB>(UDERB::esscount, stages);
+	SpParHelper::GetSetSizes( *(A.seqptr()), ARecvSizes, (A.getcommgrid())->GetRowWorld());
+	SpParHelper::GetSetSizes( *(B.seqptr()), BRecvSizes, (B.getcommgrid())->GetColWorld());
+
+	acp.assign(stages, std::vector<LIA>());
+	air.assign(stages, std::vector<LIA>());
+	bcp.assign(stages, std::vector<LIB>());
+	amatch.assign(stages, std::vector<LIB>());
+	astagenz.assign(stages, 0);
+	bstagenz.assign(stages, 0);
+	std::vector< std::vector<LIB> > bjc(stages);
+	std::vector<LIA> acolpos;	// dcsc index of every column of A_i, reused across stages
+	for(int i = 0; i < stages; ++i)
+	{
+		std::vector<LIA> ess;
+		UDERA * ARecv;
+		UDERB * BRecv;
+		if(i == Aself)	ARecv = A.seqptr();
+		else
+		{
+			ess.resize(UDERA::esscount);
+			for(int j=0; j< UDERA::esscount; ++j)
+				ess[j] = ARecvSizes[j][i];
+			ARecv = new UDERA();
+		}
+		SpParHelper::BCastMatrix(GridC->GetRowWorld(), *ARecv, ess, i);
+		ess.clear();
+		if(i == Bself)	BRecv = B.seqptr();
+		else
+		{
+			ess.resize(UDERB::esscount);
+			for(int j=0; j< UDERB::esscount; ++j)
+				ess[j] = BRecvSizes[j][i];
+			BRecv = new UDERB();
+		}
+		SpParHelper::BCastMatrix(GridC->GetColWorld(), *BRecv, ess, i);
+
+		astagenz[i] = ARecv->getnnz();
+		bstagenz[i] = BRecv->getnnz();
+		if(astagenz[i] > 0 && bstagenz[i] > 0)
+		{
+			Dcsc<LIA,NU1> * adcsc = ARecv->GetDCSC();
+			Dcsc<LIB,NU2> * bdcsc = BRecv->GetDCSC();
+			acp[i].assign(adcsc->cp, adcsc->cp + adcsc->nzc + 1);
+			air[i].assign(adcsc->ir, adcsc->ir + adcsc->nz);
+			bcp[i].assign(bdcsc->cp, bdcsc->cp + bdcsc->nzc + 1);
+			bjc[i].assign(bdcsc->jc, bdcsc->jc + bdcsc->nzc);
+			acolpos.assign(ARecv->getncol(), -1);
+			for(LIA c = 0; c < adcsc->nzc; ++c)
+				acolpos[adcsc->jc[c]] = c;
+			amatch[i].resize(bdcsc->nz);
+			for(LIB k = 0; k < bdcsc->nz; ++k)
+				amatch[i][k] = acolpos[bdcsc->ir[k]];
+		}
+		if(i != Aself) delete ARecv;
+		if(i != Bself) delete BRecv;
+	}
+	SpHelper::deallocate2D(ARecvSizes, UDERA::esscount);
+	SpHelper::deallocate2D(BRecvSizes, UDERB::esscount);
+
+	// stage pieces of B that contribute to every column of C
+	std::vector<LIC> colcnt(C_n+1, 0);
+	for(int i = 0; i < stages; ++i)
+		for(LIB c : bjc[i]) ++colcnt[c+1];
+	std::partial_sum(colcnt.begin(), colcnt.end(), colcnt.begin());
+	std::vector< std::pair<int,LIB> > bycol(colcnt.back());
+	std::vector<LIC> fill(colcnt.begin(), colcnt.end()-1);
+	for(int i = 0; i < stages; ++i)
+		for(LIB c = 0; c < static_cast<LIB>(bjc[i].size()); ++c)
+			bycol[fill[bjc[i][c]]++] = std::make_pair(i, c);
+
+	// pattern of C, one column at a time; only the nonempty columns are kept
+	std::vector<bool> mark(C_m, false);
+	std::vector<LIC> rows;
+	std::vector< std::tuple<LIC,LIC,NUO> > nonzeros;
+	cstageptr.assign(1, 0);
+	cstages.clear();
+	for(LIC j = 0; j < C_n; ++j)
+	{
+		for(LIC s = colcnt[j]; s < colcnt[j+1]; ++s)
+		{
+			int i = bycol[s].first;
+			LIB c = bycol[s].second;
+			for(LIB k = bcp[i][c]; k < bcp[i][c+1]; ++k)
+			{
+				LIA a = amatch[i][k];
+				if(a < 0) continue;
+				for(LIA e = acp[i][a]; e < acp[i][a+1]; ++e)
+				{
+					if(!mark[air[i][e]])
+					{
+						mark[air[i][e]] = true;
+						rows.push_back(air[i][e]);
+					}
+				}
+			}
+		}
+		if(rows.empty()) continue;
+		std::sort(rows.begin(), rows.end());
+		for(LIC r : rows)
+		{
+			mark[r] = false;
+			nonzeros.push_back(std::make_tuple(r, j, SR::id()));
+		}
+		rows.clear();
+		cstages.insert(cstages.end(), bycol.begin() + colcnt[j], bycol.begin() + colcnt[j+1]);
+		cstageptr.push_back(cstages.size());
+	}
+
+	std::tuple<LIC,LIC,NUO> * tuples = new std::tuple<LIC,LIC,NUO>[nonzeros.size()];
+	std::copy(nonzeros.begin(), nonzeros.end(), tuples);
+	SpTuples<LIC,NUO> spTuples(nonzeros.size(), C_m, C_n, tuples, true);
+	C = SpParMat<IU,NUO,UDERO>(new UDERO(spTuples, false), GridC);
+
+	avaloff.assign(stages+1, 0);
+	bvaloff.assign(stages+1, 0);
+	for(int i = 0; i < stages; ++i)
+	{
+		avaloff[i+1] = avaloff[i] + ((i != Aself)? astagenz[i] : 0);
+		bvaloff[i+1] = bvaloff[i] + ((i != Bself)? bstagenz[i] : 0);
+	}
+	avals.resize(avaloff.back());
+	bvals.resize(bvaloff.back());
+}
+
+
+template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
+void SpGEMMPlan<SR,NUO,UDERO,IU,NU1,NU2,UDERA,UDERB>::Numeric(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B)
+{
+	std::shared_ptr<CommGrid> GridC = C.getcommgrid();
+	NU1 * amine = (anz > 0)? A.seqptr()->GetDCSC()->numx : NULL;
+	NU2 * bmine = (bnz > 0)? B.seqptr()->GetDCSC()->numx : NULL;
+	std::vector<NU1 *> astage(stages);
+	std::vector<NU2 *> bstage(stages);
+	std::vector<MPI_Request> reqs(2*stages, MPI_REQUEST_NULL);
+	for(int i = 0; i < stages; ++i)
+	{
+		astage[i] = (i == Aself)? amine : avals.data() + avaloff[i];
+		bstage[i] = (i == Bself)? bmine : bvals.data() + bvaloff[i];
+		if(astagenz[i] > 0)
+			MPI_Ibcast(astage[i], astagenz[i], MPIType<NU1>(), i, GridC->GetRowWorld(), &reqs[2*i]);
+		if(bstagenz[i] > 0)
+			MPI_Ibcast(bstage[i], bstagenz[i], MPIType<NU2>(), i, GridC->GetColWorld(), &reqs[2*i+1]);
+	}
+	MPI_Waitall(reqs.size(), reqs.data(), MPI_STATUSES_IGNORE);
+
+	UDERO * Cloc = C.seqptr();
+	if(Cloc->getnnz() == 0) return;
+	Dcsc<LIC,NUO> * cdcsc = Cloc->GetDCSC();
+	LIC C_m = Cloc->getnrow();
+#ifdef THREADED
+#pragma omp parallel
+#endif
+	{
+		std::vector<LIC> pos(C_m);
+#ifdef THREADED
+#pragma omp for schedule(dynamic, 64)
+#endif
+		for(LIC cc = 0; cc < cdcsc->nzc; ++cc)
+		{
+			NUO * cval = cdcsc->numx + cdcsc->cp[cc];
+			for(LIC e = cdcsc->cp[cc]; e < cdcsc->cp[cc+1]; ++e)
+			{
+				pos[cdcsc->ir[e]] = e - cdcsc->cp[cc];
+				cdcsc->numx[e] = SR::id();
+			}
+			for(LIC s = cstageptr[cc]; s < cstageptr[cc+1]; ++s)
+			{
+				int i = cstages[s].first;
+				LIB c = cstages[s].second;
+				const LIA * arows = air[i].data();
+				const LIA * acols = acp[i].data();
+				const NU1 * avalues = astage[i];
+				for(LIB k = bcp[i][c]; k < bcp[i][c+1]; ++k)
+				{
+					LIA a = amatch[i][k];
+					if(a < 0) continue;
+					NU2 bval = bstage[i][k];
+					for(LIA e = acols[a]; e < acols[a+1]; ++e)
+						cval[pos[arows[e]]] = SR::add(cval[pos[arows[e]]], SR::multiply(avalues[e], bval));
+				}
+			}
+		}
+	}
+}
+
+
+/**
+ * Builds a SpGEMMPlan for C = A*B, deducing the types of A and B
+ **/
+template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
+SpGEMMPlan<SR,NUO,UDERO,IU,NU1,NU2,UDERA,UDERB> MakeSpGEMMPlan(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B)
+{
+	return SpGEMMPlan<SR,NUO,UDERO,IU,NU1,NU2,UDERA,UDERB>(A, B);
+}
+
+}
+
+#endif
@@ -0,0 +1,361 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _SPGEMM_PLANNER_H_
+#define _SPGEMM_PLANNER_H_
+
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <functional>
+#include <algorithm>
+#include <sstream>
+#include "SpParMat.h"
+#include "SpParMat3D.h"
+#include "FullyDistVec.h"
+#include "ParFriends.h"
+
+namespace combblas {
+
+/**
+ * Machine parameters of the 2D/3D SpGEMM cost model (seconds)
+ * The defaults describe a commodity cluster with one MPI process per core; they only need to be right relative to each other
+ **/
+struct SpGEMMLayoutParams
+{
+	SpGEMMLayoutParams(): alpha(1e-5), beta(1e-9), gamma(1e-8), merge(5e-9), layers(0), maxlayers(0), convertinputs(true), convertoutput(true) {}
+	double alpha;		// latency of one step of a collective
+	double beta;		// time per byte received
+	double gamma;		// time per flop of the local multiplication
+	double merge;		// time per partial result per level of a multiway merge
+	int layers;		// 0 lets the model pick the layer count, otherwise this many layers are used
+	int maxlayers;		// largest layer count considered, 0 for no limit
+	bool convertinputs;	// the operands are 2D and have to be converted to 3D (SpParMat3D constructors)
+	bool convertoutput;	// the product is needed in 2D (SpParMat3D::Convert2D)
+};
+
+/**
+ * Layout chosen by PlanSpGEMMLayout along with the quantities it was chosen from
+ **/
+struct SpGEMMLayout
+{
+	int layers;			// 1 for 2D SUMMA, c > 1 for 3D SUMMA on c layers
+	int64_t flops;			// exact number of multiplications of A*B
+	double nnzC;			// estimated nonzeros of A*B
+	double compression;		// flops over nonzeros, observed on the sampled blocks
+	std::vector<int> candidates;	// feasible layer counts
+	std::vector<double> predicted;	// modeled time of each candidate, in seconds
+};
+
+/**
+ * Layer counts c for which the p processes form c square layers: p % c == 0 and p/c is a perfect square
+ **/
+inline std::vector<int> FeasibleLayerCounts(int nprocs, int maxlayers = 0)
+{
+	std::vector<int> layers;
+	for(int c = 1; c <= nprocs; ++c)
+	{
+		if(maxlayers > 0 && c > maxlayers) break;
+		if(nprocs % c != 0) continue;
+		int q = static_cast<int>(std::sqrt(static_cast<double>(nprocs / c)) + 0.5);
+		if(q * q == nprocs / c) layers.push_back(c);
+	}
+	return layers;
+}
+
+/**
+ * Nonzeros of the partial product over a fraction f of the inner dimension, under a balls-into-bins model:
+ * F*f flops land on U possible output positions whose popularities are Gamma(k) distributed, so that
+ * nnz(f) = U (1 - (1 + F f / (k U))^-k). Large k is the uniform case, U (1 - exp(-F f / U)); small k describes
+ * skewed outputs such as power-law graphs, where a few hot positions collect most of the flops.
+ * U and k are fitted so that the model reproduces the compression observed on the sampled blocks over the sampled
+ * fraction and over half of it; U = inf means no compression
+ **/
+class SpGEMMFillModel
+{
+public:
+	SpGEMMFillModel(double flops, double sampledfraction, double sampledcompression, double halfcompression):
+		F(flops), U(std::numeric_limits<double>::infinity()), k(std::numeric_limits<double>::infinity())
+	{
+		if(sampledcompression <= 1.0 + 1e-9 || F <= 0) return;
+		double x = F * sampledfraction;
+		double y = x / sampledcompression;
+		double yhalf = std::min(std::max(x / (2 * std::max(halfcompression, 1.0)), y / 2), y);
+		double umax = 1e300;	// U is an effective number of positions, which a skewed fit can put beyond m*n
+
+		// for a fixed k, U is the one matching the full sample; k is then chosen to match the half sample
+		auto residual = [&](double kk, double & uu)
+		{
+			uu = FitBins(kk, x, y, umax);
+			return Fill(uu, kk, x/2) - yhalf;
+		};
+		double klo = 1e-3, khi = 1e3, ulo, uhi;
+		double rlo = residual(klo, ulo), rhi = residual(khi, uhi);
+		if((rlo < 0) == (rhi < 0))
+		{
+			k = (std::abs(rlo) < std::abs(rhi))? klo : khi;
+			U = (std::abs(rlo) < std::abs(rhi))? ulo : uhi;
+			return;
+		}
+		for(int it = 0; it < 60; ++it)
+		{
+			double kmid = std::sqrt(klo * khi), umid;
+			double rmid = residual(kmid, umid);
+			if((rmid < 0) == (rlo < 0)) { klo = kmid; rlo = rmid; }
+			else khi = kmid;
+		}
+		k = khi;
+		U = FitBins(k, x, y, umax);
+	}
+
+	double operator()(double f) const
+	{
+		return std::isinf(U)? F * f : Fill(U, k, F * f);
+	}
+
+private:
+	static double Fill(double u, double kk, double x)
+	{
+		if(std::isinf(kk)) return u * (-std::expm1(-x / u));
+		return u * (-std::expm1(-kk * std::log1p(x / (kk * u))));
+	}
+
+	// Fill is increasing in u, so the U that gives y nonzeros out of x flops is found by bisection
+	static double FitBins(double kk, double x, double y, double umax)
+	{
+		double lo = y, hi = umax;
+		for(int it = 0; it < 100; ++it)
+		{
+			double mid = std::sqrt(lo * hi);
+			if(Fill(mid, kk, x) < y) lo = mid;
+			else hi = mid;
+		}
+		return hi;
+	}
+
+	double F;
+	double U;
+	double k;
+};
+
+/**
+ * Sends the pattern of a local block to dest and receives the one of source; the values of the received block are zero
+ **/
+template <typename LIT, typename NT>
+SpDCCols<LIT,NT> * ShiftSpGEMMSample(const SpDCCols<LIT,NT> & mine, int dest, int source, MPI_Comm World)
+{
+	Dcsc<LIT,NT> * dcsc = mine.GetDCSC();
+	LIT mysizes[4] = {mine.getnnz(), (dcsc != NULL)? dcsc->nzc : 0, mine.getnrow(), mine.getncol()};
+	LIT sizes[4];
+	MPI_Sendrecv(mysizes, 4, MPIType<LIT>(), dest, 0, sizes, 4, MPIType<LIT>(), source, 0, World, MPI_STATUS_IGNORE);
+	SpDCCols<LIT,NT> * received = new SpDCCols<LIT,NT>(sizes[0], sizes[2], sizes[3], sizes[1]);
+	Dcsc<LIT,NT> * rdcsc = received->GetDCSC();
+	LIT empty = 0;
+	MPI_Sendrecv((mysizes[0] > 0)? dcsc->jc : &empty, mysizes[1], MPIType<LIT>(), dest, 1,
+		     (sizes[0] > 0)? rdcsc->jc : &empty, sizes[1], MPIType<LIT>(), source, 1, World, MPI_STATUS_IGNORE);
+	MPI_Sendrecv((mysizes[0] > 0)? dcsc->cp : &empty, (mysizes[0] > 0)? mysizes[1]+1 : 0, MPIType<LIT>(), dest, 2,
+		     (sizes[0] > 0)? rdcsc->cp : &empty, (sizes[0] > 0)? sizes[1]+1 : 0, MPIType<LIT>(), source, 2, World, MPI_STATUS_IGNORE);
+	MPI_Sendrecv((mysizes[0] > 0)? dcsc->ir : &empty, mysizes[0], MPIType<LIT>(), dest, 3,
+		     (sizes[0] > 0)? rdcsc->ir : &empty, sizes[0], MPIType<LIT>(), source, 3, World, MPI_STATUS_IGNORE);
+	if(sizes[0] > 0)
+		std::fill(rdcsc->numx, rdcsc->numx + sizes[0], NT());
+	return received;
+}
+
+/**
+ * Adds the flops and the nonzeros of the local product A*B, computed symbolically, to flops and nnz
+ **/
+template <typename LIT, typename NU1, typename NU2>
+void SampleSpGEMMBlock(const SpDCCols<LIT,NU1> & A, const SpDCCols<LIT,NU2> & B, double & flops, double & nnz)
+{
+	if(A.getnnz() == 0 || B.getnnz() == 0) return;
+	LIT * flopC = estimateFLOP(A, B);
+	LIT * colnnzC = estimateNNZ_Hash(A, B, flopC);
+	if(colnnzC)
+	{
+		LIT nzc = B.GetDCSC()->nzc;
+		for(LIT k=0; k< nzc; ++k)
+		{
+			flops += flopC[k];
+			nnz += colnnzC[k];
+		}
+	}
+	if(flopC) delete [] flopC;
+	if(colnnzC) delete [] colnnzC;
+}
+
+/**
+ * Picks 2D (Mult_AnXBn_Synch) or 3D (Mult_AnXBn_SUMMA3D) SUMMA and the number of layers for C = A*B
+ * The flops are exact, from the column counts of A and the row counts of B. The compression flops/nnz is sampled with
+ * estimateFLOP and estimateNNZ_Hash on one block product per process, and on its two halves along the inner dimension,
+ * which costs a single shift of the blocks of B; SpGEMMFillModel extrapolates it to the other inner ranges.
+ * Every layer count c that divides p into square q x q layers is priced with an alpha-beta-gamma model:
+ *	- SUMMA on a layer: q stages, each process receives (nnz(A)+nnz(B)) / (c q) words, F/p flops and a q-way merge of
+ *	  the stage products over an inner range of 1/(c q)
+ *	- fiber reduction (c > 1): all-to-all of the layer products, an inner range of 1/c each, and a c-way merge
+ *	- conversion (c > 1): an all-to-all of A and B into the 3D layout, and of C back to 2D, if requested
+ * c = 1 is plain 2D SUMMA on the grid of A, which needs no conversion
+ * @pre { A and B are on the same square grid; local matrices are SpDCCols }
+ **/
+template <typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
+SpGEMMLayout PlanSpGEMMLayout(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B, const SpGEMMLayoutParams & params = SpGEMMLayoutParams())
+{
+	typedef typename UDERA::LocalIT LIA;
+	typedef typename UDERB::LocalIT LIB;
+	static_assert(std::is_same<LIA, LIB>::value, "local index types for both input matrices should be the same");
+
+	SpGEMMLayout layout;
+	std::shared_ptr<CommGrid> commGrid = A.getcommgrid();
+	MPI_Comm World = commGrid->GetWorld();
+	int nprocs = commGrid->GetSize();
+
+	// exact flops: sum_k nnz(A(:,k)) * nnz(B(k,:))
+	FullyDistVec<IU,int64_t> acolnnz(commGrid), browinnz(B.getcommgrid());
+	A.Reduce(acolnnz, Column, std::plus<int64_t>(), static_cast<int64_t>(0), [](NU1){ return static_cast<int64_t>(1); });
+	B.Reduce(browinnz, Row, std::plus<int64_t>(), static_cast<int64_t>(0), [](NU2){ return static_cast<int64_t>(1); });
+	acolnnz.EWiseApply(browinnz, std::multiplies<int64_t>());
+	layout.flops = acolnnz.Reduce(std::plus<int64_t>(), static_cast<int64_t>(0));
+
+	// sampled compression: process (i,j) multiplies its A(i,j) with B(j,i+1), which share the inner range
+	// the shift keeps the sample off the diagonal blocks of C, which are denser than the rest for products like A*A'
+	double sample[4] = {0, 0, 0, 0};	// flops and nnz of the block products, nnz of the products over either half of their inner range
+	int gridq = commGrid->GetGridRows();
+	int myrow = commGrid->GetRankInProcCol();
+	int mycol = commGrid->GetRankInProcRow();
+	int shift = (gridq > 1)? 1 : 0;
+	int dest = commGrid->GetRank((mycol - shift + gridq) % gridq, myrow);
+	int source = commGrid->GetRank(mycol, (myrow + shift) % gridq);
+	SpDCCols<LIB,NU2> * BSample = ShiftSpGEMMSample(*(B.seqptr()), dest, source, World);
+	if(A.seqptr()->getncol() == BSample->getnrow())
+	{
+		SampleSpGEMMBlock(*(A.seqptr()), *BSample, sample[0], sample[1]);
+		if(BSample->getnrow() >= 2 && BSample->getnnz() > 0 && A.seqptr()->getnnz() > 0)
+		{
+			std::vector< SpDCCols<LIA,NU1> > ahalves;
+			std::vector< SpDCCols<LIB,NU2> > bhalves;
+			SpDCCols<LIA,NU1> acopy(*(A.seqptr()));
+			BSample->Transpose();
+			acopy.ColSplit(2, ahalves);
+			BSample->ColSplit(2, bhalves);
+			for(int h = 0; h < 2; ++h)
+			{
+				bhalves[h].Transpose();
+				double hflops = 0;	// adds up to sample[0]
+				SampleSpGEMMBlock(ahalves[h], bhalves[h], hflops, sample[2]);
+			}
+		}
+		else
+		{
+			sample[2] = sample[1];
+		}
+	}
+	delete BSample;
+	MPI_Allreduce(MPI_IN_PLACE, sample, 4, MPI_DOUBLE, MPI_SUM, World);
+	layout.compression = (sample[1] > 0)? sample[0] / sample[1] : 1.0;
+	double halfcompression = (sample[2] > 0)? sample[0] / sample[2] : 1.0;
+
+	double F = static_cast<double>(layout.flops);
+	double p = static_cast<double>(nprocs);
+	double maxnnz = static_cast<double>(A.getnrow()) * static_cast<double>(B.getncol());
+	SpGEMMFillModel fill(F, 1.0 / std::sqrt(p), layout.compression, halfcompression);
+	layout.nnzC = std::min(fill(1.0), maxnnz);
+
+	double nnzin = static_cast<double>(A.getnnz()) + static_cast<double>(B.getnnz());
+	double word = static_cast<double>(sizeof(LIA) + std::max(sizeof(NU1), sizeof(NU2)));	// per nonzero of a DCSC block
+	double tuple = static_cast<double>(2*sizeof(LIA) + std::max(sizeof(NU1), sizeof(NU2)));	// per nonzero in transit
+	auto lg = [](double x){ return (x > 1.0)? std::ceil(std::log2(x)) : 0.0; };
+
+	layout.candidates = FeasibleLayerCounts(nprocs, params.maxlayers);
+	int forced = params.layers;
+	if(forced > 0 && std::find(layout.candidates.begin(), layout.candidates.end(), forced) == layout.candidates.end())
+	{
+		forced = 0;
+		std::ostringstream outs;
+		outs << "PlanSpGEMMLayout: " << nprocs << " processes can not form " << params.layers << " square layers, choosing the layer count instead" << std::endl;
+		SpParHelper::Print(outs.str());
+	}
+	layout.layers = 1;
+	double best = std::numeric_limits<double>::max();
+	for(int c : layout.candidates)
+	{
+		double q = std::sqrt(p / c);
+		double stagenz = c * q * fill(1.0 / (c * q));	// all stage products, summed over the processes
+		double t = 2 * params.alpha * q * lg(q)
+			 + params.beta * word * nnzin / (c * q) * (q - 1) / q
+			 + params.gamma * F / p
+			 + params.merge * stagenz / p * std::max(lg(q), 1.0);
+		if(c > 1)
+		{
+			double layernz = c * fill(1.0 / c);
+			t += params.alpha * (c - 1)
+			   + params.beta * tuple * layernz / p * (c - 1) / c
+			   + params.merge * layernz / p * lg(c);
+			if(params.convertinputs)
+				t += 2 * params.alpha * (p - 1) + params.beta * tuple * nnzin / p;
+			if(params.convertoutput)
+				t += params.alpha * (p - 1) + params.beta * tuple * layout.nnzC / p;
+		}
+		layout.predicted.push_back(t);
+		if(forced > 0)
+		{
+			if(c == forced) layout.layers = c;
+		}
+		else if(t < best)
+		{
+			best = t;
+			layout.layers = c;
+		}
+	}
+	return layout;
+}
+
+/**
+ * C = A*B with the layout chosen by PlanSpGEMMLayout: Mult_AnXBn_Synch on the grid of A for one layer, otherwise the
+ * operands are converted with the SpParMat3D constructors, multiplied by Mult_AnXBn_SUMMA3D and converted back
+ * @param[out] chosen if not NULL, the plan that was executed
+ * @pre { A and B should not alias, have the same types and live on the same square grid }
+ **/
+template <typename SR, typename IU, typename NU, typename DER>
+SpParMat<IU,NU,DER> PlannedSpGEMM(SpParMat<IU,NU,DER> & A, SpParMat<IU,NU,DER> & B, SpGEMMLayout * chosen = NULL,
+				  const SpGEMMLayoutParams & params = SpGEMMLayoutParams())
+{
+	SpGEMMLayout layout = PlanSpGEMMLayout(A, B, params);
+	if(chosen != NULL) *chosen = layout;
+	if(layout.layers == 1)
+		return Mult_AnXBn_Synch<SR, NU, DER>(A, B);
+
+	SpParMat3D<IU,NU,DER> A3D(A, layout.layers, true, false);	// column split
+	SpParMat3D<IU,NU,DER> B3D(B, layout.layers, false, false);	// row split
+	SpParMat3D<IU,NU,DER> C3D = Mult_AnXBn_SUMMA3D<SR, NU, DER, IU, NU, NU, DER, DER>(A3D, B3D);
+	return C3D.Convert2D();
+}
+
+}
+
+#endif
@@ -35,6 +35,9 @@
 #include <limits>
 #include <map>
 #include <string>
+#include <sstream>
+#include <cstdio>
+#include <type_traits>
 #include <utility>
 #include "SpDefs.h"
 #include "StackEntry.h"
@@ -49,6 +52,33 @@ namespace combblas {
 template <class IT, class NT>
 class Dcsc;
 
+//! Types that SpHelper::AppendNumber prints exactly as std::ostream does (characters are printed as characters by streams)
+template <typename NT>
+struct IsFastText
+{
+	static const bool value = std::is_arithmetic<NT>::value && !std::is_same<NT,char>::value
+		&& !std::is_same<NT,signed char>::value && !std::is_same<NT,unsigned char>::value;
+};
+
+/**
+ * Appends the text that handler.save writes for a value to a string, for the text writers
+ * FAST is for arithmetic values saved with the default handler of the library: they are formatted without a stream
+ **/
+template <typename NT, bool FAST>
+class TextValueWriter
+{
+public:
+	template <typename HANDLER, typename... SAVEARGS>
+	void Append(std::string & out, HANDLER & handler, NT & v, SAVEARGS... args)
+	{
+		ss.str(std::string());
+		handler.save(ss, v, args...);
+		out += ss.str();
+	}
+private:
+	std::ostringstream ss;
+};
+
 class SpHelper
 {
 public:
@@ -182,6 +212,149 @@ public:
         lines.clear();
     }
 
+    /**
+     * Allocation-free tokenizers for the multithreaded text readers (ParallelReadMM)
+     * Leading blanks are skipped, p is advanced past the token, false is returned (and p is not moved) if there is no number
+     * Neither function reads past the end of the current line
+     **/
+    static const char * SkipBlanks(const char * p)
+    {
+        while(*p == ' ' || *p == '\t' || *p == '\r') ++p;
+        return p;
+    }
+
+    static bool ParseInteger(const char * & p, int64_t & val)
+    {
+        const char * c = SkipBlanks(p);
+        bool negative = (*c == '-');
+        if(*c == '-' || *c == '+') ++c;
+        if(*c < '0' || *c > '9') return false;
+        uint64_t v = 0;
+        while(*c >= '0' && *c <= '9')
+            v = v * 10 + static_cast<uint64_t>(*c++ - '0');
+        val = negative? -static_cast<int64_t>(v) : static_cast<int64_t>(v);
+        p = c;
+        return true;
+    }
+
+    //! Exact (correctly rounded) when the number has at most 15 significant digits and a decimal exponent in [-22,22], strtod otherwise
+    static bool ParseReal(const char * & p, double & val)
+    {
+        static const double exact10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        const char * start = SkipBlanks(p);
+        const char * c = start;
+        bool negative = (*c == '-');
+        if(*c == '-' || *c == '+') ++c;
+        uint64_t mantissa = 0;
+        int digits = 0;     // significant digits, leading zeros excluded
+        int exp10 = 0;
+        bool any = false;
+        while(*c >= '0' && *c <= '9')
+        {
+            any = true;
+            if(mantissa != 0 || *c != '0')
+            {
+                if(digits < 19) mantissa = mantissa * 10 + static_cast<uint64_t>(*c - '0');
+                else ++exp10;
+                ++digits;
+            }
+            ++c;
+        }
+        if(*c == '.')
+        {
+            ++c;
+            while(*c >= '0' && *c <= '9')
+            {
+                any = true;
+                if(mantissa != 0 || *c != '0')
+                {
+                    if(digits < 19)
+                    {
+                        mantissa = mantissa * 10 + static_cast<uint64_t>(*c - '0');
+                        --exp10;
+                    }
+                    ++digits;
+                }
+                else
+                {
+                    --exp10;
+                }
+                ++c;
+            }
+        }
+        if(any && (*c == 'e' || *c == 'E'))
+        {
+            const char * e = c + 1;
+            bool eneg = (*e == '-');
+            if(*e == '-' || *e == '+') ++e;
+            if(*e >= '0' && *e <= '9')
+            {
+                int ev = 0;
+                while(*e >= '0' && *e <= '9')
+                {
+                    if(ev < 100000) ev = ev * 10 + (*e - '0');
+                    ++e;
+                }
+                exp10 += eneg? -ev : ev;
+                c = e;
+            }
+        }
+        if(any && digits <= 15 && exp10 >= -22 && exp10 <= 22)
+        {
+            double v = static_cast<double>(mantissa);   // exact, since mantissa < 10^15 < 2^53
+            v = (exp10 < 0)? v / exact10[-exp10] : v * exact10[exp10];
+            val = negative? -v : v;
+            p = c;
+            return true;
+        }
+        if(*start == '\n' || *start == '\0') return false;   // strtod would continue on the next line
+        char * end;     // long mantissas, huge exponents, inf and nan
+        double v = strtod(start, &end);
+        if(end == start) return false;
+        val = v;
+        p = end;
+        return true;
+    }
+
+    //! Appends the decimal text of an integer (the same text as std::ostream's) to out, for the text writers
+    template <typename T>
+    static void AppendInteger(std::string & out, T val)
+    {
+        char buf[24];
+        char * p = buf + sizeof(buf);
+        bool negative = std::is_signed<T>::value && (val < static_cast<T>(0));
+        uint64_t v = negative? (0 - static_cast<uint64_t>(val)) : static_cast<uint64_t>(val);
+        do
+        {
+            *--p = static_cast<char>('0' + v % 10);
+            v /= 10;
+        } while(v != 0);
+        if(negative) *--p = '-';
+        out.append(p, buf + sizeof(buf) - p);
+    }
+
+    //! Same text as std::ostream with the default precision (%g)
+    static void AppendReal(std::string & out, double val)
+    {
+        char buf[32];
+        int n = snprintf(buf, sizeof(buf), "%g", val);
+        out.append(buf, n);
+    }
+
+    static void AppendReal(std::string & out, long double val)
+    {
+        char buf[48];
+        int n = snprintf(buf, sizeof(buf), "%Lg", val);
+        out.append(buf, n);
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value>::type AppendNumber(std::string & out, T val) { AppendInteger(out, val); }
+
+    template <typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type AppendNumber(std::string & out, T val) { AppendReal(out, val); }
+
 
 	template <typename T>
 	static const T * p2a (const std::vector<T> & v)   // pointer to array
@@ -253,6 +426,23 @@ public:
 		delete [] array;
 	}
 
+	//! Fingerprint of the sparsity pattern of a local matrix, to detect structural changes without keeping a copy
+	template <typename DER>
+	static uint64_t PatternHash(DER & seq)
+	{
+		uint64_t h = 14695981039346656037ULL;
+		auto mix = [&h](uint64_t x) { h = (h ^ x) * 1099511628211ULL; h ^= h >> 29; };
+		mix(static_cast<uint64_t>(seq.getnnz()));
+		for(typename DER::SpColIter colit = seq.begcol(); colit != seq.endcol(); ++colit)
+		{
+			mix(static_cast<uint64_t>(colit.colid()));
+			mix(static_cast<uint64_t>(colit.nnz()));
+			for(typename DER::SpColIter::NzIter nzit = seq.begnz(colit); nzit < seq.endnz(colit); ++nzit)
+				mix(static_cast<uint64_t>(nzit.rowid()));
+		}
+		return h;
+	}
+
 	
 	template <typename SR, typename NT1, typename NT2, typename IT, typename OVT>
 	static IT Popping(NT1 * numA, NT2 * numB, StackEntry< OVT, std::pair<IT,IT> > * multstack,
@@ -297,6 +487,17 @@ public:
 
 };
 
+template <typename NT>
+class TextValueWriter<NT, true>
+{
+public:
+	template <typename HANDLER, typename... SAVEARGS>
+	void Append(std::string & out, HANDLER &, NT & v, SAVEARGS...)
+	{
+		SpHelper::AppendNumber(out, v);
+	}
+};
+
 
 
 
@@ -275,6 +275,207 @@ std::vector<std::pair<KEY,VAL>> SpParHelper::KeyValuePSort(std::pair<KEY,VAL> *
 }
 
 
+template<typename KEY, typename VAL, typename IT>
+void SpParHelper::LocalRadixPass(const std::pair<KEY,VAL> * in, std::pair<KEY,VAL> * out, IT length, KEY minkey, int shift, int nbuckets, IT * counts)
+{
+	typedef typename std::make_unsigned<KEY>::type UKEY;
+	const UKEY mask = static_cast<UKEY>(nbuckets-1);
+	int numThreads = 1;
+#ifdef THREADED
+#pragma omp parallel
+	{
+		numThreads = omp_get_num_threads();
+	}
+#endif
+	if(length < static_cast<IT>(numThreads) * nbuckets)	numThreads = 1;	// histograms would cost more than the pass itself
+	std::vector<IT> offsets(static_cast<size_t>(numThreads) * nbuckets, 0);	// histogram of each thread's chunk, then its write positions
+
+#ifdef THREADED
+#pragma omp parallel num_threads(numThreads)
+#endif
+	{
+		int myThread = 0;
+		int nthreads = 1;
+#ifdef THREADED
+		myThread = omp_get_thread_num();
+		nthreads = omp_get_num_threads();
+#endif
+		IT begin = (length * myThread) / nthreads;
+		IT end = (length * (myThread+1)) / nthreads;
+		IT * mypos = offsets.data() + static_cast<size_t>(myThread) * nbuckets;
+		for(IT i=begin; i< end; ++i)
+			++mypos[((static_cast<UKEY>(in[i].first) - static_cast<UKEY>(minkey)) >> shift) & mask];
+#ifdef THREADED
+#pragma omp barrier
+#pragma omp single
+#endif
+		{
+			IT running = 0;
+			for(int b=0; b< nbuckets; ++b)
+			{
+				IT bucketstart = running;
+				for(int t=0; t< nthreads; ++t)
+				{
+					IT cnt = offsets[static_cast<size_t>(t) * nbuckets + b];
+					offsets[static_cast<size_t>(t) * nbuckets + b] = running;
+					running += cnt;
+				}
+				counts[b] = running - bucketstart;
+			}
+		}
+		for(IT i=begin; i< end; ++i)	// threads write disjoint ranges in chunk order, hence stable
+			out[mypos[((static_cast<UKEY>(in[i].first) - static_cast<UKEY>(minkey)) >> shift) & mask]++] = in[i];
+	}
+}
+
+
+/**
+ * Every pass is a stable counting sort of the global sequence on one digit of (key - global minimum):
+ * the local entries are bucketed, the global position of each bucket follows from an allreduce and an exscan
+ * of the histograms, entries go straight to the owner of their position (no splitters, no communicator splitting)
+ * and the receiver restores the position order with another local counting pass over what it got
+ * The digit width adapts to the key range so that keys spanning b bits need ceil(b/16) all-to-alls
+ **/
+template<typename KEY, typename VAL, typename IT>
+void SpParHelper::RadixPSort(std::pair<KEY,VAL> * array, IT length, IT * dist, const MPI_Comm & comm)
+{
+	typedef typename std::make_unsigned<KEY>::type UKEY;
+	const int MAXDIGITBITS = 16;
+	int nprocs, myrank;
+	MPI_Comm_size(comm, &nprocs);
+	MPI_Comm_rank(comm, &myrank);
+
+	KEY minkey = std::numeric_limits<KEY>::max();
+	KEY maxkey = std::numeric_limits<KEY>::min();
+	for(IT i=0; i< length; ++i)
+	{
+		minkey = std::min(minkey, array[i].first);
+		maxkey = std::max(maxkey, array[i].first);
+	}
+	MPI_Allreduce(MPI_IN_PLACE, &minkey, 1, MPIType<KEY>(), MPI_MIN, comm);
+	MPI_Allreduce(MPI_IN_PLACE, &maxkey, 1, MPIType<KEY>(), MPI_MAX, comm);
+	if(minkey >= maxkey)	return;	// empty, or all keys equal: stability means nothing moves
+
+	UKEY range = static_cast<UKEY>(maxkey) - static_cast<UKEY>(minkey);
+	int bits = 0;
+	while(bits < std::numeric_limits<UKEY>::digits && (range >> bits) != 0)	++bits;
+	int passes = (bits + MAXDIGITBITS - 1) / MAXDIGITBITS;
+	int digitbits = (bits + passes - 1) / passes;
+	int nbuckets = 1 << digitbits;
+
+	std::vector<IT> distprefix(nprocs+1, 0);
+	std::partial_sum(dist, dist+nprocs, distprefix.begin()+1);
+	std::vector<IT> counts(nbuckets), before(nbuckets), total(nbuckets);
+	int * sendcnt = new int[nprocs];
+	int * sdispls = new int[nprocs]();
+	int * recvcnt = new int[nprocs];
+	int * rdispls = new int[nprocs]();
+
+	MPI_Datatype MPI_pairType;
+	MPI_Type_contiguous(sizeof(std::pair<KEY,VAL>), MPI_CHAR, &MPI_pairType);
+	MPI_Type_commit(&MPI_pairType);
+
+	std::pair<KEY,VAL> * tmp = new std::pair<KEY,VAL>[length];
+	std::pair<KEY,VAL> * src = array;	// current data
+	std::pair<KEY,VAL> * dst = tmp;
+	for(int shift = 0; shift < bits; shift += digitbits)
+	{
+		LocalRadixPass(src, dst, length, minkey, shift, nbuckets, counts.data());
+		if(nprocs > 1)
+		{
+			MPI_Exscan(counts.data(), before.data(), nbuckets, MPIType<IT>(), MPI_SUM, comm);
+			if(myrank == 0)	std::fill(before.begin(), before.end(), static_cast<IT>(0));
+			MPI_Allreduce(counts.data(), total.data(), nbuckets, MPIType<IT>(), MPI_SUM, comm);
+
+			// global positions increase along the locally bucketed data, so the send buffer is dst itself
+			std::fill_n(sendcnt, nprocs, 0);
+			IT bucketstart = 0;
+			int owner = 0;
+			for(int b=0; b< nbuckets; ++b)
+			{
+				IT lo = bucketstart + before[b];
+				IT hi = lo + counts[b];
+				bucketstart += total[b];
+				while(lo < hi)
+				{
+					while(distprefix[owner+1] <= lo)	++owner;
+					IT upto = std::min(hi, distprefix[owner+1]);
+					sendcnt[owner] += static_cast<int>(upto - lo);
+					lo = upto;
+				}
+			}
+			MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, comm);
+			std::partial_sum(sendcnt, sendcnt+nprocs-1, sdispls+1);
+			std::partial_sum(recvcnt, recvcnt+nprocs-1, rdispls+1);
+			assert(rdispls[nprocs-1] + recvcnt[nprocs-1] == length);
+			MPI_Alltoallv(dst, sendcnt, sdispls, MPI_pairType, src, recvcnt, rdispls, MPI_pairType, comm);
+
+			// received pieces are in rank order, bucketing them again (stably) puts them in global position order
+			LocalRadixPass(src, dst, length, minkey, shift, nbuckets, counts.data());
+		}
+		std::swap(src, dst);
+	}
+	if(src != array)	std::copy(src, src+length, array);
+
+	delete [] tmp;
+	DeleteAll(sendcnt, sdispls, recvcnt, rdispls);
+	MPI_Type_free(&MPI_pairType);
+}
+
+
+template<typename KEY, typename VAL, typename IT>
+void SpParHelper::PSortByKey(std::pair<KEY,VAL> * array, IT length, IT * dist, const MPI_Comm & comm)
+{
+	PSortByKey(array, length, dist, comm, std::integral_constant<bool, std::is_integral<KEY>::value && !std::is_same<KEY,bool>::value>());
+}
+
+template<typename KEY, typename VAL, typename IT>
+void SpParHelper::PSortByKey(std::pair<KEY,VAL> * array, IT length, IT * dist, const MPI_Comm & comm, std::true_type)
+{
+	RadixPSort(array, length, dist, comm);
+}
+
+template<typename KEY, typename VAL, typename IT>
+void SpParHelper::PSortByKey(std::pair<KEY,VAL> * array, IT length, IT * dist, const MPI_Comm & comm, std::false_type)
+{
+	MemoryEfficientPSort(array, length, dist, comm);
+}
+
+
+template<typename T, typename IT>
+void SpParHelper::RebalanceOrdered(const T * in, IT length, T * out, const IT * newdist, MPI_Datatype datatype, const MPI_Comm & comm)
+{
+	int nprocs, myrank;
+	MPI_Comm_size(comm, &nprocs);
+	MPI_Comm_rank(comm, &myrank);
+
+	IT first = 0;
+	MPI_Exscan(&length, &first, 1, MPIType<IT>(), MPI_SUM, comm);
+	if(myrank == 0)	first = 0;
+	std::vector<IT> distprefix(nprocs+1, 0);
+	std::partial_sum(newdist, newdist+nprocs, distprefix.begin()+1);
+
+	int * sendcnt = new int[nprocs]();
+	int * sdispls = new int[nprocs]();
+	int * recvcnt = new int[nprocs];
+	int * rdispls = new int[nprocs]();
+	IT lo = first;
+	int owner = static_cast<int>(std::upper_bound(distprefix.begin(), distprefix.end(), lo) - distprefix.begin()) - 1;
+	while(lo < first + length)
+	{
+		while(distprefix[owner+1] <= lo)	++owner;
+		IT upto = std::min(first + length, distprefix[owner+1]);
+		sendcnt[owner] = static_cast<int>(upto - lo);
+		lo = upto;
+	}
+	MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, comm);
+	std::partial_sum(sendcnt, sendcnt+nprocs-1, sdispls+1);
+	std::partial_sum(recvcnt, recvcnt+nprocs-1, rdispls+1);
+	MPI_Alltoallv(const_cast<T*>(in), sendcnt, sdispls, datatype, out, recvcnt, rdispls, datatype, comm);
+	DeleteAll(sendcnt, sdispls, recvcnt, rdispls);
+}
+
+
 template<typename KEY, typename VAL, typename IT>
 void SpParHelper::GlobalSelect(IT gl_rank, std::pair<KEY,VAL> * & low,  std::pair<KEY,VAL> * & upp, std::pair<KEY,VAL> * array, IT length, const MPI_Comm & comm)
 {
@@ -930,6 +1131,115 @@ inline bool SpParHelper::FetchBatch(MPI_File & infile, MPI_Offset & curpos, MPI_
 }
 
 
+/**
+ * Writes the nrecords local text records of every process in rank order, preceded by header (only used on process 0)
+ * format(begin, end, out) appends the text of local records [begin,end) to out; it is called concurrently by all threads on disjoint ranges
+ * Memory is bounded: records are formatted in chunks, the first pass keeps the chunks that fit in the budget and only
+ * measures the rest (so that every process knows its offset in the file), which are formatted again when they are written
+ * Every chunk is written with MPI_File_write_at_all
+ * @param[in] chunkrecords records per chunk (split among the threads)
+ * @param[in] keepbudget bytes of formatted text kept from the first pass
+ **/
+template <typename FORMATTER>
+void SpParHelper::WriteTextRecords(const std::string & filename, const std::string & header, int64_t nrecords, FORMATTER & format, MPI_Comm comm,
+				int64_t chunkrecords, int64_t keepbudget)
+{
+	int myrank;
+	MPI_Comm_rank(comm, &myrank);
+
+	int numThreads = 1;
+#ifdef THREADED
+#pragma omp parallel
+	{
+		numThreads = omp_get_num_threads();
+	}
+#endif
+	std::vector<std::string> threadtext(numThreads);
+	auto formatchunk = [&](int64_t begin, int64_t end, std::string & chunk)
+	{
+#ifdef THREADED
+#pragma omp parallel for schedule(static,1)
+#endif
+		for(int t=0; t< numThreads; ++t)
+		{
+			threadtext[t].clear();
+			format(begin + (end-begin) * t / numThreads, begin + (end-begin) * (t+1) / numThreads, threadtext[t]);
+		}
+		size_t chunkbytes = 0;
+		for(int t=0; t< numThreads; ++t)
+			chunkbytes += threadtext[t].size();
+		chunk.clear();
+		chunk.reserve(chunkbytes);
+		for(int t=0; t< numThreads; ++t)
+			chunk += threadtext[t];
+	};
+
+	int64_t nchunks = (nrecords + chunkrecords - 1) / chunkrecords;
+	std::vector<int64_t> chunkbytes(nchunks);
+	std::vector<std::string> kept;	// a prefix of the chunks
+	int64_t keptbytes = 0;
+	std::string chunk;
+	for(int64_t c=0; c< nchunks; ++c)
+	{
+		formatchunk(c * chunkrecords, std::min(nrecords, (c+1) * chunkrecords), chunk);
+		chunkbytes[c] = chunk.size();
+		if(static_cast<int64_t>(kept.size()) == c && keptbytes + chunkbytes[c] <= keepbudget)
+		{
+			keptbytes += chunkbytes[c];
+			kept.push_back(std::move(chunk));
+			chunk = std::string();
+		}
+	}
+
+	int64_t localbytes = std::accumulate(chunkbytes.begin(), chunkbytes.end(), static_cast<int64_t>(0));
+	if(myrank == 0) localbytes += header.size();
+	int64_t bytesuntil = 0;
+	MPI_Exscan(&localbytes, &bytesuntil, 1, MPIType<int64_t>(), MPI_SUM, comm);
+	if(myrank == 0) bytesuntil = 0;	// because MPI_Exscan says the recvbuf in process 0 is undefined
+	int64_t bytestotal, maxchunks;
+	MPI_Allreduce(&localbytes, &bytestotal, 1, MPIType<int64_t>(), MPI_SUM, comm);
+	MPI_Allreduce(&nchunks, &maxchunks, 1, MPIType<int64_t>(), MPI_MAX, comm);
+
+	MPI_File thefile;
+	if(MPI_File_open(comm, (char*) filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &thefile) != MPI_SUCCESS)
+	{
+		printf("COMBBLAS: Output file %s failed to open at process %d\n", filename.c_str(), myrank);
+		MPI_Abort(comm, NOFILE);
+	}
+	MPI_File_set_size(thefile, bytestotal);	// truncates a previous (larger) file
+	MPI_Offset offset = bytesuntil;
+	MPI_Status status;
+	if(myrank == 0 && !header.empty())
+	{
+		MPI_File_write_at(thefile, offset, (char*) header.c_str(), header.size(), MPI_CHAR, &status);
+		offset += header.size();
+	}
+	for(int64_t c=0; c< maxchunks; ++c)	// the same number of collective calls on every process
+	{
+		const std::string * text = &chunk;
+		if(c < static_cast<int64_t>(kept.size()))
+		{
+			text = &kept[c];
+		}
+		else if(c < nchunks)
+		{
+			formatchunk(c * chunkrecords, std::min(nrecords, (c+1) * chunkrecords), chunk);
+			assert(static_cast<int64_t>(chunk.size()) == chunkbytes[c]);
+		}
+		else
+		{
+			chunk.clear();
+		}
+		assert(text->size() < static_cast<size_t>(std::numeric_limits<int>::max()));
+		MPI_File_write_at_all(thefile, offset, (char*) text->data(), static_cast<int>(text->size()), MPI_CHAR, &status);
+		offset += text->size();
+		if(c < static_cast<int64_t>(kept.size()))
+			std::string().swap(kept[c]);
+	}
+	MPI_File_close(&thefile);
+}
+
+
 inline void SpParHelper::WaitNFree(std::vector<MPI_Win> & arrwin)
 {
 	// End the exposure epochs for the arrays of the local matrices A and B
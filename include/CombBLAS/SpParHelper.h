@@ -36,6 +36,7 @@
 
 #include <vector>
 #include <array>
+#include <type_traits>
 #include <mpi.h>
 #include "LocArr.h"
 #include "CommGrid.h"
@@ -70,7 +71,31 @@ public:
 
     	template<typename KEY, typename VAL, typename IT>
     	static std::vector<std::pair<KEY,VAL>> KeyValuePSort(std::pair<KEY,VAL> * array, IT length, IT * dist, const MPI_Comm & comm);
-	
+
+	// Stable LSD radix sort on integral keys: one histogram reduction and one splitter-free all-to-all per digit
+	// Ties keep their global input order (rank, then local position), so when the values increase in that order
+	// the result is the same as MemoryEfficientPSort's; process i holds dist[i] entries on return
+	template<typename KEY, typename VAL, typename IT>
+	static void RadixPSort(std::pair<KEY,VAL> * array, IT length, IT * dist, const MPI_Comm & comm);
+
+	// RadixPSort for integral keys, MemoryEfficientPSort otherwise
+	template<typename KEY, typename VAL, typename IT>
+	static void PSortByKey(std::pair<KEY,VAL> * array, IT length, IT * dist, const MPI_Comm & comm);
+
+	template<typename KEY, typename VAL, typename IT>
+	static void PSortByKey(std::pair<KEY,VAL> * array, IT length, IT * dist, const MPI_Comm & comm, std::true_type isintegral);
+
+	template<typename KEY, typename VAL, typename IT>
+	static void PSortByKey(std::pair<KEY,VAL> * array, IT length, IT * dist, const MPI_Comm & comm, std::false_type isintegral);
+
+	// Stable (threaded) counting sort of in[0,length) by the digit ((key-minkey) >> shift) % nbuckets into out, bucket sizes into counts
+	template<typename KEY, typename VAL, typename IT>
+	static void LocalRadixPass(const std::pair<KEY,VAL> * in, std::pair<KEY,VAL> * out, IT length, KEY minkey, int shift, int nbuckets, IT * counts);
+
+	// Moves a sequence ordered by (rank, local position) so that process i holds newdist[i] of its entries, keeping the order
+	template<typename T, typename IT>
+	static void RebalanceOrdered(const T * in, IT length, T * out, const IT * newdist, MPI_Datatype datatype, const MPI_Comm & comm);
+
 	template<typename KEY, typename VAL, typename IT>
 	static void DebugPrintKeys(std::pair<KEY,VAL> * array, IT length, IT * dist, MPI_Comm & World);
 
@@ -109,6 +134,9 @@ public:
     	static void PrintFile(const std::string & s, const std::string & filename, MPI_Comm & world);
     	static void check_newline(int *bytes_read, int bytes_requested, char *buf);
    	static bool FetchBatch(MPI_File & infile, MPI_Offset & curpos, MPI_Offset end_fpos, bool firstcall, std::vector<std::string> & lines, int myrank);
+	template <typename FORMATTER>
+	static void WriteTextRecords(const std::string & filename, const std::string & header, int64_t nrecords, FORMATTER & format, MPI_Comm comm,
+				int64_t chunkrecords = (1 << 20), int64_t keepbudget = (256 * 1024 * 1024));
     
 	static void WaitNFree(std::vector<MPI_Win> & arrwin);
 	static void FreeWindows(std::vector<MPI_Win> & arrwin);
@@ -37,12 +37,15 @@ extern "C" {
 }
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <mpi.h>
 #include <fstream>
 #include <algorithm>
 #include <set>
 #include <stdexcept>
+#include <type_traits>
 
 namespace combblas {
 
@@ -712,6 +715,232 @@ void SpParMat< IT,NT,DER >::ParallelBinaryWrite(std::string filename) const
        delete [] localdata;
 }
 
+template <class IT, class NT, class DER>
+void SpParMat< IT,NT,DER >::SaveCheckpoint(const std::string & filename) const
+{
+	typedef typename DER::LocalIT LIT;
+	int myrank = commGrid->GetRank();
+	int nprocs = commGrid->GetSize();
+	IT totalm = getnrow();
+	IT totaln = getncol();
+	IT totnnz = getnnz();
+
+	// a local matrix split by ActivateThreading has its nonzeros in several DCSC pieces, not in GetDCSC()
+	int localsplit = (spSeq->getnsplit() > 0);
+	int anysplit;
+	MPI_Allreduce(&localsplit, &anysplit, 1, MPI_INT, MPI_LOR, commGrid->GetWorld());
+	if(anysplit)
+	{
+		SpParHelper::Print("SaveCheckpoint does not support split (multithreaded) local matrices\n");
+		MPI_Abort(MPI_COMM_WORLD, INVALIDPARAMS);
+	}
+
+	CheckpointBlock myblock;
+	myblock.nnz = spSeq->getnnz();
+	myblock.nzc = (myblock.nnz > 0)? spSeq->GetDCSC()->nzc : 0;
+	myblock.nrow = spSeq->getnrow();
+	myblock.ncol = spSeq->getncol();
+	IT roffset = 0;
+	IT coffset = 0;
+	GetPlaceInGlobalGrid(roffset, coffset);
+	myblock.roffset = roffset;
+	myblock.coffset = coffset;
+
+	uint64_t sections[4];
+	uint64_t blockbytes = CheckpointSections<LIT,NT>(myblock.nnz, myblock.nzc, sections);
+	uint64_t dataoffset = CheckpointRoundUp(sizeof(CheckpointHeader) + nprocs * sizeof(CheckpointBlock), CHECKPOINTALIGN);
+	uint64_t bytesuntil = 0;
+	MPI_Exscan(&blockbytes, &bytesuntil, 1, MPIType<uint64_t>(), MPI_SUM, commGrid->GetWorld());
+	if(myrank == 0) bytesuntil = 0;    // because MPI_Exscan says the recvbuf in process 0 is undefined
+	uint64_t bytestotal;
+	MPI_Allreduce(&blockbytes, &bytestotal, 1, MPIType<uint64_t>(), MPI_SUM, commGrid->GetWorld());
+	myblock.offset = dataoffset + bytesuntil;
+
+	std::vector<CheckpointBlock> blocks(myrank == 0? nprocs : 0);
+	MPI_Gather(&myblock, sizeof(CheckpointBlock), MPI_CHAR, blocks.data(), sizeof(CheckpointBlock), MPI_CHAR, 0, commGrid->GetWorld());
+
+	MPI_File thefile;
+	MPI_File_open(commGrid->GetWorld(), (char*) filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &thefile);
+	MPI_File_set_size(thefile, dataoffset + bytestotal);	// truncates a previous (larger) checkpoint
+	auto writebytes = [&thefile](uint64_t offset, const void * data, uint64_t bytes)
+	{
+		const uint64_t batchSize = 256 * 1024 * 1024;	// keep counts in int range
+		const char * ptr = static_cast<const char*>(data);
+		for(uint64_t written = 0; written < bytes; written += batchSize)
+		{
+			MPI_Status status;
+			int curBatch = static_cast<int>(std::min(batchSize, bytes - written));
+			MPI_File_write_at(thefile, offset + written, ptr + written, curBatch, MPI_CHAR, &status);
+		}
+	};
+	if(myrank == 0)
+	{
+		CheckpointHeader hdr;
+		std::memcpy(hdr.magic, "CBCK", 4);
+		hdr.version = CHECKPOINTVERSION;
+		hdr.itsize = sizeof(LIT);
+		hdr.ntsize = sizeof(NT);
+		hdr.m = totalm;
+		hdr.n = totaln;
+		hdr.nnz = totnnz;
+		hdr.gridrows = commGrid->GetGridRows();
+		hdr.gridcols = commGrid->GetGridCols();
+		writebytes(0, &hdr, sizeof(hdr));
+		writebytes(sizeof(hdr), blocks.data(), nprocs * sizeof(CheckpointBlock));
+	}
+	if(myblock.nnz > 0)
+	{
+		Dcsc<LIT,NT> * dcsc = spSeq->GetDCSC();
+		writebytes(myblock.offset + sections[0], dcsc->jc, myblock.nzc * sizeof(LIT));
+		writebytes(myblock.offset + sections[1], dcsc->cp, (myblock.nzc+1) * sizeof(LIT));
+		writebytes(myblock.offset + sections[2], dcsc->ir, myblock.nnz * sizeof(LIT));
+		writebytes(myblock.offset + sections[3], dcsc->numx, myblock.nnz * sizeof(NT));
+	}
+	MPI_File_close(&thefile);
+}
+
+
+template <class IT, class NT, class DER>
+void SpParMat< IT,NT,DER >::LoadCheckpoint(const std::string & filename)
+{
+	typedef typename DER::LocalIT LIT;
+	int myrank = commGrid->GetRank();
+
+	// the index is read by a single process
+	CheckpointHeader hdr;
+	std::vector<CheckpointBlock> blocks;
+	int errcode = 0;
+	if(myrank == 0)
+	{
+		FILE * f = fopen(filename.c_str(), "rb");
+		if(!f)
+			errcode = NOFILE;
+		else
+		{
+			if(fread(&hdr, sizeof(hdr), 1, f) != 1 || std::strncmp(hdr.magic, "CBCK", 4) != 0 || hdr.version != CHECKPOINTVERSION)
+				errcode = NOFILE;
+			else if(hdr.itsize != sizeof(LIT) || hdr.ntsize != sizeof(NT))
+				errcode = INVALIDPARAMS;
+			else
+			{
+				blocks.resize(hdr.gridrows * hdr.gridcols);
+				if(fread(blocks.data(), sizeof(CheckpointBlock), blocks.size(), f) != blocks.size())
+					errcode = NOFILE;
+			}
+			fclose(f);
+		}
+	}
+	MPI_Bcast(&errcode, 1, MPI_INT, 0, commGrid->GetWorld());
+	if(errcode == NOFILE)
+	{
+		SpParHelper::Print("Checkpoint " + filename + " does not exist or is not a valid checkpoint\n");
+		MPI_Abort(MPI_COMM_WORLD, NOFILE);
+	}
+	else if(errcode == INVALIDPARAMS)
+	{
+		SpParHelper::Print("Checkpoint " + filename + " was written with different index or value types\n");
+		MPI_Abort(MPI_COMM_WORLD, INVALIDPARAMS);
+	}
+	MPI_Bcast(&hdr, sizeof(hdr), MPI_CHAR, 0, commGrid->GetWorld());
+	blocks.resize(hdr.gridrows * hdr.gridcols);
+	MPI_Bcast(blocks.data(), blocks.size() * sizeof(CheckpointBlock), MPI_CHAR, 0, commGrid->GetWorld());
+
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		std::cerr << "Process " << myrank << " can not open checkpoint " << filename << std::endl;
+		MPI_Abort(MPI_COMM_WORLD, NOFILE);
+	}
+	uint64_t sections[4];
+	DER * loaded;
+	int gridrows = commGrid->GetGridRows();
+	int gridcols = commGrid->GetGridCols();
+	if(hdr.gridrows == static_cast<uint64_t>(gridrows) && hdr.gridcols == static_cast<uint64_t>(gridcols))
+	{
+		// same distribution: block number myrank is exactly my local matrix
+		const CheckpointBlock & block = blocks[myrank];
+		loaded = new DER(block.nnz, block.nrow, block.ncol, block.nzc);
+		if(block.nnz > 0)
+		{
+			CheckpointSections<LIT,NT>(block.nnz, block.nzc, sections);
+			MappedFileRange mapped(fd, block.offset, sections[3] + block.nnz * sizeof(NT), true);
+			if(mapped.data == NULL)
+			{
+				std::cerr << "Process " << myrank << " can not map its block of " << filename << std::endl;
+				MPI_Abort(MPI_COMM_WORLD, NOFILE);
+			}
+			Dcsc<LIT,NT> * dcsc = loaded->GetDCSC();
+			std::memcpy(dcsc->jc, mapped.data + sections[0], block.nzc * sizeof(LIT));
+			std::memcpy(dcsc->cp, mapped.data + sections[1], (block.nzc+1) * sizeof(LIT));
+			std::memcpy(dcsc->ir, mapped.data + sections[2], block.nnz * sizeof(LIT));
+			std::memcpy(dcsc->numx, mapped.data + sections[3], block.nnz * sizeof(NT));
+		}
+	}
+	else
+	{
+		// different grid: cut my block out of every old block it overlaps (binary search over the nonzero columns)
+		int myprocrow = commGrid->GetRankInProcCol();
+		int myproccol = commGrid->GetRankInProcRow();
+		uint64_t m_perproc = hdr.m / gridrows;
+		uint64_t n_perproc = hdr.n / gridcols;
+		uint64_t rbegin = myprocrow * m_perproc;
+		uint64_t rend = (myprocrow != gridrows-1)? rbegin + m_perproc : hdr.m;
+		uint64_t cbegin = myproccol * n_perproc;
+		uint64_t cend = (myproccol != gridcols-1)? cbegin + n_perproc : hdr.n;
+
+		std::vector< std::tuple<LIT,LIT,NT> > kept;
+		for(size_t b = 0; b < blocks.size(); ++b)
+		{
+			const CheckpointBlock & block = blocks[b];
+			if(block.nnz == 0 || block.roffset >= rend || block.roffset + block.nrow <= rbegin
+			   || block.coffset >= cend || block.coffset + block.ncol <= cbegin)
+				continue;
+			CheckpointSections<LIT,NT>(block.nnz, block.nzc, sections);
+			MappedFileRange mapped(fd, block.offset, sections[3] + block.nnz * sizeof(NT), false);
+			if(mapped.data == NULL)
+			{
+				std::cerr << "Process " << myrank << " can not map block " << b << " of " << filename << std::endl;
+				MPI_Abort(MPI_COMM_WORLD, NOFILE);
+			}
+			const LIT * jc = reinterpret_cast<const LIT*>(mapped.data + sections[0]);
+			const LIT * cp = reinterpret_cast<const LIT*>(mapped.data + sections[1]);
+			const LIT * ir = reinterpret_cast<const LIT*>(mapped.data + sections[2]);
+			const NT * numx = reinterpret_cast<const NT*>(mapped.data + sections[3]);
+
+			LIT collo = static_cast<LIT>((cbegin > block.coffset)? cbegin - block.coffset : 0);
+			LIT colhi = static_cast<LIT>(std::min(cend - block.coffset, block.ncol));
+			const LIT * first = std::lower_bound(jc, jc + block.nzc, collo);
+			const LIT * last = std::lower_bound(first, jc + block.nzc, colhi);
+			for(const LIT * j = first; j != last; ++j)
+			{
+				LIT newcol = static_cast<LIT>(block.coffset + *j - cbegin);
+				for(LIT k = cp[j-jc]; k < cp[j-jc+1]; ++k)
+				{
+					uint64_t globalrow = block.roffset + ir[k];
+					if(globalrow >= rbegin && globalrow < rend)
+						kept.push_back(std::make_tuple(static_cast<LIT>(globalrow - rbegin), newcol, numx[k]));
+				}
+			}
+		}
+		if(kept.empty())
+		{
+			loaded = new DER(0, static_cast<LIT>(rend-rbegin), static_cast<LIT>(cend-cbegin), 0);
+		}
+		else
+		{
+			int64_t keptnnz = kept.size();
+			std::tuple<LIT,LIT,NT> * tuples = new std::tuple<LIT,LIT,NT>[keptnnz];
+			std::copy(kept.begin(), kept.end(), tuples);
+			std::vector< std::tuple<LIT,LIT,NT> >().swap(kept);
+			SpTuples<LIT,NT> spTuples(keptnnz, static_cast<LIT>(rend-rbegin), static_cast<LIT>(cend-cbegin), tuples);	// sorts, owns tuples
+			loaded = new DER(spTuples, false);
+		}
+	}
+	close(fd);
+	delete spSeq;
+	spSeq = loaded;
+}
+
 template <class IT, class NT, class DER>
 SpParMat< IT,NT,DER >::SpParMat (const SpParMat< IT,NT,DER > & rhs)
 {
@@ -955,6 +1184,24 @@ void SpParMat<IT,NT,DER>::Reduce(FullyDistVec<GIT,VT> & rvec, Dim dim, _BinaryOp
     Reduce(rvec, dim, __binary_op, id, __unary_op, MPIOp<_BinaryOperation, VT>::op() );
 }
 
+template <class IT, class NT, class DER>
+template <typename SR, typename VT, typename GIT>
+void SpParMat<IT,NT,DER>::Reduce(FullyDistVec<GIT,VT> & rvec, Dim dim, VT id) const
+{
+	Reduce<SR>(rvec, dim, id, myidentity<NT>() );
+}
+
+/**
+ * Reduce with the addition of semiring SR, e.g. A.Reduce<MinDistParentSRing>(rvec, Column, MinDistParentSRing::id(), f)
+ * Partial results are combined by SRingMPIOp<SR,VT>::op(), so any SR works without its own MPIOp specialization
+ **/
+template <class IT, class NT, class DER>
+template <typename SR, typename VT, typename GIT, typename _UnaryOperation>
+void SpParMat<IT,NT,DER>::Reduce(FullyDistVec<GIT,VT> & rvec, Dim dim, VT id, _UnaryOperation __unary_op) const
+{
+	Reduce(rvec, dim, SRingAddOp<SR,VT>(), id, __unary_op, SRingMPIOp<SR,VT>::op() );
+}
+
 
 template <class IT, class NT, class DER>
 template <typename VT, typename GIT, typename _BinaryOperation, typename _UnaryOperation>	// GIT: global index type of vector
@@ -1106,6 +1353,59 @@ void SpParMat<IT,NT,DER>::Reduce(FullyDistVec<GIT,VT> & rvec, Dim dim, _BinaryOp
 	}
 }
 
+/**
+ * Same data movement as Reduce(Column), but the local part of the reduction is given:
+ * localcolvals has one entry per local column. Result rvec is distributed exactly like Reduce(Column)
+ **/
+template <class IT, class NT, class DER>
+template <typename VT, typename GIT, typename _BinaryOperation>
+void SpParMat<IT,NT,DER>::ReduceLocalColumns(FullyDistVec<GIT,VT> & rvec, const std::vector<VT> & localcolvals, _BinaryOperation) const
+{
+	if(*rvec.commGrid != *commGrid)
+	{
+		SpParHelper::Print("Grids are not comparable, SpParMat::ReduceLocalColumns() fails!", commGrid->GetWorld());
+		MPI_Abort(MPI_COMM_WORLD,GRIDMISMATCH);
+	}
+	IT n_thiscol = getlocalcols();   // length assigned to this processor column
+	int colneighs = commGrid->GetGridRows();	// including oneself
+	int colrank = commGrid->GetRankInProcCol();
+
+	GIT * loclens = new GIT[colneighs];
+	GIT * lensums = new GIT[colneighs+1]();	// begin/end points of local lengths
+
+	GIT n_perproc = n_thiscol / colneighs;    // length on a typical processor
+	if(colrank == colneighs-1)
+		loclens[colrank] = n_thiscol - (n_perproc*colrank);
+	else
+		loclens[colrank] = n_perproc;
+
+	MPI_Allgather(MPI_IN_PLACE, 0, MPIType<GIT>(), loclens, 1, MPIType<GIT>(), commGrid->GetColWorld());
+	std::partial_sum(loclens, loclens+colneighs, lensums+1);
+
+	std::vector<VT> trarr;
+	for(int i=0; i< colneighs; ++i)
+	{
+		VT * recvbuf = NULL;
+		if(colrank == i)
+		{
+			trarr.resize(loclens[i]);
+			recvbuf = SpHelper::p2a(trarr);
+		}
+		MPI_Reduce(localcolvals.data() + lensums[i], recvbuf, loclens[i], MPIType<VT>(), MPIOp<_BinaryOperation, VT>::op(), i, commGrid->GetColWorld()); // root  = i
+	}
+	DeleteAll(loclens, lensums);
+
+	GIT reallen;	// Now we have to transpose the vector
+	GIT trlen = trarr.size();
+	int diagneigh = commGrid->GetComplementRank();
+	MPI_Status status;
+	MPI_Sendrecv(&trlen, 1, MPIType<IT>(), diagneigh, TRNNZ, &reallen, 1, MPIType<IT>(), diagneigh, TRNNZ, commGrid->GetWorld(), &status);
+
+	rvec.arr.resize(reallen);
+	MPI_Sendrecv(SpHelper::p2a(trarr), trlen, MPIType<VT>(), diagneigh, TRX, SpHelper::p2a(rvec.arr), reallen, MPIType<VT>(), diagneigh, TRX, commGrid->GetWorld(), &status);
+	rvec.glen = getncol();
+}
+
 #ifndef KSELECTLIMIT
 #define KSELECTLIMIT 10000
 #endif
@@ -1283,7 +1583,7 @@ bool SpParMat<IT,NT,DER>::Kselect1(FullyDistVec<GIT,VT> & rvec, IT k, _UnaryOper
     int colneighs = commGrid->GetGridRows();
     int colrank = commGrid->GetRankInProcCol();
     
-    for(int p=2; p <= colneighs; p*=2)
+    for(int p=2; p/2 < colneighs; p*=2)   // up to the next power of two, or the last rows of a non-power-of-two column are never merged
     {
        
         if(colrank%p == p/2) // this processor is a sender in this round
@@ -1578,7 +1878,7 @@ bool SpParMat<IT,NT,DER>::Kselect1(FullyDistSpVec<GIT,VT> & rvec, IT k, _UnaryOp
     
    // Put a barrier and then print sth 
     
-    for(int p=2; p <= colneighs; p*=2)
+    for(int p=2; p/2 < colneighs; p*=2)   // up to the next power of two, or the last rows of a non-power-of-two column are never merged
     {
         
         if(colrank%p == p/2) // this processor is a sender in this round
@@ -1856,6 +2156,14 @@ void SpParMat<IT,NT,DER>::MaskedReduce(FullyDistVec<GIT,VT> & rvec, FullyDistSpV
     MaskedReduce(rvec, mask, dim, __binary_op, id, myidentity<NT>(), exclude);
 }
 
+//! MaskedReduce with the addition of semiring SR, partial results are combined by SRingMPIOp<SR,VT>::op()
+template <class IT, class NT, class DER>
+template <typename SR, typename VT, typename GIT>
+void SpParMat<IT,NT,DER>::MaskedReduce(FullyDistVec<GIT,VT> & rvec, FullyDistSpVec<GIT,VT> & mask, Dim dim, VT id, bool exclude) const
+{
+    MaskedReduce(rvec, mask, dim, SRingAddOp<SR,VT>(), id, exclude);	// MPIOp<SRingAddOp<SR,VT>,VT> is SRingMPIOp<SR,VT>
+}
+
 /**
  * Reduce along the column into a vector
  * @param[in] mask {A sparse vector indicating row indices included/excluded (based on exclude argument) in the reduction }
@@ -2016,12 +2324,236 @@ SpParMat<IT,NT,DER> SpParMat<IT,NT,DER>::SubsRefCol (const std::vector<IT> & ci)
 	return SpParMat<IT,NT,DER> (tempseq, commGrid);	
 } 
 
+/**
+ * Inverts the index vector v over the local rows (dim == Row) or columns (dim == Column):
+ * the positions k of v with v[k] equal to the i'th local row end up in tpos[tptr[i]] ... tpos[tptr[i+1]-1].
+ * Every value is routed to its processor row (column) and the pieces are then shared along it.
+ * If v is a permutation, tptr is left empty and tpos[i] is the only position selecting the i'th local row (column)
+ */
+template <class IT, class NT, class DER>
+bool SpParMat<IT,NT,DER>::InvertIndex(const FullyDistVec<IT,IT> & v, Dim dim, std::vector<IT> & tptr, std::vector<IT> & tpos) const
+{
+	MPI_Comm routeworld = (dim == Row) ? commGrid->GetColWorld() : commGrid->GetRowWorld();	// owners of different rows (columns)
+	MPI_Comm shareworld = (dim == Row) ? commGrid->GetRowWorld() : commGrid->GetColWorld();	// owners of the same rows (columns)
+	int neighs = (dim == Row) ? commGrid->GetGridRows() : commGrid->GetGridCols();
+	IT total = (dim == Row) ? getnrow() : getncol();
+	IT nloc = (dim == Row) ? spSeq->getnrow() : spSeq->getncol();
+	IT perproc = total / neighs;
+
+	IT offset = v.LengthUntil();
+	IT locvec = v.arr.size();
+	std::vector<int> owner(locvec);
+	std::vector<int> sendcnt(neighs, 0), recvcnt(neighs), sdispls(neighs, 0), rdispls(neighs, 0);
+	for(IT k=0; k< locvec; ++k)
+	{
+		owner[k] = (perproc != 0) ? static_cast<int>(std::min(v.arr[k] / perproc, static_cast<IT>(neighs-1))) : (neighs-1);
+		++sendcnt[owner[k]];
+	}
+	MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, routeworld);
+	std::partial_sum(sendcnt.begin(), sendcnt.end()-1, sdispls.begin()+1);
+	std::partial_sum(recvcnt.begin(), recvcnt.end()-1, rdispls.begin()+1);
+	int totrecv = std::accumulate(recvcnt.begin(), recvcnt.end(), 0);
+
+	std::vector< std::pair<IT,IT> > senddata(locvec);	// (local row/column, position in v)
+	std::vector< std::pair<IT,IT> > recvdata(totrecv);
+	std::vector<int> curptr(sdispls);
+	for(IT k=0; k< locvec; ++k)
+		senddata[curptr[owner[k]]++] = std::make_pair(v.arr[k] - owner[k] * perproc, offset + k);
+	MPI_Alltoallv(senddata.data(), sendcnt.data(), sdispls.data(), MPIType< std::pair<IT,IT> >(),
+				  recvdata.data(), recvcnt.data(), rdispls.data(), MPIType< std::pair<IT,IT> >(), routeworld);
+	std::vector< std::pair<IT,IT> >().swap(senddata);
+
+	int shareneighs;
+	MPI_Comm_size(shareworld, &shareneighs);
+	std::vector<int> gathercnt(shareneighs), gatherdispls(shareneighs, 0);
+	MPI_Allgather(&totrecv, 1, MPI_INT, gathercnt.data(), 1, MPI_INT, shareworld);
+	std::partial_sum(gathercnt.begin(), gathercnt.end()-1, gatherdispls.begin()+1);
+	int totgather = std::accumulate(gathercnt.begin(), gathercnt.end(), 0);
+	std::vector< std::pair<IT,IT> > pairs(totgather);
+	MPI_Allgatherv(recvdata.data(), totrecv, MPIType< std::pair<IT,IT> >(),
+				   pairs.data(), gathercnt.data(), gatherdispls.data(), MPIType< std::pair<IT,IT> >(), shareworld);
+	std::vector< std::pair<IT,IT> >().swap(recvdata);
+
+	std::vector<IT> cnt(nloc, 0);
+	for(const auto & p : pairs)
+		++cnt[p.first];
+	int localperm = (static_cast<IT>(totgather) == nloc) && std::all_of(cnt.begin(), cnt.end(), [](IT c){ return c == 1; });
+	int perm;
+	MPI_Allreduce(&localperm, &perm, 1, MPI_INT, MPI_LAND, commGrid->GetWorld());
+
+	tptr.clear();
+	tpos.resize(totgather);
+	if(perm)
+	{
+		for(const auto & p : pairs)
+			tpos[p.first] = p.second;
+	}
+	else
+	{
+		tptr.resize(nloc+1, 0);
+		std::partial_sum(cnt.begin(), cnt.end(), tptr.begin()+1);
+		std::copy(tptr.begin(), tptr.end()-1, cnt.begin());	// reuse as insertion points
+		for(const auto & p : pairs)
+			tpos[cnt[p.first]++] = p.second;
+	}
+	return perm;
+}
+
+//! Owner processor row (column) and local index of every global row (column) index in gind, for a dimension of size total
+template <class IT, class NT, class DER>
+template <typename LIT>
+void SpParMat<IT,NT,DER>::IndexOwners(const std::vector<IT> & gind, IT total, int neighs, std::vector<int> & proc, std::vector<LIT> & lind)
+{
+	IT perproc = total / neighs;
+	proc.resize(gind.size());
+	lind.resize(gind.size());
+	for(size_t k=0; k< gind.size(); ++k)
+	{
+		proc[k] = (perproc != 0) ? static_cast<int>(std::min(gind[k] / perproc, static_cast<IT>(neighs-1))) : (neighs-1);
+		lind[k] = static_cast<LIT>(gind[k] - proc[k] * perproc);
+	}
+}
+
+/**
+ * Direct indexing engine behind SubsRef_SR: each nonzero A(i,j) is sent straight to the owners of the
+ * output entries (k,l) with ri[k] = i and ci[l] = j, using a single all-to-all and no selection matrices.
+ * A null ri (ci) keeps all rows (columns) in place. Permutations need no per-row (per-column) lists,
+ * and a symmetric permutation A(p,p) inverts p only once and fetches the column side from the transpose partner
+ */
+template <class IT, class NT, class DER>
+SpParMat<IT,NT,DER> SpParMat<IT,NT,DER>::SubsRefDirect(const FullyDistVec<IT,IT> * ri, const FullyDistVec<IT,IT> * ci) const
+{
+	typedef typename DER::LocalIT LIT;
+
+	int nprocs = commGrid->GetSize();
+	int procrows = commGrid->GetGridRows();
+	int proccols = commGrid->GetGridCols();
+	int myprocrow = commGrid->GetRankInProcCol();
+	int myproccol = commGrid->GetRankInProcRow();
+	IT totalm = getnrow();
+	IT totaln = getncol();
+	IT outm = ri ? ri->TotalLength() : totalm;
+	IT outn = ci ? ci->TotalLength() : totaln;
+	LIT locm = spSeq->getnrow();
+	LIT locn = spSeq->getncol();
+
+	// destinations of the local rows/columns: owner processor row/column and local index in the output
+	// the destinations of the i'th local row are rproc[rptr[i]] ... rproc[rptr[i+1]-1], or just rproc[i] if rptr is empty
+	std::vector<IT> rptr, cptr;
+	std::vector<int> rproc, cproc;
+	std::vector<LIT> rloc, cloc;
+	if(ri)
+	{
+		std::vector<IT> rpos;
+		InvertIndex(*ri, Row, rptr, rpos);
+		IndexOwners(rpos, outm, procrows, rproc, rloc);
+	}
+	else
+	{
+		rproc.assign(locm, myprocrow);
+		rloc.resize(locm);
+		std::iota(rloc.begin(), rloc.end(), static_cast<LIT>(0));
+	}
+	if(ci && ci == ri && totalm == totaln && procrows == proccols)
+	{
+		// the rows of processor row j are the columns of processor column j
+		int diagneigh = commGrid->GetComplementRank();
+		MPI_Status status;
+		auto exchange = [&](auto & mine, auto & theirs)
+		{
+			typedef typename std::remove_reference<decltype(mine)>::type::value_type T;
+			IT mysize = mine.size();
+			IT theirsize;
+			MPI_Sendrecv(&mysize, 1, MPIType<IT>(), diagneigh, TRNNZ, &theirsize, 1, MPIType<IT>(), diagneigh, TRNNZ, commGrid->GetWorld(), &status);
+			theirs.resize(theirsize);
+			MPI_Sendrecv(mine.data(), mysize, MPIType<T>(), diagneigh, TRX, theirs.data(), theirsize, MPIType<T>(), diagneigh, TRX, commGrid->GetWorld(), &status);
+		};
+		exchange(rptr, cptr);
+		exchange(rproc, cproc);
+		exchange(rloc, cloc);
+	}
+	else if(ci)
+	{
+		std::vector<IT> cpos;
+		InvertIndex(*ci, Column, cptr, cpos);
+		IndexOwners(cpos, outn, proccols, cproc, cloc);
+	}
+	else
+	{
+		cproc.assign(locn, myproccol);
+		cloc.resize(locn);
+		std::iota(cloc.begin(), cloc.end(), static_cast<LIT>(0));
+	}
+
+	// calls visit(owner, local row, local column) for every output entry of the local nonzero (i,j)
+	auto scatter = [&](IT i, IT j, auto visit)
+	{
+		IT rbeg = rptr.empty() ? i : rptr[i];
+		IT rend = rptr.empty() ? i+1 : rptr[i+1];
+		IT cbeg = cptr.empty() ? j : cptr[j];
+		IT cend = cptr.empty() ? j+1 : cptr[j+1];
+		for(IT c = cbeg; c < cend; ++c)
+			for(IT r = rbeg; r < rend; ++r)
+				visit(commGrid->GetRank(rproc[r], cproc[c]), rloc[r], cloc[c]);
+	};
+
+	std::vector<int> sendcnt(nprocs, 0), recvcnt(nprocs), sdispls(nprocs, 0), rdispls(nprocs, 0);
+	for(typename DER::SpColIter colit = spSeq->begcol(); colit != spSeq->endcol(); ++colit)
+	{
+		if(!cptr.empty() && cptr[colit.colid()] == cptr[colit.colid()+1])	continue;	// column not selected
+		for(typename DER::SpColIter::NzIter nzit = spSeq->begnz(colit); nzit < spSeq->endnz(colit); ++nzit)
+			scatter(nzit.rowid(), colit.colid(), [&](int owner, LIT, LIT) { ++sendcnt[owner]; });
+	}
+	MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, commGrid->GetWorld());
+	std::partial_sum(sendcnt.begin(), sendcnt.end()-1, sdispls.begin()+1);
+	std::partial_sum(recvcnt.begin(), recvcnt.end()-1, rdispls.begin()+1);
+	IT totsend = std::accumulate(sendcnt.begin(), sendcnt.end(), static_cast<IT>(0));
+	IT totrecv = std::accumulate(recvcnt.begin(), recvcnt.end(), static_cast<IT>(0));
+
+	std::vector< std::tuple<LIT,LIT,NT> > senddata(totsend);
+	std::vector<int> curptr(sdispls);
+	for(typename DER::SpColIter colit = spSeq->begcol(); colit != spSeq->endcol(); ++colit)
+	{
+		if(!cptr.empty() && cptr[colit.colid()] == cptr[colit.colid()+1])	continue;
+		for(typename DER::SpColIter::NzIter nzit = spSeq->begnz(colit); nzit < spSeq->endnz(colit); ++nzit)
+		{
+			NT val = nzit.value();
+			scatter(nzit.rowid(), colit.colid(), [&](int owner, LIT lrow, LIT lcol) { senddata[curptr[owner]++] = std::make_tuple(lrow, lcol, val); });
+		}
+	}
+	std::vector< std::tuple<LIT,LIT,NT> > recvdata(totrecv);
+	MPI_Alltoallv(senddata.data(), sendcnt.data(), sdispls.data(), MPIType< std::tuple<LIT,LIT,NT> >(),
+				  recvdata.data(), recvcnt.data(), rdispls.data(), MPIType< std::tuple<LIT,LIT,NT> >(), commGrid->GetWorld());
+	std::vector< std::tuple<LIT,LIT,NT> >().swap(senddata);
+
+	// each output entry arrives exactly once, so bucketing by column and sorting the rows within is enough
+	LIT outlocm = (myprocrow != procrows-1) ? outm / procrows : outm - myprocrow * (outm / procrows);
+	LIT outlocn = (myproccol != proccols-1) ? outn / proccols : outn - myproccol * (outn / proccols);
+	std::vector<IT> colptr(outlocn+1, 0);
+	for(const auto & t : recvdata)
+		++colptr[std::get<1>(t)+1];
+	std::partial_sum(colptr.begin(), colptr.end(), colptr.begin());
+	std::tuple<LIT,LIT,NT> * sorted = new std::tuple<LIT,LIT,NT>[totrecv];
+	std::vector<IT> colpos(colptr.begin(), colptr.end()-1);
+	for(const auto & t : recvdata)
+		sorted[colpos[std::get<1>(t)]++] = t;
+	std::vector< std::tuple<LIT,LIT,NT> >().swap(recvdata);
+	for(LIT j=0; j< outlocn; ++j)
+	{
+		std::sort(sorted+colptr[j], sorted+colptr[j+1], [](const std::tuple<LIT,LIT,NT> & a, const std::tuple<LIT,LIT,NT> & b)
+			{ return std::get<0>(a) < std::get<0>(b); });
+	}
+	SpTuples<LIT,NT> tuples(totrecv, outlocm, outlocn, sorted, true);	// ~SpTuples deallocates sorted
+	return SpParMat<IT,NT,DER>(new DER(tuples, false), commGrid);
+}
+
 /** 
  * Generalized sparse matrix indexing (ri/ci are 0-based indexed)
  * Both the storage and the actual values in FullyDistVec should be IT
  * The index vectors are dense and FULLY distributed on all processors
  * We can use this function to apply a permutation like A(p,q) 
- * Sequential indexing subroutine (via multiplication) is general enough.
+ * Plain selections (the BoolCopy semirings used by operator()) route the nonzeros directly through SubsRefDirect,
+ * other semirings use the general indexing via multiplication with selection matrices
  */
 template <class IT, class NT, class DER>
 template <typename PTNTBOOL, typename PTBOOLNT>
@@ -2048,11 +2580,21 @@ SpParMat<IT,NT,DER> SpParMat<IT,NT,DER>::SubsRef_SR (const FullyDistVec<IT,IT> &
 
 	IT totalm = getnrow();
 	IT totaln = getncol();
-	if(locmax_ri > totalm || locmax_ci > totaln)	
+	if(locmax_ri >= totalm || locmax_ci >= totaln)	
 	{
 		throw outofrangeexception();
 	}
 
+	if(std::is_same<PTNTBOOL, BoolCopy1stSRing<NT> >::value && std::is_same<PTBOOLNT, BoolCopy2ndSRing<NT> >::value)
+	{
+		if(inplace)
+		{
+			*this = SubsRefDirect(&ri, &ci);
+			return SpParMat<IT,NT,DER>(commGrid);	// dummy return to match signature
+		}
+		return SubsRefDirect(&ri, &ci);
+	}
+
 	// The indices for FullyDistVec are offset'd to 1/p pieces
 	// The matrix indices are offset'd to 1/sqrt(p) pieces
 	// Add the corresponding offset before sending the data 
@@ -2285,7 +2827,7 @@ SpParMat<IT, NT, DER>::SubsRef_SR (
 	switch(dim)
 	{
 	case Row:
-		if (locmax > totalm)
+		if (locmax >= totalm)
 			throw outofrangeexception();
 
 		perproccol = totalm / rowneighs;
@@ -2301,7 +2843,7 @@ SpParMat<IT, NT, DER>::SubsRef_SR (
 		
 
 	case Column:
-		if (locmax > totaln)
+		if (locmax >= totaln)
 			throw outofrangeexception();
 
 		perproccol = totaln / rowneighs;
@@ -2314,6 +2856,20 @@ SpParMat<IT, NT, DER>::SubsRef_SR (
 		break;
 	}
 
+	if (std::is_same<PTNTBOOL, BoolCopy1stSRing<NT> >::value &&
+		std::is_same<PTBOOLNT, BoolCopy2ndSRing<NT> >::value)
+	{
+		// plain selection, route the nonzeros directly
+		const FullyDistVec<IT, IT> *ri = (dim == Row) ? &v : NULL;
+		const FullyDistVec<IT, IT> *ci = (dim == Column) ? &v : NULL;
+		if (inplace)
+		{
+			*this = SubsRefDirect(ri, ci);
+			return SpParMat<IT, NT, DER>(commGrid); // dummy
+		}
+		return SubsRefDirect(ri, ci);
+	}
+
 
 	// find owner processes and fill in the vectors
 	std::vector<std::vector<IT>> rowid(rowneighs);
@@ -2426,8 +2982,6 @@ SpParMat<IT, NT, DER>::SubsRef_SR (
 template <class IT, class NT, class DER>
 void SpParMat<IT,NT,DER>::SpAsgn(const FullyDistVec<IT,IT> & ri, const FullyDistVec<IT,IT> & ci, SpParMat<IT,NT,DER> & B)
 {
-	typedef PlusTimesSRing<NT, NT> PTRing;
-	
 	if((*(ri.commGrid) != *(B.commGrid)) || (*(ci.commGrid) != *(B.commGrid)))
 	{
 		SpParHelper::Print("Grids are not comparable, SpAsgn fails !", commGrid->GetWorld());
@@ -2449,20 +3003,68 @@ void SpParMat<IT,NT,DER>::SpAsgn(const FullyDistVec<IT,IT> & ri, const FullyDist
 		MPI_Abort(MPI_COMM_WORLD, DIMMISMATCH);
 	}
 	Prune(ri, ci);	// make a hole	
-	
-	// embed B to the size of A
-	FullyDistVec<IT,IT> * rvec = new FullyDistVec<IT,IT>(ri.commGrid);
-	rvec->iota(total_m_B, 0);	// sparse() expects a zero based index
-	
-	SpParMat<IT,NT,DER> R(total_m_A, total_m_B, ri, *rvec, 1);
-	delete rvec;	// free memory
-	SpParMat<IT,NT,DER> RB = Mult_AnXBn_DoubleBuff<PTRing, NT, DER>(R, B, true, false); // clear memory of R but not B
-	
-	FullyDistVec<IT,IT> * qvec = new FullyDistVec<IT,IT>(ri.commGrid);
-	qvec->iota(total_n_B, 0);
-	SpParMat<IT,NT,DER> Q(total_n_B, total_n_A, *qvec, ci, 1);
-	delete qvec;	// free memory
-	SpParMat<IT,NT,DER> RBQ = Mult_AnXBn_DoubleBuff<PTRing, NT, DER>(RB, Q, true, true); // clear memory of RB and Q
+
+	// route B(i,j) straight to the owner of A(ri[i], ci[j]): the pieces of ri along this processor row cover the local rows of B,
+	// and those of ci along the transpose partner's processor row cover the local columns of B
+	typedef typename DER::LocalIT LIT;
+	MPI_Comm RowWorld = commGrid->GetRowWorld();
+	int rowneighs = commGrid->GetGridCols();
+	std::vector<IT> browdest, bcoldest, mycolpart;
+	auto gatherrow = [&](const FullyDistVec<IT,IT> & v, std::vector<IT> & gathered)
+	{
+		int locvec = v.arr.size();
+		std::vector<int> recvcnt(rowneighs), rdispls(rowneighs, 0);
+		MPI_Allgather(&locvec, 1, MPI_INT, recvcnt.data(), 1, MPI_INT, RowWorld);
+		std::partial_sum(recvcnt.begin(), recvcnt.end()-1, rdispls.begin()+1);
+		gathered.resize(std::accumulate(recvcnt.begin(), recvcnt.end(), static_cast<IT>(0)));
+		MPI_Allgatherv(v.arr.data(), locvec, MPIType<IT>(), gathered.data(), recvcnt.data(), rdispls.data(), MPIType<IT>(), RowWorld);
+	};
+	gatherrow(ri, browdest);
+	gatherrow(ci, mycolpart);
+	int diagneigh = commGrid->GetComplementRank();
+	IT mysize = mycolpart.size();
+	IT theirsize;
+	MPI_Status status;
+	MPI_Sendrecv(&mysize, 1, MPIType<IT>(), diagneigh, TRNNZ, &theirsize, 1, MPIType<IT>(), diagneigh, TRNNZ, commGrid->GetWorld(), &status);
+	bcoldest.resize(theirsize);
+	MPI_Sendrecv(mycolpart.data(), mysize, MPIType<IT>(), diagneigh, TRX, bcoldest.data(), theirsize, MPIType<IT>(), diagneigh, TRX, commGrid->GetWorld(), &status);
+	std::vector<IT>().swap(mycolpart);
+
+	std::vector<int> rproc, cproc;
+	std::vector<LIT> rloc, cloc;
+	IndexOwners(browdest, total_m_A, commGrid->GetGridRows(), rproc, rloc);
+	IndexOwners(bcoldest, total_n_A, commGrid->GetGridCols(), cproc, cloc);
+
+	int nprocs = commGrid->GetSize();
+	DER * BSeq = B.seqptr();
+	std::vector<int> sendcnt(nprocs, 0), recvcnt(nprocs), sdispls(nprocs, 0), rdispls(nprocs, 0);
+	for(typename DER::SpColIter colit = BSeq->begcol(); colit != BSeq->endcol(); ++colit)
+		for(typename DER::SpColIter::NzIter nzit = BSeq->begnz(colit); nzit < BSeq->endnz(colit); ++nzit)
+			++sendcnt[commGrid->GetRank(rproc[nzit.rowid()], cproc[colit.colid()])];
+	MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, commGrid->GetWorld());
+	std::partial_sum(sendcnt.begin(), sendcnt.end()-1, sdispls.begin()+1);
+	std::partial_sum(recvcnt.begin(), recvcnt.end()-1, rdispls.begin()+1);
+	IT totrecv = std::accumulate(recvcnt.begin(), recvcnt.end(), static_cast<IT>(0));
+
+	std::vector< std::tuple<LIT,LIT,NT> > senddata(BSeq->getnnz());
+	std::vector<int> curptr(sdispls);
+	for(typename DER::SpColIter colit = BSeq->begcol(); colit != BSeq->endcol(); ++colit)
+	{
+		for(typename DER::SpColIter::NzIter nzit = BSeq->begnz(colit); nzit < BSeq->endnz(colit); ++nzit)
+		{
+			IT i = nzit.rowid();
+			IT j = colit.colid();
+			senddata[curptr[commGrid->GetRank(rproc[i], cproc[j])]++] = std::make_tuple(rloc[i], cloc[j], nzit.value());
+		}
+	}
+	std::tuple<LIT,LIT,NT> * recvdata = new std::tuple<LIT,LIT,NT>[totrecv];
+	MPI_Alltoallv(senddata.data(), sendcnt.data(), sdispls.data(), MPIType< std::tuple<LIT,LIT,NT> >(),
+				  recvdata, recvcnt.data(), rdispls.data(), MPIType< std::tuple<LIT,LIT,NT> >(), commGrid->GetWorld());
+	std::vector< std::tuple<LIT,LIT,NT> >().swap(senddata);
+
+	SpTuples<LIT,NT> tuples(totrecv, spSeq->getnrow(), spSeq->getncol(), recvdata);	// ~SpTuples deallocates recvdata
+	tuples.RemoveDuplicates(std::plus<NT>());	// repeated indices in ri or ci add up
+	SpParMat<IT,NT,DER> RBQ(new DER(tuples, false), commGrid);
 	*this += RBQ;	// extend-add
 }
 
@@ -2490,27 +3092,24 @@ void SpParMat<IT,NT,DER>::Prune(const FullyDistVec<IT,IT> & ri, const FullyDistV
 
 	IT total_m = getnrow();
 	IT total_n = getncol();
-	if(locmax_ri > total_m || locmax_ci > total_n)	
+	if(locmax_ri >= total_m || locmax_ci >= total_n)	
 	{
 		throw outofrangeexception();
 	}
 
-        // infer the concrete types to replace the value with bool
-	typedef typename DER::LocalIT LIT;
-        typedef typename create_trait<DER, LIT, bool>::T_inferred DER_BOOL;
-        typedef typename create_trait<DER, LIT, IT>::T_inferred DER_IT;
-
-	// create and downcast to boolean because this type of constructor can not be booleand as FullyDist can not be boolean
-	SpParMat<IT,bool,DER_BOOL> S = SpParMat<IT, IT, DER_IT> (total_m, total_m, ri, ri, 1);
-	SpParMat<IT,NT,DER> SA = Mult_AnXBn_DoubleBuff< BoolCopy2ndSRing<NT> , NT, DER>(S, *this, true, false); // clear memory of S but not *this
-
-	SpParMat<IT,bool,DER_BOOL> T = SpParMat<IT, IT, DER_IT> (total_n, total_n, ci, ci, 1);
-	SpParMat<IT,NT,DER> SAT = Mult_AnXBn_DoubleBuff< BoolCopy1stSRing<NT> , NT, DER>(SA, T, true, true); // clear memory of SA and T
-
-
-	// the type of the SAT matrix does not matter when calling set difference
-	// because it just copies the non-excluded values from (*this) matrix, without touching values in SAT  
-	SetDifference(SAT);	
+	// mark the local rows selected by ri and the local columns selected by ci
+	std::vector<IT> rptr, rpos, cptr, cpos;
+	bool rowperm = InvertIndex(ri, Row, rptr, rpos);
+	bool colperm = InvertIndex(ci, Column, cptr, cpos);
+	IT locm = spSeq->getnrow();
+	IT locn = spSeq->getncol();
+	std::vector<bool> rowhit(locm, true), colhit(locn, true);
+	if(!rowperm)
+		for(IT i=0; i< locm; ++i)	rowhit[i] = (rptr[i+1] > rptr[i]);
+	if(!colperm)
+		for(IT j=0; j< locn; ++j)	colhit[j] = (cptr[j+1] > cptr[j]);
+
+	spSeq->PruneI([&rowhit, &colhit](const auto & t) { return rowhit[std::get<0>(t)] && colhit[std::get<1>(t)]; }, true, static_cast<IT>(0), static_cast<IT>(0));
 }
 
 
@@ -3253,6 +3852,132 @@ SpParMat< IT,NT,DER >::SpParMat (const DistEdgeList<DELIT> & DEL, bool removeloo
   	spSeq = new DER(A,false);        // Convert SpTuples to DER
 }
 
+template <class IT, class NT, class DER>
+void SpParMat< IT,NT,DER >::GenGraph500Data(int log_numverts, int edgefactor, bool removeloops, int64_t roundedges)
+{
+	typedef typename DER::LocalIT LIT;
+	int nprocs = commGrid->GetSize();
+	int myrank = commGrid->GetRank();
+	IT globalV = static_cast<IT>(1) << log_numverts;
+	int64_t globaledges = static_cast<int64_t>(globalV) * static_cast<int64_t>(edgefactor);
+
+	// same seed and edge ranges as RefGen21::make_graph
+	uint_fast32_t seed[5];
+	RefGen21::make_graph_seed(seed);
+	int64_t start_idx, end_idx;
+	RefGen21::compute_edge_range(myrank, nprocs, globaledges, &start_idx, &end_idx);
+	roundedges = std::max(roundedges, static_cast<int64_t>(1));
+	int64_t myrounds = (end_idx - start_idx + roundedges - 1) / roundedges;
+	int64_t rounds;
+	MPI_Allreduce(&myrounds, &rounds, 1, MPIType<int64_t>(), MPI_MAX, commGrid->GetWorld());
+
+	int numThreads = 1;
+#ifdef THREADED
+#pragma omp parallel
+	{
+		numThreads = omp_get_num_threads();
+	}
+#endif
+	int gridrows = commGrid->GetGridRows();
+	int gridcols = commGrid->GetGridCols();
+	IT m_perproc = globalV / gridrows;
+	IT n_perproc = globalV / gridcols;
+	int myprocrow = commGrid->GetRankInProcCol();
+	int myproccol = commGrid->GetRankInProcRow();
+	LIT locrows = (myprocrow != gridrows-1)? m_perproc : globalV - myprocrow * m_perproc;
+	LIT loccols = (myproccol != gridcols-1)? n_perproc : globalV - myproccol * n_perproc;
+	if(spSeq) delete spSeq;
+	spSeq = new DER(0, locrows, loccols, 0);	// each round's deduplicated edges are added to it
+
+	std::vector<packed_edge> generated(std::min(roundedges, end_idx - start_idx));
+	std::vector<int> threadoffsets(numThreads * nprocs);	// [t*nprocs+i]: edges of thread t to process i, then where they go
+	std::vector<LIT> sendbuf;
+	std::vector<LIT> roundrecv;	// (row,col) pairs received in this round
+	int * sendcnt = new int[nprocs];
+	int * recvcnt = new int[nprocs];
+	int * sdispls = new int[nprocs];
+	int * rdispls = new int[nprocs];
+
+	for(int64_t r=0; r< rounds; ++r)
+	{
+		int64_t roundbeg = std::min(start_idx + r * roundedges, end_idx);
+		int64_t roundend = std::min(roundbeg + roundedges, end_idx);
+		int64_t thisround = roundend - roundbeg;
+		if(thisround > 0)
+			RefGen21::generate_kronecker_range(seed, log_numverts, roundbeg, roundend, generated.data());
+
+		std::fill(threadoffsets.begin(), threadoffsets.end(), 0);
+#ifdef THREADED
+#pragma omp parallel
+#endif
+		{
+			int t = 0;
+#ifdef THREADED
+			t = omp_get_thread_num();
+#endif
+			int64_t mybeg = thisround * t / numThreads;
+			int64_t myend = thisround * (t+1) / numThreads;
+			int * mycnt = threadoffsets.data() + static_cast<size_t>(t) * nprocs;
+			for(int64_t i = mybeg; i < myend; ++i)
+			{
+				int64_t fr = get_v0_from_edge(&(generated[i]));
+				int64_t to = get_v1_from_edge(&(generated[i]));
+				if(fr >= 0 && to >= 0)
+				{
+					LIT lrow, lcol;
+					++mycnt[Owner(globalV, globalV, fr, to, lrow, lcol)];
+				}
+			}
+#ifdef THREADED
+#pragma omp barrier
+#pragma omp single
+#endif
+			{
+				int64_t pos = 0;	// the send buffer is ordered by (owner, thread)
+				for(int i=0; i< nprocs; ++i)
+				{
+					sdispls[i] = static_cast<int>(2*pos);
+					for(int tt=0; tt< numThreads; ++tt)
+					{
+						int cnt = threadoffsets[tt * nprocs + i];
+						threadoffsets[tt * nprocs + i] = static_cast<int>(pos);
+						pos += cnt;
+					}
+					sendcnt[i] = static_cast<int>(2*pos) - sdispls[i];
+				}
+				sendbuf.resize(2*pos);
+			}
+			for(int64_t i = mybeg; i < myend; ++i)
+			{
+				int64_t fr = get_v0_from_edge(&(generated[i]));
+				int64_t to = get_v1_from_edge(&(generated[i]));
+				if(fr >= 0 && to >= 0)
+				{
+					LIT lrow, lcol;
+					int owner = Owner(globalV, globalV, fr, to, lrow, lcol);
+					LIT * dest = sendbuf.data() + 2 * static_cast<int64_t>(mycnt[owner]++);
+					dest[0] = lrow;
+					dest[1] = lcol;
+				}
+			}
+		}
+
+		MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, commGrid->GetWorld());
+		rdispls[0] = 0;
+		std::partial_sum(recvcnt, recvcnt+nprocs-1, rdispls+1);
+		int64_t thisrecv = std::accumulate(recvcnt, recvcnt+nprocs, static_cast<int64_t>(0));
+		assert((thisrecv < std::numeric_limits<int>::max()));
+		roundrecv.resize(thisrecv);
+		MPI_Alltoallv(sendbuf.data(), sendcnt, sdispls, MPIType<LIT>(), roundrecv.data(), recvcnt, rdispls, MPIType<LIT>(), commGrid->GetWorld());
+		if(thisrecv > 0)
+		{
+			SpTuples<LIT,NT> A(thisrecv/2, locrows, loccols, roundrecv, removeloops);	// sorts and sums duplicates, roundrecv is empty upon return
+			*spSeq += DER(A,false);	// duplicates across rounds are summed here
+		}
+	}
+	DeleteAll(sendcnt, recvcnt, sdispls, rdispls);
+}
+
 template <class IT, class NT, class DER>
 IT SpParMat<IT,NT,DER>::RemoveLoops()
 {
@@ -3533,56 +4258,137 @@ void SpParMat<IT,NT,DER>::Transpose()
 	}
 	else
 	{
-		typedef typename DER::LocalIT LIT;
-		SpTuples<LIT,NT> Atuples(*spSeq);
-		LIT locnnz = Atuples.getnnz();
-		LIT * rows = new LIT[locnnz];
-		LIT * cols = new LIT[locnnz];
-		NT * vals = new NT[locnnz];
-		for(LIT i=0; i < locnnz; ++i)
+		TransposeOffDiagonal(spSeq);
+	}	
+}		
+
+/**
+ * The local block is transposed with a counting sort before it leaves (Dcsc::Transpose), so the diagonal neighbor
+ * receives a ready-to-use DCSC straight into the arrays of its new local matrix: no tuples, no sorting on either side
+ * jc and cp go out (nonblocking) as soon as they are final, overlapping with the scatter of ir and numx
+ **/
+template <class IT, class NT, class DER>
+template <typename LIT>
+void SpParMat<IT,NT,DER>::TransposeOffDiagonal(SpDCCols<LIT,NT> * seq)
+{
+	if(seq->getnsplit() > 0)
+	{
+		TransposeTuples();
+		return;
+	}
+	LIT locnnz = seq->getnnz();
+	LIT locm = seq->getnrow();
+	LIT locn = seq->getncol();
+	int diagneigh = commGrid->GetComplementRank();
+	MPI_Comm World = commGrid->GetWorld();
+
+	LIT mysizes[4] = {locnnz, 0, locn, locm};	// nnz, nzc, rows and columns of the transposed block
+	LIT remotesizes[4];
+	SpDCCols<LIT,NT> * received = NULL;
+	std::vector<MPI_Request> requests;
+	auto shipcolumns = [&](Dcsc<LIT,NT> * trans)
+	{
+		mysizes[1] = (trans != NULL)? trans->nzc : 0;
+		MPI_Sendrecv(mysizes, 4, MPIType<LIT>(), diagneigh, TRTAGNZ, remotesizes, 4, MPIType<LIT>(), diagneigh, TRTAGNZ, World, MPI_STATUS_IGNORE);
+		received = new SpDCCols<LIT,NT>(remotesizes[0], remotesizes[2], remotesizes[3], remotesizes[1]);
+		if(remotesizes[0] > 0)
 		{
-			rows[i] = Atuples.colindex(i);	// swap (i,j) here
-			cols[i] = Atuples.rowindex(i);
-			vals[i] = Atuples.numvalue(i);
+			Dcsc<LIT,NT> * rdcsc = received->GetDCSC();
+			requests.resize(requests.size()+4);
+			MPI_Request * req = &requests[requests.size()-4];
+			MPI_Irecv(rdcsc->jc, remotesizes[1], MPIType<LIT>(), diagneigh, TRTAGCOLS, World, req);
+			MPI_Irecv(rdcsc->cp, remotesizes[1]+1, MPIType<LIT>(), diagneigh, TRTAGN, World, req+1);
+			MPI_Irecv(rdcsc->ir, remotesizes[0], MPIType<LIT>(), diagneigh, TRTAGROWS, World, req+2);
+			MPI_Irecv(rdcsc->numx, remotesizes[0], MPIType<NT>(), diagneigh, TRTAGVALS, World, req+3);
 		}
-		LIT locm = getlocalcols();
-		LIT locn = getlocalrows();
-		delete spSeq;
+		if(trans != NULL)
+		{
+			requests.resize(requests.size()+2);
+			MPI_Request * req = &requests[requests.size()-2];
+			MPI_Isend(trans->jc, trans->nzc, MPIType<LIT>(), diagneigh, TRTAGCOLS, World, req);
+			MPI_Isend(trans->cp, trans->nzc+1, MPIType<LIT>(), diagneigh, TRTAGN, World, req+1);
+		}
+	};
 
-		LIT remotem, remoten, remotennz;
-		std::swap(locm,locn);
-		int diagneigh = commGrid->GetComplementRank();
+	Dcsc<LIT,NT> * trans = NULL;
+	if(locnnz > 0)
+	{
+		trans = seq->GetDCSC()->Transpose(locm, shipcolumns);
+		requests.resize(requests.size()+2);
+		MPI_Request * req = &requests[requests.size()-2];
+		MPI_Isend(trans->ir, locnnz, MPIType<LIT>(), diagneigh, TRTAGROWS, World, req);
+		MPI_Isend(trans->numx, locnnz, MPIType<NT>(), diagneigh, TRTAGVALS, World, req+1);
+	}
+	else
+	{
+		shipcolumns(NULL);
+	}
+	delete spSeq;	// the original is no longer needed while the messages are in flight
+	spSeq = NULL;
+	MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+	delete trans;
+	spSeq = received;
+}
 
-		MPI_Status status;
-		MPI_Sendrecv(&locnnz, 1, MPIType<LIT>(), diagneigh, TRTAGNZ, &remotennz, 1, MPIType<LIT>(), diagneigh, TRTAGNZ, commGrid->GetWorld(), &status);
-		MPI_Sendrecv(&locn, 1, MPIType<LIT>(), diagneigh, TRTAGM, &remotem, 1, MPIType<LIT>(), diagneigh, TRTAGM, commGrid->GetWorld(), &status);
-		MPI_Sendrecv(&locm, 1, MPIType<LIT>(), diagneigh, TRTAGN, &remoten, 1, MPIType<LIT>(), diagneigh, TRTAGN, commGrid->GetWorld(), &status);
+template <class IT, class NT, class DER>
+template <typename OTHERDER>
+void SpParMat<IT,NT,DER>::TransposeOffDiagonal(OTHERDER * seq)
+{
+	TransposeTuples();
+}
 
-		LIT * rowsrecv = new LIT[remotennz];
-		MPI_Sendrecv(rows, locnnz, MPIType<LIT>(), diagneigh, TRTAGROWS, rowsrecv, remotennz, MPIType<LIT>(), diagneigh, TRTAGROWS, commGrid->GetWorld(), &status);
-		delete [] rows;
+template <class IT, class NT, class DER>
+void SpParMat<IT,NT,DER>::TransposeTuples()
+{
+	typedef typename DER::LocalIT LIT;
+	SpTuples<LIT,NT> Atuples(*spSeq);
+	LIT locnnz = Atuples.getnnz();
+	LIT * rows = new LIT[locnnz];
+	LIT * cols = new LIT[locnnz];
+	NT * vals = new NT[locnnz];
+	for(LIT i=0; i < locnnz; ++i)
+	{
+		rows[i] = Atuples.colindex(i);	// swap (i,j) here
+		cols[i] = Atuples.rowindex(i);
+		vals[i] = Atuples.numvalue(i);
+	}
+	LIT locm = getlocalcols();
+	LIT locn = getlocalrows();
+	delete spSeq;
+
+	LIT remotem, remoten, remotennz;
+	std::swap(locm,locn);
+	int diagneigh = commGrid->GetComplementRank();
 
-		LIT * colsrecv = new LIT[remotennz];
-		MPI_Sendrecv(cols, locnnz, MPIType<LIT>(), diagneigh, TRTAGCOLS, colsrecv, remotennz, MPIType<LIT>(), diagneigh, TRTAGCOLS, commGrid->GetWorld(), &status);
-		delete [] cols;
+	MPI_Status status;
+	MPI_Sendrecv(&locnnz, 1, MPIType<LIT>(), diagneigh, TRTAGNZ, &remotennz, 1, MPIType<LIT>(), diagneigh, TRTAGNZ, commGrid->GetWorld(), &status);
+	MPI_Sendrecv(&locn, 1, MPIType<LIT>(), diagneigh, TRTAGM, &remotem, 1, MPIType<LIT>(), diagneigh, TRTAGM, commGrid->GetWorld(), &status);
+	MPI_Sendrecv(&locm, 1, MPIType<LIT>(), diagneigh, TRTAGN, &remoten, 1, MPIType<LIT>(), diagneigh, TRTAGN, commGrid->GetWorld(), &status);
 
-		NT * valsrecv = new NT[remotennz];
-		MPI_Sendrecv(vals, locnnz, MPIType<NT>(), diagneigh, TRTAGVALS, valsrecv, remotennz, MPIType<NT>(), diagneigh, TRTAGVALS, commGrid->GetWorld(), &status);
-		delete [] vals;
+	LIT * rowsrecv = new LIT[remotennz];
+	MPI_Sendrecv(rows, locnnz, MPIType<LIT>(), diagneigh, TRTAGROWS, rowsrecv, remotennz, MPIType<LIT>(), diagneigh, TRTAGROWS, commGrid->GetWorld(), &status);
+	delete [] rows;
 
-		std::tuple<LIT,LIT,NT> * arrtuples = new std::tuple<LIT,LIT,NT>[remotennz];
-		for(LIT i=0; i< remotennz; ++i)
-		{
-			arrtuples[i] = std::make_tuple(rowsrecv[i], colsrecv[i], valsrecv[i]);
-		}	
-		DeleteAll(rowsrecv, colsrecv, valsrecv);
-		ColLexiCompare<LIT,NT> collexicogcmp;
-		sort(arrtuples , arrtuples+remotennz, collexicogcmp );	// sort w.r.t columns here
-
-		spSeq = new DER();
-		spSeq->Create( remotennz, remotem, remoten, arrtuples);		// the deletion of arrtuples[] is handled by SpMat::Create
+	LIT * colsrecv = new LIT[remotennz];
+	MPI_Sendrecv(cols, locnnz, MPIType<LIT>(), diagneigh, TRTAGCOLS, colsrecv, remotennz, MPIType<LIT>(), diagneigh, TRTAGCOLS, commGrid->GetWorld(), &status);
+	delete [] cols;
+
+	NT * valsrecv = new NT[remotennz];
+	MPI_Sendrecv(vals, locnnz, MPIType<NT>(), diagneigh, TRTAGVALS, valsrecv, remotennz, MPIType<NT>(), diagneigh, TRTAGVALS, commGrid->GetWorld(), &status);
+	delete [] vals;
+
+	std::tuple<LIT,LIT,NT> * arrtuples = new std::tuple<LIT,LIT,NT>[remotennz];
+	for(LIT i=0; i< remotennz; ++i)
+	{
+		arrtuples[i] = std::make_tuple(rowsrecv[i], colsrecv[i], valsrecv[i]);
 	}	
-}		
+	DeleteAll(rowsrecv, colsrecv, valsrecv);
+	ColLexiCompare<LIT,NT> collexicogcmp;
+	sort(arrtuples , arrtuples+remotennz, collexicogcmp );	// sort w.r.t columns here
+
+	spSeq = new DER();
+	spSeq->Create( remotennz, remotem, remoten, arrtuples);		// the deletion of arrtuples[] is handled by SpMat::Create
+}
 
 
 template <class IT, class NT, class DER>
@@ -4067,24 +4873,125 @@ void SpParMat< IT,NT,DER >::ParallelReadMM (const std::string & filename, bool o
     MPI_File mpi_fh;
     MPI_File_open (commGrid->commWorld, const_cast<char*>(filename.c_str()), MPI_MODE_RDONLY, MPI_INFO_NULL, &mpi_fh);
 
-	 
     typedef typename DER::LocalIT LIT;
-    std::vector<LIT> rows;
-    std::vector<LIT> cols;
-    std::vector<NT> vals;
-
-    std::vector<std::string> lines;
-    bool finished = SpParHelper::FetchBatch(mpi_fh, fpos, end_fpos, true, lines, myrank);
-    int64_t entriesread = lines.size();
-    SpHelper::ProcessLines(rows, cols, vals, lines, symmetric, type, onebased);
-    MPI_Barrier(commGrid->commWorld);
-
-    while(!finished)
+    int numThreads = 1;	// default case
+#ifdef THREADED
+#pragma omp parallel
     {
-        finished = SpParHelper::FetchBatch(mpi_fh, fpos, end_fpos, false, lines, myrank);
-        entriesread += lines.size();
-        SpHelper::ProcessLines(rows, cols, vals, lines, symmetric, type, onebased);
+        numThreads = omp_get_num_threads();
+    }
+#endif
+    // every thread packs its tuples directly by recipient; concatenated into the buffers of SparseCommon at the end
+    std::vector< std::vector< std::vector < std::tuple<LIT,LIT,NT> > > > perthread(numThreads, std::vector< std::vector < std::tuple<LIT,LIT,NT> > >(nprocs));
+    std::vector<int64_t> entriesperthread(numThreads, 0);
+
+    // this rank parses the lines that start in [fpos, end_fpos), in chunks of whole lines
+    const int64_t chunksize = std::min(static_cast<int64_t>(64 * ONEMILLION), static_cast<int64_t>(end_fpos - fpos) + ONEMILLION);
+    std::vector<char> buf(chunksize + 1);
+    MPI_Offset curpos = fpos;
+    bool firstcall = (myrank != 0);    // unless we started at the beginning of a line, the partial line belongs to the previous rank
+    while(curpos < end_fpos)
+    {
+        MPI_Offset readfrom = firstcall? curpos-1 : curpos;
+        int bytes2fetch = static_cast<int>(std::min(static_cast<int64_t>(file_size - readfrom), chunksize));
+        MPI_Status status;
+        int bytes_read;
+        MPI_File_read_at(mpi_fh, readfrom, buf.data(), bytes2fetch, MPI_CHAR, &status);
+        MPI_Get_count(&status, MPI_CHAR, &bytes_read);
+        if(bytes_read <= 0) break;
+        if(readfrom + bytes_read == file_size && buf[bytes_read-1] != '\n')
+            buf[bytes_read++] = '\n';  // no newline at the end of the file
+        const char * begin = buf.data();
+        const char * bufend = buf.data() + bytes_read;
+        if(firstcall)
+        {
+            const char * firstnl = static_cast<const char*>(memchr(begin, '\n', bytes_read));   // buf[0] is the byte before fpos
+            if(firstnl == NULL)     // the previous rank's line spans the whole chunk, keep looking for its end
+            {
+                curpos = readfrom + bytes_read;
+                continue;
+            }
+            begin = firstnl + 1;
+            firstcall = false;
+        }
+        // the partial line at the end is re-read with the next chunk
+        const char * stop = bufend;
+        while(stop > begin && stop[-1] != '\n') --stop;
+        if(readfrom + bytes_read > end_fpos)    // the last line that starts before end_fpos is still ours, no line after that
+        {
+            const char * last = buf.data() + (end_fpos - 1 - readfrom);
+            if(last < begin)
+            {
+                stop = begin;
+            }
+            else
+            {
+                const char * lastnl = static_cast<const char*>(memchr(last, '\n', bufend - last));
+                if(lastnl != NULL)  stop = lastnl + 1;  // otherwise the straddling line is carried into the next read
+            }
+        }
+        if(stop == begin && readfrom + (begin - buf.data()) < end_fpos)
+        {
+            std::cout << "COMBBLAS: Line longer than " << chunksize << " bytes in " << filename << std::endl;
+            break;
+        }
+
+        // split the chunk at line boundaries, one piece per thread
+        std::vector<const char *> pieces(numThreads+1, stop);
+        pieces[0] = begin;
+        for(int t=1; t< numThreads; ++t)
+        {
+            const char * p = std::max(begin + (stop - begin) * t / numThreads, pieces[t-1]);
+            if(p > begin && p < stop && p[-1] != '\n')
+            {
+                const char * nl = static_cast<const char*>(memchr(p, '\n', stop - p));
+                p = (nl != NULL)? nl + 1 : stop;
+            }
+            pieces[t] = p;
+        }
+#ifdef THREADED
+#pragma omp parallel for schedule(static,1)
+#endif
+        for(int t=0; t< numThreads; ++t)
+        {
+            std::vector< std::vector < std::tuple<LIT,LIT,NT> > > & mydata = perthread[t];
+            const char * p = pieces[t];
+            while(p < pieces[t+1])
+            {
+                const char * eol = static_cast<const char*>(memchr(p, '\n', pieces[t+1] - p));
+                int64_t ii, jj;
+                double realval = 1;
+                int64_t intval = 1;
+                bool valid = SpHelper::ParseInteger(p, ii) && SpHelper::ParseInteger(p, jj);
+                if(valid && type == 0)  valid = SpHelper::ParseReal(p, realval);
+                else if(valid && type == 1)  valid = SpHelper::ParseInteger(p, intval);
+                if(valid)   // skips blank and malformed lines
+                {
+                    NT vv = (type == 0)? static_cast<NT>(realval) : static_cast<NT>(intval);
+                    if(onebased)
+                    {
+                        ii--;  // adjust from 1-based to 0-based
+                        jj--;
+                    }
+                    LIT lrow, lcol;
+                    int owner = Owner(nrows, ncols, ii, jj, lrow, lcol);
+                    mydata[owner].push_back(std::make_tuple(lrow,lcol,vv));
+                    if(symmetric && ii != jj)
+                    {
+                        owner = Owner(nrows, ncols, jj, ii, lrow, lcol);
+                        mydata[owner].push_back(std::make_tuple(lrow,lcol,vv));
+                    }
+                    ++entriesperthread[t];
+                }
+                p = eol + 1;
+            }
+        }
+        curpos = readfrom + (stop - buf.data());
     }
+    MPI_File_close(&mpi_fh);
+    std::vector<char>().swap(buf);
+
+    int64_t entriesread = std::accumulate(entriesperthread.begin(), entriesperthread.end(), static_cast<int64_t>(0));
     int64_t allentriesread;
     MPI_Reduce(&entriesread, &allentriesread, 1, MPIType<int64_t>(), MPI_SUM, 0, commGrid->commWorld);
 #ifdef COMBBLAS_DEBUG
@@ -4093,17 +5000,30 @@ void SpParMat< IT,NT,DER >::ParallelReadMM (const std::string & filename, bool o
 #endif
 
     std::vector< std::vector < std::tuple<LIT,LIT,NT> > > data(nprocs);
-    
-    LIT locsize = rows.size();   // remember: locsize != entriesread (unless the matrix is unsymmetric)
-    for(LIT i=0; i<locsize; ++i)
+    LIT locsize = 0;   // remember: locsize != entriesread (unless the matrix is unsymmetric)
+#ifdef THREADED
+#pragma omp parallel for reduction(+:locsize)
+#endif
+    for(int i=0; i< nprocs; ++i)
     {
-        LIT lrow, lcol;
-        int owner = Owner(nrows, ncols, rows[i], cols[i], lrow, lcol);
-        data[owner].push_back(std::make_tuple(lrow,lcol,vals[i]));
+        size_t tosend = 0;
+        for(int t=0; t< numThreads; ++t)
+            tosend += perthread[t][i].size();
+        if(numThreads == 1)
+        {
+            data[i].swap(perthread[0][i]);
+        }
+        else
+        {
+            data[i].reserve(tosend);
+            for(int t=0; t< numThreads; ++t)
+            {
+                data[i].insert(data[i].end(), perthread[t][i].begin(), perthread[t][i].end());
+                std::vector < std::tuple<LIT,LIT,NT> >().swap(perthread[t][i]);
+            }
+        }
+        locsize += static_cast<LIT>(tosend);
     }
-    std::vector<LIT>().swap(rows);
-    std::vector<LIT>().swap(cols);
-    std::vector<NT>().swap(vals);	
 
 #ifdef COMBBLAS_DEBUG
     if(myrank == 0)
@@ -4120,23 +5040,19 @@ template <class HANDLER>
 void SpParMat< IT,NT,DER >::ParallelWriteMM(const std::string & filename, bool onebased, HANDLER handler)
 {
     int myrank = commGrid->GetRank();
-    int nprocs = commGrid->GetSize();
     IT totalm = getnrow();
     IT totaln = getncol();
     IT totnnz = getnnz();
 
-    std::stringstream ss;
+    std::string header;
     if(myrank == 0)
     {
+        std::stringstream ss;
         ss << "%%MatrixMarket matrix coordinate real general" << std::endl;
         ss << totalm << " " << totaln << " " << totnnz << std::endl;
+        header = ss.str();
     }
     
-    IT entries =  getlocalnnz();
-    IT sizeuntil = 0;
-    MPI_Exscan( &entries, &sizeuntil, 1, MPIType<IT>(), MPI_SUM, commGrid->GetWorld() );
-    if(myrank == 0) sizeuntil = 0;    // because MPI_Exscan says the recvbuf in process 0 is undefined
-    
     IT roffset = 0;
     IT coffset = 0;
     GetPlaceInGlobalGrid(roffset, coffset);
@@ -4145,60 +5061,44 @@ void SpParMat< IT,NT,DER >::ParallelWriteMM(const std::string & filename, bool o
         roffset += 1;    // increment by 1
         coffset += 1;
     }
-    
+
+    // nonempty columns and the number of nonzeros before each, so that any range of nonzeros can be formatted on its own
+    std::vector<typename DER::SpColIter> colits;
+    std::vector<int64_t> nzbefore(1, 0);
     for(typename DER::SpColIter colit = spSeq->begcol(); colit != spSeq->endcol(); ++colit)    // iterate over nonempty subcolumns
     {
-        for(typename DER::SpColIter::NzIter nzit = spSeq->begnz(colit); nzit != spSeq->endnz(colit); ++nzit)
+        colits.push_back(colit);
+        nzbefore.push_back(nzbefore.back() + colit.nnz());
+    }
+
+    typedef TextValueWriter<NT, std::is_same<HANDLER, ScalarReadSaveHandler>::value && IsFastText<NT>::value> ValueWriter;
+    auto format = [&](int64_t begin, int64_t end, std::string & out)
+    {
+        if(begin >= end) return;
+        HANDLER myhandler(handler);     // handlers are not required to be thread-safe
+        ValueWriter writer;
+        size_t c = std::upper_bound(nzbefore.begin(), nzbefore.end(), begin) - nzbefore.begin() - 1;
+        typename DER::SpColIter colit = colits[c];
+        typename DER::SpColIter::NzIter nzit = spSeq->begnz(colit);
+        for(int64_t k = nzbefore[c]; k < begin; ++k)  ++nzit;
+        for(int64_t i = begin; i < end; ++i, ++nzit)
         {
+            while(i == nzbefore[c+1])
+            {
+                colit = colits[++c];
+                nzit = spSeq->begnz(colit);
+            }
             IT glrowid = nzit.rowid() + roffset;
             IT glcolid = colit.colid() + coffset;
-            ss << glrowid << '\t';
-            ss << glcolid << '\t';
-            handler.save(ss, nzit.value(), glrowid, glcolid);
-            ss << '\n';
+            SpHelper::AppendInteger(out, glrowid);
+            out += '\t';
+            SpHelper::AppendInteger(out, glcolid);
+            out += '\t';
+            writer.Append(out, myhandler, nzit.value(), glrowid, glcolid);
+            out += '\n';
         }
-    }
-    std::string text = ss.str();
-
-    int64_t * bytes = new int64_t[nprocs];
-    bytes[myrank] = text.size();
-    MPI_Allgather(MPI_IN_PLACE, 1, MPIType<int64_t>(), bytes, 1, MPIType<int64_t>(), commGrid->GetWorld());
-    int64_t bytesuntil = std::accumulate(bytes, bytes+myrank, static_cast<int64_t>(0));
-    int64_t bytestotal = std::accumulate(bytes, bytes+nprocs, static_cast<int64_t>(0));
-
-
-    MPI_File thefile;
-    MPI_File_open(commGrid->GetWorld(), (char*) filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &thefile) ;
-    int mpi_err = MPI_File_set_view(thefile, bytesuntil, MPI_CHAR, MPI_CHAR, (char*)"external32", MPI_INFO_NULL);
-    if (mpi_err == 51) {
-        // external32 datarep is not supported, use native instead
-        MPI_File_set_view(thefile, bytesuntil, MPI_CHAR, MPI_CHAR, (char*)"native", MPI_INFO_NULL);
-    }
- 
-    int64_t batchSize = 256 * 1024 * 1024;
-    size_t localfileptr = 0;
-    int64_t remaining = bytes[myrank];
-    int64_t totalremaining = bytestotal;
-    
-    while(totalremaining > 0)
-    {
-    #ifdef COMBBLAS_DEBUG
-        if(myrank == 0)
-            std::cout << "Remaining " << totalremaining << " bytes to write in aggregate" << std::endl;
-    #endif
-        MPI_Status status;
-        int curBatch = std::min(batchSize, remaining);
-        MPI_File_write_all(thefile, text.c_str()+localfileptr, curBatch, MPI_CHAR, &status);
-        int count;
-        MPI_Get_count(&status, MPI_CHAR, &count); // known bug: https://github.com/pmodels/mpich/issues/2332
-        assert( (curBatch == 0) || (count == curBatch) ); // count can return the previous/wrong value when 0 elements are written
-        localfileptr += curBatch;
-        remaining -= curBatch;
-        MPI_Allreduce(&remaining, &totalremaining, 1, MPIType<int64_t>(), MPI_SUM, commGrid->GetWorld());
-    }
-    MPI_File_close(&thefile);
-    
-    delete [] bytes;
+    };
+    SpParHelper::WriteTextRecords(filename, header, static_cast<int64_t>(getlocalnnz()), format, commGrid->GetWorld());
 }
 
 
@@ -4872,7 +5772,7 @@ void SpParMat<IT,NT,DER>::Find (FullyDistVec<IT,IT> & distrows, FullyDistVec<IT,
 	locncols[rowrank] = getlocalcols();
 
 	MPI_Allgather(MPI_IN_PLACE, 0, MPIType<IT>(),locnrows, 1, MPIType<IT>(), commGrid->GetColWorld());
-	MPI_Allgather(MPI_IN_PLACE, 0, MPIType<IT>(),locncols, 1, MPIType<IT>(), commGrid->GetColWorld());
+	MPI_Allgather(MPI_IN_PLACE, 0, MPIType<IT>(),locncols, 1, MPIType<IT>(), commGrid->GetRowWorld());
 	IT roffset = std::accumulate(locnrows, locnrows+colrank, static_cast<IT>(0));
 	IT coffset = std::accumulate(locncols, locncols+rowrank, static_cast<IT>(0));
 	
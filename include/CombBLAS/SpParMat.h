@@ -122,6 +122,18 @@ public:
 	template <typename VT, typename GIT, typename _BinaryOperation>	
 	void Reduce(FullyDistVec<GIT,VT> & rvec, Dim dim, _BinaryOperation __binary_op, VT id) const;
 
+	//! Reductions with the addition of semiring SR, combined across processors by SRingMPIOp<SR,VT>
+	template <typename SR, typename VT, typename GIT>
+	void Reduce(FullyDistVec<GIT,VT> & rvec, Dim dim, VT id) const;
+
+	template <typename SR, typename VT, typename GIT, typename _UnaryOperation>
+	void Reduce(FullyDistVec<GIT,VT> & rvec, Dim dim, VT id, _UnaryOperation __unary_op) const;
+
+	//! Column reduction of values already reduced locally (one per local column), e.g. statistics kept by fused kernels
+	//! Only the type of __binary_op matters: the values are combined across the processor column by its MPIOp
+	template <typename VT, typename GIT, typename _BinaryOperation>
+	void ReduceLocalColumns(FullyDistVec<GIT,VT> & rvec, const std::vector<VT> & localcolvals, _BinaryOperation __binary_op) const;
+
     template <typename VT, typename GIT>
     bool Kselect(FullyDistVec<GIT,VT> & rvec, IT k_limit, int kselectVersion) const;
     template <typename VT, typename GIT>
@@ -143,6 +155,8 @@ public:
     void MaskedReduce(FullyDistVec<GIT,VT> & rvec, FullyDistSpVec<GIT,VT> & mask, Dim dim, _BinaryOperation __binary_op, VT id, bool exclude=false) const;
     template <typename VT, typename GIT, typename _BinaryOperation, typename _UnaryOperation >
     void MaskedReduce(FullyDistVec<GIT,VT> & rvec, FullyDistSpVec<GIT,VT> & mask, Dim dim, _BinaryOperation __binary_op, VT id, _UnaryOperation __unary_op, bool exclude=false) const;
+    template <typename SR, typename VT, typename GIT>
+    void MaskedReduce(FullyDistVec<GIT,VT> & rvec, FullyDistSpVec<GIT,VT> & mask, Dim dim, VT id, bool exclude=false) const;
     
 	template <typename _UnaryOperation>
 	void Apply(_UnaryOperation __unary_op)
@@ -282,6 +296,23 @@ public:
     void ParallelWriteMM(const std::string & filename, bool onebased) { ParallelWriteMM(filename, onebased, ScalarReadSaveHandler()); };
 
     void ParallelBinaryWrite(std::string filename) const;
+
+    /**
+     * Streaming Graph500 generator: the same matrix as SpParMat(DistEdgeList) after DistEdgeList::GenGraph500Data(..., scramble, packed=true),
+     * but without an edge list. Each process generates its range of edges in rounds of at most roundedges (all threads, scrambled on the fly),
+     * packs them directly into per-owner send buffers and exchanges them. The received edges are deduplicated and added to the local matrix
+     * before the next round, so only one round's edges are held at a time. Keeps self-loops unless removeloops, sums duplicates
+     **/
+    void GenGraph500Data(int log_numverts, int edgefactor, bool removeloops = true, int64_t roundedges = (1 << 22));
+
+    /**
+     * Partitioned checkpoint: every process writes its local DCSC arrays as they are, plus an index entry (see FileHeader.h)
+     * LoadCheckpoint maps the file: on the same process grid each process copies its own block with no communication,
+     * otherwise each process extracts its new block from the old blocks that overlap it
+     * Only for SpDCCols local matrices and plain-old-data NT; aborts if the local matrices are split for multithreading
+     **/
+    void SaveCheckpoint(const std::string & filename) const;
+    void LoadCheckpoint(const std::string & filename);
     
     template <typename _BinaryOperation>
     FullyDistVec<IT,std::array<char, MAXVERTNAME>> ReadGeneralizedTuples(const std::string&, _BinaryOperation);
@@ -335,6 +366,9 @@ public:
     template <typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
     friend int64_t EstPerProcessNnzSUMMA(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B, bool hashEstimate);
 
+    template <typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
+    friend std::vector<int64_t> SymbolicSUMMAColumnNnz(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B);
+
 	template <typename SR, typename IU, typename NU1, typename NU2, typename UDER1, typename UDER2> 
 	friend SpParMat<IU,typename promote_trait<NU1,NU2>::T_promote,typename promote_trait<UDER1,UDER2>::T_promote> 
 	Mult_AnXBn_ActiveTarget (const SpParMat<IU,NU1,UDER1> & A, const SpParMat<IU,NU2,UDER2> & B );
@@ -353,7 +387,8 @@ public:
 
     template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
     friend SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B,
-                                               int phases, NUO hardThreshold, IU selectNum, IU recoverNum, NUO recoverPct, int kselectVersion, int computationKernel, int64_t perProcessMem);
+                                               int phases, NUO hardThreshold, IU selectNum, IU recoverNum, NUO recoverPct, int kselectVersion, int computationKernel, int64_t perProcessMem,
+                                               bool pipelined, SUMMAPipelineStats * pipestats, bool fusedSelect, const std::vector<typename UDERB::LocalIT> * plannedCuts);
 
     template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
     friend int CalculateNumberOfPhases (SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B,
@@ -427,6 +462,17 @@ private:
                     IT coffset, const FullyDistVec<GIT,VT> & rvec) const;
     
     void GetPlaceInGlobalGrid(IT& rowOffset, IT& colOffset) const;
+
+	bool InvertIndex(const FullyDistVec<IT,IT> & v, Dim dim, std::vector<IT> & tptr, std::vector<IT> & tpos) const;	// positions of v that select each local row/column
+	template <typename LIT>
+	static void IndexOwners(const std::vector<IT> & gind, IT total, int neighs, std::vector<int> & proc, std::vector<LIT> & lind);
+	SpParMat<IT,NT,DER> SubsRefDirect(const FullyDistVec<IT,IT> * ri, const FullyDistVec<IT,IT> * ci) const;	// indexing by routing nonzeros, null keeps the dimension
+
+	template <typename LIT>
+	void TransposeOffDiagonal(SpDCCols<LIT,NT> * seq);	// exchanges the locally transposed DCSC arrays
+	template <typename OTHERDER>
+	void TransposeOffDiagonal(OTHERDER * seq);		// exchanges tuples
+	void TransposeTuples();
 	
 	void HorizontalSend(IT * & rows, IT * & cols, NT * & vals, IT * & temprows, IT * & tempcols, NT * & tempvals, std::vector < std::tuple <IT,IT,NT> > & localtuples,
 						int * rcurptrs, int * rdispls, IT buffperrowneigh, int rowneighs, int recvcount, IT m_perproc, IT n_perproc, int rankinrow);
@@ -31,6 +31,7 @@
 #include <algorithm>
 #include <functional>
 #include <iostream>
+#include <tuple>
 #include "Friends.h"
 #include "SpHelper.h"
 
@@ -1229,6 +1230,143 @@ void Dcsc<IT,NT>::Merge(const Dcsc<IT,NT> * A, const Dcsc<IT,NT> * B, IT cut)
 }
 
 
+/**
+ * O(nz + nrow) time transpose by a counting sort on the row indices (no comparison sort)
+ * Each thread histograms the rows of a contiguous range of columns, so the scatter is stable
+ * and the row indices of every output column come out sorted
+ * Hypersparse blocks (nrow > 4*nz) are sorted instead (TransposeSorted), in O(nz log nz) time and O(nz) space
+ * @param[in] nrow number of rows of this matrix, i.e. the number of columns of the transpose
+ * @param[in] colsready called with the result once its jc and cp arrays are final, before ir and numx
+ * are filled, so that callers can start shipping the column structure early
+ * @return the transpose, or NULL if this is empty
+ **/
+template<class IT, class NT>
+template <typename _Callback>
+Dcsc<IT,NT> * Dcsc<IT,NT>::Transpose(IT nrow, _Callback colsready) const
+{
+	if(nz == 0)	return NULL;
+	if(nrow / 4 > nz)	return TransposeSorted(colsready);	// the histograms would dwarf the matrix
+
+	int numThreads = 1;
+#ifdef THREADED
+#pragma omp parallel
+	{
+		numThreads = omp_get_num_threads();
+	}
+#endif
+	// every thread keeps a histogram of nrow entries, don't let those dwarf the matrix itself
+	numThreads = static_cast<int>(std::max(static_cast<IT>(1), std::min(static_cast<IT>(numThreads), (4 * nz) / std::max(nrow, static_cast<IT>(1)))));
+
+	std::vector<IT> colsplit(numThreads+1);	// thread t handles columns [colsplit[t], colsplit[t+1]), with about nz/numThreads nonzeros
+	for(int t=0; t< numThreads; ++t)
+		colsplit[t] = std::lower_bound(cp, cp+nzc, (nz / numThreads) * t) - cp;
+	colsplit[numThreads] = nzc;
+
+	std::vector<IT> offsets(static_cast<size_t>(numThreads) * nrow, 0);
+	std::vector<IT> rowstart(nrow+1, 0);
+#ifdef THREADED
+#pragma omp parallel for schedule(static,1)
+#endif
+	for(int t=0; t< numThreads; ++t)
+	{
+		IT * mycounts = offsets.data() + static_cast<size_t>(t) * nrow;
+		for(IT k = cp[colsplit[t]]; k < cp[colsplit[t+1]]; ++k)
+			++mycounts[ir[k]];
+	}
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+	for(IT r=0; r< nrow; ++r)	// offsets of each thread within the row, and the row's total
+	{
+		IT running = 0;
+		for(int t=0; t< numThreads; ++t)
+		{
+			IT cnt = offsets[static_cast<size_t>(t) * nrow + r];
+			offsets[static_cast<size_t>(t) * nrow + r] = running;
+			running += cnt;
+		}
+		rowstart[r+1] = running;
+	}
+	IT nzcT = 0;
+	for(IT r=0; r< nrow; ++r)
+	{
+		if(rowstart[r+1] > 0)	++nzcT;
+		rowstart[r+1] += rowstart[r];
+	}
+
+	Dcsc<IT,NT> * trans = new Dcsc<IT,NT>(nz, nzcT);
+	IT jT = 0;
+	for(IT r=0; r< nrow; ++r)
+	{
+		if(rowstart[r+1] > rowstart[r])
+		{
+			trans->jc[jT] = r;
+			trans->cp[jT++] = rowstart[r];
+		}
+	}
+	trans->cp[nzcT] = nz;
+	colsready(trans);
+
+#ifdef THREADED
+#pragma omp parallel for schedule(static,1)
+#endif
+	for(int t=0; t< numThreads; ++t)
+	{
+		IT * mypos = offsets.data() + static_cast<size_t>(t) * nrow;
+		for(IT j = colsplit[t]; j < colsplit[t+1]; ++j)
+		{
+			for(IT k = cp[j]; k < cp[j+1]; ++k)
+			{
+				IT pos = rowstart[ir[k]] + mypos[ir[k]]++;
+				trans->ir[pos] = jc[j];
+				trans->numx[pos] = numx[k];
+			}
+		}
+	}
+	return trans;
+}
+
+/**
+ * O(nz log nz) time, O(nz) space transpose for hypersparse blocks: sorts (row, column, position) triples
+ * so that nothing of size nrow is allocated. Same output and callback contract as Transpose
+ **/
+template<class IT, class NT>
+template <typename _Callback>
+Dcsc<IT,NT> * Dcsc<IT,NT>::TransposeSorted(_Callback colsready) const
+{
+	std::vector< std::tuple<IT,IT,IT> > triples(nz);
+	for(IT j=0; j< nzc; ++j)
+		for(IT k = cp[j]; k < cp[j+1]; ++k)
+			triples[k] = std::make_tuple(ir[k], jc[j], k);
+	std::sort(triples.begin(), triples.end());
+
+	IT nzcT = 0;
+	for(IT k=0; k< nz; ++k)
+	{
+		if(k == 0 || std::get<0>(triples[k]) != std::get<0>(triples[k-1]))	++nzcT;
+	}
+	Dcsc<IT,NT> * trans = new Dcsc<IT,NT>(nz, nzcT);
+	IT jT = 0;
+	for(IT k=0; k< nz; ++k)
+	{
+		if(k == 0 || std::get<0>(triples[k]) != std::get<0>(triples[k-1]))
+		{
+			trans->jc[jT] = std::get<0>(triples[k]);
+			trans->cp[jT++] = k;
+		}
+	}
+	trans->cp[nzcT] = nz;
+	colsready(trans);
+
+	for(IT k=0; k< nz; ++k)
+	{
+		trans->ir[k] = std::get<1>(triples[k]);
+		trans->numx[k] = numx[std::get<2>(triples[k])];
+	}
+	return trans;
+}
+
+
 /**
  * @pre {no member of "parts" is empty}
  * @pre {there are at least 2 members}
@@ -103,6 +103,13 @@ public:
     void ColSplit(std::vector< Dcsc<IT,NT>* > & parts, std::vector<IT> & cuts);
     void ColConcatenate(std::vector< Dcsc<IT,NT>* > & parts, std::vector<IT> & offsets);
 
+	template <typename _Callback>
+	Dcsc<IT,NT> * Transpose(IT nrow, _Callback colsready) const;	//!< Counting sort transpose (sort for hypersparse blocks), colsready(result) runs once jc and cp are final
+	Dcsc<IT,NT> * Transpose(IT nrow) const
+	{
+		return Transpose(nrow, [](Dcsc<IT,NT> *){});
+	}
+
 	void Split(Dcsc<IT,NT> * & A, Dcsc<IT,NT> * & B, IT cut); 	//! \todo{special case of ColSplit, to be deprecated...}
 	void Merge(const Dcsc<IT,NT> * Adcsc, const Dcsc<IT,NT> * B, IT cut);	 //! \todo{special case of ColConcatenate, to be deprecated...}
 
@@ -132,6 +139,9 @@ public:
 
 private:
 	void getindices (StackEntry<NT, std::pair<IT,IT> > * multstack, IT & rindex, IT & cindex, IT & j, IT nnz);
+
+	template <typename _Callback>
+	Dcsc<IT,NT> * TransposeSorted(_Callback colsready) const;
 };
 
 }
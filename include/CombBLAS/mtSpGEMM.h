@@ -1,7 +1,9 @@
 #ifndef _mtSpGEMM_h
 #define _mtSpGEMM_h
 
+#include <random>
 #include "CombBLAS.h"
+#include "SpGEMMCostModel.h"
 
 namespace combblas {
 /*
@@ -209,30 +211,246 @@ bool sort_less(const std::pair<IT, NT> &left, const std::pair<IT, NT> &right)
     return left.first < right.first;
 }
 
-// Hybrid approach of multithreaded HeapSpGEMM and HashSpGEMM
+/*
+ * Column accumulators used by LocalHybridSpGEMM
+ * Each one computes column i of A*B into out[0..) sorted by row index and returns the number of entries written
+ * colinds[j] brackets the nonzeros of the column of A selected by the jth nonzero of B(:,i) (see Dcsc::FillColInds)
+ */
+template <typename SR, typename NTO, typename IT, typename NT1, typename NT2>
+IT HeapAccumulateColumn(const Dcsc<IT,NT1> * Adcsc, const Dcsc<IT,NT2> * Bdcsc, size_t i, std::pair<IT,IT> * colinds, size_t nnzcolB,
+                        std::vector<HeapEntry<IT,NT1>> & heapvec, std::tuple<IT,IT,NTO> * out)
+{
+    if(heapvec.size() < nnzcolB)
+        heapvec.resize(nnzcolB);
+    HeapEntry<IT, NT1> * wset = heapvec.data();
+    IT hsize = 0;
+
+    for(size_t j = 0; j < nnzcolB; ++j)		// create the initial heap
+    {
+        if(colinds[j].first != colinds[j].second)	// current != end
+        {
+            wset[hsize++] = HeapEntry< IT,NT1 > (Adcsc->ir[colinds[j].first], j, Adcsc->numx[colinds[j].first]);
+        }
+    }
+    std::make_heap(wset, wset+hsize);
+
+    IT curptr = 0;
+    while(hsize > 0)
+    {
+        std::pop_heap(wset, wset + hsize);         // result is stored in wset[hsize-1]
+        IT locb = wset[hsize-1].runr;	// relative location of the nonzero in B's current column
+
+        NTO mrhs = SR::multiply(wset[hsize-1].num, Bdcsc->numx[Bdcsc->cp[i]+locb]);
+        if (!SR::returnedSAID())
+        {
+            if( (curptr > 0) && std::get<0>(out[curptr-1]) == wset[hsize-1].key)
+            {
+                std::get<2>(out[curptr-1]) = SR::add(std::get<2>(out[curptr-1]), mrhs);
+            }
+            else
+            {
+                out[curptr++]= std::make_tuple(wset[hsize-1].key, Bdcsc->jc[i], mrhs) ;
+            }
+        }
+        if( (++(colinds[locb].first)) != colinds[locb].second)	// current != end
+        {
+            // runr stays the same !
+            wset[hsize-1].key = Adcsc->ir[colinds[locb].first];
+            wset[hsize-1].num = Adcsc->numx[colinds[locb].first];
+            std::push_heap(wset, wset+hsize);
+        }
+        else
+        {
+            --hsize;
+        }
+    }
+    return curptr;
+}
+
+template <typename SR, typename NTO, typename IT, typename NT1, typename NT2>
+IT HashAccumulateColumn(const Dcsc<IT,NT1> * Adcsc, const Dcsc<IT,NT2> * Bdcsc, size_t i, std::pair<IT,IT> * colinds, size_t nnzcolB,
+                        size_t nnzcolC, std::vector<std::pair<IT,NTO>> & hashvec, std::tuple<IT,IT,NTO> * out)
+{
+    const IT minHashTableSize = 16;
+    const IT hashScale = 107;
+
+    size_t ht_size = minHashTableSize;
+    while(ht_size < nnzcolC) //ht_size is set as 2^n
+    {
+        ht_size <<= 1;
+    }
+    if(hashvec.size() < ht_size)
+        hashvec.resize(ht_size);
+    std::pair<IT,NTO>* globalHashVec = hashvec.data();
+
+    // Initialize hash tables
+    for(size_t j=0; j < ht_size; ++j)
+    {
+        globalHashVec[j].first = -1;
+    }
+
+    // Multiply and add on Hash table
+    for (size_t j=0; j < nnzcolB; ++j)
+    {
+        NT2 t_bval = Bdcsc->numx[Bdcsc->cp[i] + j];
+        for (IT k = colinds[j].first; k < colinds[j].second; ++k)
+        {
+            NTO mrhs = SR::multiply(Adcsc->numx[k], t_bval);
+            IT key = Adcsc->ir[k];
+            IT hash = (key*hashScale) & (ht_size-1);
+            while (1) //hash probing
+            {
+                if (globalHashVec[hash].first == key) //key is found in hash table
+                {
+                    globalHashVec[hash].second = SR::add(mrhs, globalHashVec[hash].second);
+                    break;
+                }
+                else if (globalHashVec[hash].first == -1) //key is not registered yet
+                {
+                    globalHashVec[hash].first = key;
+                    globalHashVec[hash].second = mrhs;
+                    break;
+                }
+                else //key is not found
+                {
+                    hash = (hash+1) & (ht_size-1);
+                }
+            }
+        }
+    }
+    // gather non-zero elements from hash table, and then sort them by row indices
+    size_t index = 0;
+    for (size_t j=0; j < ht_size; ++j)
+    {
+        if (globalHashVec[j].first != -1)
+        {
+            globalHashVec[index++] = globalHashVec[j];
+        }
+    }
+    std::sort(hashvec.begin(), hashvec.begin() + index, sort_less<IT, NTO>);
+    for (size_t j=0; j < index; ++j)
+    {
+        out[j]= std::make_tuple(globalHashVec[j].first, Bdcsc->jc[i], globalHashVec[j].second);
+    }
+    return static_cast<IT>(index);
+}
+
+// Dense SPA: the vectors are sized to nrow(A) on first use and the flags are reset after every column
+template <typename SR, typename NTO, typename IT, typename NT1, typename NT2>
+IT SpaAccumulateColumn(const Dcsc<IT,NT1> * Adcsc, const Dcsc<IT,NT2> * Bdcsc, size_t i, std::pair<IT,IT> * colinds, size_t nnzcolB, IT mdim,
+                       std::vector<NTO> & spavals, std::vector<bool> & spaflags, std::vector<IT> & touched, std::tuple<IT,IT,NTO> * out)
+{
+    if(spavals.size() < static_cast<size_t>(mdim))
+    {
+        spavals.resize(mdim);
+        spaflags.resize(mdim, false);
+    }
+    touched.clear();
+    for (size_t j=0; j < nnzcolB; ++j)
+    {
+        NT2 t_bval = Bdcsc->numx[Bdcsc->cp[i] + j];
+        for (IT k = colinds[j].first; k < colinds[j].second; ++k)
+        {
+            NTO mrhs = SR::multiply(Adcsc->numx[k], t_bval);
+            IT key = Adcsc->ir[k];
+            if(spaflags[key])
+            {
+                spavals[key] = SR::add(spavals[key], mrhs);
+            }
+            else
+            {
+                spaflags[key] = true;
+                spavals[key] = mrhs;
+                touched.push_back(key);
+            }
+        }
+    }
+    std::sort(touched.begin(), touched.end());
+    for (size_t j=0; j < touched.size(); ++j)
+    {
+        out[j] = std::make_tuple(touched[j], Bdcsc->jc[i], spavals[touched[j]]);
+        spaflags[touched[j]] = false;
+    }
+    return static_cast<IT>(touched.size());
+}
+
+// Merges the (sorted) columns of A one at a time into a running result; cheap when B(:,i) has very few nonzeros
+template <typename SR, typename NTO, typename IT, typename NT1, typename NT2>
+IT MergeAccumulateColumn(const Dcsc<IT,NT1> * Adcsc, const Dcsc<IT,NT2> * Bdcsc, size_t i, std::pair<IT,IT> * colinds, size_t nnzcolB, size_t flopcolC,
+                         std::vector<std::pair<IT,NTO>> & runvec, std::vector<std::pair<IT,NTO>> & tmpvec, std::tuple<IT,IT,NTO> * out)
+{
+    if(runvec.size() < flopcolC)
+    {
+        runvec.resize(flopcolC);
+        tmpvec.resize(flopcolC);
+    }
+    std::pair<IT,NTO> * run = runvec.data();
+    std::pair<IT,NTO> * tmp = tmpvec.data();
+    size_t runsize = 0;
+    for (size_t j=0; j < nnzcolB; ++j)
+    {
+        NT2 t_bval = Bdcsc->numx[Bdcsc->cp[i] + j];
+        IT k = colinds[j].first;
+        size_t r = 0, t = 0;
+        while(r < runsize && k < colinds[j].second)
+        {
+            if(run[r].first < Adcsc->ir[k])
+            {
+                tmp[t++] = run[r++];
+            }
+            else if(run[r].first > Adcsc->ir[k])
+            {
+                tmp[t++] = std::make_pair(Adcsc->ir[k], SR::multiply(Adcsc->numx[k], t_bval));
+                ++k;
+            }
+            else
+            {
+                tmp[t++] = std::make_pair(run[r].first, SR::add(run[r].second, SR::multiply(Adcsc->numx[k], t_bval)));
+                ++r; ++k;
+            }
+        }
+        while(r < runsize)
+            tmp[t++] = run[r++];
+        for(; k < colinds[j].second; ++k)
+            tmp[t++] = std::make_pair(Adcsc->ir[k], SR::multiply(Adcsc->numx[k], t_bval));
+        std::swap(run, tmp);
+        runsize = t;
+    }
+    for (size_t j=0; j < runsize; ++j)
+    {
+        out[j] = std::make_tuple(run[j].first, Bdcsc->jc[i], run[j].second);
+    }
+    return static_cast<IT>(runsize);
+}
+
+/*
+ * Hybrid multithreaded SpGEMM: the accumulator of every output column is picked by a cost model
+ * from its flop count, its (exact) output nnz and nnz of the corresponding column of B
+ * If model is null, LocalSpGEMMCostModel::Default() is used, which falls back to the
+ * heap/hash compression-ratio heuristic unless a calibrated model has been loaded
+ */
 template <typename SR, typename NTO, typename IT, typename NT1, typename NT2>
 SpTuples<IT, NTO> * LocalHybridSpGEMM
 (const SpDCCols<IT, NT1> & A,
  const SpDCCols<IT, NT2> & B,
- bool clearA, bool clearB, IT * aux = nullptr)
+ bool clearA, bool clearB, IT * aux = nullptr, const LocalSpGEMMCostModel * model = nullptr)
 {
 
 
     IT mdim = A.getnrow();
     IT ndim = B.getncol();
-    IT nnzA = A.getnnz();
     if(A.isZero() || B.isZero())
     {
         return new SpTuples<IT, NTO>(0, mdim, ndim);
     }
-	
+    if(model == nullptr)
+        model = &LocalSpGEMMCostModel::Default();
 	
     Dcsc<IT,NT1>* Adcsc = A.GetDCSC();
     Dcsc<IT,NT2>* Bdcsc = B.GetDCSC();
     IT nA = A.getncol();
     float cf  = static_cast<float>(nA+1) / static_cast<float>(Adcsc->nzc);
     IT csize = static_cast<IT>(ceil(cf));   // chunk size
-    //IT * aux;
     bool deleteAux = false;
     if(aux==nullptr)
     {
@@ -247,47 +465,28 @@ SpTuples<IT, NTO> * LocalHybridSpGEMM
         numThreads = omp_get_num_threads();
     }
 #endif
-   
-    // std::cout << "numThreads: " << numThreads << std::endl;
 
     IT* flopC =  estimateFLOP(A, B, aux);
-    //IT* flopptr = prefixsum<IT>(flopC, Bdcsc->nzc, numThreads);
-    //IT flop = flopptr[Bdcsc->nzc];
-    // std::cout << "FLOP of A * B is " << flop << std::endl;
-
-
     IT* colnnzC = estimateNNZ_Hash(A, B, flopC, aux);
     IT* flopptr = prefixsum<IT>(flopC, Bdcsc->nzc, numThreads);
-    IT flop = flopptr[Bdcsc->nzc];
     IT* colptrC = prefixsum<IT>(colnnzC, Bdcsc->nzc, numThreads);
     delete [] colnnzC;
     delete [] flopC;
     IT nnzc = colptrC[Bdcsc->nzc];
-    //double compression_ratio = (double)flop / nnzc;
-
-
-    // std::cout << "NNZ of A * B is " << nnzc << std::endl;
-    // std::cout << "Compression ratio is " << compression_ratio << std::endl;
 
     std::tuple<IT,IT,NTO> * tuplesC = static_cast<std::tuple<IT,IT,NTO> *> (::operator new (sizeof(std::tuple<IT,IT,NTO>[nnzc])));
-   //std::tuple<IT,IT,NTO> * tuplesC = new std::tuple<IT,IT,NTO>[nnzc];
        
-    // thread private space for heap and colinds
+    // thread private space for colinds and the accumulators (allocated lazily, only the ones selected are grown)
     std::vector<std::vector< std::pair<IT,IT>>> colindsVec(numThreads);
-   
-     std::vector<std::vector< std::pair<IT,NTO>>> globalHashVecAll(numThreads); 
-     std::vector<std::vector< HeapEntry<IT,NT1>>> globalHeapVecAll(numThreads);
-    /*
-    for(int i=0; i<numThreads; i++) //inital allocation per thread, may be an overestimate, but does not require more memoty than inputs
-    {
-        colindsVec[i].resize(nnzA/numThreads);
-    }*/
-
-    // IT hashSelected = 0;
-
+    std::vector<std::vector< HeapEntry<IT,NT1>>> globalHeapVecAll(numThreads);
+    std::vector<std::vector< std::pair<IT,NTO>>> globalHashVecAll(numThreads);
+    std::vector<std::vector< std::pair<IT,NTO>>> globalMergeVecAll(numThreads);
+    std::vector<std::vector< NTO >> spaValsAll(numThreads);
+    std::vector<std::vector< bool >> spaFlagsAll(numThreads);
+    std::vector<std::vector< IT >> spaTouchedAll(numThreads);
 
 #ifdef THREADED
-#pragma omp parallel for
+#pragma omp parallel for schedule(dynamic, 64)
 #endif
     for(size_t i=0; i < Bdcsc->nzc; ++i)
     {
@@ -307,136 +506,23 @@ SpTuples<IT, NTO> * LocalHybridSpGEMM
         Adcsc->FillColInds(Bdcsc->ir + Bdcsc->cp[i], nnzcolB, colindsVec[myThread], aux, csize);
         std::pair<IT,IT> * colinds = colindsVec[myThread].data();
 
-        double cr = static_cast<double>(flopptr[i+1] - flopptr[i]) / (colptrC[i+1] - colptrC[i]);
-        if (cr < 2.0) // Heap Algorithm
+        IT flopcolC = flopptr[i+1] - flopptr[i];
+        IT nnzcolC = colptrC[i+1] - colptrC[i];
+        std::tuple<IT,IT,NTO> * out = tuplesC + colptrC[i];
+        switch(model->Select(flopcolC, nnzcolC, nnzcolB, mdim))
         {
-	    if(globalHeapVecAll[myThread].size() < nnzcolB)
-	    	globalHeapVecAll[myThread].resize(nnzcolB);	    
-            //std::vector<HeapEntry<IT,NT1>> globalheapVec(nnzcolB);
-            //HeapEntry<IT, NT1> * wset = globalheapVec.data();
-            HeapEntry<IT, NT1> * wset = globalHeapVecAll[myThread].data();
-
-            IT hsize = 0;
-        
-            for(size_t j = 0; j < nnzcolB; ++j)		// create the initial heap
-            {
-                if(colinds[j].first != colinds[j].second)	// current != end
-                {
-                    wset[hsize++] = HeapEntry< IT,NT1 > (Adcsc->ir[colinds[j].first], j, Adcsc->numx[colinds[j].first]);
-                }
-            }
-            std::make_heap(wset, wset+hsize);
-        
-            IT curptr = colptrC[i];
-            while(hsize > 0)
-            {
-                std::pop_heap(wset, wset + hsize);         // result is stored in wset[hsize-1]
-                IT locb = wset[hsize-1].runr;	// relative location of the nonzero in B's current column
-            
-                NTO mrhs = SR::multiply(wset[hsize-1].num, Bdcsc->numx[Bdcsc->cp[i]+locb]);
-                if (!SR::returnedSAID())
-                {
-                    if( (curptr > colptrC[i]) && std::get<0>(tuplesC[curptr-1]) == wset[hsize-1].key)
-                    {
-                        std::get<2>(tuplesC[curptr-1]) = SR::add(std::get<2>(tuplesC[curptr-1]), mrhs);
-                    }
-                    else
-                    {
-                        tuplesC[curptr++]= std::make_tuple(wset[hsize-1].key, Bdcsc->jc[i], mrhs) ;
-                    }
-                }
-                if( (++(colinds[locb].first)) != colinds[locb].second)	// current != end
-                {
-                    // runr stays the same !
-                    wset[hsize-1].key = Adcsc->ir[colinds[locb].first];
-                    wset[hsize-1].num = Adcsc->numx[colinds[locb].first];
-                    std::push_heap(wset, wset+hsize);
-                }
-                else
-                {
-                    --hsize;
-                }
-            }
-        } // Finish Heap
-        
-        else // Hash Algorithm
-        {
-	// #pragma omp atomic
-	// 	hashSelected++;
-            const IT minHashTableSize = 16;
-            const IT hashScale = 107;
-            size_t nnzcolC = colptrC[i+1] - colptrC[i]; //nnz in the current column of C (=Output)
-
-            size_t ht_size = minHashTableSize;
-            while(ht_size < nnzcolC) //ht_size is set as 2^n
-            {
-                ht_size <<= 1;
-            }
-            
-	    
-	    if(globalHashVecAll[myThread].size() < ht_size)
-                globalHashVecAll[myThread].resize(ht_size);
-            //std::vector<HeapEntry<IT,NT1>> globalheapVec(nnzcolB);
-            //HeapEntry<IT, NT1> * wset = globalheapVec.data();
-            //HeapEntry<IT, NT1> * wset = globalheapVecAll[myThread].data();
-
-	    //std::vector< std::pair<IT,NTO>> globalHashVec(ht_size);
-	    std::pair<IT,NTO>* globalHashVec =  globalHashVecAll[myThread].data();
-            // colinds.first vector keeps indices to A.cp, i.e. it dereferences "colnums" vector (above),
-            // colinds.second vector keeps the end indices (i.e. it gives the index to the last valid element of A.cpnack)
-            
-            // Initialize hash tables
-            for(size_t j=0; j < ht_size; ++j)
-            {
-                globalHashVec[j].first = -1;
-            }
-            
-            // Multiply and add on Hash table
-            for (size_t j=0; j < nnzcolB; ++j)
-            {
-                IT t_bcol = Bdcsc->ir[Bdcsc->cp[i] + j];
-                NT2 t_bval = Bdcsc->numx[Bdcsc->cp[i] + j];
-                for (IT k = colinds[j].first; k < colinds[j].second; ++k)
-                {
-                    NTO mrhs = SR::multiply(Adcsc->numx[k], t_bval);
-                    IT key = Adcsc->ir[k];
-                    IT hash = (key*hashScale) & (ht_size-1);
-                    while (1) //hash probing
-                    {
-                        if (globalHashVec[hash].first == key) //key is found in hash table
-                        {
-                            globalHashVec[hash].second = SR::add(mrhs, globalHashVec[hash].second);
-                            break;
-                        }
-                        else if (globalHashVec[hash].first == -1) //key is not registered yet
-                        {
-                            globalHashVec[hash].first = key;
-                            globalHashVec[hash].second = mrhs;
-                            break;
-                        }
-                        else //key is not found
-                        {
-                            hash = (hash+1) & (ht_size-1);
-                        }
-                    }
-                }
-            }
-            // gather non-zero elements from hash table, and then sort them by row indices
-            size_t index = 0;
-            for (size_t j=0; j < ht_size; ++j)
-            {
-                if (globalHashVec[j].first != -1)
-                {
-                    globalHashVec[index++] = globalHashVec[j];
-                }
-            }
-            //std::sort(globalHashVec.begin(), globalHashVec.begin() + index, sort_less<IT, NTO>);
-	    std::sort(globalHashVecAll[myThread].begin(), globalHashVecAll[myThread].begin() + index, sort_less<IT, NTO>);
-            IT curptr = colptrC[i];
-            for (size_t j=0; j < index; ++j)
-            {
-                tuplesC[curptr++]= std::make_tuple(globalHashVec[j].first, Bdcsc->jc[i], globalHashVec[j].second);
-            }
+            case HEAP_KERNEL:
+                HeapAccumulateColumn<SR>(Adcsc, Bdcsc, i, colinds, nnzcolB, globalHeapVecAll[myThread], out);
+                break;
+            case SPA_KERNEL:
+                SpaAccumulateColumn<SR>(Adcsc, Bdcsc, i, colinds, nnzcolB, mdim, spaValsAll[myThread], spaFlagsAll[myThread], spaTouchedAll[myThread], out);
+                break;
+            case MERGE_KERNEL:
+                MergeAccumulateColumn<SR>(Adcsc, Bdcsc, i, colinds, nnzcolB, flopcolC, globalHashVecAll[myThread], globalMergeVecAll[myThread], out);
+                break;
+            default:
+                HashAccumulateColumn<SR>(Adcsc, Bdcsc, i, colinds, nnzcolB, nnzcolC, globalHashVecAll[myThread], out);
+                break;
         }
     }
     
@@ -451,12 +537,232 @@ SpTuples<IT, NTO> * LocalHybridSpGEMM
     	delete [] aux;
     
     SpTuples<IT, NTO>* spTuplesC = new SpTuples<IT, NTO> (nnzc, mdim, ndim, tuplesC, true, true);
+    return spTuplesC;
+}
 
+/*
+ * Per-column statistics of a product truncated by the fused select kernels below, indexed by local column
+ * These are the quantities MCLPruneRecoverySelect otherwise computes from the full product:
+ * nnz, nnz above the hard threshold and the sum of the values above the hard threshold
+ */
+template <typename NT>
+struct ColumnSelectStats
+{
+    std::vector<NT> nnz;
+    std::vector<NT> nnzPruned;
+    std::vector<NT> sumPruned;
 
-    // std::cout << "localspgemminfo," << flop << "," << nnzc << "," << compression_ratio << "," << t1-t0 << std::endl;
-    // std::cout << hashSelected << ", " << Bdcsc->nzc << ", " << (float)hashSelected / Bdcsc->nzc << std::endl;
+    void reset(size_t ncols)
+    {
+        nnz.assign(ncols, 0);
+        nnzPruned.assign(ncols, 0);
+        sumPruned.assign(ncols, 0);
+    }
+};
 
-    return spTuplesC;
+/*
+ * Truncates one output column in place to the entries that MCLPruneRecoverySelect may keep:
+ * the K = max(selectNum, recoverNum) largest values (ties included), and every value at or above the hard threshold
+ * unless this part of the column alone already has more than selectNum values above it. Since every process keeps the local top K of its part of the column, the global top K
+ * is unchanged and so is every Kselect done by MCLPruneRecoverySelect (no recomputation is needed for recovery).
+ * Order of the kept entries is preserved. Returns the number of entries kept.
+ */
+template <typename IT, typename NT>
+IT SelectColumn(std::tuple<IT,IT,NT> * col, IT len, NT hardThreshold, int64_t selectNum, int64_t recoverNum, std::vector<NT> & scratch,
+                NT & nnz, NT & nnzPruned, NT & sumPruned)
+{
+    nnz = static_cast<NT>(len);
+    nnzPruned = 0;
+    sumPruned = 0;
+    for(IT j=0; j < len; ++j)
+    {
+        if(std::get<2>(col[j]) > hardThreshold)
+        {
+            nnzPruned += 1;
+            sumPruned += std::get<2>(col[j]);
+        }
+    }
+    int64_t K = std::max(selectNum, recoverNum);
+    if(static_cast<int64_t>(len) <= K) return len;
+
+    NT cutoff = hardThreshold;
+    if(K > 0)
+    {
+        scratch.resize(len);
+        for(IT j=0; j < len; ++j)
+            scratch[j] = std::get<2>(col[j]);
+        std::nth_element(scratch.begin(), scratch.begin()+(K-1), scratch.end(), std::greater<NT>());
+        cutoff = scratch[K-1];
+        // if the column may escape selection, MCLPruneRecoverySelect keeps everything at or above the hard threshold
+        if(nnzPruned <= static_cast<NT>(selectNum))
+            cutoff = std::min(cutoff, hardThreshold);
+    }
+    IT kept = 0;
+    for(IT j=0; j < len; ++j)
+    {
+        if(std::get<2>(col[j]) >= cutoff)
+            col[kept++] = col[j];
+    }
+    return kept;
+}
+
+/*
+ * Fused SpGEMM and column selection for HipMCL: every output column is accumulated with a hash table,
+ * its statistics are recorded into stats (indexed by column of B) and it is truncated by SelectColumn before
+ * it is stored, so the unpruned product is never materialized. Only valid when the values are final, i.e. A and B
+ * are the whole operands of the column (single-stage SUMMA)
+ * Columns are statically partitioned so that each thread appends the kept entries of a contiguous range of columns
+ */
+template <typename SR, typename NTO, typename IT, typename NT1, typename NT2>
+SpTuples<IT, NTO> * LocalSpGEMMSelect
+(const SpDCCols<IT, NT1> & A,
+ const SpDCCols<IT, NT2> & B,
+ bool clearA, bool clearB, NTO hardThreshold, int64_t selectNum, int64_t recoverNum, ColumnSelectStats<NTO> & stats)
+{
+    IT mdim = A.getnrow();
+    IT ndim = B.getncol();
+    stats.reset(ndim);
+    if(A.isZero() || B.isZero())
+    {
+        if(clearA) delete const_cast<SpDCCols<IT, NT1> *>(&A);
+        if(clearB) delete const_cast<SpDCCols<IT, NT2> *>(&B);
+        return new SpTuples<IT, NTO>(0, mdim, ndim);
+    }
+
+    Dcsc<IT,NT1>* Adcsc = A.GetDCSC();
+    Dcsc<IT,NT2>* Bdcsc = B.GetDCSC();
+    IT nA = A.getncol();
+    float cf  = static_cast<float>(nA+1) / static_cast<float>(Adcsc->nzc);
+    IT csize = static_cast<IT>(ceil(cf));   // chunk size
+    IT * aux;
+    Adcsc->ConstructAux(nA, aux);
+
+    int numThreads = 1;
+#ifdef THREADED
+#pragma omp parallel
+    {
+        numThreads = omp_get_num_threads();
+    }
+#endif
+
+    IT* flopC = estimateFLOP(A, B, aux);
+    IT* colnnzC = estimateNNZ_Hash(A, B, flopC, aux);
+    delete [] flopC;
+
+    std::vector<std::vector< std::tuple<IT,IT,NTO> >> keptAll(numThreads);
+    std::vector<std::vector< std::tuple<IT,IT,NTO> >> columnAll(numThreads);
+    std::vector<std::vector< std::pair<IT,IT>>> colindsVec(numThreads);
+    std::vector<std::vector< std::pair<IT,NTO>>> globalHashVecAll(numThreads);
+    std::vector<std::vector< NTO >> scratchAll(numThreads);
+
+#ifdef THREADED
+#pragma omp parallel for schedule(static)
+#endif
+    for(size_t i=0; i < Bdcsc->nzc; ++i)
+    {
+        size_t nnzcolB = Bdcsc->cp[i+1] - Bdcsc->cp[i];
+        int myThread = 0;
+#ifdef THREADED
+        myThread = omp_get_thread_num();
+#endif
+        if(colindsVec[myThread].size() < nnzcolB)
+            colindsVec[myThread].resize(nnzcolB);
+        Adcsc->FillColInds(Bdcsc->ir + Bdcsc->cp[i], nnzcolB, colindsVec[myThread], aux, csize);
+
+        IT nnzcolC = colnnzC[i];
+        if(columnAll[myThread].size() < static_cast<size_t>(nnzcolC))
+            columnAll[myThread].resize(nnzcolC);
+        std::tuple<IT,IT,NTO> * column = columnAll[myThread].data();
+        IT len = HashAccumulateColumn<SR>(Adcsc, Bdcsc, i, colindsVec[myThread].data(), nnzcolB, nnzcolC, globalHashVecAll[myThread], column);
+
+        IT j = Bdcsc->jc[i];
+        IT kept = SelectColumn(column, len, hardThreshold, selectNum, recoverNum, scratchAll[myThread], stats.nnz[j], stats.nnzPruned[j], stats.sumPruned[j]);
+        keptAll[myThread].insert(keptAll[myThread].end(), column, column + kept);
+    }
+    delete [] colnnzC;
+    delete [] aux;
+
+    if(clearA)
+        delete const_cast<SpDCCols<IT, NT1> *>(&A);
+    if(clearB)
+        delete const_cast<SpDCCols<IT, NT2> *>(&B);
+
+    std::vector<IT> threadptr(numThreads+1, 0);
+    for(int t=0; t < numThreads; ++t)
+        threadptr[t+1] = threadptr[t] + keptAll[t].size();
+    IT nnzc = threadptr[numThreads];
+    std::tuple<IT,IT,NTO> * tuplesC = static_cast<std::tuple<IT,IT,NTO> *> (::operator new (sizeof(std::tuple<IT,IT,NTO>[nnzc])));
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+    for(int t=0; t < numThreads; ++t)
+    {
+        std::copy(keptAll[t].begin(), keptAll[t].end(), tuplesC + threadptr[t]);
+        std::vector< std::tuple<IT,IT,NTO> >().swap(keptAll[t]);
+    }
+    return new SpTuples<IT, NTO> (nnzc, mdim, ndim, tuplesC, true, true);
+}
+
+/*
+ * Same truncation as LocalSpGEMMSelect, applied to an already merged product whose columns are contiguous
+ * (the output of MultiwayMerge/MultiwayMergeHash). Used when SUMMA has more than one stage, since the values
+ * are only final after the merge. Deletes T and returns the truncated product
+ */
+template <typename IT, typename NT>
+SpTuples<IT, NT> * SelectTuples(SpTuples<IT, NT> * T, NT hardThreshold, int64_t selectNum, int64_t recoverNum, ColumnSelectStats<NT> & stats)
+{
+    IT ncols = T->getncol();
+    stats.reset(ncols);
+    int64_t nnz = T->getnnz();
+    std::tuple<IT,IT,NT> * tuples = T->tuples;
+
+    std::vector<int64_t> colstart;
+    for(int64_t k=0; k < nnz; ++k)
+    {
+        if(k == 0 || std::get<1>(tuples[k]) != std::get<1>(tuples[k-1]))
+            colstart.push_back(k);
+    }
+    IT nzc = static_cast<IT>(colstart.size());
+    colstart.push_back(nnz);
+
+    int numThreads = 1;
+#ifdef THREADED
+#pragma omp parallel
+    {
+        numThreads = omp_get_num_threads();
+    }
+#endif
+    std::vector<std::vector< NT >> scratchAll(numThreads);
+    IT * colkept = new IT[nzc];
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for(IT c=0; c < nzc; ++c)
+    {
+        int myThread = 0;
+#ifdef THREADED
+        myThread = omp_get_thread_num();
+#endif
+        IT j = std::get<1>(tuples[colstart[c]]);
+        colkept[c] = SelectColumn(tuples + colstart[c], static_cast<IT>(colstart[c+1] - colstart[c]), hardThreshold, selectNum, recoverNum,
+                                  scratchAll[myThread], stats.nnz[j], stats.nnzPruned[j], stats.sumPruned[j]);
+    }
+    IT * keptptr = prefixsum<IT>(colkept, nzc, numThreads);
+    delete [] colkept;
+    IT nnzkept = keptptr[nzc];
+    std::tuple<IT,IT,NT> * tuplesC = static_cast<std::tuple<IT,IT,NT> *> (::operator new (sizeof(std::tuple<IT,IT,NT>[nnzkept])));
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+    for(IT c=0; c < nzc; ++c)
+    {
+        std::copy(tuples + colstart[c], tuples + colstart[c] + (keptptr[c+1] - keptptr[c]), tuplesC + keptptr[c]);
+    }
+    delete [] keptptr;
+
+    SpTuples<IT, NT> * truncated = new SpTuples<IT, NT> (nnzkept, T->getnrow(), ncols, tuplesC, true, true);
+    delete T;
+    return truncated;
 }
 
     // Hybrid approach of multithreaded HeapSpGEMM and HashSpGEMM
@@ -1437,6 +1743,156 @@ estimateNNZ_Hash (const SpCCols<IT, NT1>	&A,
 }
 			  
 	
+/*
+ * Microbenchmark that fits the coefficients of a LocalSpGEMMCostModel on this machine
+ * Random A (nrow x ncolA) and B (ncolA x ncolB) pairs are multiplied with every kernel forced;
+ * the row range of A's columns controls the compression ratio and the nnz per column of B
+ * controls the heap/merge terms. Each kernel is then fitted by nonnegative least squares
+ * on the per-column features summed over the product.
+ * Intended to be run once per machine (see ReleaseTests/CalibrateSpGEMM.cpp), followed by model.Save()
+ */
+template <typename IT, typename NT>
+void CalibrateLocalSpGEMM(LocalSpGEMMCostModel & model, IT nrow = 16384, IT ncolB = 2048, int reps = 3)
+{
+    typedef PlusTimesSRing<NT, NT> PTNN;
+    const int nfeat = LocalSpGEMMCostModel::nfeatures;
+    const IT ncolA = nrow;
+    std::mt19937_64 gen(1234);
+
+    // random column-sorted tuples, nnzpercol distinct rows drawn from [0, range) per column
+    auto randmat = [&gen](IT m, IT n, IT nnzpercol, IT range)
+    {
+        std::vector<std::tuple<IT,IT,NT>> tuples;
+        std::uniform_int_distribution<IT> rowdist(0, range-1);
+        std::uniform_int_distribution<IT> offdist(0, m-range);
+        std::uniform_real_distribution<NT> valdist(0.0, 1.0);
+        std::vector<IT> rows;
+        for(IT j=0; j<n; ++j)
+        {
+            IT offset = offdist(gen);
+            rows.clear();
+            for(IT k=0; k<nnzpercol; ++k)
+                rows.push_back(offset + rowdist(gen));
+            std::sort(rows.begin(), rows.end());
+            rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+            for(auto r : rows)
+                tuples.push_back(std::make_tuple(r, j, valdist(gen)));
+        }
+        return new SpDCCols<IT,NT>(m, n, static_cast<IT>(tuples.size()), tuples.data(), false);
+    };
+
+    std::vector<std::vector<double>> X;  // summed features of each experiment
+    std::vector<std::vector<double>> Y(NUM_LOCAL_KERNELS);  // measured time of each kernel
+    const IT nnzBs[] = {1, 2, 4, 8, 16, 32};
+    const IT nnzAs[] = {2, 8, 32};
+    const IT ranges[] = {64, nrow};
+    for(IT nnzB : nnzBs)
+    {
+        for(IT nnzA : nnzAs)
+        {
+            for(IT range : ranges)
+            {
+                SpDCCols<IT,NT> * A = randmat(nrow, ncolA, nnzA, std::min(range, nrow));
+                SpDCCols<IT,NT> * B = randmat(ncolA, ncolB, nnzB, ncolA);
+                if(A->isZero() || B->isZero())
+                {
+                    delete A; delete B;
+                    continue;
+                }
+                IT * flopC = estimateFLOP(*A, *B);
+                IT * nnzC = estimateNNZ_Hash(*A, *B, flopC);
+                Dcsc<IT,NT> * Bdcsc = B->GetDCSC();
+                std::vector<double> sum(nfeat, 0.0), feat(nfeat);
+                for(IT i=0; i< Bdcsc->nzc; ++i)
+                {
+                    LocalSpGEMMCostModel::Features(flopC[i], nnzC[i], Bdcsc->cp[i+1]-Bdcsc->cp[i], feat.data());
+                    for(int f=0; f<nfeat; ++f) sum[f] += feat[f];
+                }
+                delete [] flopC;
+                delete [] nnzC;
+                X.push_back(sum);
+
+                for(int k=0; k< NUM_LOCAL_KERNELS; ++k)
+                {
+                    LocalSpGEMMCostModel forced;
+                    forced.SetMaxSpaRows(nrow);
+                    forced.Force(k);
+                    double best = std::numeric_limits<double>::max();
+                    for(int r=0; r<reps; ++r)
+                    {
+                        double t0 = MPI_Wtime();
+                        SpTuples<IT,NT> * C = LocalHybridSpGEMM<PTNN, NT>(*A, *B, false, false, static_cast<IT*>(nullptr), &forced);
+                        double t1 = MPI_Wtime();
+                        delete C;
+                        best = std::min(best, t1-t0);
+                    }
+                    Y[k].push_back(best);
+                }
+                delete A;
+                delete B;
+            }
+        }
+    }
+
+    // nonnegative least squares via active set: refit without the features whose coefficients went negative
+    for(int k=0; k< NUM_LOCAL_KERNELS; ++k)
+    {
+        std::vector<bool> active(nfeat, true);
+        std::vector<double> coef(nfeat, 0.0);
+        bool negative = true;
+        while(negative)
+        {
+            std::vector<int> idx;
+            for(int f=0; f<nfeat; ++f) if(active[f]) idx.push_back(f);
+            int na = idx.size();
+            if(na == 0) break;
+            // normal equations with a tiny ridge, scaled per feature for conditioning
+            std::vector<double> scale(na, 0.0);
+            for(size_t e=0; e<X.size(); ++e)
+                for(int a=0; a<na; ++a) scale[a] = std::max(scale[a], X[e][idx[a]]);
+            for(int a=0; a<na; ++a) if(scale[a] == 0.0) scale[a] = 1.0;
+            std::vector<double> M(na*(na+1), 0.0);
+            for(size_t e=0; e<X.size(); ++e)
+            {
+                for(int a=0; a<na; ++a)
+                {
+                    double xa = X[e][idx[a]] / scale[a];
+                    for(int b=0; b<na; ++b)
+                        M[a*(na+1)+b] += xa * X[e][idx[b]] / scale[b];
+                    M[a*(na+1)+na] += xa * Y[k][e];
+                }
+            }
+            for(int a=0; a<na; ++a) M[a*(na+1)+a] += 1e-12;
+            for(int a=0; a<na; ++a)	// Gaussian elimination with partial pivoting
+            {
+                int piv = a;
+                for(int b=a+1; b<na; ++b)
+                    if(std::abs(M[b*(na+1)+a]) > std::abs(M[piv*(na+1)+a])) piv = b;
+                for(int c=0; c<=na; ++c) std::swap(M[a*(na+1)+c], M[piv*(na+1)+c]);
+                for(int b=0; b<na; ++b)
+                {
+                    if(b == a || M[a*(na+1)+a] == 0.0) continue;
+                    double factor = M[b*(na+1)+a] / M[a*(na+1)+a];
+                    for(int c=a; c<=na; ++c) M[b*(na+1)+c] -= factor * M[a*(na+1)+c];
+                }
+            }
+            std::fill(coef.begin(), coef.end(), 0.0);
+            negative = false;
+            for(int a=0; a<na; ++a)
+            {
+                double c = (M[a*(na+1)+a] != 0.0) ? M[a*(na+1)+na] / M[a*(na+1)+a] / scale[a] : 0.0;
+                if(c < 0.0)
+                {
+                    active[idx[a]] = false;
+                    negative = true;
+                }
+                else coef[idx[a]] = c;
+            }
+        }
+        model.SetCoefficients(k, coef.data());
+    }
+}
+
 }
 
 #endif